@@ -0,0 +1,122 @@
+/* Compares shaping with and without the lookup fusion of
+ * hb_ot_map_builder_t::fuse_lookups(), and reports how many passes over
+ * the buffer it saves. */
+
+#include "hb.hh"
+#include "hb-shape-plan.hh"
+
+#include "hb-benchmark.hh"
+
+struct test_input_t
+{
+  const char *font_path;
+  const char *text_path;
+} tests[] =
+{
+  {"perf/fonts/Roboto-Regular.ttf",
+   "perf/texts/en-thelittleprince.txt"},
+
+  {"perf/fonts/Amiri-Regular.ttf",
+   "perf/texts/fa-thelittleprince.txt"},
+
+  {"perf/fonts/NotoNastaliqUrdu-Regular.ttf",
+   "perf/texts/fa-thelittleprince.txt"},
+
+  {"perf/fonts/Gulzar-Regular.ttf",
+   "perf/texts/fa-thelittleprince.txt"},
+
+  {"perf/fonts/NotoSansDuployan-Regular.otf",
+   "perf/texts/duployan.txt"},
+};
+
+/* Clears the fusion marks, so the map applies one lookup per pass. */
+static void unfuse (const hb_ot_map_t &map, unsigned table_index)
+{
+  unsigned num_lookups = map.get_num_lookups (table_index);
+  for (unsigned stage = 0, seen = 0; seen < num_lookups; stage++)
+  {
+    auto lookups = map.get_stage_lookups (table_index, stage);
+    for (const auto &lookup : lookups)
+      const_cast<hb_ot_map_t::lookup_map_t &> (lookup).fuse_next = false;
+    seen += lookups.length;
+  }
+}
+
+static void BM_LayoutFusion (benchmark::State &state,
+			     bool fused,
+			     const test_input_t &input)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned orig_text_length;
+  const char *orig_text = hb_blob_get_data (text_blob, &orig_text_length);
+
+  hb_buffer_t *buf = hb_buffer_create ();
+  hb_buffer_add_utf8 (buf, orig_text, orig_text_length, 0, -1);
+  hb_buffer_guess_segment_properties (buf);
+  hb_segment_properties_t props;
+  hb_buffer_get_segment_properties (buf, &props);
+
+  const char *shaper_list[] = {"ot", nullptr};
+  hb_shape_plan_t *shape_plan = hb_shape_plan_create (hb_font_get_face (font), &props,
+						      nullptr, 0, shaper_list);
+  const hb_ot_map_t &map = shape_plan->ot.map;
+
+  state.counters["gsub_lookups"] = map.get_num_lookups (0);
+  state.counters["gpos_lookups"] = map.get_num_lookups (1);
+  if (!fused)
+  {
+    unfuse (map, 0);
+    unfuse (map, 1);
+  }
+  state.counters["gsub_passes"] = map.get_num_passes (0);
+  state.counters["gpos_passes"] = map.get_num_passes (1);
+
+  for (auto _ : state)
+  {
+    const char *text = orig_text;
+    unsigned text_length = orig_text_length;
+    const char *end;
+    while ((end = (const char *) memchr (text, '\n', text_length)))
+    {
+      hb_buffer_clear_contents (buf);
+      hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+      hb_buffer_set_segment_properties (buf, &props);
+      hb_shape_plan_execute (shape_plan, font, buf, nullptr, 0);
+
+      unsigned skip = end - text + 1;
+      text_length -= skip;
+      text += skip;
+    }
+  }
+
+  hb_shape_plan_destroy (shape_plan);
+  hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+int main (int argc, char **argv)
+{
+  benchmark::Initialize (&argc, argv);
+
+  for (const auto &input : tests)
+    for (bool fused : {false, true})
+    {
+      char name[1024];
+      snprintf (name, sizeof (name), "BM_LayoutFusion/%s/%s/%s",
+		strrchr (input.font_path, '/') + 1,
+		strrchr (input.text_path, '/') + 1,
+		fused ? "fused" : "unfused");
+      benchmark::RegisterBenchmark (name, BM_LayoutFusion, fused, input)
+       ->Unit (benchmark::kMillisecond);
+    }
+
+  benchmark::RunSpecifiedBenchmarks ();
+  benchmark::Shutdown ();
+}
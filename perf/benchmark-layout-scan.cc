@@ -0,0 +1,66 @@
+/* Isolates the loop in apply_forward() that skips glyphs a lookup cannot
+ * apply to; see src/hb-ot-layout-scan.hh. */
+
+#include "hb.hh"
+#include "hb-ot-layout.hh"
+#include "hb-ot-layout-scan.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#define NUM_GLYPHS 4096
+
+/* A buffer of glyphs about one in state.range(0) of which the lookup may
+ * apply to; the rest fail the digest, lookup mask, or glyph class check in
+ * roughly equal parts. */
+static void BM_LayoutScan (benchmark::State &state, bool vector)
+{
+  unsigned period = state.range (0);
+
+  hb_set_digest_t digest;
+  for (hb_codepoint_t g = 100; g < 140; g++)
+    digest.add (g);
+  hb_mask_t lookup_mask = 0x10;
+  unsigned ignore_props = HB_OT_LAYOUT_GLYPH_PROPS_MARK;
+  hb_ot_layout_scan_t scan (digest, lookup_mask, ignore_props);
+
+  std::vector<hb_glyph_info_t> info (NUM_GLYPHS);
+  srand (period);
+  unsigned num_found = 0;
+  for (unsigned i = 0; i < NUM_GLYPHS; i++)
+  {
+    hb_glyph_info_t &info_ = info[i];
+    info_.codepoint = 100 + rand () % 40;
+    info_.mask = lookup_mask | 1;
+    info_.var1.u16[0] = HB_OT_LAYOUT_GLYPH_PROPS_BASE_GLYPH;
+    if (rand () % period)
+      switch (rand () % 3)
+      {
+	case 0: info_.codepoint = 1000 + rand () % 30000; break;
+	case 1: info_.mask = 1; break;
+	case 2: info_.var1.u16[0] = HB_OT_LAYOUT_GLYPH_PROPS_MARK; break;
+      }
+    num_found += scan.may_apply (info_);
+  }
+
+  for (auto _ : state)
+  {
+    unsigned j = 0, n = 0;
+    while ((j = vector ? scan.forward (info.data (), j, NUM_GLYPHS)
+		       : scan.forward_scalar (info.data (), j, NUM_GLYPHS)) < NUM_GLYPHS)
+    {
+      n++;
+      j++;
+    }
+    benchmark::DoNotOptimize (n);
+  }
+
+  state.counters["found"] = num_found;
+  state.SetItemsProcessed (state.iterations () * NUM_GLYPHS);
+}
+
+BENCHMARK_CAPTURE (BM_LayoutScan, scalar, false)->Arg (1)->Arg (4)->Arg (16)->Arg (64)->Arg (1024);
+BENCHMARK_CAPTURE (BM_LayoutScan, vector, true)->Arg (1)->Arg (4)->Arg (16)->Arg (64)->Arg (1024);
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,440 @@
+/* Compares rasterizing a paragraph glyph by glyph, rendering each glyph
+ * and compositing it into a line image, with hb_raster_draw_buffer() /
+ * hb_raster_paint_buffer(), one render per line, and with
+ * hb_raster_draw_render_into() the line image; drawing both with and
+ * without the outline cache.  Also times rendering
+ * it a page of lines at a time, with different numbers of threads, and
+ * painting every glyph of COLRv1 fonts, in pixels per second. */
+
+#include "hb-benchmark.hh"
+
+#include <hb-raster.h>
+
+#include <algorithm>
+#include <vector>
+
+#define LINE_LENGTH 80
+#define PAGE_LINES 32
+
+struct test_input_t
+{
+  const char *font_path;
+  const char *text_path;
+} tests[] =
+{
+  {"perf/fonts/Roboto-Regular.ttf",
+   "perf/texts/en-paragraph.txt"},
+};
+
+/* Color fonts full of gradients, clips and compositing. */
+static const char *colr_fonts[] =
+{
+  "test/api/fonts/test_glyphs-glyf_colr_1.ttf",
+  "test/api/fonts/noto_handwriting-cff2_colr_1.otf",
+};
+
+/* Shapes the text wrapped at spaces into lines of about LINE_LENGTH
+ * characters. */
+static std::vector<hb_buffer_t *>
+shape_lines (hb_font_t *font, const char *text, unsigned length)
+{
+  std::vector<hb_buffer_t *> lines;
+  while (length)
+  {
+    unsigned line = length < LINE_LENGTH ? length : LINE_LENGTH;
+    if (line < length)
+      while (line > 1 && text[line - 1] != ' ')
+	line--;
+
+    hb_buffer_t *buf = hb_buffer_create ();
+    hb_buffer_add_utf8 (buf, text, line, 0, line);
+    hb_buffer_guess_segment_properties (buf);
+    hb_shape (font, buf, nullptr, 0);
+    lines.push_back (buf);
+
+    text += line;
+    length -= line;
+  }
+  return lines;
+}
+
+/* A line image for compositing glyph images into, the way a caller
+ * rendering glyph by glyph would. */
+struct line_t
+{
+  std::vector<uint8_t> pixels;
+  int x_origin, y_origin;
+  unsigned width, height, bpp;
+
+  void init (hb_font_t *font, hb_buffer_t *buf, unsigned bpp_)
+  {
+    hb_font_extents_t extents;
+    hb_font_get_h_extents (font, &extents);
+    unsigned count;
+    hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buf, &count);
+    int advance = 0;
+    for (unsigned i = 0; i < count; i++)
+      advance += pos[i].x_advance;
+
+    bpp = bpp_;
+    x_origin = -extents.ascender;
+    y_origin = extents.descender - extents.ascender / 2;
+    width = advance + 2 * extents.ascender;
+    height = 2 * (extents.ascender - extents.descender);
+    pixels.assign ((size_t) width * height * bpp, 0);
+  }
+
+  void composite (hb_raster_image_t *image)
+  {
+    hb_raster_extents_t ext;
+    hb_raster_image_get_extents (image, &ext);
+    const uint8_t *src = hb_raster_image_get_buffer (image);
+    for (unsigned y = 0; y < ext.height; y++)
+    {
+      int ly = ext.y_origin + (int) y - y_origin;
+      if (ly < 0 || ly >= (int) height) continue;
+      for (unsigned x = 0; x < ext.width; x++)
+      {
+	int lx = ext.x_origin + (int) x - x_origin;
+	if (lx < 0 || lx >= (int) width) continue;
+	const uint8_t *s = src + y * ext.stride + x * bpp;
+	uint8_t *d = pixels.data () + ((size_t) ly * width + lx) * bpp;
+	unsigned a = s[bpp - 1];
+	for (unsigned c = 0; c < bpp; c++)
+	  d[c] = s[c] + (d[c] * (255 - a) + 127) / 255;
+      }
+    }
+  }
+};
+
+static void BM_RasterDraw (benchmark::State &state,
+			   bool per_glyph,
+			   const test_input_t &input)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, state.range (0), state.range (0));
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  auto lines = shape_lines (font, text, text_length);
+
+  hb_raster_draw_t *draw = hb_raster_draw_create_or_fail ();
+  assert (draw);
+  if (state.range (1))
+    hb_raster_draw_set_outline_cache_max_bytes (draw, 4 << 20);
+  line_t line;
+
+  for (auto _ : state)
+    for (hb_buffer_t *buf : lines)
+    {
+      if (per_glyph)
+      {
+	line.init (font, buf, 1);
+	unsigned count;
+	hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buf, &count);
+	hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buf, nullptr);
+	float x = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+	  hb_raster_draw_set_transform (draw, 1, 0, 0, 1,
+					x + pos[i].x_offset, pos[i].y_offset);
+	  hb_raster_draw_glyph (draw, font, info[i].codepoint);
+	  hb_raster_image_t *image = hb_raster_draw_render (draw);
+	  line.composite (image);
+	  hb_raster_draw_recycle_image (draw, image);
+	  x += pos[i].x_advance;
+	}
+      }
+      else
+      {
+	hb_raster_draw_buffer (draw, font, buf);
+	hb_raster_draw_recycle_image (draw, hb_raster_draw_render (draw));
+      }
+    }
+
+  hb_raster_draw_destroy (draw);
+  for (hb_buffer_t *buf : lines)
+    hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+/* Like BM_RasterDraw per glyph, but rendering each glyph straight into
+ * its rectangle of the line image. */
+static void BM_RasterDrawInto (benchmark::State &state,
+			       const test_input_t &input)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, state.range (0), state.range (0));
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  auto lines = shape_lines (font, text, text_length);
+
+  hb_raster_draw_t *draw = hb_raster_draw_create_or_fail ();
+  assert (draw);
+  if (state.range (1))
+    hb_raster_draw_set_outline_cache_max_bytes (draw, 4 << 20);
+  hb_raster_image_t *image = hb_raster_image_create_or_fail ();
+  assert (image);
+  line_t line;
+
+  for (auto _ : state)
+    for (hb_buffer_t *buf : lines)
+    {
+      line.init (font, buf, 1);
+      unsigned count;
+      hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buf, &count);
+      hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buf, nullptr);
+      float x = 0;
+      for (unsigned i = 0; i < count; i++)
+      {
+	hb_raster_draw_set_transform (draw, 1, 0, 0, 1,
+				      x + pos[i].x_offset, pos[i].y_offset);
+	x += pos[i].x_advance;
+
+	hb_glyph_extents_t glyph_extents;
+	hb_raster_extents_t ext;
+	if (!hb_font_get_glyph_extents (font, info[i].codepoint, &glyph_extents) ||
+	    !hb_raster_draw_set_glyph_extents (draw, &glyph_extents) ||
+	    !hb_raster_draw_get_extents (draw, &ext))
+	  continue;
+
+	/* Clip to the line. */
+	int x0 = std::max (ext.x_origin, line.x_origin);
+	int y0 = std::max (ext.y_origin, line.y_origin);
+	int x1 = std::min (ext.x_origin + (int) ext.width, line.x_origin + (int) line.width);
+	int y1 = std::min (ext.y_origin + (int) ext.height, line.y_origin + (int) line.height);
+	if (x0 >= x1 || y0 >= y1)
+	{
+	  hb_raster_draw_clear (draw);
+	  continue;
+	}
+	ext = {x0, y0, (unsigned) (x1 - x0), (unsigned) (y1 - y0), line.width};
+	hb_raster_draw_set_extents (draw, &ext);
+
+	uint8_t *data = line.pixels.data () +
+			(size_t) (y0 - line.y_origin) * line.width + (x0 - line.x_origin);
+	hb_raster_image_configure_for_data (image, HB_RASTER_FORMAT_A8, &ext, data);
+	hb_raster_draw_glyph (draw, font, info[i].codepoint);
+	hb_raster_draw_render_into (draw, image);
+      }
+    }
+
+  hb_raster_image_destroy (image);
+  hb_raster_draw_destroy (draw);
+  for (hb_buffer_t *buf : lines)
+    hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+static void BM_RasterDrawPage (benchmark::State &state,
+			       const test_input_t &input)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, state.range (0), state.range (0));
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  auto lines = shape_lines (font, text, text_length);
+
+  hb_font_extents_t extents;
+  hb_font_get_h_extents (font, &extents);
+  int line_height = extents.ascender - extents.descender + extents.line_gap;
+
+  hb_raster_draw_t *draw = hb_raster_draw_create_or_fail ();
+  assert (draw);
+  hb_raster_draw_set_num_threads (draw, state.range (1));
+
+  for (auto _ : state)
+    for (unsigned page = 0; page < lines.size (); page += PAGE_LINES)
+    {
+      for (unsigned i = page; i < lines.size () && i < page + PAGE_LINES; i++)
+      {
+	hb_raster_draw_set_transform (draw, 1, 0, 0, 1,
+				      0, -(float) ((i - page) * line_height));
+	hb_raster_draw_buffer (draw, font, lines[i]);
+      }
+      hb_raster_draw_recycle_image (draw, hb_raster_draw_render (draw));
+    }
+
+  hb_raster_draw_destroy (draw);
+  for (hb_buffer_t *buf : lines)
+    hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+static void BM_RasterPaint (benchmark::State &state,
+			    bool per_glyph,
+			    const test_input_t &input)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, state.range (0), state.range (0));
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  auto lines = shape_lines (font, text, text_length);
+
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  assert (paint);
+  line_t line;
+
+  for (auto _ : state)
+    for (hb_buffer_t *buf : lines)
+    {
+      if (per_glyph)
+      {
+	line.init (font, buf, 4);
+	unsigned count;
+	hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buf, &count);
+	hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buf, nullptr);
+	float x = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+	  hb_raster_paint_set_transform (paint, 1, 0, 0, 1,
+					 x + pos[i].x_offset, pos[i].y_offset);
+	  hb_raster_paint_glyph (paint, font, info[i].codepoint);
+	  hb_raster_image_t *image = hb_raster_paint_render (paint);
+	  if (image)
+	  {
+	    line.composite (image);
+	    hb_raster_paint_recycle_image (paint, image);
+	  }
+	  x += pos[i].x_advance;
+	}
+      }
+      else
+      {
+	hb_raster_paint_buffer (paint, font, buf);
+	hb_raster_image_t *image = hb_raster_paint_render (paint);
+	if (image)
+	  hb_raster_paint_recycle_image (paint, image);
+      }
+    }
+
+  hb_raster_paint_destroy (paint);
+  for (hb_buffer_t *buf : lines)
+    hb_buffer_destroy (buf);
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
+static void BM_RasterPaintColr (benchmark::State &state,
+				const char *font_path)
+{
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (font_path, 0);
+  assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, state.range (0), state.range (0));
+  unsigned glyph_count = hb_face_get_glyph_count (face);
+  hb_face_destroy (face);
+
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  assert (paint);
+
+  uint64_t pixels = 0;
+  for (auto _ : state)
+    for (unsigned g = 0; g < glyph_count; g++)
+    {
+      hb_raster_paint_glyph (paint, font, g);
+      hb_raster_image_t *image = hb_raster_paint_render (paint);
+      if (image)
+      {
+	hb_raster_extents_t ext;
+	hb_raster_image_get_extents (image, &ext);
+	pixels += (uint64_t) ext.width * ext.height;
+	hb_raster_paint_recycle_image (paint, image);
+      }
+    }
+  state.counters["pixels"] = benchmark::Counter ((double) pixels,
+						 benchmark::Counter::kIsRate);
+
+  hb_raster_paint_destroy (paint);
+  hb_font_destroy (font);
+}
+
+int main (int argc, char **argv)
+{
+  benchmark::Initialize (&argc, argv);
+
+  for (const auto &input : tests)
+    for (bool per_glyph : {true, false})
+    {
+      char name[1024];
+      snprintf (name, sizeof (name), "BM_RasterDraw/%s/%s/%s",
+		strrchr (input.font_path, '/') + 1,
+		strrchr (input.text_path, '/') + 1,
+		per_glyph ? "glyph" : "buffer");
+      benchmark::RegisterBenchmark (name, BM_RasterDraw, per_glyph, input)
+       ->ArgsProduct ({{16, 64}, {0, 1}})
+       ->ArgNames ({"size", "cache"})
+       ->Unit (benchmark::kMillisecond);
+
+      if (per_glyph)
+      {
+	snprintf (name, sizeof (name), "BM_RasterDraw/%s/%s/into",
+		  strrchr (input.font_path, '/') + 1,
+		  strrchr (input.text_path, '/') + 1);
+	benchmark::RegisterBenchmark (name, BM_RasterDrawInto, input)
+	 ->ArgsProduct ({{16, 64}, {0, 1}})
+	 ->ArgNames ({"size", "cache"})
+	 ->Unit (benchmark::kMillisecond);
+      }
+
+      snprintf (name, sizeof (name), "BM_RasterPaint/%s/%s/%s",
+		strrchr (input.font_path, '/') + 1,
+		strrchr (input.text_path, '/') + 1,
+		per_glyph ? "glyph" : "buffer");
+      benchmark::RegisterBenchmark (name, BM_RasterPaint, per_glyph, input)
+       ->Arg (16)->Arg (64)
+       ->Unit (benchmark::kMillisecond);
+    }
+
+  for (const auto &input : tests)
+  {
+    char name[1024];
+    snprintf (name, sizeof (name), "BM_RasterDrawPage/%s/%s",
+	      strrchr (input.font_path, '/') + 1,
+	      strrchr (input.text_path, '/') + 1);
+    benchmark::RegisterBenchmark (name, BM_RasterDrawPage, input)
+     ->ArgsProduct ({{16, 64}, {1, 4}})
+     ->ArgNames ({"size", "threads"})
+     ->UseRealTime ()
+     ->Unit (benchmark::kMillisecond);
+  }
+
+  for (const char *font_path : colr_fonts)
+  {
+    char name[1024];
+    snprintf (name, sizeof (name), "BM_RasterPaintColr/%s",
+	      strrchr (font_path, '/') + 1);
+    benchmark::RegisterBenchmark (name, BM_RasterPaintColr, font_path)
+     ->Arg (64)->Arg (256)
+     ->Unit (benchmark::kMillisecond);
+  }
+
+  benchmark::RunSpecifiedBenchmarks ();
+  benchmark::Shutdown ();
+}
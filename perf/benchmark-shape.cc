@@ -1,6 +1,7 @@
 #include "hb-benchmark.hh"
 
 #include <glib.h>
+#include <thread>
 
 #define SUBSET_FONT_BASE_PATH "test/subset/data/fonts/"
 
@@ -46,6 +47,13 @@ static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
 const char *variation = nullptr;
 const char *direction = nullptr;
 
+static void set_direction (hb_buffer_t *buf)
+{
+  hb_buffer_guess_segment_properties (buf);
+  if (direction)
+    hb_buffer_set_direction (buf, hb_direction_from_string (direction, -1));
+}
+
 static bool shape (hb_buffer_t *buf,
 		   hb_font_t *font,
 		   const char *text,
@@ -57,9 +65,7 @@ static bool shape (hb_buffer_t *buf,
   {
     hb_buffer_clear_contents (buf);
     hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
-    hb_buffer_guess_segment_properties (buf);
-    if (direction)
-      hb_buffer_set_direction (buf, hb_direction_from_string (direction, -1));
+    set_direction (buf);
     const char *shaper_list[] = {shaper, nullptr};
     if (!hb_shape_full (font, buf, nullptr, 0, shaper_list))
       return false;
@@ -71,10 +77,85 @@ static bool shape (hb_buffer_t *buf,
   return true;
 }
 
+/* Same as shape(), but fills one buffer per line and shapes them
+ * BATCH_SIZE at a time with hb_shape_batch(). */
+#define BATCH_SIZE 64
+static bool shape_batch (hb_buffer_t **bufs,
+			 hb_font_t *font,
+			 const char *text,
+			 unsigned text_length,
+			 const char *shaper)
+{
+  const char *shaper_list[] = {shaper, nullptr};
+  unsigned num_bufs = 0;
+  const char *end;
+  while ((end = (const char *) memchr (text, '\n', text_length)))
+  {
+    hb_buffer_t *buf = bufs[num_bufs++];
+    hb_buffer_clear_contents (buf);
+    hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+    set_direction (buf);
+
+    if (num_bufs == BATCH_SIZE)
+    {
+      if (!hb_shape_batch (font, bufs, num_bufs, nullptr, 0, shaper_list))
+	return false;
+      num_bufs = 0;
+    }
+
+    unsigned skip = end - text + 1;
+    text_length -= skip;
+    text += skip;
+  }
+  return hb_shape_batch (font, bufs, num_bufs, nullptr, 0, shaper_list);
+}
+
+/* Same as shape(), but through a shaped-word cache. */
+static bool shape_cached (hb_buffer_t *buf,
+			  hb_shape_cache_t *cache,
+			  hb_font_t *font,
+			  const char *text,
+			  unsigned text_length,
+			  const char *shaper)
+{
+  const char *shaper_list[] = {shaper, nullptr};
+  const char *end;
+  while ((end = (const char *) memchr (text, '\n', text_length)))
+  {
+    hb_buffer_clear_contents (buf);
+    hb_buffer_add_utf8 (buf, text, text_length, 0, end - text);
+    set_direction (buf);
+    if (!hb_shape_cached (font, buf, nullptr, 0, shaper_list, cache))
+      return false;
+
+    unsigned skip = end - text + 1;
+    text_length -= skip;
+    text += skip;
+  }
+  return true;
+}
+
+enum shape_mode_t
+{
+  SHAPE_MODE_PLAIN,
+  SHAPE_MODE_BATCH,
+  SHAPE_MODE_CACHED,
+};
+
+static unsigned count_lines (const char *text, unsigned text_length)
+{
+  unsigned count = 0;
+  for (unsigned i = 0; i < text_length; i++)
+    count += text[i] == '\n';
+  return count;
+}
+
 static void BM_Shape (benchmark::State &state,
 		      const char *shaper,
+		      shape_mode_t mode,
 		      const test_input_t &input)
 {
+  bool batch = mode == SHAPE_MODE_BATCH;
   hb_font_t *font;
   {
     hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
@@ -94,11 +175,36 @@ static void BM_Shape (benchmark::State &state,
   assert (text_blob);
   unsigned text_length;
   const char *text = hb_blob_get_data (text_blob, &text_length);
+  unsigned num_lines = count_lines (text, text_length);
 
   hb_buffer_t *buf = hb_buffer_create ();
+  hb_shape_cache_t *cache = nullptr;
+  hb_buffer_t **bufs = nullptr;
+  if (batch)
+  {
+    bufs = (hb_buffer_t **) calloc (BATCH_SIZE, sizeof (bufs[0]));
+    for (unsigned i = 0; i < BATCH_SIZE; i++)
+      bufs[i] = hb_buffer_create ();
+  }
+  if (mode == SHAPE_MODE_CACHED)
+  {
+    cache = hb_shape_cache_create ();
+    assert (cache);
+  }
 
-  // Shape once, to warm up the font and buffer.
-  bool ret = shape (buf, font, text, text_length, shaper);
+  auto run = [&] ()
+  {
+    switch (mode)
+    {
+    case SHAPE_MODE_BATCH:  return shape_batch (bufs, font, text, text_length, shaper);
+    case SHAPE_MODE_CACHED: return shape_cached (buf, cache, font, text, text_length, shaper);
+    case SHAPE_MODE_PLAIN:  default: break;
+    }
+    return shape (buf, font, text, text_length, shaper);
+  };
+
+  // Shape once, to warm up the font and buffer; and the cache, if any.
+  bool ret = run ();
   if (!ret)
   {
     state.SkipWithMessage ("Shaping failed.");
@@ -107,23 +213,122 @@ static void BM_Shape (benchmark::State &state,
 
   for (auto _ : state)
   {
-    bool ret = shape (buf, font, text, text_length, shaper);
-    if (!ret)
+    if (!run ())
       abort ();
   }
 
+  if (cache)
+  {
+    /* Words found in the cache, and words that were not. */
+    unsigned hits, misses;
+    hb_shape_cache_get_stats (cache, &hits, &misses);
+    state.counters["hits"] = hits;
+    state.counters["misses"] = misses;
+  }
+
+  /* For the word lists, this is words per second. */
+  state.counters["lines"] = benchmark::Counter (num_lines,
+						benchmark::Counter::kIsIterationInvariantRate);
+
 done:
+  if (bufs)
+  {
+    for (unsigned i = 0; i < BATCH_SIZE; i++)
+      hb_buffer_destroy (bufs[i]);
+    free (bufs);
+  }
+  hb_shape_cache_destroy (cache);
   hb_buffer_destroy (buf);
 
   hb_blob_destroy (text_blob);
   hb_font_destroy (font);
 }
 
+/* Shapes the whole text, one buffer per line, with hb_shape_parallel()
+ * on state.range(0) threads. */
+static void BM_ShapeParallel (benchmark::State &state,
+			      const test_input_t &input)
+{
+  unsigned num_threads = state.range (0);
+
+  hb_font_t *font;
+  {
+    hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (input.font_path, 0);
+    assert (face);
+    font = hb_font_create (face);
+    hb_face_destroy (face);
+  }
+
+  if (variation)
+  {
+    hb_variation_t var;
+    hb_variation_from_string (variation, -1, &var);
+    hb_font_set_variations (font, &var, 1);
+  }
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  unsigned num_lines = count_lines (text, text_length);
+
+  hb_buffer_t **bufs = (hb_buffer_t **) calloc (num_lines, sizeof (bufs[0]));
+  for (unsigned i = 0; i < num_lines; i++)
+    bufs[i] = hb_buffer_create ();
+
+  auto fill = [&] ()
+  {
+    unsigned offset = 0;
+    for (unsigned i = 0; i < num_lines; i++)
+    {
+      const char *end = (const char *) memchr (text + offset, '\n', text_length - offset);
+      hb_buffer_clear_contents (bufs[i]);
+      hb_buffer_add_utf8 (bufs[i], text, text_length, offset, end - text - offset);
+      set_direction (bufs[i]);
+      offset = end - text + 1;
+    }
+  };
+
+  // Shape once, to warm up the font and buffers.
+  fill ();
+  if (!hb_shape_parallel (font, bufs, num_lines, nullptr, 0, nullptr, num_threads))
+  {
+    state.SkipWithMessage ("Shaping failed.");
+    goto done;
+  }
+
+  for (auto _ : state)
+  {
+    state.PauseTiming ();
+    fill ();
+    state.ResumeTiming ();
+
+    if (!hb_shape_parallel (font, bufs, num_lines, nullptr, 0, nullptr, num_threads))
+      abort ();
+  }
+
+  state.counters["lines"] = benchmark::Counter (num_lines,
+						benchmark::Counter::kIsIterationInvariantRate);
+
+done:
+  for (unsigned i = 0; i < num_lines; i++)
+    hb_buffer_destroy (bufs[i]);
+  free (bufs);
+
+  hb_blob_destroy (text_blob);
+  hb_font_destroy (font);
+}
+
 static void test_shaper (const char *shaper,
+			 shape_mode_t mode,
 			 const test_input_t &test_input)
 {
   char name[1024] = "BM_Shape";
   const char *p;
+  if (mode == SHAPE_MODE_BATCH)
+    strcat (name, "Batch");
+  if (mode == SHAPE_MODE_CACHED)
+    strcat (name, "Cached");
   strcat (name, "/");
   p = strrchr (test_input.font_path, '/');
   strcat (name, p ? p + 1 : test_input.font_path);
@@ -133,7 +338,29 @@ static void test_shaper (const char *shaper,
   strcat (name, "/");
   strcat (name, shaper);
 
-  benchmark::RegisterBenchmark (name, BM_Shape, shaper, test_input)
+  benchmark::RegisterBenchmark (name, BM_Shape, shaper, mode, test_input)
+   ->Unit(benchmark::kMillisecond);
+}
+
+static void test_parallel (const test_input_t &test_input)
+{
+  char name[1024] = "BM_ShapeParallel";
+  const char *p;
+  strcat (name, "/");
+  p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+  strcat (name, "/");
+  p = strrchr (test_input.text_path, '/');
+  strcat (name, p ? p + 1 : test_input.text_path);
+
+  /* Thread counts up to the number of processors, to show scaling. */
+  unsigned max_threads = std::thread::hardware_concurrency ();
+  if (!max_threads) max_threads = 1;
+  auto *b = benchmark::RegisterBenchmark (name, BM_ShapeParallel, test_input);
+  for (unsigned n = 1; n < max_threads; n *= 2)
+    b->Arg (n);
+  b->Arg (max_threads)
+   ->UseRealTime()
    ->Unit(benchmark::kMillisecond);
 }
 
@@ -231,7 +458,18 @@ int main(int argc, char** argv)
     auto& test_input = tests[i];
     const char **shapers = hb_shape_list_shapers ();
     for (const char **shaper = shapers; *shaper; shaper++)
-      test_shaper (*shaper, test_input);
+      test_shaper (*shaper, SHAPE_MODE_PLAIN, test_input);
+
+    /* Batched shaping pays off for many short runs; compare it on the
+     * word lists. */
+    if (strstr (test_input.text_path, "-words.txt"))
+      test_shaper ("ot", SHAPE_MODE_BATCH, test_input);
+
+    /* The word cache pays off for running text that repeats words. */
+    if (strstr (test_input.text_path, "-thelittleprince.txt"))
+      test_shaper ("ot", SHAPE_MODE_CACHED, test_input);
+
+    test_parallel (test_input);
   }
 
   benchmark::RunSpecifiedBenchmarks();
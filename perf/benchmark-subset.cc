@@ -205,6 +205,91 @@ static void BM_subset (benchmark::State &state,
   hb_face_destroy (face);
 }
 
+enum plan_mode_t
+{
+  plan_fresh,
+  plan_extended,
+  plan_depend,
+};
+
+/* benchmark for planning a subset from scratch, versus extending a plan
+ * for most of the same codepoints, or closing over a depend graph */
+static void BM_subset_plan (benchmark::State &state,
+                            const test_input_t &test_input,
+                            plan_mode_t mode)
+{
+  unsigned subset_size = state.range(0);
+
+  hb_face_t *face = hb_benchmark_face_create_from_file_or_fail (test_input.font_path, 0);
+  assert (face);
+  face = preprocess_face (face);
+
+  hb_set_t* all_codepoints = hb_set_create ();
+  hb_face_collect_unicodes (face, all_codepoints);
+
+  hb_subset_input_t* input = hb_subset_input_create_or_fail ();
+  assert (input);
+  AddCodepoints(all_codepoints, subset_size, input);
+
+  /* The last tenth of the codepoints are the ones the plan is extended by. */
+  hb_set_t *added = hb_set_create ();
+  auto *unicodes = hb_subset_input_unicode_set (input);
+  unsigned num_added = hb_set_get_population (unicodes) / 10;
+  hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+  for (unsigned i = 0; i < num_added && hb_set_previous (unicodes, &cp); i++)
+    hb_set_add (added, cp);
+
+  bool extended = mode == plan_extended;
+  hb_subset_plan_t *base = nullptr;
+  if (extended)
+  {
+    hb_set_subtract (unicodes, added);
+    base = hb_subset_plan_create_or_fail (face, input);
+    assert (base);
+  }
+
+#ifdef HB_EXPERIMENTAL_API
+  if (mode == plan_depend)
+  {
+    hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+    assert (depend);
+    hb_subset_input_set_depend (input, depend);
+    hb_subset_depend_destroy (depend);
+  }
+#endif
+
+  for (auto _ : state)
+  {
+    hb_subset_plan_t *plan = extended
+			   ? hb_subset_plan_create_extended_or_fail (base, added, nullptr)
+			   : hb_subset_plan_create_or_fail (face, input);
+    assert (plan);
+    hb_subset_plan_destroy (plan);
+  }
+
+  hb_subset_plan_destroy (base);
+  hb_set_destroy (added);
+  hb_subset_input_destroy (input);
+  hb_set_destroy (all_codepoints);
+  hb_face_destroy (face);
+}
+
+static void test_subset_plan (plan_mode_t mode,
+                              const char *mode_name,
+                              benchmark::TimeUnit time_unit,
+                              const test_input_t &test_input)
+{
+  char name[1024] = "BM_subset_plan/";
+  strcat (name, mode_name);
+  strcat (name, "/");
+  const char *p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+
+  benchmark::RegisterBenchmark (name, BM_subset_plan, test_input, mode)
+      ->Range(10, test_input.max_subset_size)
+      ->Unit(time_unit);
+}
+
 static void test_subset (operation_t op,
                          const char *op_name,
                          bool retain_gids,
@@ -268,6 +353,15 @@ int main(int argc, char** argv)
 
 #undef TEST_OPERATION
 
+  for (unsigned i = 0; i < num_tests; i++)
+  {
+    test_subset_plan (plan_fresh, "fresh", benchmark::kMicrosecond, tests[i]);
+    test_subset_plan (plan_extended, "extended", benchmark::kMicrosecond, tests[i]);
+#ifdef HB_EXPERIMENTAL_API
+    test_subset_plan (plan_depend, "depend", benchmark::kMicrosecond, tests[i]);
+#endif
+  }
+
   benchmark::RunSpecifiedBenchmarks();
   benchmark::Shutdown();
 
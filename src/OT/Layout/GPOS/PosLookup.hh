@@ -20,6 +20,24 @@ struct PosLookup : Lookup
     return false;
   }
 
+  /* Whether the lookup only does single adjustment, possibly through
+   * Extension subtables. */
+  bool is_single () const
+  {
+    unsigned int type = get_type ();
+    unsigned int count = get_subtable_count ();
+    if (!count) return false;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int subtable_type = type;
+      if (unlikely (type == SubTable::Extension) && hb_barrier ())
+	subtable_type = get_subtable (i).u.extension.get_type ();
+      if (subtable_type != SubTable::Single)
+	return false;
+    }
+    return true;
+  }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -29,6 +29,24 @@ struct SubstLookup : Lookup
     return lookup_type_is_reverse (type);
   }
 
+  /* Whether the lookup only does single substitution, possibly through
+   * Extension subtables. */
+  bool is_single () const
+  {
+    unsigned int type = get_type ();
+    unsigned int count = get_subtable_count ();
+    if (!count) return false;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      unsigned int subtable_type = type;
+      if (unlikely (type == SubTable::Extension) && hb_barrier ())
+	subtable_type = get_subtable (i).u.extension.get_type ();
+      if (subtable_type != SubTable::Single)
+	return false;
+    }
+    return true;
+  }
+
   bool may_have_non_1to1 () const
   {
     hb_have_non_1to1_context_t c;
@@ -22,14 +22,25 @@ if '--experimental-api' not in sys.argv:
 """hb_shape_justify
 hb_subset_input_override_name_table
 hb_subset_input_to_string_or_fail
+hb_subset_cache_create_or_fail
+hb_subset_cache_reference
+hb_subset_cache_destroy
+hb_subset_cache_set_max_bytes
+hb_subset_cache_get_stats
+hb_subset_cached_or_fail
 hb_subset_cff_get_charstring_data
 hb_subset_cff_get_charstrings_index
 hb_subset_cff2_get_charstring_data
 hb_subset_cff2_get_charstrings_index
 hb_subset_depend_from_face_or_fail
+hb_subset_depend_from_blob_or_fail
+hb_subset_depend_reference
 hb_subset_depend_lookup_glyph
 hb_subset_depend_lookup_set
+hb_subset_depend_serialize_or_fail
 hb_subset_depend_destroy
+hb_subset_input_set_depend
+hb_subset_input_get_depend
 """.splitlines ()
 	symbols = [x for x in symbols if x not in experimental_symbols]
 symbols = "\n".join (symbols)
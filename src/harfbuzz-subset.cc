@@ -54,6 +54,7 @@
 #include "hb-shaper.cc"
 #include "hb-static.cc"
 #include "hb-style.cc"
+#include "hb-subset-cache.cc"
 #include "hb-subset-cff-common.cc"
 #include "hb-subset-cff1.cc"
 #include "hb-subset-cff2.cc"
@@ -40,6 +40,7 @@
 #include "hb-common.cc"
 #include "hb-draw.cc"
 #include "hb-face-builder.cc"
+#include "hb-face-snapshot.cc"
 #include "hb-face.cc"
 #include "hb-fallback-shape.cc"
 #include "hb-font.cc"
@@ -79,6 +80,7 @@
 #include "hb-paint-extents.cc"
 #include "hb-paint.cc"
 #include "hb-set.cc"
+#include "hb-shape-cache.cc"
 #include "hb-shape-plan.cc"
 #include "hb-shape.cc"
 #include "hb-shaper.cc"
@@ -124,6 +126,7 @@
 #endif
 
 #ifdef HB_HAS_GPU
+#include "hb-gpu-atlas.cc"
 #include "hb-gpu-draw.cc"
 #include "hb-gpu-paint.cc"
 #include "hb-gpu.cc"
@@ -135,6 +138,7 @@
 #endif
 
 #ifdef HB_HAS_RASTER
+#include "hb-raster-atlas.cc"
 #include "hb-raster-draw.cc"
 #include "hb-raster-image.cc"
 #include "hb-raster-paint.cc"
@@ -148,6 +152,7 @@
 #include "hb-ot-cff1-table.cc"
 #include "hb-ot-cff2-table.cc"
 #include "hb-static.cc"
+#include "hb-subset-cache.cc"
 #include "hb-subset-cff-common.cc"
 #include "hb-subset-cff1.cc"
 #include "hb-subset-cff2.cc"
@@ -42,6 +42,14 @@ struct hb_aat_map_t
     unsigned cluster_last; // end - 1
   };
 
+  size_t get_size () const
+  {
+    size_t size = chain_flags.get_size ();
+    for (const auto &flags : chain_flags)
+      size += flags.get_size ();
+    return size;
+  }
+
   public:
   hb_vector_t<hb_sorted_vector_t<range_flags_t>> chain_flags;
 };
@@ -166,6 +166,8 @@ struct hb_atomic_t
   T get_acquire () const { return v.load (std::memory_order_acquire); }
   T inc () { return v.fetch_add (1, std::memory_order_acq_rel); }
   T dec () { return v.fetch_add (-1, std::memory_order_acq_rel); }
+  T add (T v_) { return v.fetch_add (v_, std::memory_order_acq_rel); }
+  T sub (T v_) { return v.fetch_sub (v_, std::memory_order_acq_rel); }
 
   int operator++ (int) { return inc (); }
   int operator-- (int) { return dec (); }
@@ -231,6 +233,8 @@ struct hb_atomic_t
   T get_acquire () const { return hb_atomic_int_impl_get (&v); }
   T inc () { return hb_atomic_int_impl_add (&v,  1); }
   T dec () { return hb_atomic_int_impl_add (&v, -1); }
+  T add (T v_) { return hb_atomic_int_impl_add (&v,  v_); }
+  T sub (T v_) { return hb_atomic_int_impl_add (&v, -v_); }
 
   int operator ++ (int) { return inc (); }
   int operator -- (int) { return dec (); }
@@ -29,6 +29,8 @@
 
 #include "hb.hh"
 
+#include "hb-map.hh"
+
 
 /* Implements a lockfree and thread-safe cache for int->int functions,
  * using (optionally) _relaxed_ atomic integer operations.
@@ -122,4 +124,138 @@ struct hb_cache_t
 };
 
 
+/* Least-recently-used cache of variable-size entries, for the caches
+ * that keep results within a byte budget.
+ *
+ * Entries derive from hb_lru_link_t, are allocated with hb_malloc() by
+ * the caller, and are owned by the cache once inserted.  They are found
+ * through a map from the 32-bit hash of their key; entries sharing a
+ * hash are chained.  An entry_t provides:
+ *
+ *   size_t get_size () const;       Bytes charged against the budget.
+ *   bool equal (const key_t &key);  Whether it is the entry for @key.
+ *   void fini ();                   Releases what it holds.
+ *
+ * Not thread-safe; callers lock around it as they need.
+ */
+
+struct hb_lru_link_t
+{
+  hb_lru_link_t *prev;
+  hb_lru_link_t *next;
+  hb_lru_link_t *next_same_hash;
+  uint32_t hash;
+
+  void unlink ()
+  {
+    prev->next = next;
+    next->prev = prev;
+  }
+  void link_after (hb_lru_link_t *node)
+  {
+    prev = node;
+    next = node->next;
+    node->next->prev = this;
+    node->next = this;
+  }
+};
+
+template <typename entry_t>
+struct hb_lru_cache_t
+{
+  hb_lru_cache_t ()
+  {
+    lru.prev = lru.next = &lru;
+  }
+  ~hb_lru_cache_t ()
+  {
+    clear ();
+  }
+
+  hb_hashmap_t<uint32_t, entry_t *> entries;
+  hb_lru_link_t lru; /* Sentinel; most recently used first. */
+  size_t num_bytes = 0;
+
+  bool is_empty () const { return lru.next == &lru; }
+
+  entry_t *oldest ()
+  { return is_empty () ? nullptr : static_cast<entry_t *> (lru.prev); }
+
+  template <typename key_t>
+  entry_t *fetch (const key_t &key, uint32_t hash)
+  {
+    for (entry_t *entry = entries.get (hash);
+	 entry;
+	 entry = static_cast<entry_t *> (entry->next_same_hash))
+      if (entry->equal (key))
+      {
+	entry->unlink ();
+	entry->link_after (&lru);
+	return entry;
+      }
+    return nullptr;
+  }
+
+  /* Takes ownership of @entry, which is finalized and freed if it can
+   * not be added. */
+  bool insert (entry_t *entry, uint32_t hash)
+  {
+    entry->hash = hash;
+    entry->next_same_hash = entries.get (hash);
+    if (unlikely (!entries.set (hash, entry)))
+    {
+      /* The map is unchanged; let later inserts try again. */
+      entries.reset_error ();
+      entry->fini ();
+      hb_free (entry);
+      return false;
+    }
+
+    entry->link_after (&lru);
+    num_bytes += entry->get_size ();
+    return true;
+  }
+
+  void remove (entry_t *entry)
+  {
+    entry->unlink ();
+
+    entry_t **head;
+    entries.has (entry->hash, &head);
+    if (*head == entry)
+    {
+      if (entry->next_same_hash)
+	*head = static_cast<entry_t *> (entry->next_same_hash);
+      else
+	entries.del (entry->hash);
+    }
+    else
+    {
+      hb_lru_link_t *node = *head;
+      while (node->next_same_hash != entry)
+	node = node->next_same_hash;
+      node->next_same_hash = entry->next_same_hash;
+    }
+
+    num_bytes -= entry->get_size ();
+    entry->fini ();
+    hb_free (entry);
+  }
+
+  /* Removes least-recently-used entries until at most @budget bytes are
+   * left. */
+  void evict (size_t budget)
+  {
+    while (num_bytes > budget && !is_empty ())
+      remove (oldest ());
+  }
+
+  void clear ()
+  {
+    while (!is_empty ())
+      remove (oldest ());
+  }
+};
+
+
 #endif /* HB_CACHE_HH */
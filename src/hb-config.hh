@@ -64,6 +64,7 @@
 #define HB_NO_BITMAP
 #define HB_NO_ERRNO
 #define HB_NO_FACE_COLLECT_UNICODES
+#define HB_NO_FACE_SNAPSHOT
 #define HB_NO_GETENV
 #define HB_NO_HINTING
 #define HB_NO_LAYOUT_FEATURE_PARAMS
@@ -188,7 +189,9 @@
 #ifdef HB_MINIMIZE_MEMORY_USAGE
 #define HB_NO_GDEF_CACHE
 #define HB_NO_OT_LAYOUT_LOOKUP_CACHE
+#define HB_NO_OT_LAYOUT_SUBTABLE_INDEX
 #define HB_NO_OT_FONT_CMAP_CACHE
+#define HB_NO_OT_FONT_CMAP_PAGES
 #endif
 
 #if defined(HAVE_CONFIG_OVERRIDE_LAST_H) || defined(HB_CONFIG_OVERRIDE_LAST_H)
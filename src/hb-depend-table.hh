@@ -0,0 +1,269 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Google Author(s): Garret Rieger
+ */
+
+#ifndef HB_DEPEND_TABLE_HH
+#define HB_DEPEND_TABLE_HH
+
+#include "hb-open-type.hh"
+#include "hb-depend-data.hh"
+
+/*
+ * Serialized glyph dependency graph, as written by
+ * hb_subset_depend_serialize_or_fail().
+ *
+ * The edges of all glyphs are stored in one array, in glyph order, with
+ * glyphEdges[gid] to glyphEdges[gid + 1] delimiting those of gid.  Sets
+ * are stored the same way, as sorted glyph (or context element) runs.
+ * Everything is read in place, so a graph can be used straight from a
+ * read-only mapping of the file.  Out of range indices read as empty,
+ * which keeps sanitizing down to bounds checks on the arrays.
+ */
+#define HB_DEPEND_GRAPH_TAG HB_TAG('h','b','d','p')
+
+
+namespace OT {
+
+struct DependEdgeRecord
+{
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (c->check_struct (this));
+  }
+
+  public:
+  HBUINT8	tableIndex;	/* Index of the source table tag in
+				 * tableTags. */
+  HBUINT8	flags;		/* hb_subset_depend_edge_flags_t. */
+  HBUINT16	layoutIndex;	/* Index of the feature tag in
+				 * layoutTags. */
+  HBUINT32	dependent;	/* Glyph the edge leads to. */
+  HBUINT32	ligatureSet;	/* Set of ligature components, or
+				 * 0xFFFFFFFF. */
+  HBUINT32	contextSet;	/* Set of context requirements, or
+				 * 0xFFFFFFFF. */
+  public:
+  DEFINE_SIZE_STATIC (16);
+};
+
+struct DependGraph
+{
+  static constexpr hb_tag_t tableTag = HB_DEPEND_GRAPH_TAG;
+
+  unsigned get_glyph_count () const { return glyphCount; }
+
+  hb_array_t<const DependEdgeRecord> get_edges (hb_codepoint_t gid) const
+  {
+    if (gid >= glyphCount) return hb_array_t<const DependEdgeRecord> ();
+    const auto &starts = this+glyphEdges;
+    unsigned start = starts[gid];
+    unsigned end = hb_min ((unsigned) starts[gid + 1], (unsigned) edgeCount);
+    if (start >= end) return hb_array_t<const DependEdgeRecord> ();
+    return (this+edges).as_array (end).sub_array (start);
+  }
+
+  hb_depend_edge_t get_edge (const DependEdgeRecord &record) const
+  {
+    return hb_depend_edge_t ((this+tableTags)[record.tableIndex],
+			     record.dependent,
+			     (this+layoutTags)[record.layoutIndex],
+			     record.ligatureSet,
+			     record.contextSet,
+			     (hb_subset_depend_edge_flags_t) (record.flags &
+							      (HB_SUBSET_DEPEND_EDGE_FLAG_FROM_CONTEXT_POSITION |
+							       HB_SUBSET_DEPEND_EDGE_FLAG_FROM_NESTED_CONTEXT)));
+  }
+
+  bool has_set (hb_codepoint_t index) const
+  { return index < setCount; }
+
+  hb_array_t<const HBUINT32> get_set (hb_codepoint_t index) const
+  {
+    if (index >= setCount) return hb_array_t<const HBUINT32> ();
+    const auto &starts = this+setStarts;
+    unsigned start = starts[index];
+    unsigned end = hb_min ((unsigned) starts[index + 1], (unsigned) setGlyphCount);
+    if (start >= end) return hb_array_t<const HBUINT32> ();
+    return (this+setGlyphs).as_array (end).sub_array (start);
+  }
+
+  /* Bytes needed to serialize data, or 0 if it can not be. */
+  static unsigned get_size (const hb_depend_data_t &data,
+			    unsigned num_table_tags,
+			    unsigned num_layout_tags)
+  {
+    if (num_table_tags > 0xFFu || num_layout_tags > 0xFFFFu)
+      return 0;
+
+    uint64_t edge_count = 0;
+    for (const auto &g : data.glyph_dependencies)
+      edge_count += g.dependencies.length;
+    uint64_t set_glyph_count = 0;
+    for (const auto &s : data.sets)
+      set_glyph_count += s->get_population ();
+
+    uint64_t size = min_size
+		  + HBUINT8::static_size + num_table_tags * Tag::static_size
+		  + HBUINT16::static_size + num_layout_tags * Tag::static_size
+		  + (data.glyph_dependencies.length + 1ull) * HBUINT32::static_size
+		  + edge_count * DependEdgeRecord::static_size
+		  + (data.sets.length + 1ull) * HBUINT32::static_size
+		  + set_glyph_count * HBUINT32::static_size;
+    return size < 0x80000000u ? (unsigned) size : 0;
+  }
+
+  template <typename Iterator,
+	    hb_requires (hb_is_iterator (Iterator))>
+  bool serialize (hb_serialize_context_t *c,
+		  const hb_depend_data_t &data,
+		  Iterator table_tags,
+		  Iterator layout_tags,
+		  const hb_map_t &table_indices,
+		  const hb_map_t &layout_indices)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (this))) return_trace (false);
+
+    magic = HB_DEPEND_GRAPH_TAG;
+    version.major = 1;
+    version.minor = 0;
+    glyphCount = data.glyph_dependencies.length;
+    setCount = data.sets.length;
+
+    if (unlikely (!serialize_offset (c, tableTags))) return_trace (false);
+    auto *table_tags_out = c->start_embed<ArrayOf<Tag, HBUINT8>> ();
+    if (unlikely (!table_tags_out->serialize (c, table_tags))) return_trace (false);
+    if (unlikely (!serialize_offset (c, layoutTags))) return_trace (false);
+    auto *layout_tags_out = c->start_embed<Array16Of<Tag>> ();
+    if (unlikely (!layout_tags_out->serialize (c, layout_tags))) return_trace (false);
+
+    /* Edge runs of each glyph, then the edges themselves. */
+    if (unlikely (!serialize_offset (c, glyphEdges))) return_trace (false);
+    HBUINT32 *starts = c->allocate_size<HBUINT32> ((glyphCount + 1) * HBUINT32::static_size, false);
+    if (unlikely (!starts)) return_trace (false);
+    unsigned edge_count = 0;
+    for (unsigned gid = 0; gid < glyphCount; gid++)
+    {
+      starts[gid] = edge_count;
+      edge_count += data.glyph_dependencies.arrayZ[gid].dependencies.length;
+    }
+    starts[glyphCount] = edge_count;
+    edgeCount = edge_count;
+
+    if (unlikely (!serialize_offset (c, edges))) return_trace (false);
+    for (const auto &g : data.glyph_dependencies)
+      for (const hb_depend_edge_t &e : g.dependencies)
+      {
+	DependEdgeRecord *record = c->allocate_size<DependEdgeRecord> (DependEdgeRecord::static_size, false);
+	if (unlikely (!record)) return_trace (false);
+	record->tableIndex = table_indices.get (e.table_tag);
+	record->flags = e.flags;
+	record->layoutIndex = layout_indices.get (e.layout_tag);
+	record->dependent = e.dependent;
+	record->ligatureSet = e.ligature_set;
+	record->contextSet = e.context_set;
+      }
+
+    /* Likewise for sets. */
+    if (unlikely (!serialize_offset (c, setStarts))) return_trace (false);
+    starts = c->allocate_size<HBUINT32> ((setCount + 1) * HBUINT32::static_size, false);
+    if (unlikely (!starts)) return_trace (false);
+    unsigned set_glyph_count = 0;
+    for (unsigned i = 0; i < setCount; i++)
+    {
+      starts[i] = set_glyph_count;
+      set_glyph_count += data.sets.arrayZ[i]->get_population ();
+    }
+    starts[setCount] = set_glyph_count;
+    setGlyphCount = set_glyph_count;
+
+    if (unlikely (!serialize_offset (c, setGlyphs))) return_trace (false);
+    for (const auto &s : data.sets)
+      for (hb_codepoint_t g : *s)
+      {
+	HBUINT32 *glyph = c->allocate_size<HBUINT32> (HBUINT32::static_size, false);
+	if (unlikely (!glyph)) return_trace (false);
+	*glyph = g;
+      }
+
+    return_trace (true);
+  }
+
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (likely (c->check_struct (this) &&
+			  hb_barrier () &&
+			  magic == HB_DEPEND_GRAPH_TAG &&
+			  version.major == 1 &&
+			  glyphCount < 0xFFFFFFFFu &&
+			  setCount < 0xFFFFFFFFu &&
+			  (this+tableTags).sanitize (c) &&
+			  (this+layoutTags).sanitize (c) &&
+			  c->check_array (&(this+glyphEdges), glyphCount + 1) &&
+			  c->check_array (&(this+edges), edgeCount) &&
+			  c->check_array (&(this+setStarts), setCount + 1) &&
+			  c->check_array (&(this+setGlyphs), setGlyphCount)));
+  }
+
+  protected:
+  template <typename T>
+  bool serialize_offset (hb_serialize_context_t *c, T &offset)
+  {
+    offset = 0;
+    return c->check_assign (offset,
+			    (unsigned) ((char *) c->head - (char *) this),
+			    HB_SERIALIZE_ERROR_OFFSET_OVERFLOW);
+  }
+
+  protected:
+  Tag		magic;		/* 'hbdp' */
+  FixedVersion<>version;	/* 1.0 */
+  HBUINT32	glyphCount;	/* Number of glyphs in the face. */
+  HBUINT32	edgeCount;	/* Total number of edges. */
+  HBUINT32	setCount;	/* Number of sets. */
+  HBUINT32	setGlyphCount;	/* Total number of set elements. */
+  NNOffset32To<ArrayOf<Tag, HBUINT8>>
+		tableTags;	/* Source table tags of edges. */
+  NNOffset32To<Array16Of<Tag>>
+		layoutTags;	/* Feature tags of edges, with 0 for
+				 * non-GSUB edges. */
+  NNOffset32To<UnsizedArrayOf<HBUINT32>>
+		glyphEdges;	/* glyphCount + 1 indices into edges. */
+  NNOffset32To<UnsizedArrayOf<DependEdgeRecord>>
+		edges;		/* Edges of all glyphs. */
+  NNOffset32To<UnsizedArrayOf<HBUINT32>>
+		setStarts;	/* setCount + 1 indices into setGlyphs. */
+  NNOffset32To<UnsizedArrayOf<HBUINT32>>
+		setGlyphs;	/* Sorted elements of all sets. */
+  public:
+  DEFINE_SIZE_STATIC (48);
+};
+
+} /* namespace OT */
+
+
+#endif /* HB_DEPEND_TABLE_HH */
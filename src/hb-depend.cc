@@ -103,6 +103,139 @@ hb_depend_data_builder_t::compile (hb_face_t *face)
   return successful;
 }
 
+hb_subset_depend_t::hb_subset_depend_t (hb_blob_t *blob_)
+{
+  blob = hb_sanitize_context_t ().sanitize_blob<OT::DependGraph> (hb_blob_reference (blob_));
+  graph = blob->as<OT::DependGraph> ();
+  successful = graph != &Null (OT::DependGraph);
+}
+
+bool
+hb_subset_depend_t::gsub_closure (const hb_set_t *features,
+				  hb_set_t *glyphs) const
+{
+  auto satisfied = [&] (const hb_depend_edge_t &e)
+  {
+    if (!set_all (e.ligature_set, [&] (hb_codepoint_t g) { return glyphs->has (g); }))
+      return false;
+
+    /* Context elements are either glyphs that must all be present, or
+     * references to sets at least one glyph of which must be. */
+    return set_all (e.context_set, [&] (hb_codepoint_t element)
+    {
+      if (element < HB_DEPEND_CONTEXT_SET_FLAG)
+	return glyphs->has (element);
+      return set_intersects (element & ~HB_DEPEND_CONTEXT_SET_FLAG, glyphs);
+    });
+  };
+
+  /* Walked in stages, one per generation of added glyphs, under the same
+   * stage limit as hb_ot_layout_lookups_substitute_closure() and an
+   * operation budget in the manner of the shaping one.  The lookup closure
+   * stops short of the full closure at its limits; hitting ours undoes
+   * what was added, so that it closes the original glyphs instead, just as
+   * without the graph. */
+  int max_ops;
+  unsigned mul;
+  if (likely (!hb_unsigned_mul_overflows (get_glyph_count (), HB_DEPEND_CLOSURE_MAX_OPS_FACTOR, &mul)))
+    max_ops = (int) hb_min (hb_max (mul, (unsigned) HB_DEPEND_CLOSURE_MAX_OPS_MIN), (unsigned) INT_MAX);
+  else
+    max_ops = INT_MAX;
+
+  hb_vector_t<hb_codepoint_t> queue, next, added;
+  hb_vector_t<hb_depend_edge_t> pending, flagged;
+  queue.alloc (glyphs->get_population ());
+  for (hb_codepoint_t gid : *glyphs)
+    queue.push (gid);
+
+  /* Glyphs are only added once recorded, so that they can be taken out
+   * again whatever stops the walk. */
+  auto add = [&] (hb_codepoint_t gid)
+  {
+    added.push (gid);
+    if (unlikely (added.in_error ()))
+      return;
+    glyphs->add (gid);
+    next.push (gid);
+  };
+
+  bool limited = false;
+  for (unsigned stage = 0; queue; stage++)
+  {
+    if (unlikely (stage > HB_CLOSURE_MAX_STAGES))
+    {
+      limited = true;
+      break;
+    }
+
+    for (hb_codepoint_t gid : queue)
+    {
+      for_each_edge (gid, [&] (const hb_depend_edge_t &e)
+      {
+	max_ops--;
+	if (e.table_tag != HB_OT_TAG_GSUB ||
+	    !features->has (e.layout_tag) ||
+	    glyphs->has (e.dependent))
+	  return;
+
+	if (e.flags & (HB_SUBSET_DEPEND_EDGE_FLAG_FROM_CONTEXT_POSITION |
+		       HB_SUBSET_DEPEND_EDGE_FLAG_FROM_NESTED_CONTEXT))
+	  flagged.push (e);
+	else if (satisfied (e))
+	  add (e.dependent);
+	else
+	  pending.push (e);
+      });
+      if (unlikely (max_ops < 0))
+	break;
+    }
+
+    /* Ligature components and context glyphs may have been added in this
+     * stage; the edges waiting on them are looked at again once per stage,
+     * which the stage limit keeps linear. */
+    unsigned j = 0;
+    for (const hb_depend_edge_t &e : pending)
+    {
+      if (glyphs->has (e.dependent))
+	continue;
+      max_ops--;
+      if (satisfied (e))
+	add (e.dependent);
+      else
+	pending.arrayZ[j++] = e;
+    }
+    pending.shrink (j, false);
+
+    if (unlikely (max_ops < 0))
+    {
+      limited = true;
+      break;
+    }
+    if (unlikely (next.in_error () || added.in_error ()))
+      break;
+
+    hb_swap (queue, next);
+    next.resize (0);
+  }
+
+  bool ok = !limited &&
+	    !queue.in_error () && !next.in_error () && !added.in_error () &&
+	    !pending.in_error () && !flagged.in_error () && !glyphs->in_error ();
+
+  if (likely (ok))
+    for (const hb_depend_edge_t &e : flagged)
+      if (!glyphs->has (e.dependent) && satisfied (e))
+      {
+	ok = false;
+	break;
+      }
+
+  if (unlikely (!ok))
+    for (hb_codepoint_t gid : added)
+      glyphs->del (gid);
+  return ok;
+}
+
 
 #ifndef HB_NO_SUBSET_DEPEND
 
@@ -147,6 +280,22 @@ hb_subset_depend_from_face_or_fail (hb_face_t *face)
   return depend;
 }
 
+/**
+ * hb_subset_depend_reference: (skip)
+ * @depend: a #hb_subset_depend_t
+ *
+ * Increases the reference count on @depend.
+ *
+ * Return value: @depend.
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_depend_t *
+hb_subset_depend_reference (hb_subset_depend_t *depend)
+{
+  return hb_object_reference (depend);
+}
+
 /**
  * hb_subset_depend_lookup_glyph:
  * @depend: depend object
@@ -183,20 +332,20 @@ hb_subset_depend_lookup_glyph (hb_subset_depend_t *depend,
                                 unsigned int *entry_count,
                                 hb_subset_depend_entry_t *entries)
 {
-  unsigned int total = depend->data.get_glyph_entry_count (gid);
+  unsigned int total = depend->get_edge_count (gid);
   if (entry_count)
   {
     unsigned int count = hb_min (*entry_count,
                                   start_offset < total ? total - start_offset : 0u);
     for (unsigned int i = 0; i < count; i++)
     {
-      uint8_t flags_byte = 0;
-      depend->data.get_glyph_entry (gid, start_offset + i,
-                                    &entries[i].table_tag, &entries[i].dependent,
-                                    &entries[i].layout_tag, &entries[i].ligature_set_index,
-                                    &entries[i].context_set_index,
-                                    &flags_byte);
-      entries[i].flags = (hb_subset_depend_edge_flags_t) flags_byte;
+      hb_depend_edge_t e = depend->get_edge (gid, start_offset + i);
+      entries[i].table_tag = e.table_tag;
+      entries[i].dependent = e.dependent;
+      entries[i].layout_tag = e.layout_tag;
+      entries[i].ligature_set_index = e.ligature_set;
+      entries[i].context_set_index = e.context_set;
+      entries[i].flags = e.flags;
     }
     *entry_count = count;
   }
@@ -230,10 +379,112 @@ hb_bool_t
 hb_subset_depend_lookup_set (hb_subset_depend_t *depend, hb_codepoint_t index,
                               hb_set_t *out)
 {
-  const hb_set_t *s = depend->get_set_from_index (index);
-  if (!s) return false;
-  out->set (*s);
-  return true;
+  return depend->get_set (index, out);
+}
+
+/**
+ * hb_subset_depend_serialize_or_fail:
+ * @depend: depend object
+ *
+ * Serializes @depend into a compact binary form, for
+ * hb_subset_depend_from_blob_or_fail() to load.  Edges and sets are
+ * stored as flat arrays indexed by glyph and by set, read in place when
+ * loading, so the result can be written to a file and later mapped
+ * read-only and shared between processes.
+ *
+ * The format is versioned; this version of HarfBuzz refuses to load
+ * graphs of a different major version.
+ *
+ * Return value: (transfer full): A blob holding the serialized graph, or
+ * `NULL` on allocation failure.
+ *
+ * Since: REPLACEME
+ **/
+hb_blob_t *
+hb_subset_depend_serialize_or_fail (hb_subset_depend_t *depend)
+{
+  if (depend->graph)
+    return hb_blob_reference (depend->blob);
+
+  const hb_depend_data_t &data = depend->data;
+
+  /* Tags are stored once; edges refer to them by index. */
+  hb_vector_t<hb_tag_t> table_tags, layout_tags;
+  hb_map_t table_indices, layout_indices;
+  for (const auto &g : data.glyph_dependencies)
+    for (const hb_depend_edge_t &e : g.dependencies)
+    {
+      if (!table_indices.has (e.table_tag))
+      {
+	table_indices.set (e.table_tag, table_tags.length);
+	table_tags.push (e.table_tag);
+      }
+      if (!layout_indices.has (e.layout_tag))
+      {
+	layout_indices.set (e.layout_tag, layout_tags.length);
+	layout_tags.push (e.layout_tag);
+      }
+    }
+  if (unlikely (table_tags.in_error () || layout_tags.in_error () ||
+		table_indices.in_error () || layout_indices.in_error ()))
+    return nullptr;
+
+  unsigned length = OT::DependGraph::get_size (data, table_tags.length, layout_tags.length);
+  if (unlikely (!length))
+    return nullptr;
+
+  char *buf = (char *) hb_malloc (length);
+  if (unlikely (!buf))
+    return nullptr;
+
+  hb_serialize_context_t c (buf, length);
+  OT::DependGraph *graph = c.start_serialize<OT::DependGraph> ();
+  bool ret = graph->serialize (&c, data,
+			       hb_iter (table_tags), hb_iter (layout_tags),
+			       table_indices, layout_indices);
+  c.end_serialize ();
+
+  if (unlikely (!ret || c.in_error ()))
+  {
+    hb_free (buf);
+    return nullptr;
+  }
+
+  return hb_blob_create_or_fail (buf, c.head - c.start, HB_MEMORY_MODE_WRITABLE, buf, hb_free);
+}
+
+/**
+ * hb_subset_depend_from_blob_or_fail:
+ * @blob: a blob holding a graph from hb_subset_depend_serialize_or_fail()
+ *
+ * Loads a dependency graph serialized with
+ * hb_subset_depend_serialize_or_fail().  The graph is read from @blob in
+ * place, without being copied or decoded, so loading is constant time;
+ * the returned object keeps a reference to @blob.  For a blob mapped
+ * from a file, use hb_blob_create_from_file_or_fail().
+ *
+ * The graph must have been built from the face it is used with; that is
+ * not checked beyond the glyph count.
+ *
+ * Return value: (transfer full): New depend object, or `NULL` if @blob
+ * does not hold a valid graph or on allocation failure.
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_depend_t *
+hb_subset_depend_from_blob_or_fail (hb_blob_t *blob)
+{
+  hb_subset_depend_t *depend;
+  if (unlikely (!(depend = hb_object_create<hb_subset_depend_t> (blob))))
+    return nullptr;
+
+  if (unlikely (depend->in_error ()))
+  {
+    hb_subset_depend_destroy (depend);
+    return nullptr;
+  }
+
+  return depend;
 }
 
 /**
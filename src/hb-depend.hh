@@ -31,6 +31,7 @@
 
 #include "hb-subset-depend.h"
 #include "hb-depend-data.hh"
+#include "hb-depend-table.hh"
 
 
 /**
@@ -39,12 +40,16 @@
  * Internal structure implementing the dependency graph API.
  *
  * Initialized via hb_subset_depend_from_face_or_fail() which computes the dependency
- * graph once via hb_depend_data_builder_t::compile(). The graph remains
- * immutable for the lifetime of the object.
+ * graph once via hb_depend_data_builder_t::compile(), or via
+ * hb_subset_depend_from_blob_or_fail() which reads a serialized graph in place
+ * (see hb-depend-table.hh). The graph remains immutable for the lifetime of
+ * the object.
  */
 struct hb_subset_depend_t
 {
   HB_INTERNAL hb_subset_depend_t (hb_face_t *face);
+  HB_INTERNAL hb_subset_depend_t (hb_blob_t *blob);
+  ~hb_subset_depend_t () { hb_blob_destroy (blob); }
 
   hb_object_header_t header;
 
@@ -52,12 +57,95 @@ struct hb_subset_depend_t
 
   bool in_error () const { return !successful; }
 
-  const hb_set_t *get_set_from_index (hb_codepoint_t index)
+  unsigned get_glyph_count () const
+  { return graph ? graph->get_glyph_count () : data.glyph_dependencies.length; }
+
+  template <typename Callback>
+  void for_each_edge (hb_codepoint_t gid, Callback callback) const
+  {
+    if (graph)
+    {
+      for (const OT::DependEdgeRecord &record : graph->get_edges (gid))
+	callback (graph->get_edge (record));
+      return;
+    }
+    if (gid < data.glyph_dependencies.length)
+      for (const hb_depend_edge_t &e : data.glyph_dependencies.arrayZ[gid].dependencies)
+	callback (e);
+  }
+
+  unsigned get_edge_count (hb_codepoint_t gid) const
+  {
+    if (graph) return graph->get_edges (gid).length;
+    return data.get_glyph_entry_count (gid);
+  }
+
+  hb_depend_edge_t get_edge (hb_codepoint_t gid, unsigned index) const
+  {
+    if (graph) return graph->get_edge (graph->get_edges (gid)[index]);
+    return data.glyph_dependencies[gid].dependencies[index];
+  }
+
+  bool get_set (hb_codepoint_t index, hb_set_t *out) const
   {
-    return data.get_set_from_index (index);
+    if (graph)
+    {
+      if (!graph->has_set (index)) return false;
+      out->clear ();
+      for (hb_codepoint_t g : graph->get_set (index))
+	out->add (g);
+      return true;
+    }
+    if (index >= data.sets.length) return false;
+    out->set (*data.sets.arrayZ[index]);
+    return true;
   }
 
+  /* Whether pred holds for every element of set index; true if there is
+   * no such set. */
+  template <typename Pred>
+  bool set_all (hb_codepoint_t index, Pred pred) const
+  {
+    if (graph)
+    {
+      for (hb_codepoint_t g : graph->get_set (index))
+	if (!pred (g)) return false;
+      return true;
+    }
+    if (index < data.sets.length)
+      for (hb_codepoint_t g : *data.sets.arrayZ[index])
+	if (!pred (g)) return false;
+    return true;
+  }
+
+  /* Whether set index and glyphs share a glyph; true if there is no such
+   * set. */
+  bool set_intersects (hb_codepoint_t index, const hb_set_t *glyphs) const
+  {
+    if (graph)
+    {
+      if (!graph->has_set (index)) return true;
+      for (hb_codepoint_t g : graph->get_set (index))
+	if (glyphs->has (g)) return true;
+      return false;
+    }
+    if (index >= data.sets.length) return true;
+    return data.sets.arrayZ[index]->intersects (*glyphs);
+  }
+
+  /* Grows glyphs to its GSUB closure over the lookups of features, by
+   * walking the graph.  Returns false, with glyphs as they were, if an
+   * edge flagged as possibly over-approximating would add a glyph, if
+   * the walk runs past HB_CLOSURE_MAX_STAGES or its operation budget, or
+   * on allocation failure; the caller then runs the exact closure. */
+  HB_INTERNAL bool gsub_closure (const hb_set_t *features,
+				 hb_set_t *glyphs) const;
+
   hb_depend_data_t data;
+
+  /* Set instead of data when read from a serialized graph. */
+  hb_blob_t *blob = nullptr;
+  const OT::DependGraph *graph = nullptr;
 };
 
 
@@ -0,0 +1,271 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+
+#ifndef HB_NO_FACE_SNAPSHOT
+
+#include "hb-face-snapshot.hh"
+
+#include "hb-face.hh"
+#include "hb-ot-cmap-table.hh"
+#include "hb-ot-layout-gsub-table.hh"
+#include "hb-ot-layout-gpos-table.hh"
+
+
+uint64_t
+hb_face_snapshot_t::compute_key (hb_face_t *face)
+{
+  /* The tables the snapshot's contents are derived from. */
+  static const hb_tag_t tags[] = {
+    HB_OT_TAG_cmap,
+    HB_OT_TAG_OS2,
+    HB_OT_TAG_GSUB,
+    HB_OT_TAG_GPOS,
+  };
+
+  /* Hash the table data itself; the lengths and checksums in the table
+   * directory are not checked against the data, so they cannot be
+   * trusted to tell two fonts apart. */
+  uint64_t key = face->index;
+  for (hb_tag_t tag : tags)
+  {
+    hb_blob_t *blob = face->reference_table (tag);
+    unsigned length;
+    const char *data = hb_blob_get_data (blob, &length);
+    key = fasthash64 (data, length, key ^ ((uint64_t) tag << 32 | length));
+    hb_blob_destroy (blob);
+  }
+  return key;
+}
+
+const hb_face_snapshot_t *
+hb_face_snapshot_t::get (hb_blob_t *blob, hb_face_t *face)
+{
+  unsigned length;
+  const char *data = hb_blob_get_data (blob, &length);
+  if (length < sizeof (hb_face_snapshot_t) || (uintptr_t) data % 8)
+    return nullptr;
+
+  const auto *snapshot = (const hb_face_snapshot_t *) data;
+  if (snapshot->magic != HB_FACE_SNAPSHOT_MAGIC ||
+      snapshot->format != HB_FACE_SNAPSHOT_FORMAT ||
+      snapshot->hb_version != HB_FACE_SNAPSHOT_HB_VERSION ||
+      snapshot->length < sizeof (hb_face_snapshot_t) ||
+      snapshot->length > length ||
+      snapshot->index != face->index ||
+      snapshot->upem != face->get_upem () ||
+      snapshot->num_glyphs != face->get_num_glyphs () ||
+      snapshot->key != compute_key (face))
+    return nullptr;
+
+  return snapshot;
+}
+
+
+struct hb_face_snapshot_writer_t
+{
+  /* Returns the offset of @size zeroed bytes aligned to @align. */
+  uint32_t alloc (unsigned size, unsigned align)
+  {
+    unsigned offset = (buf.length + align - 1) / align * align;
+    if (unlikely (!buf.resize (offset + size)))
+      return 0;
+    return offset;
+  }
+
+  template <typename T>
+  T *at (uint32_t offset) { return (T *) (buf.arrayZ + offset); }
+
+  void write_cmap (hb_face_t *face)
+  {
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+    hb_set_t unicodes;
+    face->table.cmap->collect_unicodes (&unicodes, face->get_num_glyphs ());
+
+    hb_vector_t<uint32_t> numbers;
+    hb_vector_t<uint16_t> pages;
+    uint16_t glyphs[256];
+    uint32_t last = (uint32_t) -1; /* Last page tried, filled or not. */
+    for (hb_codepoint_t u : unicodes)
+    {
+      uint32_t number = u >> 8;
+      if (number >= 17u * 256u) break;
+      if (number == last) continue;
+      last = number;
+      if (!face->table.cmap->fill_page (number << 8, glyphs)) continue;
+      numbers.push (number);
+      pages.extend (hb_array (glyphs));
+    }
+    if (unlikely (numbers.in_error () || pages.in_error ()) || !numbers)
+      return;
+
+    uint32_t offset = alloc (numbers.get_size () + pages.get_size (), 8);
+    if (unlikely (!offset)) return;
+    hb_memcpy (at<char> (offset), numbers.arrayZ, numbers.get_size ());
+    hb_memcpy (at<char> (offset + numbers.get_size ()), pages.arrayZ, pages.get_size ());
+    at<hb_face_snapshot_t> (0)->cmap_page_count = numbers.length;
+    at<hb_face_snapshot_t> (0)->cmap_pages = offset;
+#endif
+  }
+
+  template <typename Accel>
+  void write_layout (const Accel &accel, hb_face_snapshot_t::table_t table)
+  {
+    unsigned lookup_count = accel.lookup_count;
+    if (!lookup_count) return;
+
+    uint32_t layout = alloc (4 + 4 * lookup_count, 8);
+    if (unlikely (!layout)) return;
+    at<hb_face_snapshot_layout_t> (layout)->lookup_count = lookup_count;
+
+    for (unsigned i = 0; i < lookup_count; i++)
+    {
+      const OT::hb_ot_layout_lookup_accelerator_t *lookup = accel.get_accel (i);
+      if (unlikely (!lookup)) continue;
+
+      unsigned count = lookup->get_subtable_count ();
+      uint32_t offset = alloc (8 + count * sizeof (hb_set_digest_t), 8);
+      if (unlikely (!offset)) return;
+      auto *record = at<hb_face_snapshot_lookup_t> (offset);
+      record->subtable_count = count;
+      for (unsigned j = 0; j < count; j++)
+	record->digests[j] = lookup->get_subtable_digest (j);
+
+#ifndef HB_NO_OT_LAYOUT_SUBTABLE_INDEX
+      if (count >= HB_OT_LAYOUT_SUBTABLE_INDEX_MIN_SUBTABLES)
+	if (const OT::hb_ot_layout_subtable_index_t *index = lookup->get_subtable_index ())
+	{
+	  unsigned size = 4 + index->length;
+	  uint32_t index_offset = alloc (size, 4);
+	  if (unlikely (!index_offset)) return;
+	  at<uint32_t> (index_offset)[0] = index->length;
+	  hb_memcpy (at<char> (index_offset + 4), index->first, index->length);
+	  at<hb_face_snapshot_lookup_t> (offset)->subtable_index = index_offset;
+	}
+#endif
+
+      at<hb_face_snapshot_layout_t> (layout)->lookups[i] = offset;
+    }
+
+    at<hb_face_snapshot_t> (0)->layout[table] = layout;
+  }
+
+  hb_vector_t<char> buf;
+};
+
+
+/**
+ * hb_face_create_snapshot:
+ * @face: A face object
+ *
+ * Computes the accelerator state HarfBuzz builds lazily for @face while
+ * shaping, and returns it as a snapshot that hb_face_set_snapshot() can
+ * use on another face object for the same font, for example in a later
+ * run of the program.  This includes the flat character-map pages and,
+ * for every GSUB and GPOS lookup, the glyph digests and subtable index.
+ *
+ * Snapshots are meant to be stored next to the font, for example with
+ * one file per font and face index, and loaded with
+ * hb_blob_create_from_file(), which maps the file into memory where
+ * possible.  They are in native byte order and specific to the HarfBuzz
+ * version that created them.
+ *
+ * Return value: (transfer full): The snapshot blob, or the empty blob on
+ * allocation failure.
+ *
+ * Since: REPLACEME
+ **/
+hb_blob_t *
+hb_face_create_snapshot (hb_face_t *face)
+{
+  hb_face_snapshot_writer_t writer;
+  if (unlikely (writer.alloc (sizeof (hb_face_snapshot_t), 8) != 0 ||
+		writer.buf.in_error ()))
+    return hb_blob_get_empty ();
+
+  writer.write_cmap (face);
+  writer.write_layout (*face->table.GSUB.get (), hb_face_snapshot_t::GSUB);
+  writer.write_layout (*face->table.GPOS.get (), hb_face_snapshot_t::GPOS);
+  if (unlikely (writer.buf.in_error ()))
+    return hb_blob_get_empty ();
+
+  auto *snapshot = writer.at<hb_face_snapshot_t> (0);
+  snapshot->magic = HB_FACE_SNAPSHOT_MAGIC;
+  snapshot->format = HB_FACE_SNAPSHOT_FORMAT;
+  snapshot->hb_version = HB_FACE_SNAPSHOT_HB_VERSION;
+  snapshot->length = writer.buf.length;
+  snapshot->key = hb_face_snapshot_t::compute_key (face);
+  snapshot->index = face->index;
+  snapshot->upem = face->get_upem ();
+  snapshot->num_glyphs = face->get_num_glyphs ();
+
+  unsigned length;
+  char *data = writer.buf.steal (&length);
+  return hb_blob_create (data, length, HB_MEMORY_MODE_WRITABLE, data, hb_free);
+}
+
+/**
+ * hb_face_set_snapshot:
+ * @face: A face object
+ * @snapshot: A blob returned by hb_face_create_snapshot()
+ *
+ * Makes @face use the accelerator state in @snapshot in place, instead of
+ * computing it.  Must be called before @face is used: once @face has built
+ * its character-map or layout accelerators, the snapshot is refused.
+ *
+ * The snapshot is only accepted if it was created by this version of
+ * HarfBuzz, for a face with the same index, and from character map and
+ * layout tables with the same contents.  Otherwise @face is left unchanged and computes
+ * its state as usual.
+ *
+ * Return value: `true` if @snapshot is used, `false` otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_face_set_snapshot (hb_face_t *face,
+		      hb_blob_t *snapshot)
+{
+  if (hb_object_is_immutable (face))
+    return false;
+
+  /* Accelerators already built would not see the snapshot. */
+  if (face->table.cmap.get_stored_relaxed () ||
+      face->table.GSUB.get_stored_relaxed () ||
+      face->table.GPOS.get_stored_relaxed ())
+    return false;
+
+  const hb_face_snapshot_t *data = hb_face_snapshot_t::get (snapshot, face);
+  if (!data)
+    return false;
+
+  hb_blob_destroy (face->snapshot_blob);
+  face->snapshot_blob = hb_blob_reference (snapshot);
+  face->snapshot = data;
+  return true;
+}
+
+
+#endif
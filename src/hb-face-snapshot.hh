@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_FACE_SNAPSHOT_HH
+#define HB_FACE_SNAPSHOT_HH
+
+#include "hb.hh"
+
+#include "hb-set-digest.hh"
+
+
+/*
+ * Face snapshot.
+ *
+ * A snapshot holds accelerator state computed for a face, laid out to be
+ * used in place from a read-only (typically mmap()ed) blob: the cmap flat
+ * pages and, for each GSUB / GPOS lookup, the subtable digests and the
+ * subtable index.  It is in native byte order and only valid for the
+ * HarfBuzz version that wrote it.  Everything in it is only ever used to
+ * speed up answers the font tables give anyway, and snapshots never let a
+ * table skip sanitizing.
+ *
+ * All offsets are from the start of the snapshot.
+ */
+
+#define HB_FACE_SNAPSHOT_MAGIC HB_TAG ('h','b','F','S')
+#define HB_FACE_SNAPSHOT_FORMAT 3u
+#define HB_FACE_SNAPSHOT_HB_VERSION ((HB_VERSION_MAJOR << 20) | (HB_VERSION_MINOR << 10) | HB_VERSION_MICRO)
+
+struct hb_face_snapshot_lookup_t
+{
+  uint32_t subtable_count;
+  uint32_t subtable_index;		/* hb_ot_layout_subtable_index_t, or 0. */
+  hb_set_digest_t digests[HB_VAR_ARRAY];	/* One per subtable. */
+};
+
+struct hb_face_snapshot_layout_t
+{
+  uint32_t lookup_count;
+  uint32_t lookups[HB_VAR_ARRAY];	/* hb_face_snapshot_lookup_t, or 0. */
+};
+
+struct hb_face_snapshot_t
+{
+  enum table_t { GSUB, GPOS, LAYOUT_TABLES };
+
+  /* Returns the snapshot in @blob if it belongs to @face, nullptr otherwise. */
+  HB_INTERNAL static const hb_face_snapshot_t *get (hb_blob_t *blob, hb_face_t *face);
+  HB_INTERNAL static uint64_t compute_key (hb_face_t *face);
+
+  template <typename T>
+  const T *get_at (uint32_t offset, unsigned size, unsigned align = alignof (T)) const
+  {
+    if (!offset || offset % align ||
+	offset > length || size > length - offset)
+      return nullptr;
+    return (const T *) ((const char *) this + offset);
+  }
+
+  /* The @count cmap pages, numbered by codepoint / 256; each page holds
+   * 256 16-bit glyph ids, 0 for unmapped. */
+  const uint32_t *get_cmap_pages (unsigned *count) const
+  {
+    if (cmap_page_count > 17u * 256u) return nullptr;
+    const uint32_t *numbers = get_at<uint32_t> (cmap_pages, cmap_page_count * (4u + 512u));
+    *count = numbers ? cmap_page_count : 0;
+    return numbers;
+  }
+  const uint16_t *get_cmap_page (unsigned i) const
+  { return (const uint16_t *) ((const char *) this + cmap_pages + cmap_page_count * 4u + i * 512u); }
+
+  const hb_face_snapshot_lookup_t *get_lookup (table_t table,
+					       unsigned lookup_index,
+					       unsigned lookup_count) const
+  {
+    const auto *l = get_at<hb_face_snapshot_layout_t> (layout[table], 4);
+    if (!l || l->lookup_count != lookup_count || lookup_index >= lookup_count ||
+	!get_at<hb_face_snapshot_layout_t> (layout[table], 4 + 4 * lookup_count))
+      return nullptr;
+
+    uint32_t offset = l->lookups[lookup_index];
+    const auto *lookup = get_at<hb_face_snapshot_lookup_t> (offset, 8);
+    if (!lookup ||
+	lookup->subtable_count > (length - offset - 8) / sizeof (hb_set_digest_t))
+      return nullptr;
+    return lookup;
+  }
+
+  uint32_t magic;		/* HB_FACE_SNAPSHOT_MAGIC, in native byte order. */
+  uint32_t format;		/* HB_FACE_SNAPSHOT_FORMAT. */
+  uint32_t hb_version;		/* HB_FACE_SNAPSHOT_HB_VERSION. */
+  uint32_t length;		/* Of the whole snapshot. */
+  uint64_t key;			/* compute_key() of the face. */
+  uint32_t index;		/* Of the face. */
+  uint32_t upem;
+  uint32_t num_glyphs;
+  uint32_t cmap_page_count;
+  uint32_t cmap_pages;		/* Page numbers, then the pages. */
+  uint32_t layout[LAYOUT_TABLES];	/* hb_face_snapshot_layout_t, or 0. */
+  uint32_t reserved;
+};
+static_assert (sizeof (hb_face_snapshot_t) % 8 == 0, "");
+static_assert (alignof (hb_set_digest_t) <= 8, "");
+
+
+#endif /* HB_FACE_SNAPSHOT_HH */
@@ -579,17 +579,15 @@ hb_face_destroy (hb_face_t *face)
   if (!hb_object_destroy (face)) return;
 
 #ifndef HB_NO_SHAPER
-  for (hb_face_t::plan_node_t *node = face->shape_plans; node; )
-  {
-    hb_face_t::plan_node_t *next = node->next;
-    hb_shape_plan_destroy (node->shape_plan);
-    hb_free (node);
-    node = next;
-  }
+  hb_shape_plan_cache_t::destroy (face->shape_plans.get_relaxed ());
 #endif
 
   face->data.fini ();
   face->table.fini ();
+#ifndef HB_NO_FACE_SNAPSHOT
+  /* After the tables, whose accelerators may point into it. */
+  hb_blob_destroy (face->snapshot_blob);
+#endif
 
   if (face->get_table_tags_destroy)
     face->get_table_tags_destroy (face->get_table_tags_user_data);
@@ -220,6 +220,18 @@ hb_face_collect_variation_unicodes (hb_face_t *face,
 				    hb_set_t  *out);
 
 
+/*
+ * Snapshot.
+ */
+
+HB_EXTERN hb_blob_t *
+hb_face_create_snapshot (hb_face_t *face);
+
+HB_EXTERN hb_bool_t
+hb_face_set_snapshot (hb_face_t *face,
+		      hb_blob_t *snapshot);
+
+
 /*
  * Builder face.
  */
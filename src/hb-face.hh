@@ -44,6 +44,8 @@
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
 
+struct hb_face_snapshot_t;
+
 struct hb_face_t
 {
   hb_object_header_t header;
@@ -63,14 +65,16 @@ struct hb_face_t
   hb_shaper_object_dataset_t<hb_face_t> data;/* Various shaper data. */
   hb_ot_face_t table;			/* All the face's tables. */
 
+#ifndef HB_NO_FACE_SNAPSHOT
+  hb_blob_t *snapshot_blob;		/* See hb_face_set_snapshot(). */
+  const hb_face_snapshot_t *snapshot;	/* Points into snapshot_blob. */
+#endif
+
   /* Cache */
-  struct plan_node_t
-  {
-    hb_shape_plan_t *shape_plan;
-    plan_node_t *next;
-  };
 #ifndef HB_NO_SHAPER
-  hb_atomic_t<plan_node_t *> shape_plans;
+  hb_atomic_t<hb_shape_plan_cache_t *> shape_plans;
+
+  HB_INTERNAL hb_shape_plan_cache_t *get_shape_plan_cache ();
 #endif
 
   hb_blob_t *reference_table (hb_tag_t tag) const
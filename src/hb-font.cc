@@ -2213,6 +2213,23 @@ hb_font_create_sub_font (hb_font_t *parent)
   return font;
 }
 
+/* A font equivalent to @font, for use on another thread concurrently with
+ * it.  The OpenType font functions keep their caches in their font data,
+ * so for those the new font gets a set of its own; other font functions
+ * are reached through the parent and have to be thread-safe themselves. */
+hb_font_t *
+_hb_font_create_for_thread (hb_font_t *font)
+{
+  hb_font_t *sub_font = hb_font_create_sub_font (font);
+
+#ifndef HB_NO_OT_FONT
+  if (_hb_font_uses_ot_funcs (font))
+    hb_ot_font_set_funcs (sub_font);
+#endif
+
+  return sub_font;
+}
+
 /**
  * hb_font_get_empty:
  *
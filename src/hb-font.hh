@@ -1170,5 +1170,13 @@ struct hb_font_t
 };
 DECLARE_NULL_INSTANCE (hb_font_t);
 
+HB_INTERNAL hb_font_t *
+_hb_font_create_for_thread (hb_font_t *font);
+
+#ifndef HB_NO_OT_FONT
+HB_INTERNAL bool
+_hb_font_uses_ot_funcs (const hb_font_t *font);
+#endif
+
 
 #endif /* HB_FONT_HH */
@@ -0,0 +1,708 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+
+#include "hb-gpu.h"
+#include "hb-object.hh"
+#include "hb-cache.hh"
+
+
+/*
+ * Encoded-glyph atlas.
+ *
+ * Encoded glyphs are copied into one linear buffer of RGBA16I texels,
+ * the layout the shaders address with a texel offset.  Ranges freed by
+ * evicting glyphs are kept on a free list, sorted by offset and merged
+ * with their neighbors, and reused first-fit; the buffer only grows
+ * when no free range is big enough.  When the byte budget doesn't
+ * allow growing either, the least recently used glyphs are evicted
+ * until the new one fits.
+ */
+
+#define HB_GPU_ATLAS_TEXEL_SIZE 8
+#define HB_GPU_ATLAS_MAX_BYTES_DEFAULT (16u << 20)
+
+struct hb_gpu_atlas_key_t
+{
+  hb_face_t *face;
+  hb_codepoint_t glyph;
+  bool color;
+  int x_scale, y_scale;
+  float slant;
+  float x_embolden, y_embolden;
+  bool embolden_in_place;
+  unsigned palette;
+  hb_vector_t<int> coords;
+
+  uint32_t hash () const
+  {
+    uint32_t h = hb_hash ((uintptr_t) face);
+    h = h * 31 + glyph;
+    h = h * 31 + hb_hash (x_scale);
+    h = h * 31 + hb_hash (y_scale);
+    h = h * 31 + hb_hash (slant);
+    h = h * 31 + hb_hash (x_embolden);
+    h = h * 31 + hb_hash (y_embolden);
+    h = h * 31 + (color | embolden_in_place << 1);
+    h = h * 31 + palette;
+    h = h * 31 + coords.as_array ().hash ();
+    return h;
+  }
+
+  bool operator == (const hb_gpu_atlas_key_t &o) const
+  {
+    return face == o.face &&
+	   glyph == o.glyph &&
+	   color == o.color &&
+	   x_scale == o.x_scale && y_scale == o.y_scale &&
+	   slant == o.slant &&
+	   x_embolden == o.x_embolden && y_embolden == o.y_embolden &&
+	   embolden_in_place == o.embolden_in_place &&
+	   palette == o.palette &&
+	   coords.as_array () == o.coords.as_array ();
+  }
+};
+
+struct hb_gpu_atlas_entry_t : hb_lru_link_t
+{
+  hb_gpu_atlas_key_t key;
+  hb_gpu_atlas_glyph_t glyph;
+
+  size_t get_size () const
+  { return sizeof (*this) + (size_t) glyph.length * HB_GPU_ATLAS_TEXEL_SIZE; }
+
+  bool equal (const hb_gpu_atlas_key_t &key_) const { return key == key_; }
+  void fini () { this->~hb_gpu_atlas_entry_t (); }
+};
+
+struct hb_gpu_atlas_range_t
+{
+  unsigned offset, length;
+};
+
+/* hb_gpu_atlas_t — cache of encoded glyphs */
+struct hb_gpu_atlas_t
+{
+  hb_object_header_t header;
+
+  unsigned max_bytes = HB_GPU_ATLAS_MAX_BYTES_DEFAULT;
+  unsigned palette = 0;
+
+  hb_lru_cache_t<hb_gpu_atlas_entry_t> glyphs;
+  hb_vector_t<hb_face_t *> faces; /* Referenced. */
+  unsigned serial = 0;
+
+  /* The texel buffer; its length is the high-water mark. */
+  hb_vector_t<char> data;
+  /* Sorted by offset; no two ranges touch. */
+  hb_vector_t<hb_gpu_atlas_range_t> free_ranges;
+  /* Texels written since the dirty range was last cleared. */
+  unsigned dirty_start = 0, dirty_end = 0;
+
+  /* For encoding glyphs that aren't cached. */
+  hb_gpu_draw_t *draw = nullptr;
+  hb_gpu_paint_t *paint = nullptr;
+
+  unsigned texel_count () const { return data.length / HB_GPU_ATLAS_TEXEL_SIZE; }
+  unsigned max_texels () const { return max_bytes / HB_GPU_ATLAS_TEXEL_SIZE; }
+
+  void release (unsigned offset, unsigned length)
+  {
+    unsigned i = 0;
+    while (i < free_ranges.length && free_ranges.arrayZ[i].offset < offset)
+      i++;
+
+    bool merge_prev = i && free_ranges.arrayZ[i - 1].offset + free_ranges.arrayZ[i - 1].length == offset;
+    bool merge_next = i < free_ranges.length && offset + length == free_ranges.arrayZ[i].offset;
+    if (merge_prev && merge_next)
+    {
+      free_ranges.arrayZ[i - 1].length += length + free_ranges.arrayZ[i].length;
+      free_ranges.remove_ordered (i);
+    }
+    else if (merge_prev)
+      free_ranges.arrayZ[i - 1].length += length;
+    else if (merge_next)
+    {
+      free_ranges.arrayZ[i].offset = offset;
+      free_ranges.arrayZ[i].length += length;
+    }
+    else
+    {
+      /* On allocation failure the range is just lost until a clear. */
+      if (unlikely (!free_ranges.push ()))
+	return;
+      for (unsigned j = free_ranges.length - 1; j > i; j--)
+	free_ranges.arrayZ[j] = free_ranges.arrayZ[j - 1];
+      free_ranges.arrayZ[i] = hb_gpu_atlas_range_t {offset, length};
+    }
+  }
+
+  /* Finds @length free texels, without evicting anything. */
+  bool claim (unsigned length, unsigned *offset)
+  {
+    for (unsigned i = 0; i < free_ranges.length; i++)
+    {
+      hb_gpu_atlas_range_t &range = free_ranges.arrayZ[i];
+      if (range.length < length)
+	continue;
+      *offset = range.offset;
+      range.offset += length;
+      range.length -= length;
+      if (!range.length)
+	free_ranges.remove_ordered (i);
+      return true;
+    }
+
+    /* Grow the buffer, starting from a free range at its end, if any. */
+    unsigned count = texel_count ();
+    bool tail_free = free_ranges.length &&
+		     free_ranges.tail ().offset + free_ranges.tail ().length == count;
+    unsigned start = tail_free ? free_ranges.tail ().offset : count;
+    if (length > max_texels () || start > max_texels () - length)
+      return false;
+    if (unlikely (!data.resize ((start + length) * HB_GPU_ATLAS_TEXEL_SIZE)))
+      return false;
+    if (tail_free)
+      free_ranges.pop ();
+    *offset = start;
+    return true;
+  }
+
+  /* Evicts the least recently used glyph that occupies texels. */
+  bool evict ()
+  {
+    for (hb_lru_link_t *link = glyphs.lru.prev; link != &glyphs.lru; link = link->prev)
+    {
+      hb_gpu_atlas_entry_t *victim = static_cast<hb_gpu_atlas_entry_t *> (link);
+      if (!victim->glyph.length)
+	continue;
+
+      release (victim->glyph.offset, victim->glyph.length);
+      glyphs.remove (victim);
+      serial++;
+      return true;
+    }
+    return false;
+  }
+
+  bool allocate (unsigned length, unsigned *offset)
+  {
+    if (length > max_texels ())
+      return false;
+    while (!claim (length, offset))
+      if (!evict ())
+	return false;
+    return true;
+  }
+
+  void mark_dirty (unsigned offset, unsigned length)
+  {
+    if (dirty_start == dirty_end)
+    {
+      dirty_start = offset;
+      dirty_end = offset + length;
+      return;
+    }
+    dirty_start = hb_min (dirty_start, offset);
+    dirty_end = hb_max (dirty_end, offset + length);
+  }
+
+  /* Encodes @glyph; the returned blob goes back through recycle(). */
+  hb_blob_t *encode (hb_font_t *font, hb_codepoint_t glyph, bool color,
+		     hb_glyph_extents_t *extents)
+  {
+    if (!color)
+    {
+      hb_gpu_draw_glyph (draw, font, glyph);
+      return hb_gpu_draw_encode (draw, extents);
+    }
+
+    if (!paint)
+    {
+      paint = hb_gpu_paint_create_or_fail ();
+      if (unlikely (!paint))
+	return nullptr;
+    }
+    hb_gpu_paint_set_palette (paint, palette);
+    hb_gpu_paint_glyph (paint, font, glyph);
+    return hb_gpu_paint_encode (paint, extents);
+  }
+
+  void recycle (hb_blob_t *blob, bool color)
+  {
+    if (!color)
+      hb_gpu_draw_recycle_blob (draw, blob);
+    else
+      hb_gpu_paint_recycle_blob (paint, blob);
+  }
+
+  bool get_glyph (hb_font_t *font, hb_codepoint_t glyph, bool color,
+		  hb_gpu_atlas_glyph_t *atlas_glyph);
+};
+
+bool
+hb_gpu_atlas_t::get_glyph (hb_font_t            *font,
+			   hb_codepoint_t        glyph,
+			   bool                  color,
+			   hb_gpu_atlas_glyph_t *atlas_glyph)
+{
+  if (unlikely (!draw))
+    return false;
+
+  hb_gpu_atlas_key_t key;
+  key.face = hb_font_get_face (font);
+  key.glyph = glyph;
+  key.color = color;
+  hb_font_get_scale (font, &key.x_scale, &key.y_scale);
+  key.slant = hb_font_get_synthetic_slant (font);
+  hb_bool_t in_place;
+  hb_font_get_synthetic_bold (font, &key.x_embolden, &key.y_embolden, &in_place);
+  key.embolden_in_place = in_place;
+  key.palette = color ? palette : 0;
+  unsigned coords_length;
+  const int *coords = hb_font_get_var_coords_normalized (font, &coords_length);
+  key.coords.extend (hb_array (coords, coords_length));
+  if (unlikely (key.coords.in_error ()))
+    return false;
+
+  uint32_t hash = key.hash ();
+  hb_gpu_atlas_entry_t *cached = glyphs.fetch (key, hash);
+  if (cached)
+  {
+    *atlas_glyph = cached->glyph;
+    return true;
+  }
+
+  hb_gpu_atlas_glyph_t encoded = {};
+  hb_blob_t *blob = encode (font, glyph, color, &encoded.extents);
+  if (unlikely (!blob))
+    return false;
+
+  unsigned length;
+  const char *blob_data = hb_blob_get_data (blob, &length);
+  encoded.length = length / HB_GPU_ATLAS_TEXEL_SIZE;
+  if (encoded.length)
+  {
+    if (!allocate (encoded.length, &encoded.offset))
+    {
+      recycle (blob, color);
+      return false;
+    }
+    hb_memcpy (data.arrayZ + (size_t) encoded.offset * HB_GPU_ATLAS_TEXEL_SIZE,
+	       blob_data,
+	       (size_t) encoded.length * HB_GPU_ATLAS_TEXEL_SIZE);
+    mark_dirty (encoded.offset, encoded.length);
+  }
+  recycle (blob, color);
+
+  if (!faces.lfind (key.face))
+  {
+    faces.push (hb_face_reference (key.face));
+    if (unlikely (faces.in_error ()))
+    {
+      hb_face_destroy (key.face);
+      if (encoded.length)
+	release (encoded.offset, encoded.length);
+      return false;
+    }
+  }
+
+  hb_gpu_atlas_entry_t *entry = (hb_gpu_atlas_entry_t *) hb_malloc (sizeof (hb_gpu_atlas_entry_t));
+  if (unlikely (!entry))
+  {
+    if (encoded.length)
+      release (encoded.offset, encoded.length);
+    return false;
+  }
+  new (entry) hb_gpu_atlas_entry_t ();
+  entry->key = std::move (key);
+  entry->glyph = encoded;
+  if (unlikely (!glyphs.insert (entry, hash)))
+  {
+    if (encoded.length)
+      release (encoded.offset, encoded.length);
+    return false;
+  }
+
+  *atlas_glyph = encoded;
+  return true;
+}
+
+
+/**
+ * hb_gpu_atlas_create_or_fail:
+ *
+ * Creates a new encoded-glyph atlas.  Glyphs are encoded with
+ * #hb_gpu_draw_t or #hb_gpu_paint_t on first use and their data kept
+ * in a single texel buffer, ready to upload to the buffer or texture
+ * the shaders read glyphs from.
+ *
+ * An atlas is not thread-safe; use one per thread.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_gpu_atlas_t, or `NULL` on allocation failure.
+ *
+ * Since: REPLACEME
+ **/
+hb_gpu_atlas_t *
+hb_gpu_atlas_create_or_fail (void)
+{
+  hb_gpu_atlas_t *atlas = hb_object_create<hb_gpu_atlas_t> ();
+  if (unlikely (!atlas))
+    return nullptr;
+
+  atlas->draw = hb_gpu_draw_create_or_fail ();
+  if (unlikely (!atlas->draw))
+  {
+    hb_gpu_atlas_destroy (atlas);
+    return nullptr;
+  }
+
+  return atlas;
+}
+
+/**
+ * hb_gpu_atlas_reference: (skip)
+ * @atlas: an encoded-glyph atlas
+ *
+ * Increases the reference count on @atlas by one.
+ *
+ * Return value: (transfer full):
+ * The referenced #hb_gpu_atlas_t.
+ *
+ * Since: REPLACEME
+ **/
+hb_gpu_atlas_t *
+hb_gpu_atlas_reference (hb_gpu_atlas_t *atlas)
+{
+  return hb_object_reference (atlas);
+}
+
+/**
+ * hb_gpu_atlas_destroy: (skip)
+ * @atlas: an encoded-glyph atlas
+ *
+ * Decreases the reference count on @atlas by one. When the
+ * reference count reaches zero, the atlas and its buffer are freed.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_gpu_atlas_destroy (hb_gpu_atlas_t *atlas)
+{
+  if (!hb_object_should_destroy (atlas))
+    return;
+
+  hb_gpu_atlas_clear (atlas);
+  hb_gpu_draw_destroy (atlas->draw);
+  hb_gpu_paint_destroy (atlas->paint);
+  hb_object_actually_destroy (atlas);
+  hb_free (atlas);
+}
+
+/**
+ * hb_gpu_atlas_set_user_data: (skip)
+ * @atlas: an encoded-glyph atlas
+ * @key: the user-data key
+ * @data: a pointer to the user data
+ * @destroy: (nullable): a callback to call when @data is not needed anymore
+ * @replace: whether to replace an existing data with the same key
+ *
+ * Attaches a user-data key/data pair to the specified atlas.
+ *
+ * Return value: `true` if success, `false` otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_set_user_data (hb_gpu_atlas_t     *atlas,
+			    hb_user_data_key_t *key,
+			    void               *data,
+			    hb_destroy_func_t   destroy,
+			    hb_bool_t           replace)
+{
+  return hb_object_set_user_data (atlas, key, data, destroy, replace);
+}
+
+/**
+ * hb_gpu_atlas_get_user_data: (skip)
+ * @atlas: an encoded-glyph atlas
+ * @key: the user-data key
+ *
+ * Fetches the user-data associated with the specified key,
+ * attached to the specified atlas.
+ *
+ * Return value: (transfer none):
+ * A pointer to the user data
+ *
+ * Since: REPLACEME
+ **/
+void *
+hb_gpu_atlas_get_user_data (const hb_gpu_atlas_t *atlas,
+			    hb_user_data_key_t   *key)
+{
+  return hb_object_get_user_data (atlas, key);
+}
+
+/**
+ * hb_gpu_atlas_set_max_bytes:
+ * @atlas: an encoded-glyph atlas
+ * @max_bytes: the largest the texel buffer may grow, in bytes
+ *
+ * Sets how large the texel buffer of @atlas may grow.  Once it can't
+ * grow any further, the least recently used glyphs are evicted to make
+ * room.  Lowering the budget below the current buffer length doesn't
+ * shrink the buffer, but stops it from growing.
+ *
+ * The default is 16 megabytes.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_gpu_atlas_set_max_bytes (hb_gpu_atlas_t *atlas,
+			    unsigned int    max_bytes)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->max_bytes = max_bytes;
+}
+
+/**
+ * hb_gpu_atlas_get_max_bytes:
+ * @atlas: an encoded-glyph atlas
+ *
+ * Fetches the texel buffer budget of @atlas.
+ *
+ * Return value: The budget, in bytes.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_max_bytes (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->max_bytes;
+}
+
+/**
+ * hb_gpu_atlas_set_palette:
+ * @atlas: an encoded-glyph atlas
+ * @palette: a palette index
+ *
+ * Sets the color palette used to encode glyphs fetched with
+ * hb_gpu_atlas_get_color_glyph().  Glyphs encoded with different
+ * palettes are cached separately.  The default is palette 0.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_gpu_atlas_set_palette (hb_gpu_atlas_t *atlas,
+			  unsigned int    palette)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->palette = palette;
+}
+
+/**
+ * hb_gpu_atlas_get_palette:
+ * @atlas: an encoded-glyph atlas
+ *
+ * Fetches the color palette set with hb_gpu_atlas_set_palette().
+ *
+ * Return value: The palette index.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_palette (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->palette;
+}
+
+/**
+ * hb_gpu_atlas_get_glyph:
+ * @atlas: an encoded-glyph atlas
+ * @font: font to encode from
+ * @glyph: glyph ID
+ * @atlas_glyph: (out): where the glyph is in @atlas
+ *
+ * Looks the outline of @glyph up in @atlas, encoding it with
+ * #hb_gpu_draw_t and adding it first if needed.
+ *
+ * Glyphs are cached by face, glyph ID, font scale, synthetic slant and
+ * bold, and variation coordinates.  The atlas keeps a reference to
+ * every face it has encoded a glyph from, until it is cleared.
+ *
+ * Adding a glyph may evict others; the returned location is valid
+ * until the serial number of @atlas changes.  See
+ * hb_gpu_atlas_get_serial().
+ *
+ * Return value: `true` if the glyph is in @atlas, `false` if it
+ * couldn't be encoded or doesn't fit in the budget.  Glyphs without
+ * ink succeed with zero length.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_get_glyph (hb_gpu_atlas_t       *atlas,
+			hb_font_t            *font,
+			hb_codepoint_t        glyph,
+			hb_gpu_atlas_glyph_t *atlas_glyph)
+{
+  return atlas->get_glyph (font, glyph, false, atlas_glyph);
+}
+
+/**
+ * hb_gpu_atlas_get_color_glyph:
+ * @atlas: an encoded-glyph atlas
+ * @font: font to encode from
+ * @glyph: glyph ID
+ * @atlas_glyph: (out): where the glyph is in @atlas
+ *
+ * Like hb_gpu_atlas_get_glyph(), but encodes @glyph with
+ * #hb_gpu_paint_t, in the palette set with hb_gpu_atlas_set_palette(),
+ * for rendering with the paint shaders.  Color and outline encodings
+ * of the same glyph are cached separately.
+ *
+ * Return value: `true` if the glyph is in @atlas, `false` if it
+ * couldn't be encoded or doesn't fit in the budget.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_get_color_glyph (hb_gpu_atlas_t       *atlas,
+			      hb_font_t            *font,
+			      hb_codepoint_t        glyph,
+			      hb_gpu_atlas_glyph_t *atlas_glyph)
+{
+  return atlas->get_glyph (font, glyph, true, atlas_glyph);
+}
+
+/**
+ * hb_gpu_atlas_get_data:
+ * @atlas: an encoded-glyph atlas
+ * @length: (out) (nullable): the length of the buffer, in bytes
+ *
+ * Fetches the texel buffer of @atlas.  It is a multiple of eight bytes
+ * long, one RGBA16I texel each, and ranges no glyph occupies hold
+ * stale data.  The buffer may move and grow as glyphs are added.
+ *
+ * Return value: (transfer none) (array length=length):
+ * The buffer, owned by @atlas, or `NULL` if it is empty.
+ *
+ * Since: REPLACEME
+ **/
+const char *
+hb_gpu_atlas_get_data (const hb_gpu_atlas_t *atlas,
+		       unsigned int         *length)
+{
+  if (length)
+    *length = atlas->data.length;
+  return atlas->data.length ? atlas->data.arrayZ : nullptr;
+}
+
+/**
+ * hb_gpu_atlas_get_dirty_range:
+ * @atlas: an encoded-glyph atlas
+ * @offset: (out) (nullable): the first texel written
+ * @length: (out) (nullable): the number of texels from @offset on
+ *
+ * Fetches the range of texels written since the dirty range was last
+ * cleared with hb_gpu_atlas_clear_dirty_range().  Uploading it is
+ * enough to bring a copy of the buffer up to date, as long as the copy
+ * is as long as the buffer.
+ *
+ * Return value: `true` if any texels were written, `false` otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_gpu_atlas_get_dirty_range (const hb_gpu_atlas_t *atlas,
+			      unsigned int         *offset,
+			      unsigned int         *length)
+{
+  if (offset) *offset = atlas->dirty_start;
+  if (length) *length = atlas->dirty_end - atlas->dirty_start;
+  return atlas->dirty_end > atlas->dirty_start;
+}
+
+/**
+ * hb_gpu_atlas_clear_dirty_range:
+ * @atlas: an encoded-glyph atlas
+ *
+ * Empties the dirty range of @atlas, typically after uploading it.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_gpu_atlas_clear_dirty_range (hb_gpu_atlas_t *atlas)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->dirty_start = atlas->dirty_end = 0;
+}
+
+/**
+ * hb_gpu_atlas_get_serial:
+ * @atlas: an encoded-glyph atlas
+ *
+ * Fetches the serial number of @atlas.  It changes whenever glyphs are
+ * evicted or the atlas is cleared, which is when glyph locations
+ * fetched before may have become stale.
+ *
+ * Return value: The serial number.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_gpu_atlas_get_serial (const hb_gpu_atlas_t *atlas)
+{
+  return atlas->serial;
+}
+
+/**
+ * hb_gpu_atlas_clear:
+ * @atlas: an encoded-glyph atlas
+ *
+ * Drops all cached glyphs and the texel buffer of @atlas, and the
+ * references it holds to faces.  Configuration is kept.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_gpu_atlas_clear (hb_gpu_atlas_t *atlas)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+
+  atlas->glyphs.clear ();
+  atlas->data.clear ();
+  atlas->free_ranges.clear ();
+  atlas->dirty_start = atlas->dirty_end = 0;
+  for (hb_face_t *face : atlas->faces)
+    hb_face_destroy (face);
+  atlas->faces.clear ();
+  atlas->serial++;
+}
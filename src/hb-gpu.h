@@ -265,6 +265,98 @@ hb_gpu_paint_shader_source (hb_gpu_shader_stage_t stage,
 			    hb_gpu_shader_lang_t  lang);
 
 
+/**
+ * hb_gpu_atlas_t:
+ *
+ * An opaque encoded-glyph atlas.  It caches encoded glyphs in a single
+ * texel buffer, so each glyph is only encoded and uploaded once.
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_gpu_atlas_t hb_gpu_atlas_t;
+
+/**
+ * hb_gpu_atlas_glyph_t:
+ * @offset: Texel offset of the glyph data in the atlas buffer
+ * @length: Length of the glyph data, in texels
+ * @extents: Ink extents of the glyph, in font units
+ *
+ * Where a glyph's encoded data lives in an atlas.  @offset is what the
+ * shaders take as the glyph's location in the atlas.
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_gpu_atlas_glyph_t {
+  unsigned int offset;
+  unsigned int length;
+  hb_glyph_extents_t extents;
+} hb_gpu_atlas_glyph_t;
+
+HB_EXTERN hb_gpu_atlas_t *
+hb_gpu_atlas_create_or_fail (void);
+
+HB_EXTERN hb_gpu_atlas_t *
+hb_gpu_atlas_reference (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN void
+hb_gpu_atlas_destroy (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_set_user_data (hb_gpu_atlas_t     *atlas,
+			    hb_user_data_key_t *key,
+			    void               *data,
+			    hb_destroy_func_t   destroy,
+			    hb_bool_t           replace);
+
+HB_EXTERN void *
+hb_gpu_atlas_get_user_data (const hb_gpu_atlas_t *atlas,
+			    hb_user_data_key_t   *key);
+
+HB_EXTERN void
+hb_gpu_atlas_set_max_bytes (hb_gpu_atlas_t *atlas,
+			    unsigned int    max_bytes);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_max_bytes (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN void
+hb_gpu_atlas_set_palette (hb_gpu_atlas_t *atlas,
+			  unsigned int    palette);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_palette (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_get_glyph (hb_gpu_atlas_t       *atlas,
+			hb_font_t            *font,
+			hb_codepoint_t        glyph,
+			hb_gpu_atlas_glyph_t *atlas_glyph);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_get_color_glyph (hb_gpu_atlas_t       *atlas,
+			      hb_font_t            *font,
+			      hb_codepoint_t        glyph,
+			      hb_gpu_atlas_glyph_t *atlas_glyph);
+
+HB_EXTERN const char *
+hb_gpu_atlas_get_data (const hb_gpu_atlas_t *atlas,
+		       unsigned int         *length);
+
+HB_EXTERN hb_bool_t
+hb_gpu_atlas_get_dirty_range (const hb_gpu_atlas_t *atlas,
+			      unsigned int         *offset,
+			      unsigned int         *length);
+
+HB_EXTERN void
+hb_gpu_atlas_clear_dirty_range (hb_gpu_atlas_t *atlas);
+
+HB_EXTERN unsigned int
+hb_gpu_atlas_get_serial (const hb_gpu_atlas_t *atlas);
+
+HB_EXTERN void
+hb_gpu_atlas_clear (hb_gpu_atlas_t *atlas);
+
+
 HB_END_DECLS
 
 
@@ -272,6 +364,7 @@ HB_END_DECLS
 namespace hb {
 HB_DEFINE_VTABLE (gpu_draw,  nullptr);
 HB_DEFINE_VTABLE (gpu_paint, nullptr);
+HB_DEFINE_VTABLE (gpu_atlas, nullptr);
 } // namespace hb
 #endif
 
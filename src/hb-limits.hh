@@ -49,6 +49,31 @@
 #endif
 
 
+#ifndef HB_SHAPE_PLAN_CACHE_MAX_PLANS_DEFAULT
+#define HB_SHAPE_PLAN_CACHE_MAX_PLANS_DEFAULT 256
+#endif
+#ifndef HB_SHAPE_PLAN_CACHE_MAX_BYTES_DEFAULT
+#define HB_SHAPE_PLAN_CACHE_MAX_BYTES_DEFAULT (16u << 20) /* 16mb */
+#endif
+
+#ifndef HB_SHAPE_CACHE_MAX_BYTES_DEFAULT
+#define HB_SHAPE_CACHE_MAX_BYTES_DEFAULT (1u << 20) /* 1mb */
+#endif
+#ifndef HB_SHAPE_CACHE_MAX_WORD_LENGTH
+#define HB_SHAPE_CACHE_MAX_WORD_LENGTH 64
+#endif
+#ifndef HB_SHAPE_CACHE_MAX_PLANS
+#define HB_SHAPE_CACHE_MAX_PLANS 16
+#endif
+#ifndef HB_SHAPE_CACHE_TRIAL_WORDS
+#define HB_SHAPE_CACHE_TRIAL_WORDS 1024
+#endif
+
+#ifndef HB_SUBSET_CACHE_MAX_BYTES_DEFAULT
+#define HB_SUBSET_CACHE_MAX_BYTES_DEFAULT (16u << 20) /* 16mb */
+#endif
+
+
 #ifndef HB_MAX_NESTING_LEVEL
 #define HB_MAX_NESTING_LEVEL 64
 #endif
@@ -58,6 +83,24 @@
 #define HB_MAX_CONTEXT_LENGTH 64
 #endif
 
+#ifndef HB_OT_LAYOUT_SUBTABLE_INDEX_MIN_SUBTABLES
+#define HB_OT_LAYOUT_SUBTABLE_INDEX_MIN_SUBTABLES 4
+#endif
+#ifndef HB_OT_LAYOUT_SUBTABLE_INDEX_MAX_BYTES
+#define HB_OT_LAYOUT_SUBTABLE_INDEX_MAX_BYTES (1u << 20) /* Per GSUB / GPOS table. */
+#endif
+
+#ifndef HB_OT_FONT_CMAP_PAGES_MIN_MISSES
+#define HB_OT_FONT_CMAP_PAGES_MIN_MISSES 256
+#endif
+#ifndef HB_OT_FONT_CMAP_PAGES_MAX_BYTES
+#define HB_OT_FONT_CMAP_PAGES_MAX_BYTES (256u << 10) /* Per face. */
+#endif
+
+#ifndef HB_OT_MAP_MAX_FUSED_LOOKUPS
+#define HB_OT_MAP_MAX_FUSED_LOOKUPS 64
+#endif
+
 #ifndef HB_MAX_SYLLABLE_LENGTH
 #define HB_MAX_SYLLABLE_LENGTH 64
 #endif
@@ -72,6 +115,15 @@
 #define HB_CLOSURE_MAX_STAGES 12
 #endif
 
+/* Operations, per glyph of the face, that walking a depend graph for the
+ * GSUB closure may take before the lookup closure is left to do it. */
+#ifndef HB_DEPEND_CLOSURE_MAX_OPS_FACTOR
+#define HB_DEPEND_CLOSURE_MAX_OPS_FACTOR 256
+#endif
+#ifndef HB_DEPEND_CLOSURE_MAX_OPS_MIN
+#define HB_DEPEND_CLOSURE_MAX_OPS_MIN 1048576
+#endif
+
 #ifndef HB_MAX_SCRIPTS
 #define HB_MAX_SCRIPTS 500
 #endif
@@ -145,6 +197,13 @@
 #define HB_RASTER_MAX_AUTO_DIMENSION 4096
 #endif
 
+#ifndef HB_RASTER_ATLAS_MAX_BYTES_DEFAULT
+#define HB_RASTER_ATLAS_MAX_BYTES_DEFAULT (16u << 20) /* 16mb */
+#endif
+#ifndef HB_RASTER_ATLAS_SUBPIXEL_BUCKETS
+#define HB_RASTER_ATLAS_SUBPIXEL_BUCKETS 4
+#endif
+
 /*
  * Cumulative work budgets.
  *
@@ -215,6 +274,12 @@
 #define HB_RASTER_MAX_DRAW_EDGES ((int64_t) 1 << 20)
 #endif
 
+/* One raster distance-field render, in pixel-to-segment distance
+ * evaluations.  Renders that would need more fail. */
+#ifndef HB_RASTER_MAX_DISTANCE_WORK
+#define HB_RASTER_MAX_DISTANCE_WORK ((int64_t) 1 << 28)
+#endif
+
 
 #ifndef HB_REPACKER_MAX_ITERATIONS
 #define HB_REPACKER_MAX_ITERATIONS 500
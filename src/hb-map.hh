@@ -200,6 +200,7 @@ struct hb_hashmap_t
   }
 
   bool in_error () const { return !successful; }
+  void reset_error () { successful = true; }
 
   bool alloc (unsigned new_population = 0)
   {
@@ -32,6 +32,7 @@
 #include "hb-open-type.hh"
 #include "hb-set.hh"
 #include "hb-cache.hh"
+#include "hb-face-snapshot.hh"
 
 /*
  * cmap -- Character to Glyph Index Mapping
@@ -2150,11 +2151,32 @@ struct cmap
 	  }
 	}
       }
+
+#if !defined(HB_NO_OT_FONT_CMAP_PAGES) && !defined(HB_NO_FACE_SNAPSHOT)
+      if (face->snapshot)
+	load_snapshot (face->snapshot);
+#endif
     }
     ~accelerator_t ()
     {
 #ifndef HB_NO_OT_FONT_CMAP_CACHE
       hb_free (cache);
+#endif
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+      for (auto &plane : planes)
+      {
+	plane_t *p = plane.get_relaxed ();
+	if (!p) continue;
+	for (auto &page : p->pages)
+	{
+	  const page_t *pg = page.get_relaxed ();
+	  if (pg != &Null (page_t) &&
+	      !((const char *) pg >= snapshot_pages.arrayZ &&
+		(const char *) pg < snapshot_pages.arrayZ + snapshot_pages.length))
+	    hb_free ((void *) pg);
+	}
+	hb_free (p);
+      }
 #endif
       table.destroy ();
     }
@@ -2173,6 +2195,11 @@ struct cmap
 #endif
       bool ret  = this->get_glyph_funcZ (this->get_glyph_data, unicode, glyph);
 
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+      if (misses.get_relaxed () < HB_OT_FONT_CMAP_PAGES_MIN_MISSES)
+	misses.inc ();
+#endif
+
 #ifndef HB_NO_OT_FONT_CMAP_CACHE
       if (ret)
         cache->set (unicode, *glyph);
@@ -2185,6 +2212,18 @@ struct cmap
 			    hb_codepoint_t *glyph) const
     {
       if (unlikely (!this->get_glyph_funcZ)) return false;
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+      if (const page_t *page = get_page (unicode))
+      {
+	unsigned g = page->glyphs[unicode & 0xFF];
+	if (g != page_t::UNKNOWN)
+	{
+	  if (!g) return false;
+	  *glyph = g;
+	  return true;
+	}
+      }
+#endif
       return _cached_get (unicode, glyph);
     }
 
@@ -2197,6 +2236,37 @@ struct cmap
       if (unlikely (!this->get_glyph_funcZ)) return 0;
 
       unsigned int done;
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+      if (misses.get_relaxed () >= HB_OT_FONT_CMAP_PAGES_MIN_MISSES)
+      {
+	const page_t *page = nullptr;
+	hb_codepoint_t page_base = (hb_codepoint_t) -1;
+	for (done = 0; done < count; done++)
+	{
+	  hb_codepoint_t unicode = *first_unicode;
+	  if ((unicode & ~0xFFu) != page_base)
+	  {
+	    page_base = unicode & ~0xFFu;
+	    page = get_page (unicode, true);
+	  }
+	  unsigned g = page ? page->glyphs[unicode & 0xFF] : (unsigned) page_t::UNKNOWN;
+	  if (g == page_t::UNKNOWN)
+	  {
+	    if (!_cached_get (unicode, first_glyph))
+	      break;
+	  }
+	  else if (g)
+	    *first_glyph = g;
+	  else
+	    break;
+
+	  first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	  first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+	}
+	return done;
+      }
+#endif
+
       for (done = 0;
 	   done < count && _cached_get (*first_unicode, first_glyph);
 	   done++)
@@ -2286,6 +2356,140 @@ struct cmap
       return c && typed_obj->get_glyph (c, glyph);
     }
 
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+    /* Once the small cache above keeps missing, as it does on CJK text and
+     * other large repertoires, codepoints are mapped through flat pages of
+     * 256 glyph ids each instead.  A page is filled from the subtable the
+     * first time get_nominal_glyphs() needs it; pages nobody maps share
+     * Null, and the face's budget caps the memory used. */
+    struct page_t
+    {
+      /* Glyph ids that don't fit are looked up in the subtable. */
+      static constexpr uint16_t UNKNOWN = 0xFFFFu;
+
+      uint16_t glyphs[256];
+    };
+    struct plane_t
+    {
+      hb_atomic_t<const page_t *> pages[256];
+    };
+
+    public:
+    /* Fills in the 256 glyphs from @first on; returns false if none is mapped. */
+    bool fill_page (hb_codepoint_t first, uint16_t *glyphs) const
+    {
+      if (unlikely (!this->get_glyph_funcZ)) return false;
+      bool empty = true;
+      for (unsigned i = 0; i < 256; i++)
+      {
+	hb_codepoint_t g;
+	if (!this->get_glyph_funcZ (this->get_glyph_data, first + i, &g))
+	  g = 0;
+	glyphs[i] = g < page_t::UNKNOWN ? g : page_t::UNKNOWN;
+	empty = empty && !g;
+      }
+      return !empty;
+    }
+    protected:
+
+#ifndef HB_NO_FACE_SNAPSHOT
+    /* Uses the snapshot's pages in place. */
+    void load_snapshot (const hb_face_snapshot_t *snapshot)
+    {
+      unsigned count;
+      const uint32_t *numbers = snapshot->get_cmap_pages (&count);
+      for (unsigned i = 0; i < count; i++)
+      {
+	hb_codepoint_t first = numbers[i] << 8;
+	if (unlikely ((first >> 8) != numbers[i] || (first >> 16) >= ARRAY_LENGTH (planes)))
+	  continue;
+	plane_t *plane = planes[first >> 16].get_relaxed ();
+	if (!plane)
+	  plane = create_plane (first >> 16);
+	if (unlikely (!plane))
+	  break;
+	plane->pages[(first >> 8) & 0xFF].set_relaxed ((const page_t *) (const void *) snapshot->get_cmap_page (i));
+      }
+      if (count)
+      {
+	snapshot_pages = hb_bytes_t ((const char *) snapshot->get_cmap_page (0), count * sizeof (page_t));
+	misses = HB_OT_FONT_CMAP_PAGES_MIN_MISSES;
+      }
+    }
+#endif
+
+    const page_t *get_page (hb_codepoint_t unicode, bool create = false) const
+    {
+      unsigned plane_index = unicode >> 16;
+      if (unlikely (plane_index >= ARRAY_LENGTH (planes))) return nullptr;
+      plane_t *plane = planes[plane_index].get_acquire ();
+      if (!plane)
+      {
+	if (!create) return nullptr;
+	plane = create_plane (plane_index);
+	if (!plane) return nullptr;
+      }
+      const page_t *page = plane->pages[(unicode >> 8) & 0xFF].get_acquire ();
+      if (!page && create)
+	page = create_page (plane, unicode & ~0xFFu);
+      return page;
+    }
+
+    bool take_budget (int size) const
+    {
+      if (budget.get_relaxed () < size) return false;
+      if (budget.add (-size) >= size) return true;
+      budget.add (size);
+      return false;
+    }
+
+    HB_NEVER_INLINE
+    plane_t *create_plane (unsigned plane_index) const
+    {
+      if (!take_budget (sizeof (plane_t))) return nullptr;
+      plane_t *plane = (plane_t *) hb_calloc (1, sizeof (plane_t));
+      if (unlikely (!plane || !planes[plane_index].cmpexch (nullptr, plane)))
+      {
+	hb_free (plane);
+	budget.add (sizeof (plane_t));
+	plane = planes[plane_index].get_acquire ();
+      }
+      return plane;
+    }
+
+    HB_NEVER_INLINE
+    const page_t *create_page (plane_t *plane, hb_codepoint_t first) const
+    {
+      if (!take_budget (sizeof (page_t))) return nullptr;
+      page_t *page = (page_t *) hb_malloc (sizeof (page_t));
+      if (unlikely (!page))
+      {
+	budget.add (sizeof (page_t));
+	return nullptr;
+      }
+
+      const page_t *stored = page;
+      if (!fill_page (first, page->glyphs))
+      {
+	hb_free (page);
+	budget.add (sizeof (page_t));
+	stored = &Null (page_t);
+      }
+
+      auto &slot = plane->pages[(first >> 8) & 0xFF];
+      if (unlikely (!slot.cmpexch (nullptr, stored)))
+      {
+	if (stored != &Null (page_t))
+	{
+	  hb_free ((void *) stored);
+	  budget.add (sizeof (page_t));
+	}
+	stored = slot.get_acquire ();
+      }
+      return stored;
+    }
+#endif
+
     unsigned int get_subtable_data_size (const CmapSubtable *subtable) const
     {
       unsigned int table_length = this->table.get_length ();
@@ -2313,6 +2517,12 @@ struct cmap
 #ifndef HB_NO_OT_FONT_CMAP_CACHE
     cache_t *cache = nullptr;
 #endif
+#ifndef HB_NO_OT_FONT_CMAP_PAGES
+    mutable hb_atomic_t<plane_t *> planes[17] = {};
+    mutable hb_atomic_t<int> budget {HB_OT_FONT_CMAP_PAGES_MAX_BYTES};
+    mutable hb_atomic_t<int> misses {0};
+    hb_bytes_t snapshot_pages; /* Pages that live in a face snapshot. */
+#endif
 
     public:
     hb_blob_ptr_t<cmap> table;
@@ -1030,4 +1030,10 @@ hb_ot_font_set_funcs (hb_font_t *font)
 		     _hb_ot_font_destroy);
 }
 
+bool
+_hb_font_uses_ot_funcs (const hb_font_t *font)
+{
+  return font->destroy == _hb_ot_font_destroy;
+}
+
 #endif
@@ -37,6 +37,7 @@
 #include "hb-ot-layout-common.hh"
 #include "hb-ot-layout-gdef-table.hh"
 #include "hb-depend-data.hh"
+#include "hb-face-snapshot.hh"
 
 
 namespace OT {
@@ -1435,6 +1436,7 @@ struct hb_accelerate_subtables_context_t :
 	       , hb_cache_func_t cache_func_
 	       , void *external_cache_
 #endif
+	       , const hb_set_digest_t *digest_ = nullptr
 		)
     {
       obj = &obj_;
@@ -1444,8 +1446,14 @@ struct hb_accelerate_subtables_context_t :
       cache_func = cache_func_;
       external_cache = external_cache_;
 #endif
-      digest.init ();
-      obj_.get_coverage ().collect_coverage (&digest);
+      coverage = &obj_.get_coverage ();
+      if (digest_)
+	digest = *digest_;
+      else
+      {
+	digest.init ();
+	coverage->collect_coverage (&digest);
+      }
     }
 
 #ifdef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -1493,6 +1501,7 @@ struct hb_accelerate_subtables_context_t :
     hb_cache_func_t cache_func;
     void *external_cache;
 #endif
+    const Coverage *coverage;
     hb_set_digest_t digest;
   };
 
@@ -1527,6 +1536,7 @@ struct hb_accelerate_subtables_context_t :
 		 , cache_func_to<T>
 		 , external_cache
 #endif
+		 , i <= digest_count ? &digests[i - 1] : nullptr
 		 );
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -1550,10 +1560,16 @@ struct hb_accelerate_subtables_context_t :
   }
   static return_t default_return_value () { return hb_empty_t (); }
 
-  hb_accelerate_subtables_context_t (hb_applicable_t *array_) :
-				     array (array_) {}
+  hb_accelerate_subtables_context_t (hb_applicable_t *array_,
+				     const hb_set_digest_t *digests_ = nullptr,
+				     unsigned digest_count_ = 0) :
+				     array (array_),
+				     digests (digests_),
+				     digest_count (digest_count_) {}
 
   hb_applicable_t *array;
+  const hb_set_digest_t *digests; /* Precomputed, from a face snapshot. */
+  unsigned digest_count;
   unsigned i = 0;
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -5808,10 +5824,23 @@ struct Extension
  * GSUB/GPOS Common
  */
 
+/* For a lookup with many subtables, maps each glyph to the first subtable
+ * that covers it; see hb_ot_layout_lookup_accelerator_t::get_subtable_index(). */
+struct hb_ot_layout_subtable_index_t
+{
+  static constexpr uint8_t NO_SUBTABLE = 0xFFu;
+
+  unsigned int length;		/* One past the last glyph covered. */
+  uint8_t first[HB_VAR_ARRAY];	/* Subtable index, or NO_SUBTABLE. */
+};
+
 struct hb_ot_layout_lookup_accelerator_t
 {
   template <typename TLookup>
-  static hb_ot_layout_lookup_accelerator_t *create (const TLookup &lookup)
+  static hb_ot_layout_lookup_accelerator_t *create (const TLookup &lookup,
+						     hb_atomic_t<int> *subtable_index_budget = nullptr,
+						     const hb_face_snapshot_t *snapshot = nullptr,
+						     const hb_face_snapshot_lookup_t *snapshot_lookup = nullptr)
   {
     unsigned count = lookup.get_subtable_count ();
 
@@ -5828,7 +5857,12 @@ struct hb_ot_layout_lookup_accelerator_t
     if (unlikely (!thiz))
       return nullptr;
 
-    hb_accelerate_subtables_context_t c_accelerate_subtables (thiz->subtables);
+    if (snapshot_lookup && snapshot_lookup->subtable_count > count)
+      snapshot_lookup = nullptr;
+
+    hb_accelerate_subtables_context_t c_accelerate_subtables (thiz->subtables,
+							      snapshot_lookup ? snapshot_lookup->digests : nullptr,
+							      snapshot_lookup ? snapshot_lookup->subtable_count : 0);
     lookup.dispatch (&c_accelerate_subtables);
 
     /* Invalid subtables do not collect and leave zeroed tail entries
@@ -5842,6 +5876,22 @@ struct hb_ot_layout_lookup_accelerator_t
       thiz->digest.union_ (subtable.digest);
 
     thiz->count = count;
+    thiz->subtable_index_budget = subtable_index_budget;
+
+#ifndef HB_NO_OT_LAYOUT_SUBTABLE_INDEX
+    /* The snapshot's index is used in place; apply() ignores any entry
+     * that is out of range, so it needs no checking beyond its size. */
+    if (snapshot_lookup && snapshot_lookup->subtable_index)
+    {
+      uint32_t offset = snapshot_lookup->subtable_index;
+      const auto *index = snapshot->get_at<hb_ot_layout_subtable_index_t> (offset, 4);
+      if (index && index->length <= snapshot->length - offset - 4)
+      {
+	thiz->subtable_index = const_cast<hb_ot_layout_subtable_index_t *> (index);
+	thiz->subtable_index_is_borrowed = true;
+      }
+    }
+#endif
 
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     thiz->subtable_cache_user_idx = c_accelerate_subtables.subtable_cache_user_idx;
@@ -5860,8 +5910,14 @@ struct hb_ot_layout_lookup_accelerator_t
     for (unsigned i = 0; i < count; i++)
       hb_free (subtables[i].external_cache);
 #endif
+    auto *index = subtable_index.get_relaxed ();
+    if (index != &Null (hb_ot_layout_subtable_index_t) && !subtable_index_is_borrowed)
+      hb_free (index);
   }
 
+  unsigned get_subtable_count () const { return count; }
+  const hb_set_digest_t &get_subtable_digest (unsigned i) const { return subtables[i].digest; }
+
   bool may_have (hb_codepoint_t g) const
   { return digest.may_have (g); }
 
@@ -5884,11 +5940,30 @@ struct hb_ot_layout_lookup_accelerator_t
 #endif
       return subtables[0].apply_no_digest (c);
     }
+
+    /* Subtables before the first one covering the glyph can't apply. */
+    unsigned start = 0;
+#ifndef HB_NO_OT_LAYOUT_SUBTABLE_INDEX
+    if (count >= HB_OT_LAYOUT_SUBTABLE_INDEX_MIN_SUBTABLES)
+    {
+      const hb_ot_layout_subtable_index_t *index = get_subtable_index ();
+      if (index)
+      {
+	hb_codepoint_t g = c->buffer->cur().codepoint;
+	if (g >= index->length)
+	  return false;
+	start = index->first[g];
+	if (start >= count) /* NO_SUBTABLE, or a bad snapshot. */
+	  return false;
+      }
+    }
+#endif
+
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
     if (use_cache)
     {
       return
-      + hb_iter (hb_iter (subtables, count))
+      + hb_iter (hb_iter (subtables + start, count - start))
       | hb_map ([&c] (const hb_accelerate_subtables_context_t::hb_applicable_t &_) { return _.apply_cached (c); })
       | hb_any
       ;
@@ -5897,7 +5972,7 @@ struct hb_ot_layout_lookup_accelerator_t
 #endif
     {
       return
-      + hb_iter (hb_iter (subtables, count))
+      + hb_iter (hb_iter (subtables + start, count - start))
       | hb_map ([&c] (const hb_accelerate_subtables_context_t::hb_applicable_t &_) { return _.apply (c); })
       | hb_any
       ;
@@ -5905,6 +5980,61 @@ struct hb_ot_layout_lookup_accelerator_t
     return false;
   }
 
+  /* Built the first time it's needed, as long as the table's budget for
+   * these allows; returns nullptr if there is none. */
+  const hb_ot_layout_subtable_index_t *get_subtable_index () const
+  {
+    const auto *index = subtable_index.get_acquire ();
+    if (unlikely (!index))
+      index = create_subtable_index ();
+    return index == &Null (hb_ot_layout_subtable_index_t) ? nullptr : index;
+  }
+
+  HB_NEVER_INLINE
+  const hb_ot_layout_subtable_index_t *create_subtable_index () const
+  {
+    hb_ot_layout_subtable_index_t *index = nullptr;
+    int size = 0;
+
+    if (subtable_index_budget && count < hb_ot_layout_subtable_index_t::NO_SUBTABLE)
+    {
+      hb_set_t covered;
+      for (unsigned i = 0; i < count; i++)
+	subtables[i].coverage->collect_coverage (&covered);
+      unsigned length = covered.is_empty () ? 0 : covered.get_max () + 1;
+
+      if (length && length <= HB_OT_LAYOUT_SUBTABLE_INDEX_MAX_BYTES)
+      {
+	size = sizeof (hb_ot_layout_subtable_index_t) - HB_VAR_ARRAY * sizeof (uint8_t) + length;
+	if (subtable_index_budget->add (-size) >= size)
+	  index = (hb_ot_layout_subtable_index_t *) hb_malloc (size);
+	if (likely (index))
+	{
+	  index->length = length;
+	  hb_memset (index->first, hb_ot_layout_subtable_index_t::NO_SUBTABLE, length);
+	  for (unsigned i = count; i--;)
+	    for (hb_codepoint_t g : subtables[i].coverage->iter ())
+	      index->first[g] = i;
+	}
+	else
+	  subtable_index_budget->add (size);
+      }
+    }
+
+    /* Remember if there is none, so we don't try again. */
+    auto *stored = index ? index : const_cast<hb_ot_layout_subtable_index_t *> (&Null (hb_ot_layout_subtable_index_t));
+    if (unlikely (!subtable_index.cmpexch (nullptr, stored)))
+    {
+      if (index)
+      {
+	hb_free (index);
+	subtable_index_budget->add (size);
+      }
+      stored = subtable_index.get_acquire ();
+    }
+    return stored;
+  }
+
   bool cache_enter (hb_ot_apply_context_t *c) const
   {
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
@@ -5928,6 +6058,9 @@ struct hb_ot_layout_lookup_accelerator_t
 #ifndef HB_NO_OT_LAYOUT_LOOKUP_CACHE
   unsigned subtable_cache_user_idx = (unsigned) -1;
 #endif
+  hb_atomic_t<int> *subtable_index_budget = nullptr; /* Shared by the table's lookups. */
+  mutable hb_atomic_t<hb_ot_layout_subtable_index_t *> subtable_index;
+  bool subtable_index_is_borrowed = false; /* Lives in a face snapshot. */
   hb_accelerate_subtables_context_t::hb_applicable_t subtables[HB_VAR_ARRAY];
 };
 
@@ -6300,6 +6433,9 @@ struct GSUBGPOS
       }
 
       this->lookup_count = table->get_lookup_count ();
+#ifndef HB_NO_FACE_SNAPSHOT
+      this->snapshot = face->snapshot;
+#endif
 
       this->accels = (hb_atomic_t<hb_ot_layout_lookup_accelerator_t *> *) hb_calloc (this->lookup_count, sizeof (*accels));
       if (unlikely (!this->accels))
@@ -6332,7 +6468,16 @@ struct GSUBGPOS
       auto *accel = accels[lookup_index].get_acquire ();
       if (unlikely (!accel))
       {
-	accel = hb_ot_layout_lookup_accelerator_t::create (table->get_lookup (lookup_index));
+	const hb_face_snapshot_lookup_t *snapshot_lookup = nullptr;
+#ifndef HB_NO_FACE_SNAPSHOT
+	if (snapshot)
+	  snapshot_lookup = snapshot->get_lookup (T::tableTag == HB_OT_TAG_GSUB ? hb_face_snapshot_t::GSUB
+										 : hb_face_snapshot_t::GPOS,
+						  lookup_index, lookup_count);
+#endif
+	accel = hb_ot_layout_lookup_accelerator_t::create (table->get_lookup (lookup_index),
+							   &subtable_index_budget,
+							   snapshot, snapshot_lookup);
 	if (unlikely (!accel))
 	  return nullptr;
 
@@ -6350,6 +6495,9 @@ struct GSUBGPOS
     hb_blob_ptr_t<T> table;
     unsigned int lookup_count;
     hb_atomic_t<hb_ot_layout_lookup_accelerator_t *> *accels;
+    /* Bytes left for the lookups' subtable indices. */
+    mutable hb_atomic_t<int> subtable_index_budget {HB_OT_LAYOUT_SUBTABLE_INDEX_MAX_BYTES};
+    const hb_face_snapshot_t *snapshot = nullptr;
   };
 
   protected:
@@ -0,0 +1,302 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_OT_LAYOUT_SCAN_HH
+#define HB_OT_LAYOUT_SCAN_HH
+
+#include "hb.hh"
+
+#include "hb-set-digest.hh"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HB_OT_LAYOUT_SCAN_AVX2 1
+#define HB_OT_LAYOUT_SCAN_VECTOR_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HB_OT_LAYOUT_SCAN_SSE2 1
+#define HB_OT_LAYOUT_SCAN_VECTOR_WIDTH 4
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && \
+      !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#include <arm_neon.h>
+#define HB_OT_LAYOUT_SCAN_NEON 1
+#define HB_OT_LAYOUT_SCAN_VECTOR_WIDTH 4
+#endif
+
+
+/*
+ * Skip-scan for applying a lookup.
+ *
+ * Before trying a lookup on a glyph, apply_forward() checks that the glyph
+ * may be in the lookup's coverage digest, that its mask has the lookup
+ * mask, and that the lookup flags don't ignore its class.  Most glyphs fail
+ * one of those for most lookups, so we do those checks on several glyphs
+ * at a time, and only stop at glyphs that pass.
+ *
+ * Mark glyphs may still be rejected by mark filtering; the caller goes on
+ * to check_glyph_property() for the glyphs we stop at.
+ */
+
+struct hb_ot_layout_scan_t
+{
+  hb_ot_layout_scan_t (const hb_set_digest_t &digest_,
+		       hb_mask_t lookup_mask_,
+		       unsigned int ignore_props_) :
+    digest (digest_), lookup_mask (lookup_mask_)
+  {
+    /* Glyph props live in the low half of var1; build a var1 value with
+     * the ignored ones, so the test works on var1 as a whole. */
+    hb_var_int_t v;
+    v.u32 = 0;
+    v.u16[0] = ignore_props_;
+    ignore_props = v.u32;
+  }
+
+  HB_ALWAYS_INLINE
+  bool may_apply (const hb_glyph_info_t &info) const
+  {
+    return digest.may_have (info.codepoint) &&
+	   (info.mask & lookup_mask) &&
+	   !(info.var1.u32 & ignore_props);
+  }
+
+  /* Returns the index of the first glyph in [start, end) that may_apply(),
+   * or end. */
+  unsigned int forward (const hb_glyph_info_t *info,
+			unsigned int start,
+			unsigned int end) const
+  {
+    unsigned int j = start;
+#ifdef HB_OT_LAYOUT_SCAN_VECTOR_WIDTH
+    /* The glyph we want is often close by; only go over whole blocks once
+     * a few glyphs one by one didn't find it. */
+    for (unsigned int stop = hb_min (end, j + HB_OT_LAYOUT_SCAN_VECTOR_WIDTH); j < stop; j++)
+      if (may_apply (info[j]))
+	return j;
+    j = forward_vector (info, j, end);
+#endif
+    for (; j < end; j++)
+      if (may_apply (info[j]))
+	break;
+    return j;
+  }
+
+  /* Slow, reference version of forward(), for testing. */
+  unsigned int forward_scalar (const hb_glyph_info_t *info,
+			       unsigned int start,
+			       unsigned int end) const
+  {
+    unsigned int j = start;
+    while (j < end && !may_apply (info[j]))
+      j++;
+    return j;
+  }
+
+  /* The vector versions below go over whole blocks of glyphs, and return
+   * the index of the first glyph that may_apply(), or of the first glyph
+   * of the partial block at the end, for forward() to finish off.
+   *
+   * Digest masks are 64 bits, but vector lanes are 32, and variable
+   * per-lane shifts of 64-bit lanes are not to be had everywhere.  So for
+   * a digest bit index k we pick the low or high half of the mask by bit 5
+   * of k, and test bit (k & 31) of it. */
+
+#if defined(HB_OT_LAYOUT_SCAN_AVX2)
+  unsigned int forward_vector (const hb_glyph_info_t *info,
+			       unsigned int j,
+			       unsigned int end) const
+  {
+    static_assert (sizeof (hb_glyph_info_t) == 5 * 4, "");
+    static_assert (hb_set_digest_t::n == 3, "");
+    const __m256i stride = _mm256_setr_epi32 (0, 5, 10, 15, 20, 25, 30, 35);
+    const __m256i zero = _mm256_setzero_si256 ();
+    const __m256i one = _mm256_set1_epi32 (1);
+    const __m256i b5 = _mm256_set1_epi32 (32);
+    const __m256i low5 = _mm256_set1_epi32 (31);
+    const __m256i lookup_mask_v = _mm256_set1_epi32 (lookup_mask);
+    const __m256i ignore_props_v = _mm256_set1_epi32 (ignore_props);
+    __m256i lo[3], hi[3];
+    for (unsigned int i = 0; i < 3; i++)
+    {
+      lo[i] = _mm256_set1_epi32 ((int) (uint32_t) digest.get_mask (i));
+      hi[i] = _mm256_set1_epi32 ((int) (uint32_t) (digest.get_mask (i) >> 32));
+    }
+
+    for (; j + 8 <= end; j += 8)
+    {
+      const int *p = (const int *) (info + j);
+      __m256i g = _mm256_i32gather_epi32 (p, stride, 4);
+      __m256i m = _mm256_i32gather_epi32 (p + 1, stride, 4);
+      __m256i v = _mm256_i32gather_epi32 (p + 3, stride, 4);
+
+      /* Lanes are all-ones for glyphs we skip. */
+      __m256i skip = _mm256_or_si256 (_mm256_cmpeq_epi32 (_mm256_and_si256 (m, lookup_mask_v), zero),
+				      _mm256_andnot_si256 (_mm256_cmpeq_epi32 (_mm256_and_si256 (v, ignore_props_v), zero),
+							   _mm256_set1_epi32 (-1)));
+      auto test = [&] (unsigned int i)
+      {
+	__m256i k = _mm256_srli_epi32 (g, hb_set_digest_shifts[i]);
+	__m256i bit = _mm256_sllv_epi32 (one, _mm256_and_si256 (k, low5));
+	__m256i word = _mm256_blendv_epi8 (lo[i], hi[i], _mm256_cmpeq_epi32 (_mm256_and_si256 (k, b5), b5));
+	skip = _mm256_or_si256 (skip, _mm256_cmpeq_epi32 (_mm256_and_si256 (word, bit), zero));
+      };
+      test (0); test (1); test (2);
+
+      unsigned int found = ~(unsigned int) _mm256_movemask_ps (_mm256_castsi256_ps (skip)) & 0xFFu;
+      if (found)
+	return j + hb_ctz (found);
+    }
+    return j;
+  }
+
+#elif defined(HB_OT_LAYOUT_SCAN_SSE2)
+  /* 1 << b for each lane, b in [0, 31], without a variable shift: build
+   * the float 2^b and convert.  2^31 converts to 0x80000000, the
+   * "integer indefinite" value, which happens to be just what we want. */
+  static HB_ALWAYS_INLINE __m128i
+  pow2 (__m128i b)
+  {
+    __m128i f = _mm_slli_epi32 (_mm_add_epi32 (b, _mm_set1_epi32 (127)), 23);
+    return _mm_cvttps_epi32 (_mm_castsi128_ps (f));
+  }
+
+  unsigned int forward_vector (const hb_glyph_info_t *info,
+			       unsigned int j,
+			       unsigned int end) const
+  {
+    static_assert (hb_set_digest_t::n == 3, "");
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i b5 = _mm_set1_epi32 (32);
+    const __m128i low5 = _mm_set1_epi32 (31);
+    const __m128i lookup_mask_v = _mm_set1_epi32 (lookup_mask);
+    const __m128i ignore_props_v = _mm_set1_epi32 (ignore_props);
+    __m128i lo[3], hi[3];
+    for (unsigned int i = 0; i < 3; i++)
+    {
+      lo[i] = _mm_set1_epi32 ((int) (uint32_t) digest.get_mask (i));
+      hi[i] = _mm_set1_epi32 ((int) (uint32_t) (digest.get_mask (i) >> 32));
+    }
+
+    for (; j + 4 <= end; j += 4)
+    {
+      /* Each load picks up codepoint, mask, cluster, and var1 of one
+       * glyph; transpose them into one vector each. */
+      __m128i r0 = _mm_loadu_si128 ((const __m128i *) (info + j + 0));
+      __m128i r1 = _mm_loadu_si128 ((const __m128i *) (info + j + 1));
+      __m128i r2 = _mm_loadu_si128 ((const __m128i *) (info + j + 2));
+      __m128i r3 = _mm_loadu_si128 ((const __m128i *) (info + j + 3));
+      __m128i t0 = _mm_unpacklo_epi32 (r0, r1); /* g0 g1 m0 m1 */
+      __m128i t1 = _mm_unpacklo_epi32 (r2, r3); /* g2 g3 m2 m3 */
+      __m128i t2 = _mm_unpackhi_epi32 (r0, r1); /* c0 c1 v0 v1 */
+      __m128i t3 = _mm_unpackhi_epi32 (r2, r3); /* c2 c3 v2 v3 */
+      __m128i g = _mm_unpacklo_epi64 (t0, t1);
+      __m128i m = _mm_unpackhi_epi64 (t0, t1);
+      __m128i v = _mm_unpackhi_epi64 (t2, t3);
+
+      /* Lanes are all-ones for glyphs we skip. */
+      __m128i skip = _mm_or_si128 (_mm_cmpeq_epi32 (_mm_and_si128 (m, lookup_mask_v), zero),
+				   _mm_andnot_si128 (_mm_cmpeq_epi32 (_mm_and_si128 (v, ignore_props_v), zero),
+						     _mm_set1_epi32 (-1)));
+      auto test = [&] (unsigned int i)
+      {
+	__m128i k = _mm_srli_epi32 (g, hb_set_digest_shifts[i]);
+	__m128i bit = pow2 (_mm_and_si128 (k, low5));
+	__m128i sel = _mm_cmpeq_epi32 (_mm_and_si128 (k, b5), b5);
+	__m128i word = _mm_or_si128 (_mm_andnot_si128 (sel, lo[i]), _mm_and_si128 (sel, hi[i]));
+	skip = _mm_or_si128 (skip, _mm_cmpeq_epi32 (_mm_and_si128 (word, bit), zero));
+      };
+      test (0); test (1); test (2);
+
+      unsigned int found = ~(unsigned int) _mm_movemask_ps (_mm_castsi128_ps (skip)) & 0xFu;
+      if (found)
+	return j + hb_ctz (found);
+    }
+    return j;
+  }
+
+#elif defined(HB_OT_LAYOUT_SCAN_NEON)
+  unsigned int forward_vector (const hb_glyph_info_t *info,
+			       unsigned int j,
+			       unsigned int end) const
+  {
+    static_assert (hb_set_digest_t::n == 3, "");
+    const uint32x4_t one = vdupq_n_u32 (1);
+    const uint32x4_t b5 = vdupq_n_u32 (32);
+    const uint32x4_t low5 = vdupq_n_u32 (31);
+    const uint32x4_t lookup_mask_v = vdupq_n_u32 (lookup_mask);
+    const uint32x4_t ignore_props_v = vdupq_n_u32 (ignore_props);
+    const uint32_t weights_[4] = {1, 2, 4, 8};
+    const uint32x4_t weights = vld1q_u32 (weights_);
+    uint32x4_t lo[3], hi[3];
+    for (unsigned int i = 0; i < 3; i++)
+    {
+      lo[i] = vdupq_n_u32 ((uint32_t) digest.get_mask (i));
+      hi[i] = vdupq_n_u32 ((uint32_t) (digest.get_mask (i) >> 32));
+    }
+
+    for (; j + 4 <= end; j += 4)
+    {
+      /* Each load picks up codepoint, mask, cluster, and var1 of one
+       * glyph; transpose them into one vector each. */
+      const uint32_t *p = (const uint32_t *) (info + j);
+      uint32x4_t r0 = vld1q_u32 (p + 0);
+      uint32x4_t r1 = vld1q_u32 (p + 5);
+      uint32x4_t r2 = vld1q_u32 (p + 10);
+      uint32x4_t r3 = vld1q_u32 (p + 15);
+      uint64x2_t t0 = vreinterpretq_u64_u32 (vzip1q_u32 (r0, r1)); /* g0 g1 m0 m1 */
+      uint64x2_t t1 = vreinterpretq_u64_u32 (vzip1q_u32 (r2, r3)); /* g2 g3 m2 m3 */
+      uint64x2_t t2 = vreinterpretq_u64_u32 (vzip2q_u32 (r0, r1)); /* c0 c1 v0 v1 */
+      uint64x2_t t3 = vreinterpretq_u64_u32 (vzip2q_u32 (r2, r3)); /* c2 c3 v2 v3 */
+      uint32x4_t g = vreinterpretq_u32_u64 (vzip1q_u64 (t0, t1));
+      uint32x4_t m = vreinterpretq_u32_u64 (vzip2q_u64 (t0, t1));
+      uint32x4_t v = vreinterpretq_u32_u64 (vzip2q_u64 (t2, t3));
+
+      /* Lanes are all-ones for glyphs we may apply to. */
+      uint32x4_t keep = vbicq_u32 (vtstq_u32 (m, lookup_mask_v),
+				   vtstq_u32 (v, ignore_props_v));
+      auto test = [&] (unsigned int i)
+      {
+	uint32x4_t k = vshrq_n_u32 (g, hb_set_digest_shifts[i]);
+	uint32x4_t bit = vshlq_u32 (one, vreinterpretq_s32_u32 (vandq_u32 (k, low5)));
+	uint32x4_t word = vbslq_u32 (vtstq_u32 (k, b5), hi[i], lo[i]);
+	keep = vandq_u32 (keep, vtstq_u32 (word, bit));
+      };
+      test (0); test (1); test (2);
+
+      unsigned int found = vaddvq_u32 (vandq_u32 (keep, weights));
+      if (found)
+	return j + hb_ctz (found);
+    }
+    return j;
+  }
+
+#endif
+
+  const hb_set_digest_t &digest;
+  hb_mask_t lookup_mask;
+  uint32_t ignore_props;
+};
+
+
+#endif /* HB_OT_LAYOUT_SCAN_HH */
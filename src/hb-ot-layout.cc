@@ -38,6 +38,7 @@
 
 #include "hb-open-type.hh"
 #include "hb-ot-layout.hh"
+#include "hb-ot-layout-scan.hh"
 #include "hb-ot-face.hh"
 #include "hb-ot-map.hh"
 #include "hb-map.hh"
@@ -1429,6 +1430,30 @@ hb_ot_layout_lookup_collect_glyphs (hb_face_t    *face,
 }
 #endif
 
+bool
+hb_ot_layout_lookup_is_single (hb_face_t    *face,
+			       hb_tag_t      table_tag,
+			       unsigned int  lookup_index,
+			       unsigned int *lookup_props /* OUT */)
+{
+  switch (table_tag)
+  {
+    case HB_OT_TAG_GSUB:
+    {
+      const OT::SubstLookup& l = face->table.GSUB->table->get_lookup (lookup_index);
+      *lookup_props = l.get_props ();
+      return l.is_single ();
+    }
+    case HB_OT_TAG_GPOS:
+    {
+      const OT::PosLookup& l = face->table.GPOS->table->get_lookup (lookup_index);
+      *lookup_props = l.get_props ();
+      return l.is_single ();
+    }
+  }
+  return false;
+}
+
 
 /* Variations support */
 
@@ -1919,16 +1944,17 @@ apply_forward (OT::hb_ot_apply_context_t *c,
 {
   bool use_hot_subtable_cache = accel.cache_enter (c);
 
+  hb_ot_layout_scan_t scan (accel.digest, c->lookup_mask,
+			    c->lookup_props & OT::LookupFlag::IgnoreFlags);
+
   bool ret = false;
   hb_buffer_t *buffer = c->buffer;
   while (buffer->successful)
   {
     hb_glyph_info_t *info = buffer->info;
     unsigned j = buffer->idx;
-    while (j < buffer->len &&
-	   !(accel.digest.may_have (info[j].codepoint) &&
-	     (info[j].mask & c->lookup_mask) &&
-	     c->check_glyph_property (&info[j], c->lookup_props)))
+    while ((j = scan.forward (info, j, buffer->len)) < buffer->len &&
+	   !c->check_glyph_property (&info[j], c->lookup_props))
       j++;
     if (unlikely (j > buffer->idx && !buffer->next_glyphs (j - buffer->idx)))
       break;
@@ -2006,6 +2032,89 @@ apply_string (OT::hb_ot_apply_context_t *c,
   return ret;
 }
 
+/* Applies a run of lookups marked by hb_ot_map_builder_t::fuse_lookups()
+ * in one pass: each glyph gets all lookups of the run, in order, before we
+ * move on to the next glyph. */
+template <typename Proxy>
+static inline void
+apply_fused (OT::hb_ot_apply_context_t *c,
+	     const Proxy &proxy,
+	     const hb_ot_map_t::lookup_map_t *lookups,
+	     unsigned int count)
+{
+  hb_buffer_t *buffer = c->buffer;
+
+  if (unlikely (!buffer->len))
+    return;
+
+  const OT::hb_ot_layout_lookup_accelerator_t *accels[HB_OT_MAP_MAX_FUSED_LOOKUPS];
+  /* Lookups that may match a glyph from before the run.  Others can only
+   * match a glyph some earlier lookup of the run substituted. */
+  bool active[HB_OT_MAP_MAX_FUSED_LOOKUPS];
+  bool any_active = false;
+  for (unsigned int k = 0; k < count; k++)
+  {
+    accels[k] = proxy.accel.get_accel (lookups[k].index);
+    active[k] = accels[k] &&
+		lookups[k].mask &&
+		accels[k]->digest.may_intersect (buffer->digest);
+    any_active |= active[k];
+  }
+  if (!any_active)
+    return;
+
+  /* The run shares all of these. */
+  c->set_auto_zwj (lookups[0].auto_zwj, false);
+  c->set_auto_zwnj (lookups[0].auto_zwnj, false);
+  c->set_random (false);
+  c->set_per_syllable (lookups[0].per_syllable, false);
+  c->set_lookup_props (proxy.accel.table->get_lookup (lookups[0].index).get_props ());
+
+  if (!Proxy::always_inplace)
+    buffer->clear_output ();
+
+  buffer->idx = 0;
+  while (buffer->idx < buffer->len && buffer->successful)
+  {
+    bool substituted = false;
+    for (unsigned int k = 0; k < count; k++)
+    {
+      if (!active[k] && !(substituted && accels[k] && lookups[k].mask))
+	continue;
+
+      const hb_glyph_info_t &cur = buffer->cur();
+      if (!accels[k]->digest.may_have (cur.codepoint) ||
+	  !(cur.mask & lookups[k].mask) ||
+	  !c->check_glyph_property (&cur, c->lookup_props))
+	continue;
+
+      c->set_lookup_index (lookups[k].index);
+      c->set_lookup_mask (lookups[k].mask, false);
+      if (!accels[k]->apply (c, false))
+	continue;
+      if (unlikely (!buffer->successful))
+	break;
+
+      /* Step back onto the glyph for the next lookup.  Single substitution
+       * never makes the output outgrow the input, so output is still being
+       * written over the input, and the substitute is in cur(). */
+      buffer->idx--;
+      if (!Proxy::always_inplace)
+      {
+	buffer->out_len--;
+	substituted = true;
+      }
+    }
+
+    if (unlikely (!buffer->successful))
+      break;
+    (void) buffer->next_glyph ();
+  }
+
+  if (!Proxy::always_inplace)
+    buffer->sync ();
+}
+
 template <typename Proxy>
 inline void hb_ot_map_t::apply (const Proxy &proxy,
 				const hb_ot_shape_plan_t *plan,
@@ -2028,6 +2137,16 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
     {
       auto &lookup = lookups[table_index][i];
 
+      if (lookup.fuse_next && !buffer->messaging ())
+      {
+	unsigned int count = 1;
+	while (lookups[table_index][i + count - 1].fuse_next)
+	  count++;
+	apply_fused (&c, proxy, &lookup, count);
+	i += count - 1;
+	continue;
+      }
+
       unsigned int lookup_index = lookup.index;
 
       auto *accel = proxy.accel.get_accel (lookup_index);
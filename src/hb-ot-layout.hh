@@ -62,6 +62,14 @@ hb_ot_layout_kern (const hb_ot_shape_plan_t *plan,
 
 /* Private API corresponding to hb-ot-layout.h: */
 
+/* Whether the lookup only has single substitution / adjustment subtables,
+ * each of which acts on one glyph alone. */
+HB_INTERNAL bool
+hb_ot_layout_lookup_is_single (hb_face_t    *face,
+			       hb_tag_t      table_tag,
+			       unsigned int  lookup_index,
+			       unsigned int *lookup_props /* OUT */);
+
 HB_INTERNAL bool
 hb_ot_layout_table_find_feature (hb_face_t    *face,
 				 hb_tag_t      table_tag,
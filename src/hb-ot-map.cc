@@ -163,6 +163,7 @@ hb_ot_map_builder_t::add_lookups (hb_ot_map_t  &m,
       lookup->auto_zwj = auto_zwj;
       lookup->random = random;
       lookup->per_syllable = per_syllable;
+      lookup->fuse_next = false;
       lookup->feature_tag = feature_tag;
     }
 
@@ -171,6 +172,52 @@ hb_ot_map_builder_t::add_lookups (hb_ot_map_t  &m,
 }
 
 
+/* Lookups that only do single substitution or adjustment act on each
+ * glyph alone: what one does to a glyph depends on nothing but that glyph.
+ * Applying a run of them one after the other to each glyph in turn, in a
+ * single pass, hence gives the same result as applying them one after the
+ * other to the whole buffer, whatever their coverage.  Mark runs of such
+ * lookups within a stage that also agree on lookup flags and the other
+ * matching knobs, so hb_ot_map_t::apply() can set those up once per run. */
+void
+hb_ot_map_builder_t::fuse_lookups (hb_ot_map_t  &m,
+				   unsigned int  table_index)
+{
+  auto &lookups = m.lookups[table_index];
+
+  hb_vector_t<unsigned> props;
+  hb_vector_t<bool> single;
+  if (unlikely (!props.resize_exact (lookups.length) ||
+		!single.resize_exact (lookups.length)))
+    return;
+  for (unsigned int i = 0; i < lookups.length; i++)
+    single.arrayZ[i] = hb_ot_layout_lookup_is_single (face,
+						      table_tags[table_index],
+						      lookups.arrayZ[i].index,
+						      &props.arrayZ[i]);
+
+  unsigned int start = 0;
+  for (const auto &stage : m.stages[table_index])
+  {
+    unsigned int run_length = 1;
+    for (unsigned int i = start; i + 1 < stage.last_lookup; i++)
+    {
+      const auto &a = lookups.arrayZ[i];
+      const auto &b = lookups.arrayZ[i + 1];
+      bool fuse = single.arrayZ[i] && single.arrayZ[i + 1] &&
+		  props.arrayZ[i] == props.arrayZ[i + 1] &&
+		  a.auto_zwnj == b.auto_zwnj &&
+		  a.auto_zwj == b.auto_zwj &&
+		  !a.random && !b.random &&
+		  a.per_syllable == b.per_syllable &&
+		  run_length < HB_OT_MAP_MAX_FUSED_LOOKUPS;
+      lookups.arrayZ[i].fuse_next = fuse;
+      run_length = fuse ? run_length + 1 : 1;
+    }
+    start = stage.last_lookup;
+  }
+}
+
 void hb_ot_map_builder_t::add_pause (unsigned int table_index, hb_ot_map_t::pause_func_t pause_func)
 {
   stage_info_t *s = stages[table_index].push ();
@@ -387,6 +434,8 @@ hb_ot_map_builder_t::compile (hb_ot_map_t                  &m,
 	stage_index++;
       }
     }
+
+    fuse_lookups (m, table_index);
   }
 }
 
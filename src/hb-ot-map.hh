@@ -75,6 +75,9 @@ struct hb_ot_map_t
     unsigned short auto_zwj : 1;
     unsigned short random : 1;
     unsigned short per_syllable : 1;
+    /* Applied in the same pass over the buffer as the next lookup; see
+     * hb_ot_map_builder_t::fuse_lookups(). */
+    unsigned short fuse_next : 1;
     hb_mask_t mask;
     hb_tag_t feature_tag;
 
@@ -161,6 +164,20 @@ struct hb_ot_map_t
   }
 
   HB_INTERNAL void collect_lookups (unsigned int table_index, hb_set_t *lookups) const;
+
+  unsigned int get_num_lookups (unsigned int table_index) const
+  { return lookups[table_index].length; }
+
+  /* Passes over the buffer applying the lookups of the table takes, at
+   * most; each run of fused lookups takes one. */
+  unsigned int get_num_passes (unsigned int table_index) const
+  {
+    unsigned int count = 0;
+    for (const lookup_map_t &lookup : lookups[table_index])
+      count += !lookup.fuse_next;
+    return count;
+  }
+
   template <typename Proxy>
   HB_INTERNAL void apply (const Proxy &proxy,
 			  const struct hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer) const;
@@ -170,6 +187,13 @@ struct hb_ot_map_t
 					     unsigned int *tag_count, /* IN/OUT */
 					     hb_tag_t     *tags /* OUT */) const;
 
+  size_t get_size () const
+  {
+    return features.get_size () +
+	   lookups[0].get_size () + lookups[1].get_size () +
+	   stages[0].get_size () + stages[1].get_size ();
+  }
+
   public:
   hb_tag_t chosen_script[2];
   bool found_script[2];
@@ -255,6 +279,9 @@ struct hb_ot_map_builder_t
 				bool          per_syllable = false,
 				hb_tag_t      feature_tag = HB_TAG(' ',' ',' ',' '));
 
+  HB_INTERNAL void fuse_lookups (hb_ot_map_t &m,
+				 unsigned int table_index);
+
   struct feature_info_t {
     hb_tag_t tag;
     unsigned int seq; /* sequence#, used for stable sorting only */
@@ -127,6 +127,9 @@ struct hb_ot_shape_plan_t
     map.collect_lookups (table_index, lookups);
   }
 
+  size_t get_size () const
+  { return map.get_size () + aat_map.get_size (); }
+
   HB_INTERNAL bool init0 (hb_face_t                     *face,
 			  const hb_shape_plan_key_t     *key);
   HB_INTERNAL void fini ();
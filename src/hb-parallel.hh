@@ -0,0 +1,224 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_PARALLEL_HH
+#define HB_PARALLEL_HH
+
+#include "hb.hh"
+#include "hb-mutex.hh"
+#include "hb-vector.hh"
+
+#if !defined(HB_NO_MT) && defined(HAVE_PTHREAD)
+#define HB_PARALLEL_PTHREAD 1
+#include <pthread.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#endif
+
+
+/*
+ * hb_parallel_for()
+ *
+ * Runs func (worker, item) for every item in [0, count), spread over up to
+ * num_threads threads, the calling thread being worker zero.  Each worker
+ * starts with a contiguous share of the items in its own queue, takes items
+ * from the front of it, and when it runs dry steals the back half of
+ * another worker's queue.  No new work is ever produced, so a worker that
+ * finds every queue empty is done.
+ *
+ * Without thread support, or if threads fail to start, the remaining
+ * workers' shares are stolen by the ones that did, down to the calling
+ * thread doing everything.
+ */
+
+struct hb_parallel_queue_t
+{
+  hb_mutex_t lock;
+  unsigned start = 0;
+  unsigned end = 0;
+
+  bool pop (unsigned *item)
+  {
+    hb_lock_t l (lock);
+    if (start == end) return false;
+    *item = start++;
+    return true;
+  }
+
+  /* Takes the back half; the front is left to the owner, whose caches
+   * are likely warmer for it. */
+  bool steal (unsigned *start_, unsigned *end_)
+  {
+    hb_lock_t l (lock);
+    unsigned n = end - start;
+    if (!n) return false;
+    *end_ = end;
+    end -= (n + 1) / 2;
+    *start_ = end;
+    return true;
+  }
+
+  void set (unsigned start_, unsigned end_)
+  {
+    hb_lock_t l (lock);
+    start = start_;
+    end = end_;
+  }
+};
+
+template <typename Func>
+struct hb_parallel_t
+{
+  hb_parallel_t (Func &func_, unsigned num_workers_, unsigned count) :
+    func (func_), num_workers (num_workers_)
+  {
+    queues = (hb_parallel_queue_t *) hb_calloc (num_workers, sizeof (queues[0]));
+    if (unlikely (!queues))
+      return;
+    for (unsigned i = 0; i < num_workers; i++)
+    {
+      new (&queues[i]) hb_parallel_queue_t ();
+      queues[i].set ((uint64_t) count * i / num_workers,
+		     (uint64_t) count * (i + 1) / num_workers);
+    }
+  }
+  ~hb_parallel_t ()
+  {
+    if (!queues) return;
+    for (unsigned i = 0; i < num_workers; i++)
+      queues[i].~hb_parallel_queue_t ();
+    hb_free (queues);
+  }
+
+  void work (unsigned worker)
+  {
+    hb_parallel_queue_t &own = queues[worker];
+    for (;;)
+    {
+      unsigned item;
+      while (own.pop (&item))
+	func (worker, item);
+
+      /* Steal from the other workers, nearest first. */
+      unsigned start, end;
+      bool stolen = false;
+      for (unsigned i = 1; i < num_workers && !stolen; i++)
+	stolen = queues[(worker + i) % num_workers].steal (&start, &end);
+      if (!stolen)
+	return;
+      own.set (start, end);
+    }
+  }
+
+  Func &func;
+  unsigned num_workers;
+  hb_parallel_queue_t *queues = nullptr;
+};
+
+#ifdef HB_PARALLEL_PTHREAD
+template <typename Func>
+struct hb_parallel_worker_t
+{
+  hb_parallel_t<Func> *parallel;
+  unsigned worker;
+  pthread_t thread;
+
+  static void *run (void *p)
+  {
+    auto *w = (hb_parallel_worker_t *) p;
+    w->parallel->work (w->worker);
+    return nullptr;
+  }
+};
+#endif
+
+/* Returns the number of workers to use for a num_threads argument of a
+ * public API; zero means one per online processor. */
+static inline unsigned
+hb_parallel_num_threads (unsigned num_threads)
+{
+#ifdef HB_PARALLEL_PTHREAD
+  if (!num_threads)
+  {
+#if defined(HAVE_SYSCONF) && defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    num_threads = n > 0 ? (unsigned) n : 1;
+#else
+    num_threads = 1;
+#endif
+  }
+  return hb_clamp (num_threads, 1u, 256u);
+#else
+  return 1;
+#endif
+}
+
+/* Returns false on allocation failure, in which case no item was run. */
+template <typename Func>
+static inline bool
+hb_parallel_for (unsigned num_threads, unsigned count, Func &&func)
+{
+  num_threads = hb_min (hb_parallel_num_threads (num_threads), hb_max (count, 1u));
+
+  if (num_threads == 1)
+  {
+    for (unsigned i = 0; i < count; i++)
+      func (0u, i);
+    return true;
+  }
+
+  hb_parallel_t<Func> parallel (func, num_threads, count);
+  if (unlikely (!parallel.queues))
+    return false;
+
+#ifdef HB_PARALLEL_PTHREAD
+  hb_vector_t<hb_parallel_worker_t<Func>> workers;
+  if (likely (workers.resize_exact (num_threads - 1)))
+    for (unsigned i = 0; i < workers.length; i++)
+    {
+      auto &w = workers.arrayZ[i];
+      w.parallel = &parallel;
+      w.worker = i + 1;
+      if (pthread_create (&w.thread, nullptr, hb_parallel_worker_t<Func>::run, &w))
+      {
+	/* Whatever was not started gets stolen by the workers we have. */
+	workers.shrink (i);
+	break;
+      }
+    }
+#endif
+
+  parallel.work (0);
+
+#ifdef HB_PARALLEL_PTHREAD
+  for (auto &w : workers)
+    pthread_join (w.thread, nullptr);
+#endif
+
+  return true;
+}
+
+
+#endif /* HB_PARALLEL_HH */
@@ -0,0 +1,722 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+
+#include "hb-raster-image.hh"
+#include "hb-map.hh"
+
+
+/*
+ * Glyph atlas.
+ *
+ * Rendered glyphs are packed into fixed-size pages with a skyline
+ * packer: each page keeps the height of its filled area per run of
+ * columns, and a glyph goes wherever it lands lowest.  Glyphs are never
+ * removed one by one; when the byte budget allows no new page, the
+ * least recently used page is emptied and reused.
+ */
+
+/* Empty pixels around each glyph, so that filtered sampling of one
+ * glyph doesn't pick up its neighbors. */
+#define HB_RASTER_ATLAS_PADDING 1
+
+struct hb_raster_atlas_key_t
+{
+  hb_face_t *face;
+  hb_codepoint_t glyph;
+  int x_scale, y_scale;
+  float slant;
+  float x_embolden, y_embolden;
+  bool embolden_in_place;
+  uint8_t x_bucket, y_bucket;
+  unsigned palette;
+  hb_color_t foreground;
+  hb_vector_t<int> coords;
+
+  uint32_t hash () const
+  {
+    uint32_t h = hb_hash ((uintptr_t) face);
+    h = h * 31 + glyph;
+    h = h * 31 + hb_hash (x_scale);
+    h = h * 31 + hb_hash (y_scale);
+    h = h * 31 + hb_hash (slant);
+    h = h * 31 + hb_hash (x_embolden);
+    h = h * 31 + hb_hash (y_embolden);
+    h = h * 31 + (embolden_in_place | x_bucket << 1 | y_bucket << 9);
+    h = h * 31 + palette;
+    h = h * 31 + foreground;
+    h = h * 31 + coords.as_array ().hash ();
+    return h;
+  }
+
+  bool operator == (const hb_raster_atlas_key_t &o) const
+  {
+    return face == o.face &&
+	   glyph == o.glyph &&
+	   x_scale == o.x_scale && y_scale == o.y_scale &&
+	   slant == o.slant &&
+	   x_embolden == o.x_embolden && y_embolden == o.y_embolden &&
+	   embolden_in_place == o.embolden_in_place &&
+	   x_bucket == o.x_bucket && y_bucket == o.y_bucket &&
+	   palette == o.palette &&
+	   foreground == o.foreground &&
+	   coords.as_array () == o.coords.as_array ();
+  }
+};
+
+struct hb_raster_atlas_page_t
+{
+  struct node_t
+  {
+    unsigned x, y, width;
+  };
+
+  hb_raster_image_t *image = nullptr;
+  hb_vector_t<node_t> skyline;
+  uint64_t last_used = 0;
+  /* Changes whenever pixels change, and when the page is emptied. */
+  unsigned serial = 0;
+  /* Changes only when the page is emptied, dropping its glyphs. */
+  unsigned generation = 0;
+
+  void reset (unsigned width, unsigned serial_)
+  {
+    skyline.reset ();
+    skyline.push (node_t {0, 0, width});
+    serial = generation = serial_;
+  }
+
+  /* Finds the lowest spot @width x @height fits, and claims it. */
+  bool pack (unsigned width, unsigned height,
+	     unsigned page_width, unsigned page_height,
+	     unsigned *x, unsigned *y)
+  {
+    unsigned best = (unsigned) -1;
+    unsigned best_x = 0, best_y = (unsigned) -1;
+
+    for (unsigned i = 0; i < skyline.length; i++)
+    {
+      unsigned nx = skyline.arrayZ[i].x;
+      if (width > page_width - nx)
+	break;
+
+      /* The spot rests on the highest of the nodes it spans. */
+      unsigned ny = 0;
+      unsigned left = width;
+      for (unsigned j = i; left; j++)
+      {
+	ny = hb_max (ny, skyline.arrayZ[j].y);
+	left -= hb_min (left, skyline.arrayZ[j].width);
+      }
+      if (height > page_height - ny)
+	continue;
+
+      if (ny < best_y)
+      {
+	best = i;
+	best_x = nx;
+	best_y = ny;
+      }
+    }
+    if (best == (unsigned) -1)
+      return false;
+
+    if (unlikely (!skyline.push ()))
+      return false;
+    for (unsigned i = skyline.length - 1; i > best; i--)
+      skyline.arrayZ[i] = skyline.arrayZ[i - 1];
+    skyline.arrayZ[best] = node_t {best_x, best_y + height, width};
+
+    /* Trim the nodes the new one covers. */
+    unsigned end = best_x + width;
+    unsigned i = best + 1;
+    while (i < skyline.length && skyline.arrayZ[i].x < end)
+    {
+      node_t &node = skyline.arrayZ[i];
+      unsigned covered = end - node.x;
+      if (covered >= node.width)
+      {
+	skyline.remove_ordered (i);
+	continue;
+      }
+      node.x += covered;
+      node.width -= covered;
+      break;
+    }
+
+    /* Merge neighbors of the same height. */
+    for (i = 0; i + 1 < skyline.length;)
+      if (skyline.arrayZ[i].y == skyline.arrayZ[i + 1].y)
+      {
+	skyline.arrayZ[i].width += skyline.arrayZ[i + 1].width;
+	skyline.remove_ordered (i + 1);
+      }
+      else
+	i++;
+
+    *x = best_x;
+    *y = best_y;
+    return true;
+  }
+};
+
+/* hb_raster_atlas_t — cache of rendered glyphs */
+struct hb_raster_atlas_t
+{
+  hb_object_header_t header;
+
+  hb_raster_format_t format = HB_RASTER_FORMAT_A8;
+  unsigned page_width = 0, page_height = 0;
+  unsigned max_bytes = HB_RASTER_ATLAS_MAX_BYTES_DEFAULT;
+  unsigned palette = 0;
+  hb_color_t foreground = HB_COLOR (0, 0, 0, 255);
+
+  hb_hashmap_t<hb_raster_atlas_key_t, hb_raster_atlas_glyph_t> glyphs;
+  hb_vector_t<hb_raster_atlas_page_t> pages;
+  hb_vector_t<hb_face_t *> faces; /* Referenced. */
+  uint64_t clock = 0;
+  /* Source of page serials and generations; never reused, even after
+   * a clear. */
+  unsigned serial = 0;
+
+  /* For rendering glyphs that aren't cached. */
+  hb_raster_draw_t *draw = nullptr;
+  hb_raster_paint_t *paint = nullptr;
+
+  unsigned page_bytes () const
+  { return page_height * page_width * hb_raster_image_t::bytes_per_pixel (format); }
+
+  unsigned max_pages () const
+  { return hb_max (1u, max_bytes / hb_max (1u, page_bytes ())); }
+
+  void evict_page (unsigned index)
+  {
+    hb_vector_t<hb_raster_atlas_key_t> evicted;
+    for (auto _ : glyphs.iter_ref ())
+      if (_.second.page == index && _.second.width)
+	evicted.push (_.first);
+    for (const auto &key : evicted)
+      glyphs.del (key);
+
+    hb_raster_atlas_page_t &page = pages.arrayZ[index];
+    page.image->clear ();
+    page.reset (page_width, ++serial);
+  }
+
+  /* Renders @glyph with its pen position at (@dx, @dy) pixels. */
+  hb_raster_image_t *render (hb_font_t *font, hb_codepoint_t glyph,
+			     float dx, float dy)
+  {
+    hb_glyph_extents_t extents;
+    bool has_extents = hb_font_get_glyph_extents (font, glyph, &extents);
+
+    if (format == HB_RASTER_FORMAT_A8)
+    {
+      hb_raster_draw_reset (draw);
+      hb_raster_draw_set_transform (draw, 1, 0, 0, 1, dx, dy);
+      if (has_extents)
+	hb_raster_draw_set_glyph_extents (draw, &extents);
+      hb_raster_draw_glyph (draw, font, glyph);
+      return hb_raster_draw_render (draw);
+    }
+
+    hb_raster_paint_reset (paint);
+    hb_raster_paint_set_transform (paint, 1, 0, 0, 1, dx, dy);
+    hb_raster_paint_set_palette (paint, palette);
+    hb_raster_paint_set_foreground (paint, foreground);
+    if (!has_extents || !hb_raster_paint_set_glyph_extents (paint, &extents))
+    {
+      hb_raster_extents_t empty = {0, 0, 0, 0, 0};
+      hb_raster_paint_set_extents (paint, &empty);
+    }
+    else
+      hb_raster_paint_glyph (paint, font, glyph);
+    return hb_raster_paint_render (paint);
+  }
+
+  void recycle (hb_raster_image_t *image)
+  {
+    if (format == HB_RASTER_FORMAT_A8)
+      hb_raster_draw_recycle_image (draw, image);
+    else
+      hb_raster_paint_recycle_image (paint, image);
+  }
+
+  /* Finds room for @width x @height, emptying a page if need be. */
+  bool place (unsigned width, unsigned height,
+	      unsigned *page, unsigned *x, unsigned *y)
+  {
+    width += HB_RASTER_ATLAS_PADDING;
+    height += HB_RASTER_ATLAS_PADDING;
+    if (width > page_width || height > page_height)
+      return false;
+
+    for (unsigned i = 0; i < pages.length; i++)
+      if (pages.arrayZ[i].pack (width, height, page_width, page_height, x, y))
+      {
+	pages.arrayZ[i].serial = ++serial;
+	*page = i;
+	return true;
+      }
+
+    unsigned index;
+    if (pages.length < max_pages ())
+    {
+      hb_raster_image_t *image = hb_raster_image_create_or_fail ();
+      hb_raster_extents_t extents = {0, 0, page_width, page_height, 0};
+      if (unlikely (!image ||
+		    !image->configure (format, extents) ||
+		    !pages.push ()))
+      {
+	hb_raster_image_destroy (image);
+	return false;
+      }
+      image->clear ();
+      index = pages.length - 1;
+      pages.arrayZ[index].image = image;
+      pages.arrayZ[index].reset (page_width, ++serial);
+    }
+    else
+    {
+      index = 0;
+      for (unsigned i = 1; i < pages.length; i++)
+	if (pages.arrayZ[i].last_used < pages.arrayZ[index].last_used)
+	  index = i;
+      evict_page (index);
+    }
+
+    *page = index;
+    if (!pages.arrayZ[index].pack (width, height, page_width, page_height, x, y))
+      return false;
+    pages.arrayZ[index].serial = ++serial;
+    return true;
+  }
+};
+
+
+/**
+ * hb_raster_atlas_create_or_fail:
+ * @format: pixel format of the pages
+ * @page_width: width of each page, in pixels
+ * @page_height: height of each page, in pixels
+ *
+ * Creates a new glyph atlas.  Glyphs are rendered with
+ * #hb_raster_draw_t for @HB_RASTER_FORMAT_A8 and with
+ * #hb_raster_paint_t for @HB_RASTER_FORMAT_BGRA32.
+ *
+ * An atlas is not thread-safe; use one per thread.
+ *
+ * Return value: (transfer full):
+ * A newly allocated #hb_raster_atlas_t, or `NULL` on allocation failure
+ * or if a page dimension is zero.
+ *
+ * Since: REPLACEME
+ **/
+hb_raster_atlas_t *
+hb_raster_atlas_create_or_fail (hb_raster_format_t format,
+				unsigned int       page_width,
+				unsigned int       page_height)
+{
+  if (unlikely (!page_width || !page_height ||
+		(format != HB_RASTER_FORMAT_A8 && format != HB_RASTER_FORMAT_BGRA32)))
+    return nullptr;
+
+  hb_raster_atlas_t *atlas = hb_object_create<hb_raster_atlas_t> ();
+  if (unlikely (!atlas))
+    return nullptr;
+
+  atlas->format = format;
+  atlas->page_width = page_width;
+  atlas->page_height = page_height;
+  if (format == HB_RASTER_FORMAT_A8)
+    atlas->draw = hb_raster_draw_create_or_fail ();
+  else
+    atlas->paint = hb_raster_paint_create_or_fail ();
+  if (unlikely (!atlas->draw && !atlas->paint))
+  {
+    hb_raster_atlas_destroy (atlas);
+    return nullptr;
+  }
+
+  return atlas;
+}
+
+/**
+ * hb_raster_atlas_reference: (skip)
+ * @atlas: a glyph atlas
+ *
+ * Increases the reference count on @atlas by one.
+ *
+ * Return value: (transfer full):
+ * The referenced #hb_raster_atlas_t.
+ *
+ * Since: REPLACEME
+ **/
+hb_raster_atlas_t *
+hb_raster_atlas_reference (hb_raster_atlas_t *atlas)
+{
+  return hb_object_reference (atlas);
+}
+
+/**
+ * hb_raster_atlas_destroy: (skip)
+ * @atlas: a glyph atlas
+ *
+ * Decreases the reference count on @atlas by one. When the
+ * reference count reaches zero, the atlas and its pages are freed.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_atlas_destroy (hb_raster_atlas_t *atlas)
+{
+  if (!hb_object_should_destroy (atlas))
+    return;
+
+  hb_raster_atlas_clear (atlas);
+  hb_raster_draw_destroy (atlas->draw);
+  hb_raster_paint_destroy (atlas->paint);
+  hb_object_actually_destroy (atlas);
+  hb_free (atlas);
+}
+
+/**
+ * hb_raster_atlas_set_user_data: (skip)
+ * @atlas: a glyph atlas
+ * @key: the user-data key
+ * @data: a pointer to the user data
+ * @destroy: (nullable): a callback to call when @data is not needed anymore
+ * @replace: whether to replace an existing data with the same key
+ *
+ * Attaches a user-data key/data pair to the specified atlas.
+ *
+ * Return value: `true` if success, `false` otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_atlas_set_user_data (hb_raster_atlas_t  *atlas,
+			       hb_user_data_key_t *key,
+			       void               *data,
+			       hb_destroy_func_t   destroy,
+			       hb_bool_t           replace)
+{
+  return hb_object_set_user_data (atlas, key, data, destroy, replace);
+}
+
+/**
+ * hb_raster_atlas_get_user_data: (skip)
+ * @atlas: a glyph atlas
+ * @key: the user-data key
+ *
+ * Fetches the user-data associated with the specified key,
+ * attached to the specified atlas.
+ *
+ * Return value: (transfer none):
+ * A pointer to the user data
+ *
+ * Since: REPLACEME
+ **/
+void *
+hb_raster_atlas_get_user_data (const hb_raster_atlas_t *atlas,
+			       hb_user_data_key_t      *key)
+{
+  return hb_object_get_user_data (atlas, key);
+}
+
+/**
+ * hb_raster_atlas_set_max_bytes:
+ * @atlas: a glyph atlas
+ * @max_bytes: the most page memory to use, in bytes
+ *
+ * Sets how much memory the pages of @atlas may use.  At least one page
+ * is always kept.  Once the budget is reached, the least recently used
+ * page is emptied to make room.  Lowering the budget below what the
+ * pages already use takes effect as pages are reused.
+ *
+ * The default is 16 megabytes.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_atlas_set_max_bytes (hb_raster_atlas_t *atlas,
+			       unsigned int       max_bytes)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->max_bytes = max_bytes;
+}
+
+/**
+ * hb_raster_atlas_get_max_bytes:
+ * @atlas: a glyph atlas
+ *
+ * Fetches the page memory budget of @atlas.
+ *
+ * Return value: The budget, in bytes.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_raster_atlas_get_max_bytes (const hb_raster_atlas_t *atlas)
+{
+  return atlas->max_bytes;
+}
+
+/**
+ * hb_raster_atlas_set_palette:
+ * @atlas: a glyph atlas
+ * @palette: a palette index
+ *
+ * Sets the color palette used to render color glyphs into a
+ * @HB_RASTER_FORMAT_BGRA32 atlas.  Glyphs rendered with different
+ * palettes are cached separately.  The default is palette 0.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_atlas_set_palette (hb_raster_atlas_t *atlas,
+			     unsigned int       palette)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->palette = palette;
+}
+
+/**
+ * hb_raster_atlas_set_foreground:
+ * @atlas: a glyph atlas
+ * @foreground: the foreground color
+ *
+ * Sets the foreground color used to render glyphs into a
+ * @HB_RASTER_FORMAT_BGRA32 atlas.  Glyphs rendered with different
+ * foreground colors are cached separately.  The default is opaque black.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_atlas_set_foreground (hb_raster_atlas_t *atlas,
+				hb_color_t         foreground)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+  atlas->foreground = foreground;
+}
+
+/**
+ * hb_raster_atlas_get_glyph:
+ * @atlas: a glyph atlas
+ * @font: font to render from
+ * @glyph: glyph ID
+ * @x_offset: horizontal pen position, in pixels
+ * @y_offset: vertical pen position, in pixels
+ * @atlas_glyph: (out): where the glyph is in @atlas
+ *
+ * Looks @glyph up in @atlas, rendering and adding it first if needed.
+ * The font's scale is taken as pixels, as with #hb_raster_draw_t.
+ *
+ * Only the fractional parts of @x_offset and @y_offset are used,
+ * rounded down to a quarter pixel; the origin returned in @atlas_glyph
+ * is relative to the pen position rounded down to whole pixels.
+ *
+ * Glyphs are cached by face, glyph ID, font scale, synthetic slant and
+ * bold, variation coordinates, that subpixel position, and for BGRA32
+ * atlases palette and foreground color.  The atlas keeps a reference to
+ * every face it has rendered a glyph from, until it is cleared.
+ *
+ * The returned location is valid until the generation of its page
+ * changes; see hb_raster_atlas_get_page().
+ *
+ * Return value: `true` if the glyph is in @atlas, `false` if it
+ * couldn't be rendered or doesn't fit in a page.  Glyphs without ink
+ * succeed with zero width and height.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_atlas_get_glyph (hb_raster_atlas_t       *atlas,
+			   hb_font_t               *font,
+			   hb_codepoint_t           glyph,
+			   float                    x_offset,
+			   float                    y_offset,
+			   hb_raster_atlas_glyph_t *atlas_glyph)
+{
+  if (unlikely (!atlas->draw && !atlas->paint))
+    return false;
+
+  float x_fract = x_offset - floorf (x_offset);
+  float y_fract = y_offset - floorf (y_offset);
+  if (!(x_fract >= 0.f && x_fract < 1.f)) x_fract = 0.f;
+  if (!(y_fract >= 0.f && y_fract < 1.f)) y_fract = 0.f;
+
+  hb_raster_atlas_key_t key;
+  key.face = hb_font_get_face (font);
+  key.glyph = glyph;
+  hb_font_get_scale (font, &key.x_scale, &key.y_scale);
+  key.slant = hb_font_get_synthetic_slant (font);
+  hb_bool_t in_place;
+  hb_font_get_synthetic_bold (font, &key.x_embolden, &key.y_embolden, &in_place);
+  key.embolden_in_place = in_place;
+  key.x_bucket = (uint8_t) (x_fract * HB_RASTER_ATLAS_SUBPIXEL_BUCKETS);
+  key.y_bucket = (uint8_t) (y_fract * HB_RASTER_ATLAS_SUBPIXEL_BUCKETS);
+  key.palette = atlas->format == HB_RASTER_FORMAT_BGRA32 ? atlas->palette : 0;
+  key.foreground = atlas->format == HB_RASTER_FORMAT_BGRA32 ? atlas->foreground : 0;
+  unsigned coords_length;
+  const int *coords = hb_font_get_var_coords_normalized (font, &coords_length);
+  key.coords.extend (hb_array (coords, coords_length));
+  if (unlikely (key.coords.in_error ()))
+    return false;
+
+  const hb_raster_atlas_glyph_t *cached;
+  if (atlas->glyphs.has (key, &cached))
+  {
+    if (cached->width)
+      atlas->pages.arrayZ[cached->page].last_used = ++atlas->clock;
+    *atlas_glyph = *cached;
+    return true;
+  }
+
+  hb_raster_image_t *image = atlas->render (font, glyph,
+					    (float) key.x_bucket / HB_RASTER_ATLAS_SUBPIXEL_BUCKETS,
+					    (float) key.y_bucket / HB_RASTER_ATLAS_SUBPIXEL_BUCKETS);
+  if (unlikely (!image))
+    return false;
+
+  hb_raster_extents_t extents;
+  hb_raster_image_get_extents (image, &extents);
+
+  hb_raster_atlas_glyph_t entry = {0, 0, 0, 0, 0, extents.x_origin, extents.y_origin};
+  if (extents.width && extents.height)
+  {
+    if (!atlas->place (extents.width, extents.height, &entry.page, &entry.x, &entry.y))
+    {
+      atlas->recycle (image);
+      return false;
+    }
+    entry.width = extents.width;
+    entry.height = extents.height;
+
+    hb_raster_atlas_page_t &page = atlas->pages.arrayZ[entry.page];
+    page.last_used = ++atlas->clock;
+    hb_raster_image_t *dst = page.image;
+    unsigned bpp = hb_raster_image_t::bytes_per_pixel (atlas->format);
+    for (unsigned row = 0; row < entry.height; row++)
+      hb_memcpy (dst->buffer.arrayZ + (entry.y + row) * dst->extents.stride + entry.x * bpp,
+		 image->buffer.arrayZ + row * extents.stride,
+		 entry.width * bpp);
+  }
+  atlas->recycle (image);
+
+  if (!atlas->faces.lfind (key.face))
+  {
+    atlas->faces.push (hb_face_reference (key.face));
+    if (unlikely (atlas->faces.in_error ()))
+    {
+      hb_face_destroy (key.face);
+      return false;
+    }
+  }
+  if (unlikely (!atlas->glyphs.set (std::move (key), entry)))
+    return false;
+
+  *atlas_glyph = entry;
+  return true;
+}
+
+/**
+ * hb_raster_atlas_get_page_count:
+ * @atlas: a glyph atlas
+ *
+ * Fetches the number of pages @atlas has allocated so far.
+ *
+ * Return value: The number of pages.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_raster_atlas_get_page_count (const hb_raster_atlas_t *atlas)
+{
+  return atlas->pages.length;
+}
+
+/**
+ * hb_raster_atlas_get_page:
+ * @atlas: a glyph atlas
+ * @page: a page index
+ * @serial: (out) (nullable): the serial number of the page
+ * @generation: (out) (nullable): the generation of the page
+ *
+ * Fetches the image of a page of @atlas.
+ *
+ * The serial number changes whenever the page's pixels change, as
+ * glyphs are added to it or it is emptied; it tells when a copy of the
+ * page, for example a GPU texture, needs updating.  The generation
+ * changes only when the page is emptied to make room, or the atlas is
+ * cleared; glyph locations in the page fetched before then have become
+ * stale and need looking up again.
+ *
+ * Return value: (transfer none) (nullable):
+ * The page image, owned by @atlas, or `NULL` if @page is out of range.
+ *
+ * Since: REPLACEME
+ **/
+const hb_raster_image_t *
+hb_raster_atlas_get_page (const hb_raster_atlas_t *atlas,
+			  unsigned int             page,
+			  unsigned int            *serial,
+			  unsigned int            *generation)
+{
+  if (page >= atlas->pages.length)
+    return nullptr;
+  if (serial)
+    *serial = atlas->pages.arrayZ[page].serial;
+  if (generation)
+    *generation = atlas->pages.arrayZ[page].generation;
+  return atlas->pages.arrayZ[page].image;
+}
+
+/**
+ * hb_raster_atlas_clear:
+ * @atlas: a glyph atlas
+ *
+ * Drops all cached glyphs and pages of @atlas, and the references it
+ * holds to faces.  Configuration is kept.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_atlas_clear (hb_raster_atlas_t *atlas)
+{
+  if (hb_object_is_immutable (atlas))
+    return;
+
+  atlas->glyphs.clear ();
+  for (auto &page : atlas->pages)
+    hb_raster_image_destroy (page.image);
+  atlas->pages.clear ();
+  for (hb_face_t *face : atlas->faces)
+    hb_face_destroy (face);
+  atlas->faces.clear ();
+}
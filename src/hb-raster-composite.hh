@@ -0,0 +1,1091 @@
+/*
+ * Copyright © 2026  Behdad Esfahbod
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ *
+ * Author(s): Behdad Esfahbod
+ */
+
+#ifndef HB_RASTER_COMPOSITE_HH
+#define HB_RASTER_COMPOSITE_HH
+
+#include "hb.hh"
+
+#include "hb-raster.hh"
+
+#include <math.h>
+
+/* HB_NO_RASTER_SIMD builds the scalar paths only, as on targets with
+ * none of these. */
+#if defined(HB_NO_RASTER_SIMD)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HB_RASTER_COMPOSITE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HB_RASTER_COMPOSITE_SSE2 1
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && \
+      !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#include <arm_neon.h>
+#define HB_RASTER_COMPOSITE_NEON 1
+#endif
+
+/* The vector code below matches the scalar code only if neither fuses
+ * multiplies and adds; keep the compiler from doing so on its own. */
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+
+/*
+ * Image compositing
+ */
+
+/* Unpack premultiplied pixel to float RGBA [0,1]. */
+static inline void
+unpack_to_float (uint32_t px, float &r, float &g, float &b, float &a)
+{
+  b = (px & 0xFF) / 255.f;
+  g = ((px >> 8) & 0xFF) / 255.f;
+  r = ((px >> 16) & 0xFF) / 255.f;
+  a = (px >> 24) / 255.f;
+}
+
+/* Pack float RGBA [0,1] premultiplied back to uint32_t. */
+static inline uint32_t
+pack_from_float (float r, float g, float b, float a)
+{
+  return hb_raster_pack_pixel ((uint8_t) (hb_clamp (b, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (g, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (r, 0.f, 1.f) * 255.f + 0.5f),
+			       (uint8_t) (hb_clamp (a, 0.f, 1.f) * 255.f + 0.5f));
+}
+
+/* Separable blend mode functions: operate on unpremultiplied [0,1] channels. */
+static inline float
+blend_multiply (float sc, float dc) { return sc * dc; }
+static inline float
+blend_screen (float sc, float dc) { return sc + dc - sc * dc; }
+static inline float
+blend_overlay (float sc, float dc)
+{ return dc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
+static inline float
+blend_darken (float sc, float dc) { return hb_min (sc, dc); }
+static inline float
+blend_lighten (float sc, float dc) { return hb_max (sc, dc); }
+static inline float
+blend_color_dodge (float sc, float dc)
+{
+  if (dc <= 0.f) return 0.f;
+  if (sc >= 1.f) return 1.f;
+  return hb_min (1.f, dc / (1.f - sc));
+}
+static inline float
+blend_color_burn (float sc, float dc)
+{
+  if (dc >= 1.f) return 1.f;
+  if (sc <= 0.f) return 0.f;
+  return 1.f - hb_min (1.f, (1.f - dc) / sc);
+}
+static inline float
+blend_hard_light (float sc, float dc)
+{ return sc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
+static inline float
+blend_soft_light (float sc, float dc)
+{
+  if (sc <= 0.5f)
+    return dc - (1.f - 2.f * sc) * dc * (1.f - dc);
+  float d = (dc <= 0.25f) ? ((16.f * dc - 12.f) * dc + 4.f) * dc
+			   : sqrtf (dc);
+  return dc + (2.f * sc - 1.f) * (d - dc);
+}
+static inline float
+blend_difference (float sc, float dc) { return fabsf (sc - dc); }
+static inline float
+blend_exclusion (float sc, float dc) { return sc + dc - 2.f * sc * dc; }
+
+/* Apply a separable blend mode per-pixel.
+ * Both src and dst are premultiplied BGRA32. */
+static inline uint32_t
+apply_separable_blend (uint32_t src, uint32_t dst,
+		       float (*blend_fn)(float, float))
+{
+  float sr, sg, sb, sa;
+  float dr, dg, db, da;
+  unpack_to_float (src, sr, sg, sb, sa);
+  unpack_to_float (dst, dr, dg, db, da);
+
+  float usr = sa > 0.f ? sr / sa : 0.f;
+  float usg = sa > 0.f ? sg / sa : 0.f;
+  float usb = sa > 0.f ? sb / sa : 0.f;
+  float udr = da > 0.f ? dr / da : 0.f;
+  float udg = da > 0.f ? dg / da : 0.f;
+  float udb = da > 0.f ? db / da : 0.f;
+
+  float br = blend_fn (usr, udr);
+  float bg = blend_fn (usg, udg);
+  float bb = blend_fn (usb, udb);
+
+  float ra = sa + da - sa * da;
+  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
+  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
+  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
+
+  return pack_from_float (rr, rg, rb, ra);
+}
+
+/* HSL helpers */
+static inline float
+hsl_luminosity (float r, float g, float b)
+{ return 0.299f * r + 0.587f * g + 0.114f * b; }
+
+static inline float
+hsl_saturation (float r, float g, float b)
+{ return hb_max (hb_max (r, g), b) - hb_min (hb_min (r, g), b); }
+
+static inline void
+hsl_clip_color (float &r, float &g, float &b)
+{
+  float l = hsl_luminosity (r, g, b);
+  float mn = hb_min (hb_min (r, g), b);
+  float mx = hb_max (hb_max (r, g), b);
+  if (mn < 0.f)
+  {
+    float d = l - mn;
+    if (d > 0.f) { r = l + (r - l) * l / d; g = l + (g - l) * l / d; b = l + (b - l) * l / d; }
+  }
+  if (mx > 1.f)
+  {
+    float d = mx - l;
+    if (d > 0.f) { r = l + (r - l) * (1.f - l) / d; g = l + (g - l) * (1.f - l) / d; b = l + (b - l) * (1.f - l) / d; }
+  }
+}
+
+static inline void
+hsl_set_luminosity (float &r, float &g, float &b, float l)
+{
+  float d = l - hsl_luminosity (r, g, b);
+  r += d; g += d; b += d;
+  hsl_clip_color (r, g, b);
+}
+
+static inline void
+hsl_set_saturation_inner (float &mn, float &mid, float &mx, float s)
+{
+  if (mx > mn)
+  {
+    mid = (mid - mn) * s / (mx - mn);
+    mx = s;
+  }
+  else
+    mid = mx = 0.f;
+  mn = 0.f;
+}
+
+static inline void
+hsl_set_saturation (float &r, float &g, float &b, float s)
+{
+  if (r <= g)
+  {
+    if (g <= b)      hsl_set_saturation_inner (r, g, b, s);
+    else if (r <= b) hsl_set_saturation_inner (r, b, g, s);
+    else             hsl_set_saturation_inner (b, r, g, s);
+  }
+  else
+  {
+    if (r <= b)      hsl_set_saturation_inner (g, r, b, s);
+    else if (g <= b) hsl_set_saturation_inner (g, b, r, s);
+    else             hsl_set_saturation_inner (b, g, r, s);
+  }
+}
+
+static inline uint32_t
+apply_hsl_blend (uint32_t src, uint32_t dst,
+		 hb_paint_composite_mode_t mode)
+{
+  float sr, sg, sb, sa;
+  float dr, dg, db, da;
+  unpack_to_float (src, sr, sg, sb, sa);
+  unpack_to_float (dst, dr, dg, db, da);
+
+  float usr = sa > 0.f ? sr / sa : 0.f;
+  float usg = sa > 0.f ? sg / sa : 0.f;
+  float usb = sa > 0.f ? sb / sa : 0.f;
+  float udr = da > 0.f ? dr / da : 0.f;
+  float udg = da > 0.f ? dg / da : 0.f;
+  float udb = da > 0.f ? db / da : 0.f;
+
+  float br = udr, bg = udg, bb = udb;
+
+  if (mode == HB_PAINT_COMPOSITE_MODE_HSL_HUE)
+  {
+    br = usr; bg = usg; bb = usb;
+    hsl_set_saturation (br, bg, bb, hsl_saturation (udr, udg, udb));
+    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
+  }
+  else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_SATURATION)
+  {
+    br = udr; bg = udg; bb = udb;
+    hsl_set_saturation (br, bg, bb, hsl_saturation (usr, usg, usb));
+    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
+  }
+  else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_COLOR)
+  {
+    br = usr; bg = usg; bb = usb;
+    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
+  }
+  else /* HSL_LUMINOSITY */
+  {
+    br = udr; bg = udg; bb = udb;
+    hsl_set_luminosity (br, bg, bb, hsl_luminosity (usr, usg, usb));
+  }
+
+  float ra = sa + da - sa * da;
+  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
+  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
+  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
+
+  return pack_from_float (rr, rg, rb, ra);
+}
+
+/* Composite per-pixel with full blend mode support. */
+static inline uint32_t
+composite_pixel (uint32_t src, uint32_t dst,
+		 hb_paint_composite_mode_t mode)
+{
+  uint8_t sa = (uint8_t) (src >> 24);
+  uint8_t da = (uint8_t) (dst >> 24);
+
+  switch (mode)
+  {
+  case HB_PAINT_COMPOSITE_MODE_CLEAR:
+    return 0;
+  case HB_PAINT_COMPOSITE_MODE_SRC:
+    return src;
+  case HB_PAINT_COMPOSITE_MODE_DEST:
+    return dst;
+  case HB_PAINT_COMPOSITE_MODE_SRC_OVER:
+    return hb_raster_src_over (src, dst);
+  case HB_PAINT_COMPOSITE_MODE_DEST_OVER:
+    return hb_raster_src_over (dst, src);
+  case HB_PAINT_COMPOSITE_MODE_SRC_IN:
+    return hb_raster_alpha_mul (src, da);
+  case HB_PAINT_COMPOSITE_MODE_DEST_IN:
+    return hb_raster_alpha_mul (dst, sa);
+  case HB_PAINT_COMPOSITE_MODE_SRC_OUT:
+    return hb_raster_alpha_mul (src, 255 - da);
+  case HB_PAINT_COMPOSITE_MODE_DEST_OUT:
+    return hb_raster_alpha_mul (dst, 255 - sa);
+  case HB_PAINT_COMPOSITE_MODE_SRC_ATOP:
+  {
+    /* Fa=Da, Fb=1-Sa */
+    uint32_t a = hb_raster_alpha_mul (src, da);
+    uint32_t b = hb_raster_alpha_mul (dst, 255 - sa);
+    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
+    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
+    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
+    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
+    return hb_raster_pack_pixel (rb, rg, rr, ra);
+  }
+  case HB_PAINT_COMPOSITE_MODE_DEST_ATOP:
+  {
+    uint32_t a = hb_raster_alpha_mul (dst, sa);
+    uint32_t b = hb_raster_alpha_mul (src, 255 - da);
+    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
+    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
+    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
+    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
+    return hb_raster_pack_pixel (rb, rg, rr, ra);
+  }
+  case HB_PAINT_COMPOSITE_MODE_XOR:
+  {
+    uint32_t a = hb_raster_alpha_mul (src, 255 - da);
+    uint32_t b = hb_raster_alpha_mul (dst, 255 - sa);
+    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
+    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
+    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
+    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
+    return hb_raster_pack_pixel (rb, rg, rr, ra);
+  }
+  case HB_PAINT_COMPOSITE_MODE_PLUS:
+  {
+    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (src & 0xFF) + (dst & 0xFF));
+    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((src >> 8) & 0xFF) + ((dst >> 8) & 0xFF));
+    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((src >> 16) & 0xFF) + ((dst >> 16) & 0xFF));
+    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (src >> 24) + (dst >> 24));
+    return hb_raster_pack_pixel (rb, rg, rr, ra);
+  }
+
+  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:  return apply_separable_blend (src, dst, blend_multiply);
+  case HB_PAINT_COMPOSITE_MODE_SCREEN:    return apply_separable_blend (src, dst, blend_screen);
+  case HB_PAINT_COMPOSITE_MODE_OVERLAY:   return apply_separable_blend (src, dst, blend_overlay);
+  case HB_PAINT_COMPOSITE_MODE_DARKEN:    return apply_separable_blend (src, dst, blend_darken);
+  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:   return apply_separable_blend (src, dst, blend_lighten);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: return apply_separable_blend (src, dst, blend_color_dodge);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  return apply_separable_blend (src, dst, blend_color_burn);
+  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  return apply_separable_blend (src, dst, blend_hard_light);
+  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  return apply_separable_blend (src, dst, blend_soft_light);
+  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  return apply_separable_blend (src, dst, blend_difference);
+  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   return apply_separable_blend (src, dst, blend_exclusion);
+
+  case HB_PAINT_COMPOSITE_MODE_HSL_HUE:
+  case HB_PAINT_COMPOSITE_MODE_HSL_SATURATION:
+  case HB_PAINT_COMPOSITE_MODE_HSL_COLOR:
+  case HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY:
+    return apply_hsl_blend (src, dst, mode);
+
+  default:
+    return hb_raster_src_over (src, dst);
+  }
+}
+
+/* Composites a span of @n premultiplied BGRA32 pixels, one at a time. */
+static inline void
+hb_raster_composite_span_scalar (uint8_t *dst,
+				 const uint8_t *src,
+				 unsigned n,
+				 hb_paint_composite_mode_t mode)
+{
+  hb_packed_t<uint32_t> *dp = (hb_packed_t<uint32_t> *) dst;
+  const hb_packed_t<uint32_t> *sp = (const hb_packed_t<uint32_t> *) src;
+  for (unsigned x = 0; x < n; x++)
+    dp[x] = hb_packed_t<uint32_t> (composite_pixel ((uint32_t) sp[x], (uint32_t) dp[x], mode));
+}
+
+/* Composites a span of @n premultiplied BGRA32 pixels of @src, scaled
+ * by the A8 @mask, onto @dst with source-over. */
+static inline void
+hb_raster_composite_span_mask_scalar (uint8_t *dst,
+				      const uint8_t *src,
+				      const uint8_t *mask,
+				      unsigned n)
+{
+  hb_packed_t<uint32_t> *dp = (hb_packed_t<uint32_t> *) dst;
+  const hb_packed_t<uint32_t> *sp = (const hb_packed_t<uint32_t> *) src;
+  for (unsigned x = 0; x < n; x++)
+  {
+    if (!mask[x]) continue;
+    uint32_t s = hb_raster_alpha_mul ((uint32_t) sp[x], mask[x]);
+    dp[x] = hb_packed_t<uint32_t> (hb_raster_src_over (s, (uint32_t) dp[x]));
+  }
+}
+
+
+/*
+ * Vectorized compositing
+ *
+ * The same arithmetic as above, on several pixels at a time.  Integer
+ * modes work on bytes, widened to 16 bits for multiplies; blend modes
+ * keep one float lane per pixel and channel, and do exactly the scalar
+ * operations in the same order, with selects in place of branches, so
+ * results match the scalar code bit for bit.
+ */
+
+#if defined(HB_RASTER_COMPOSITE_AVX2) || defined(HB_RASTER_COMPOSITE_SSE2) || defined(HB_RASTER_COMPOSITE_NEON)
+#define HB_RASTER_COMPOSITE_SIMD 1
+
+#if defined(HB_RASTER_COMPOSITE_AVX2)
+
+#define HB_RASTER_COMPOSITE_WIDTH 8
+typedef __m256  hb_raster_vf_native_t;
+typedef __m256  hb_raster_vm_native_t;
+typedef __m256i hb_raster_vpx_native_t;
+
+#elif defined(HB_RASTER_COMPOSITE_SSE2)
+
+#define HB_RASTER_COMPOSITE_WIDTH 4
+typedef __m128  hb_raster_vf_native_t;
+typedef __m128  hb_raster_vm_native_t;
+typedef __m128i hb_raster_vpx_native_t;
+
+#else
+
+#define HB_RASTER_COMPOSITE_WIDTH 4
+typedef float32x4_t hb_raster_vf_native_t;
+typedef uint32x4_t  hb_raster_vm_native_t;
+typedef uint8x16_t  hb_raster_vpx_native_t;
+
+#endif
+
+/* One float lane per pixel. */
+struct hb_raster_vf_t { hb_raster_vf_native_t v; };
+/* Lane mask, from comparisons. */
+struct hb_raster_vm_t { hb_raster_vm_native_t m; };
+/* HB_RASTER_COMPOSITE_WIDTH BGRA32 pixels. */
+struct hb_raster_vpx_t { hb_raster_vpx_native_t v; };
+
+#if defined(HB_RASTER_COMPOSITE_AVX2)
+
+static HB_ALWAYS_INLINE hb_raster_vf_t vf (float f) { return {_mm256_set1_ps (f)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator + (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_add_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator - (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_sub_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator * (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_mul_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator / (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_div_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <  (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_cmp_ps (a.v, b.v, _CMP_LT_OQ)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <= (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_cmp_ps (a.v, b.v, _CMP_LE_OQ)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >  (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_cmp_ps (a.v, b.v, _CMP_GT_OQ)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >= (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_cmp_ps (a.v, b.v, _CMP_GE_OQ)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator & (hb_raster_vm_t a, hb_raster_vm_t b) { return {_mm256_and_ps (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator | (hb_raster_vm_t a, hb_raster_vm_t b) { return {_mm256_or_ps (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator ~ (hb_raster_vm_t a) { return {_mm256_xor_ps (a.m, _mm256_castsi256_ps (_mm256_set1_epi32 (-1)))}; }
+/* m ? a : b */
+static HB_ALWAYS_INLINE hb_raster_vf_t vsel (hb_raster_vm_t m, hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_blendv_ps (b.v, a.v, m.m)}; }
+/* hb_min() and hb_max(), including which operand ties return. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vmin (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_min_ps (b.v, a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vmax (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_max_ps (b.v, a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vsqrt (hb_raster_vf_t a) { return {_mm256_sqrt_ps (a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vabs (hb_raster_vf_t a) { return {_mm256_and_ps (a.v, _mm256_castsi256_ps (_mm256_set1_epi32 (0x7FFFFFFF)))}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator == (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm256_cmp_ps (a.v, b.v, _CMP_EQ_OQ)}; }
+/* One bit per lane, lowest lane first. */
+static HB_ALWAYS_INLINE unsigned vm_bits (hb_raster_vm_t m) { return (unsigned) _mm256_movemask_ps (m.m); }
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_load (const float *p) { return {_mm256_loadu_ps (p)}; }
+static HB_ALWAYS_INLINE void vf_store (float *p, hb_raster_vf_t a) { _mm256_storeu_ps (p, a.v); }
+/* 0, 1, 2, ... */
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_ramp () { return {_mm256_setr_ps (0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)}; }
+/* Rounds toward zero; |a| must be below 2^31. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vtrunc (hb_raster_vf_t a) { return {_mm256_cvtepi32_ps (_mm256_cvttps_epi32 (a.v))}; }
+/* Truncates to integers, as (unsigned) casts of values in range. */
+static HB_ALWAYS_INLINE void vf_store_u32 (uint32_t *p, hb_raster_vf_t a) { _mm256_storeu_si256 ((__m256i *) (void *) p, _mm256_cvttps_epi32 (a.v)); }
+
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_load (const uint8_t *p) { return {_mm256_loadu_si256 ((const __m256i *) (const void *) p)}; }
+static HB_ALWAYS_INLINE void vpx_store (uint8_t *p, hb_raster_vpx_t a) { _mm256_storeu_si256 ((__m256i *) (void *) p, a.v); }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_zero () { return {_mm256_setzero_si256 ()}; }
+/* Each of HB_RASTER_COMPOSITE_WIDTH bytes, in all four bytes of a pixel. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_coverage (const uint8_t *p)
+{
+  __m256i c = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *) (const void *) p));
+  return {_mm256_mullo_epi32 (c, _mm256_set1_epi32 (0x01010101))};
+}
+/* Alpha of each pixel, in all four of its bytes. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_alpha (hb_raster_vpx_t a)
+{
+  __m256i t = _mm256_srli_epi32 (a.v, 24);
+  t = _mm256_or_si256 (t, _mm256_slli_epi32 (t, 8));
+  return {_mm256_or_si256 (t, _mm256_slli_epi32 (t, 16))};
+}
+/* 255 - a, bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_inv (hb_raster_vpx_t a) { return {_mm256_xor_si256 (a.v, _mm256_set1_epi32 (-1))}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_add (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {_mm256_add_epi8 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_adds (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {_mm256_adds_epu8 (a.v, b.v)}; }
+/* Pixels of @b where @alpha is zero, of @a elsewhere. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_unless_clear (hb_raster_vpx_t alpha, hb_raster_vpx_t a, hb_raster_vpx_t b)
+{ return {_mm256_blendv_epi8 (a.v, b.v, _mm256_cmpeq_epi8 (alpha.v, _mm256_setzero_si256 ()))}; }
+/* hb_raster_div255 (a · b), bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_mul (hb_raster_vpx_t a, hb_raster_vpx_t b)
+{
+  __m256i zero = _mm256_setzero_si256 ();
+  __m256i bias = _mm256_set1_epi16 (255);
+  __m256i lo = _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (a.v, zero), _mm256_unpacklo_epi8 (b.v, zero));
+  __m256i hi = _mm256_mullo_epi16 (_mm256_unpackhi_epi8 (a.v, zero), _mm256_unpackhi_epi8 (b.v, zero));
+  lo = _mm256_srli_epi16 (_mm256_add_epi16 (lo, bias), 8);
+  hi = _mm256_srli_epi16 (_mm256_add_epi16 (hi, bias), 8);
+  return {_mm256_packus_epi16 (lo, hi)};
+}
+/* Channel bytes @shift bits up each pixel, as floats. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vpx_channel (hb_raster_vpx_t a, int shift)
+{
+  __m256i c = _mm256_and_si256 (_mm256_srl_epi32 (a.v, _mm_cvtsi32_si128 (shift)), _mm256_set1_epi32 (0xFF));
+  return {_mm256_cvtepi32_ps (c)};
+}
+/* Truncates floats in [0, 255] and packs them as B, G, R, A. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_from_channels (hb_raster_vf_t b, hb_raster_vf_t g, hb_raster_vf_t r, hb_raster_vf_t a)
+{
+  __m256i p = _mm256_cvttps_epi32 (b.v);
+  p = _mm256_or_si256 (p, _mm256_slli_epi32 (_mm256_cvttps_epi32 (g.v), 8));
+  p = _mm256_or_si256 (p, _mm256_slli_epi32 (_mm256_cvttps_epi32 (r.v), 16));
+  p = _mm256_or_si256 (p, _mm256_slli_epi32 (_mm256_cvttps_epi32 (a.v), 24));
+  return {p};
+}
+
+#elif defined(HB_RASTER_COMPOSITE_SSE2)
+
+static HB_ALWAYS_INLINE hb_raster_vf_t vf (float f) { return {_mm_set1_ps (f)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator + (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_add_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator - (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_sub_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator * (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_mul_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator / (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_div_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <  (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_cmplt_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <= (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_cmple_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >  (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_cmpgt_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >= (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_cmpge_ps (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator & (hb_raster_vm_t a, hb_raster_vm_t b) { return {_mm_and_ps (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator | (hb_raster_vm_t a, hb_raster_vm_t b) { return {_mm_or_ps (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator ~ (hb_raster_vm_t a) { return {_mm_xor_ps (a.m, _mm_castsi128_ps (_mm_set1_epi32 (-1)))}; }
+/* m ? a : b */
+static HB_ALWAYS_INLINE hb_raster_vf_t vsel (hb_raster_vm_t m, hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_or_ps (_mm_and_ps (m.m, a.v), _mm_andnot_ps (m.m, b.v))}; }
+/* hb_min() and hb_max(), including which operand ties return. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vmin (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_min_ps (b.v, a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vmax (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_max_ps (b.v, a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vsqrt (hb_raster_vf_t a) { return {_mm_sqrt_ps (a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vabs (hb_raster_vf_t a) { return {_mm_and_ps (a.v, _mm_castsi128_ps (_mm_set1_epi32 (0x7FFFFFFF)))}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator == (hb_raster_vf_t a, hb_raster_vf_t b) { return {_mm_cmpeq_ps (a.v, b.v)}; }
+/* One bit per lane, lowest lane first. */
+static HB_ALWAYS_INLINE unsigned vm_bits (hb_raster_vm_t m) { return (unsigned) _mm_movemask_ps (m.m); }
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_load (const float *p) { return {_mm_loadu_ps (p)}; }
+static HB_ALWAYS_INLINE void vf_store (float *p, hb_raster_vf_t a) { _mm_storeu_ps (p, a.v); }
+/* 0, 1, 2, ... */
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_ramp () { return {_mm_setr_ps (0.f, 1.f, 2.f, 3.f)}; }
+/* Rounds toward zero; |a| must be below 2^31. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vtrunc (hb_raster_vf_t a) { return {_mm_cvtepi32_ps (_mm_cvttps_epi32 (a.v))}; }
+/* Truncates to integers, as (unsigned) casts of values in range. */
+static HB_ALWAYS_INLINE void vf_store_u32 (uint32_t *p, hb_raster_vf_t a) { _mm_storeu_si128 ((__m128i *) (void *) p, _mm_cvttps_epi32 (a.v)); }
+
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_load (const uint8_t *p) { return {_mm_loadu_si128 ((const __m128i *) (const void *) p)}; }
+static HB_ALWAYS_INLINE void vpx_store (uint8_t *p, hb_raster_vpx_t a) { _mm_storeu_si128 ((__m128i *) (void *) p, a.v); }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_zero () { return {_mm_setzero_si128 ()}; }
+/* Each of HB_RASTER_COMPOSITE_WIDTH bytes, in all four bytes of a pixel. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_coverage (const uint8_t *p)
+{
+  uint32_t c;
+  memcpy (&c, p, 4);
+  __m128i t = _mm_cvtsi32_si128 ((int) c);
+  t = _mm_unpacklo_epi8 (t, t);
+  return {_mm_unpacklo_epi16 (t, t)};
+}
+/* Alpha of each pixel, in all four of its bytes. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_alpha (hb_raster_vpx_t a)
+{
+  __m128i t = _mm_srli_epi32 (a.v, 24);
+  t = _mm_or_si128 (t, _mm_slli_epi32 (t, 8));
+  return {_mm_or_si128 (t, _mm_slli_epi32 (t, 16))};
+}
+/* 255 - a, bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_inv (hb_raster_vpx_t a) { return {_mm_xor_si128 (a.v, _mm_set1_epi32 (-1))}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_add (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {_mm_add_epi8 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_adds (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {_mm_adds_epu8 (a.v, b.v)}; }
+/* Pixels of @b where @alpha is zero, of @a elsewhere. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_unless_clear (hb_raster_vpx_t alpha, hb_raster_vpx_t a, hb_raster_vpx_t b)
+{
+  __m128i m = _mm_cmpeq_epi8 (alpha.v, _mm_setzero_si128 ());
+  return {_mm_or_si128 (_mm_and_si128 (m, b.v), _mm_andnot_si128 (m, a.v))};
+}
+/* hb_raster_div255 (a · b), bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_mul (hb_raster_vpx_t a, hb_raster_vpx_t b)
+{
+  __m128i zero = _mm_setzero_si128 ();
+  __m128i bias = _mm_set1_epi16 (255);
+  __m128i lo = _mm_mullo_epi16 (_mm_unpacklo_epi8 (a.v, zero), _mm_unpacklo_epi8 (b.v, zero));
+  __m128i hi = _mm_mullo_epi16 (_mm_unpackhi_epi8 (a.v, zero), _mm_unpackhi_epi8 (b.v, zero));
+  lo = _mm_srli_epi16 (_mm_add_epi16 (lo, bias), 8);
+  hi = _mm_srli_epi16 (_mm_add_epi16 (hi, bias), 8);
+  return {_mm_packus_epi16 (lo, hi)};
+}
+/* Channel bytes @shift bits up each pixel, as floats. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vpx_channel (hb_raster_vpx_t a, int shift)
+{
+  __m128i c = _mm_and_si128 (_mm_srl_epi32 (a.v, _mm_cvtsi32_si128 (shift)), _mm_set1_epi32 (0xFF));
+  return {_mm_cvtepi32_ps (c)};
+}
+/* Truncates floats in [0, 255] and packs them as B, G, R, A. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_from_channels (hb_raster_vf_t b, hb_raster_vf_t g, hb_raster_vf_t r, hb_raster_vf_t a)
+{
+  __m128i p = _mm_cvttps_epi32 (b.v);
+  p = _mm_or_si128 (p, _mm_slli_epi32 (_mm_cvttps_epi32 (g.v), 8));
+  p = _mm_or_si128 (p, _mm_slli_epi32 (_mm_cvttps_epi32 (r.v), 16));
+  p = _mm_or_si128 (p, _mm_slli_epi32 (_mm_cvttps_epi32 (a.v), 24));
+  return {p};
+}
+
+#else /* HB_RASTER_COMPOSITE_NEON */
+
+static HB_ALWAYS_INLINE hb_raster_vf_t vf (float f) { return {vdupq_n_f32 (f)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator + (hb_raster_vf_t a, hb_raster_vf_t b) { return {vaddq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator - (hb_raster_vf_t a, hb_raster_vf_t b) { return {vsubq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator * (hb_raster_vf_t a, hb_raster_vf_t b) { return {vmulq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t operator / (hb_raster_vf_t a, hb_raster_vf_t b) { return {vdivq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <  (hb_raster_vf_t a, hb_raster_vf_t b) { return {vcltq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator <= (hb_raster_vf_t a, hb_raster_vf_t b) { return {vcleq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >  (hb_raster_vf_t a, hb_raster_vf_t b) { return {vcgtq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator >= (hb_raster_vf_t a, hb_raster_vf_t b) { return {vcgeq_f32 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator & (hb_raster_vm_t a, hb_raster_vm_t b) { return {vandq_u32 (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator | (hb_raster_vm_t a, hb_raster_vm_t b) { return {vorrq_u32 (a.m, b.m)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator ~ (hb_raster_vm_t a) { return {vmvnq_u32 (a.m)}; }
+/* m ? a : b */
+static HB_ALWAYS_INLINE hb_raster_vf_t vsel (hb_raster_vm_t m, hb_raster_vf_t a, hb_raster_vf_t b) { return {vbslq_f32 (m.m, a.v, b.v)}; }
+/* hb_min() and hb_max(), including which operand ties return; vminq_f32()
+ * and vmaxq_f32() order signed zeros differently. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vmin (hb_raster_vf_t a, hb_raster_vf_t b) { return vsel (a <= b, a, b); }
+static HB_ALWAYS_INLINE hb_raster_vf_t vmax (hb_raster_vf_t a, hb_raster_vf_t b) { return vsel (a >= b, a, b); }
+static HB_ALWAYS_INLINE hb_raster_vf_t vsqrt (hb_raster_vf_t a) { return {vsqrtq_f32 (a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vf_t vabs (hb_raster_vf_t a) { return {vabsq_f32 (a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vm_t operator == (hb_raster_vf_t a, hb_raster_vf_t b) { return {vceqq_f32 (a.v, b.v)}; }
+/* One bit per lane, lowest lane first. */
+static HB_ALWAYS_INLINE unsigned vm_bits (hb_raster_vm_t m)
+{
+  static const int32_t shifts[4] = {0, 1, 2, 3};
+  return vaddvq_u32 (vshlq_u32 (vshrq_n_u32 (m.m, 31), vld1q_s32 (shifts)));
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_load (const float *p) { return {vld1q_f32 (p)}; }
+static HB_ALWAYS_INLINE void vf_store (float *p, hb_raster_vf_t a) { vst1q_f32 (p, a.v); }
+/* 0, 1, 2, ... */
+static HB_ALWAYS_INLINE hb_raster_vf_t vf_ramp () { static const float r[4] = {0.f, 1.f, 2.f, 3.f}; return {vld1q_f32 (r)}; }
+/* Rounds toward zero; |a| must be below 2^31. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vtrunc (hb_raster_vf_t a) { return {vcvtq_f32_s32 (vcvtq_s32_f32 (a.v))}; }
+/* Truncates to integers, as (unsigned) casts of values in range. */
+static HB_ALWAYS_INLINE void vf_store_u32 (uint32_t *p, hb_raster_vf_t a) { vst1q_u32 (p, vcvtq_u32_f32 (a.v)); }
+
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_load (const uint8_t *p) { return {vld1q_u8 (p)}; }
+static HB_ALWAYS_INLINE void vpx_store (uint8_t *p, hb_raster_vpx_t a) { vst1q_u8 (p, a.v); }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_zero () { return {vdupq_n_u8 (0)}; }
+/* Each of HB_RASTER_COMPOSITE_WIDTH bytes, in all four bytes of a pixel. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_coverage (const uint8_t *p)
+{
+  uint32_t c;
+  memcpy (&c, p, 4);
+  uint16x8_t t = vmovl_u8 (vreinterpret_u8_u32 (vdup_n_u32 (c)));
+  return {vreinterpretq_u8_u32 (vmulq_n_u32 (vmovl_u16 (vget_low_u16 (t)), 0x01010101u))};
+}
+/* Alpha of each pixel, in all four of its bytes. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_alpha (hb_raster_vpx_t a)
+{
+  uint32x4_t t = vshrq_n_u32 (vreinterpretq_u32_u8 (a.v), 24);
+  return {vreinterpretq_u8_u32 (vmulq_n_u32 (t, 0x01010101u))};
+}
+/* 255 - a, bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_inv (hb_raster_vpx_t a) { return {vmvnq_u8 (a.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_add (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {vaddq_u8 (a.v, b.v)}; }
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_adds (hb_raster_vpx_t a, hb_raster_vpx_t b) { return {vqaddq_u8 (a.v, b.v)}; }
+/* Pixels of @b where @alpha is zero, of @a elsewhere. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_unless_clear (hb_raster_vpx_t alpha, hb_raster_vpx_t a, hb_raster_vpx_t b)
+{ return {vbslq_u8 (vceqq_u8 (alpha.v, vdupq_n_u8 (0)), b.v, a.v)}; }
+/* hb_raster_div255 (a · b), bytewise. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_mul (hb_raster_vpx_t a, hb_raster_vpx_t b)
+{
+  uint16x8_t bias = vdupq_n_u16 (255);
+  uint16x8_t lo = vaddq_u16 (vmull_u8 (vget_low_u8 (a.v), vget_low_u8 (b.v)), bias);
+  uint16x8_t hi = vaddq_u16 (vmull_u8 (vget_high_u8 (a.v), vget_high_u8 (b.v)), bias);
+  return {vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi, 8))};
+}
+/* Channel bytes @shift bits up each pixel, as floats. */
+static HB_ALWAYS_INLINE hb_raster_vf_t vpx_channel (hb_raster_vpx_t a, int shift)
+{
+  uint32x4_t c = vshlq_u32 (vreinterpretq_u32_u8 (a.v), vdupq_n_s32 (-shift));
+  return {vcvtq_f32_u32 (vandq_u32 (c, vdupq_n_u32 (0xFF)))};
+}
+/* Truncates floats in [0, 255] and packs them as B, G, R, A. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t vpx_from_channels (hb_raster_vf_t b, hb_raster_vf_t g, hb_raster_vf_t r, hb_raster_vf_t a)
+{
+  uint32x4_t p = vcvtq_u32_f32 (b.v);
+  p = vorrq_u32 (p, vshlq_n_u32 (vcvtq_u32_f32 (g.v), 8));
+  p = vorrq_u32 (p, vshlq_n_u32 (vcvtq_u32_f32 (r.v), 16));
+  p = vorrq_u32 (p, vshlq_n_u32 (vcvtq_u32_f32 (a.v), 24));
+  return {vreinterpretq_u8_u32 (p)};
+}
+
+#endif
+
+
+/* floorf(), exactly, for finite values. */
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vfloor (hb_raster_vf_t a)
+{
+  /* From 2^23 up, floats are integers. */
+  hb_raster_vf_t t = vtrunc (vmin (vmax (a, vf (-8388608.f)), vf (8388608.f)));
+  t = vsel (t > a, t - vf (1.f), t);
+  return vsel (vabs (a) >= vf (8388608.f), a, t);
+}
+
+/* Float pixels, as unpack_to_float() and pack_from_float(). */
+
+struct hb_raster_vpixel_t { hb_raster_vf_t r, g, b, a; };
+
+static HB_ALWAYS_INLINE hb_raster_vpixel_t
+vpx_unpack (hb_raster_vpx_t px)
+{
+  hb_raster_vf_t k = vf (255.f);
+  return {vpx_channel (px, 16) / k,
+	  vpx_channel (px,  8) / k,
+	  vpx_channel (px,  0) / k,
+	  vpx_channel (px, 24) / k};
+}
+
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vpx_to_byte (hb_raster_vf_t c)
+{
+  return vmin (vmax (c, vf (0.f)), vf (1.f)) * vf (255.f) + vf (0.5f);
+}
+
+static HB_ALWAYS_INLINE hb_raster_vpx_t
+vpx_pack (hb_raster_vf_t r, hb_raster_vf_t g, hb_raster_vf_t b, hb_raster_vf_t a)
+{
+  return vpx_from_channels (vpx_to_byte (b), vpx_to_byte (g), vpx_to_byte (r), vpx_to_byte (a));
+}
+
+/* Unpremultiplied channels, as in apply_separable_blend(). */
+static HB_ALWAYS_INLINE hb_raster_vpixel_t
+vpx_unpremultiply (const hb_raster_vpixel_t &p)
+{
+  hb_raster_vf_t zero = vf (0.f);
+  hb_raster_vm_t has_alpha = p.a > zero;
+  return {vsel (has_alpha, p.r / p.a, zero),
+	  vsel (has_alpha, p.g / p.a, zero),
+	  vsel (has_alpha, p.b / p.a, zero),
+	  p.a};
+}
+
+/* Source-over of the blended color @b, from unpremultiplied @s and @d. */
+static HB_ALWAYS_INLINE hb_raster_vpx_t
+vpx_blend_result (const hb_raster_vpixel_t &s, const hb_raster_vpixel_t &d,
+		  hb_raster_vf_t br, hb_raster_vf_t bg, hb_raster_vf_t bb)
+{
+  hb_raster_vf_t one = vf (1.f);
+  hb_raster_vf_t sa = s.a, da = d.a;
+  hb_raster_vf_t ra = sa + da - sa * da;
+  hb_raster_vf_t rr = sa * da * br + sa * (one - da) * s.r + (one - sa) * da * d.r;
+  hb_raster_vf_t rg = sa * da * bg + sa * (one - da) * s.g + (one - sa) * da * d.g;
+  hb_raster_vf_t rb = sa * da * bb + sa * (one - da) * s.b + (one - sa) * da * d.b;
+  return vpx_pack (rr, rg, rb, ra);
+}
+
+
+/* Separable blend functions, as the scalar ones. */
+
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_multiply (hb_raster_vf_t sc, hb_raster_vf_t dc) { return sc * dc; }
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_screen (hb_raster_vf_t sc, hb_raster_vf_t dc) { return sc + dc - sc * dc; }
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_overlay (hb_raster_vf_t sc, hb_raster_vf_t dc)
+{
+  hb_raster_vf_t one = vf (1.f), two = vf (2.f);
+  return vsel (dc <= vf (0.5f), two * sc * dc, one - two * (one - sc) * (one - dc));
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_darken (hb_raster_vf_t sc, hb_raster_vf_t dc) { return vmin (sc, dc); }
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_lighten (hb_raster_vf_t sc, hb_raster_vf_t dc) { return vmax (sc, dc); }
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_color_dodge (hb_raster_vf_t sc, hb_raster_vf_t dc)
+{
+  hb_raster_vf_t zero = vf (0.f), one = vf (1.f);
+  return vsel (dc <= zero, zero,
+	       vsel (sc >= one, one, vmin (one, dc / (one - sc))));
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_color_burn (hb_raster_vf_t sc, hb_raster_vf_t dc)
+{
+  hb_raster_vf_t zero = vf (0.f), one = vf (1.f);
+  return vsel (dc >= one, one,
+	       vsel (sc <= zero, zero, one - vmin (one, (one - dc) / sc)));
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_hard_light (hb_raster_vf_t sc, hb_raster_vf_t dc)
+{
+  hb_raster_vf_t one = vf (1.f), two = vf (2.f);
+  return vsel (sc <= vf (0.5f), two * sc * dc, one - two * (one - sc) * (one - dc));
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_soft_light (hb_raster_vf_t sc, hb_raster_vf_t dc)
+{
+  hb_raster_vf_t one = vf (1.f), two = vf (2.f);
+  hb_raster_vf_t dark = dc - (one - two * sc) * dc * (one - dc);
+  hb_raster_vf_t d = vsel (dc <= vf (0.25f),
+			   ((vf (16.f) * dc - vf (12.f)) * dc + vf (4.f)) * dc,
+			   vsqrt (dc));
+  hb_raster_vf_t light = dc + (two * sc - one) * (d - dc);
+  return vsel (sc <= vf (0.5f), dark, light);
+}
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_difference (hb_raster_vf_t sc, hb_raster_vf_t dc) { return vabs (sc - dc); }
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vblend_exclusion (hb_raster_vf_t sc, hb_raster_vf_t dc) { return sc + dc - vf (2.f) * sc * dc; }
+
+
+/* HSL helpers, as the scalar ones. */
+
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vhsl_luminosity (hb_raster_vf_t r, hb_raster_vf_t g, hb_raster_vf_t b)
+{ return vf (0.299f) * r + vf (0.587f) * g + vf (0.114f) * b; }
+
+static HB_ALWAYS_INLINE hb_raster_vf_t
+vhsl_saturation (hb_raster_vf_t r, hb_raster_vf_t g, hb_raster_vf_t b)
+{ return vmax (vmax (r, g), b) - vmin (vmin (r, g), b); }
+
+static HB_ALWAYS_INLINE void
+vhsl_clip_color (hb_raster_vf_t &r, hb_raster_vf_t &g, hb_raster_vf_t &b)
+{
+  hb_raster_vf_t zero = vf (0.f), one = vf (1.f);
+  hb_raster_vf_t l = vhsl_luminosity (r, g, b);
+  hb_raster_vf_t mn = vmin (vmin (r, g), b);
+  hb_raster_vf_t mx = vmax (vmax (r, g), b);
+
+  hb_raster_vf_t d = l - mn;
+  hb_raster_vm_t m = (mn < zero) & (d > zero);
+  r = vsel (m, l + (r - l) * l / d, r);
+  g = vsel (m, l + (g - l) * l / d, g);
+  b = vsel (m, l + (b - l) * l / d, b);
+
+  d = mx - l;
+  m = (mx > one) & (d > zero);
+  r = vsel (m, l + (r - l) * (one - l) / d, r);
+  g = vsel (m, l + (g - l) * (one - l) / d, g);
+  b = vsel (m, l + (b - l) * (one - l) / d, b);
+}
+
+static HB_ALWAYS_INLINE void
+vhsl_set_luminosity (hb_raster_vf_t &r, hb_raster_vf_t &g, hb_raster_vf_t &b, hb_raster_vf_t l)
+{
+  hb_raster_vf_t d = l - vhsl_luminosity (r, g, b);
+  r = r + d; g = g + d; b = b + d;
+  vhsl_clip_color (r, g, b);
+}
+
+/* hsl_set_saturation() picks the minimum, middle and maximum channels
+ * with the branches below; ties must resolve the same way, as the
+ * middle channel is rescaled while the others are set. */
+static HB_ALWAYS_INLINE void
+vhsl_set_saturation (hb_raster_vf_t &r, hb_raster_vf_t &g, hb_raster_vf_t &b, hb_raster_vf_t s)
+{
+  hb_raster_vm_t r_le_g = r <= g, g_le_b = g <= b, r_le_b = r <= b;
+
+  /* Roles per ordering (min, mid, max):
+   *   r<=g, g<=b:        (r, g, b)
+   *   r<=g, g>b,  r<=b:  (r, b, g)
+   *   r<=g, g>b,  r>b:   (b, r, g)
+   *   r>g,  r<=b:        (g, r, b)
+   *   r>g,  r>b,  g<=b:  (g, b, r)
+   *   r>g,  r>b,  g>b:   (b, g, r) */
+  hb_raster_vm_t r_mn = r_le_g & (g_le_b | r_le_b);
+  hb_raster_vm_t r_mx = ~r_le_g & ~r_le_b;
+  hb_raster_vm_t g_mx = r_le_g & ~g_le_b;
+  hb_raster_vm_t g_mn = ~r_le_g & (r_le_b | g_le_b);
+  hb_raster_vm_t b_mx = g_le_b & (r_le_g | r_le_b);
+  hb_raster_vm_t b_mn = ~g_le_b & ~(r_le_g & r_le_b);
+
+  hb_raster_vf_t mn = vsel (r_mn, r, vsel (g_mn, g, b));
+  hb_raster_vf_t mx = vsel (r_mx, r, vsel (g_mx, g, b));
+  hb_raster_vf_t mid = vsel (r_mn | r_mx, vsel (g_mn | g_mx, b, g), r);
+
+  hb_raster_vf_t zero = vf (0.f);
+  hb_raster_vm_t spread = mx > mn;
+  hb_raster_vf_t new_mid = vsel (spread, (mid - mn) * s / (mx - mn), zero);
+  hb_raster_vf_t new_mx = vsel (spread, s, zero);
+
+  r = vsel (r_mn, zero, vsel (r_mx, new_mx, new_mid));
+  g = vsel (g_mn, zero, vsel (g_mx, new_mx, new_mid));
+  b = vsel (b_mn, zero, vsel (b_mx, new_mx, new_mid));
+}
+
+
+/* Per-mode span operations. */
+
+struct hb_raster_composite_clear_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t, hb_raster_vpx_t) { return vpx_zero (); } };
+struct hb_raster_composite_src_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t) { return s; } };
+/* hb_raster_src_over(): its early-out for opaque sources gives what the
+ * general formula does; the one for clear sources only does so when the
+ * source is properly premultiplied, so is kept. */
+struct hb_raster_composite_src_over_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  {
+    hb_raster_vpx_t sa = vpx_alpha (s);
+    return vpx_unless_clear (sa, vpx_add (vpx_mul (d, vpx_inv (sa)), s), d);
+  } };
+struct hb_raster_composite_dest_over_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return hb_raster_composite_src_over_t::op (d, s); } };
+/* hb_raster_alpha_mul(): its early-outs give what the formula does. */
+struct hb_raster_composite_src_in_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_mul (s, vpx_alpha (d)); } };
+struct hb_raster_composite_dest_in_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_mul (d, vpx_alpha (s)); } };
+struct hb_raster_composite_src_out_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_mul (s, vpx_inv (vpx_alpha (d))); } };
+struct hb_raster_composite_dest_out_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_mul (d, vpx_inv (vpx_alpha (s))); } };
+struct hb_raster_composite_src_atop_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_adds (vpx_mul (s, vpx_alpha (d)), vpx_mul (d, vpx_inv (vpx_alpha (s)))); } };
+struct hb_raster_composite_dest_atop_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_adds (vpx_mul (d, vpx_alpha (s)), vpx_mul (s, vpx_inv (vpx_alpha (d)))); } };
+struct hb_raster_composite_xor_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_adds (vpx_mul (s, vpx_inv (vpx_alpha (d))), vpx_mul (d, vpx_inv (vpx_alpha (s)))); } };
+struct hb_raster_composite_plus_t
+{ static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t s, hb_raster_vpx_t d)
+  { return vpx_adds (s, d); } };
+
+template <hb_raster_vf_t (*blend) (hb_raster_vf_t, hb_raster_vf_t)>
+struct hb_raster_composite_separable_t
+{
+  static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t src, hb_raster_vpx_t dst)
+  {
+    hb_raster_vpixel_t s = vpx_unpremultiply (vpx_unpack (src));
+    hb_raster_vpixel_t d = vpx_unpremultiply (vpx_unpack (dst));
+    return vpx_blend_result (s, d, blend (s.r, d.r), blend (s.g, d.g), blend (s.b, d.b));
+  }
+};
+
+template <hb_paint_composite_mode_t mode>
+struct hb_raster_composite_hsl_t
+{
+  static HB_ALWAYS_INLINE hb_raster_vpx_t op (hb_raster_vpx_t src, hb_raster_vpx_t dst)
+  {
+    hb_raster_vpixel_t s = vpx_unpremultiply (vpx_unpack (src));
+    hb_raster_vpixel_t d = vpx_unpremultiply (vpx_unpack (dst));
+    hb_raster_vf_t br, bg, bb;
+    if (mode == HB_PAINT_COMPOSITE_MODE_HSL_HUE)
+    {
+      br = s.r; bg = s.g; bb = s.b;
+      vhsl_set_saturation (br, bg, bb, vhsl_saturation (d.r, d.g, d.b));
+      vhsl_set_luminosity (br, bg, bb, vhsl_luminosity (d.r, d.g, d.b));
+    }
+    else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_SATURATION)
+    {
+      br = d.r; bg = d.g; bb = d.b;
+      vhsl_set_saturation (br, bg, bb, vhsl_saturation (s.r, s.g, s.b));
+      vhsl_set_luminosity (br, bg, bb, vhsl_luminosity (d.r, d.g, d.b));
+    }
+    else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_COLOR)
+    {
+      br = s.r; bg = s.g; bb = s.b;
+      vhsl_set_luminosity (br, bg, bb, vhsl_luminosity (d.r, d.g, d.b));
+    }
+    else /* HSL_LUMINOSITY */
+    {
+      br = d.r; bg = d.g; bb = d.b;
+      vhsl_set_luminosity (br, bg, bb, vhsl_luminosity (s.r, s.g, s.b));
+    }
+    return vpx_blend_result (s, d, br, bg, bb);
+  }
+};
+
+/* Composites whole vectors of the span; returns how many pixels it did. */
+template <typename Op>
+static inline unsigned
+hb_raster_composite_span_simd (uint8_t *dst, const uint8_t *src, unsigned n)
+{
+  const unsigned step = HB_RASTER_COMPOSITE_WIDTH;
+  unsigned x = 0;
+  for (; x + step <= n; x += step)
+    vpx_store (dst + 4 * x, Op::op (vpx_load (src + 4 * x), vpx_load (dst + 4 * x)));
+  return x;
+}
+
+static inline unsigned
+hb_raster_composite_span_simd (uint8_t *dst,
+			       const uint8_t *src,
+			       unsigned n,
+			       hb_paint_composite_mode_t mode)
+{
+  switch (mode)
+  {
+  case HB_PAINT_COMPOSITE_MODE_CLEAR:      return hb_raster_composite_span_simd<hb_raster_composite_clear_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SRC:        return hb_raster_composite_span_simd<hb_raster_composite_src_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DEST:       return n;
+  case HB_PAINT_COMPOSITE_MODE_SRC_OVER:   return hb_raster_composite_span_simd<hb_raster_composite_src_over_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DEST_OVER:  return hb_raster_composite_span_simd<hb_raster_composite_dest_over_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SRC_IN:     return hb_raster_composite_span_simd<hb_raster_composite_src_in_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DEST_IN:    return hb_raster_composite_span_simd<hb_raster_composite_dest_in_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SRC_OUT:    return hb_raster_composite_span_simd<hb_raster_composite_src_out_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DEST_OUT:   return hb_raster_composite_span_simd<hb_raster_composite_dest_out_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SRC_ATOP:   return hb_raster_composite_span_simd<hb_raster_composite_src_atop_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DEST_ATOP:  return hb_raster_composite_span_simd<hb_raster_composite_dest_atop_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_XOR:        return hb_raster_composite_span_simd<hb_raster_composite_xor_t> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_PLUS:       return hb_raster_composite_span_simd<hb_raster_composite_plus_t> (dst, src, n);
+
+  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:    return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_multiply>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SCREEN:      return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_screen>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_OVERLAY:     return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_overlay>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DARKEN:      return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_darken>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:     return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_lighten>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_color_dodge>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_color_burn>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_hard_light>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_soft_light>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_difference>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   return hb_raster_composite_span_simd<hb_raster_composite_separable_t<vblend_exclusion>> (dst, src, n);
+
+  case HB_PAINT_COMPOSITE_MODE_HSL_HUE:        return hb_raster_composite_span_simd<hb_raster_composite_hsl_t<HB_PAINT_COMPOSITE_MODE_HSL_HUE>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_HSL_SATURATION: return hb_raster_composite_span_simd<hb_raster_composite_hsl_t<HB_PAINT_COMPOSITE_MODE_HSL_SATURATION>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_HSL_COLOR:      return hb_raster_composite_span_simd<hb_raster_composite_hsl_t<HB_PAINT_COMPOSITE_MODE_HSL_COLOR>> (dst, src, n);
+  case HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY: return hb_raster_composite_span_simd<hb_raster_composite_hsl_t<HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY>> (dst, src, n);
+
+  default:                                 return hb_raster_composite_span_simd<hb_raster_composite_src_over_t> (dst, src, n);
+  }
+}
+
+static inline unsigned
+hb_raster_composite_span_mask_simd (uint8_t *dst,
+				    const uint8_t *src,
+				    const uint8_t *mask,
+				    unsigned n)
+{
+  const unsigned step = HB_RASTER_COMPOSITE_WIDTH;
+  unsigned x = 0;
+  for (; x + step <= n; x += step)
+  {
+    hb_raster_vpx_t s = vpx_mul (vpx_load (src + 4 * x), vpx_coverage (mask + x));
+    vpx_store (dst + 4 * x, hb_raster_composite_src_over_t::op (s, vpx_load (dst + 4 * x)));
+  }
+  return x;
+}
+
+#endif /* SIMD */
+
+
+/* Composites a span of @n premultiplied BGRA32 pixels of @src onto
+ * @dst with @mode; same result as hb_raster_composite_span_scalar(). */
+static inline void
+hb_raster_composite_span (uint8_t *dst,
+			  const uint8_t *src,
+			  unsigned n,
+			  hb_paint_composite_mode_t mode)
+{
+  unsigned x = 0;
+#ifdef HB_RASTER_COMPOSITE_SIMD
+  x = hb_raster_composite_span_simd (dst, src, n, mode);
+#endif
+  hb_raster_composite_span_scalar (dst + 4 * x, src + 4 * x, n - x, mode);
+}
+
+/* Composites a span of @n premultiplied BGRA32 pixels of @src, scaled
+ * by the A8 @mask, onto @dst with source-over; same result as
+ * hb_raster_composite_span_mask_scalar(). */
+static inline void
+hb_raster_composite_span_mask (uint8_t *dst,
+			       const uint8_t *src,
+			       const uint8_t *mask,
+			       unsigned n)
+{
+  unsigned x = 0;
+#ifdef HB_RASTER_COMPOSITE_SIMD
+  x = hb_raster_composite_span_mask_simd (dst, src, mask, n);
+#endif
+  hb_raster_composite_span_mask_scalar (dst + 4 * x, src + 4 * x, mask + x, n - x);
+}
+
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+
+#endif /* HB_RASTER_COMPOSITE_HH */
@@ -27,8 +27,11 @@
 #include "hb.hh"
 
 #include "hb-raster-image.hh"
+#include "hb-font.hh"
+#include "hb-cache.hh"
 #include "hb-geometry.hh"
 #include "hb-machinery.hh"
+#include "hb-parallel.hh"
 
 #if defined(__aarch64__) || defined(_M_ARM64)
 #include <arm_neon.h>
@@ -49,6 +52,28 @@
 /* Flatness threshold for Bézier flattening: max deviation in pixels */
 #define HB_RASTER_FLAT_THRESH 0.25f
 
+/* Renders at least this wide, typically whole runs of glyphs, track
+ * which blocks of 2^HB_RASTER_BLOCK_BITS columns each row touches, and
+ * sweep only those, instead of the full span between the leftmost and
+ * rightmost touched columns. */
+#define HB_RASTER_SPARSE_MIN_WIDTH 512
+#define HB_RASTER_BLOCK_BITS 3
+
+/* With more than one thread, renders at least this tall are cut into
+ * horizontal strips of HB_RASTER_STRIP_ROWS rows, swept concurrently. */
+#define HB_RASTER_PARALLEL_MIN_ROWS 256
+#define HB_RASTER_STRIP_ROWS 64
+
+/* Distance-field spread, in pixels. */
+#define HB_RASTER_SDF_SPREAD_DEFAULT 4.f
+#define HB_RASTER_SDF_SPREAD_MAX 64.f
+
+/* LCD rendering oversamples coverage three times across subpixels and
+ * filters it with a five-tap FIR, in 1/256ths.  The default is
+ * FreeType's. */
+#define HB_RASTER_LCD_TAPS 5
+static const uint8_t hb_raster_lcd_filter_default[HB_RASTER_LCD_TAPS] = {0x08, 0x4D, 0x56, 0x4D, 0x08};
+
 
 /* Normalized edge: yH > yL always */
 struct hb_raster_edge_t
@@ -59,6 +84,145 @@ struct hb_raster_edge_t
   int32_t wind;     /* +1 or -1 */
 };
 
+/* Outline segment in pixels, kept in drawing order, horizontal ones
+   included, when rendering distance fields. */
+struct hb_raster_segment_t
+{
+  enum flags_t : uint8_t
+  {
+    CONTOUR_START   = 1u << 0,	/* first segment after a move-to */
+    PRIMITIVE_START = 1u << 1,	/* first segment of a line or curve */
+  };
+
+  float x0, y0, x1, y1;
+  uint8_t flags;
+};
+
+/* Scanline scratch.  The draw keeps one for serial sweeps, and one per
+   extra worker for parallel strip sweeps. */
+struct hb_raster_sweep_scratch_t
+{
+  hb_vector_t<int32_t> row_area;
+  hb_vector_t<int16_t> row_cover;
+  hb_vector_t<uint64_t> row_blocks;
+  hb_vector_t<hb_vector_t<unsigned>> edge_buckets;
+  hb_vector_t<unsigned> active_edges;
+  hb_vector_t<uint8_t> row_alpha; /* when compositing over the image */
+
+  /* Sizes the row accumulators for @width columns, cleared, and
+     empties the first @rows edge buckets.  Only grows the outer bucket
+     vector; clears inner vectors without freeing. */
+  bool prepare (unsigned width, unsigned rows, bool sparse, bool over)
+  {
+    if (unlikely (!row_area.resize_dirty (width) ||
+		  !row_cover.resize_dirty (width)))
+      return false;
+    if (over && unlikely (!row_alpha.resize_dirty (width)))
+      return false;
+    hb_memset (row_area.arrayZ,  0, width * sizeof (int32_t));
+    hb_memset (row_cover.arrayZ, 0, width * sizeof (int16_t));
+
+    if (sparse)
+    {
+      unsigned num_words = ((((width - 1) >> HB_RASTER_BLOCK_BITS) + 1) + 63) / 64;
+      if (unlikely (!row_blocks.resize_dirty (num_words)))
+	return false;
+      hb_memset (row_blocks.arrayZ, 0, num_words * sizeof (uint64_t));
+    }
+
+    return clear_buckets (rows);
+  }
+
+  bool clear_buckets (unsigned rows)
+  {
+    unsigned old_buckets = edge_buckets.length;
+    if (rows > old_buckets)
+    {
+      if (unlikely (!edge_buckets.resize (rows)))
+	return false;
+    }
+    /* New buckets (if any) are already empty from resize's zero-init. */
+    for (unsigned i = 0; i < hb_min (rows, old_buckets); i++)
+      edge_buckets.arrayZ[i].clear ();
+    return true;
+  }
+};
+
+/* What a glyph's flattened outline depends on, besides translation.
+   Compared and hashed bytewise, so always zero-initialized first.  The
+   font serial changes with its scale, variation coordinates, and
+   anything else that changes outlines. */
+struct hb_raster_outline_key_t
+{
+  hb_font_t *font;
+  unsigned font_serial;
+  hb_codepoint_t glyph;
+  float xx, yx, xy, yy;
+  float x_scale_factor, y_scale_factor;
+  float x_oversample, y_oversample;
+  bool distance_field;
+
+  uint32_t hash () const
+  { return hb_bytes_t ((const char *) this, sizeof (*this)).hash (); }
+  bool operator == (const hb_raster_outline_key_t &o) const
+  { return 0 == hb_memcmp (this, &o, sizeof (*this)); }
+};
+
+/* A glyph outline, flattened under its key with zero translation. */
+struct hb_raster_outline_entry_t : hb_lru_link_t
+{
+  hb_raster_outline_key_t key; /* Holds a reference to key.font. */
+  unsigned num_edges;
+  unsigned num_segments;
+  bool drawn;
+
+  /* Edges, then segments, follow. */
+  hb_raster_edge_t *edges () { return (hb_raster_edge_t *) (this + 1); }
+  hb_raster_segment_t *segments () { return (hb_raster_segment_t *) (edges () + num_edges); }
+
+  size_t get_size () const
+  {
+    return sizeof (*this) +
+	   num_edges * sizeof (hb_raster_edge_t) +
+	   num_segments * sizeof (hb_raster_segment_t);
+  }
+
+  bool equal (const hb_raster_outline_key_t &key_) const { return key == key_; }
+  void fini () { hb_font_destroy (key.font); }
+};
+
+/* Least-recently-used flattened outlines, within max_bytes.  See
+   hb_raster_draw_set_outline_cache_max_bytes(). */
+struct hb_raster_outline_cache_t : hb_lru_cache_t<hb_raster_outline_entry_t>
+{
+  size_t max_bytes = 0;
+
+  bool insert (const hb_raster_outline_key_t &key, uint32_t hash, bool drawn,
+	       const hb_raster_edge_t *edges, unsigned num_edges,
+	       const hb_raster_segment_t *segments, unsigned num_segments)
+  {
+    size_t size = sizeof (hb_raster_outline_entry_t) +
+		  num_edges * sizeof (edges[0]) +
+		  num_segments * sizeof (segments[0]);
+    if (size > max_bytes)
+      return false;
+    evict (max_bytes - size);
+
+    hb_raster_outline_entry_t *entry = (hb_raster_outline_entry_t *) hb_malloc (size);
+    if (unlikely (!entry))
+      return false;
+    entry->key = key;
+    entry->num_edges = num_edges;
+    entry->num_segments = num_segments;
+    entry->drawn = drawn;
+    hb_memcpy (entry->edges (), edges, num_edges * sizeof (edges[0]));
+    hb_memcpy (entry->segments (), segments, num_segments * sizeof (segments[0]));
+    hb_font_reference (key.font);
+
+    return hb_lru_cache_t::insert (entry, hash);
+  }
+};
+
 /* hb_raster_draw_t — outline rasterizer */
 struct hb_raster_draw_t
 {
@@ -70,6 +234,16 @@ struct hb_raster_draw_t
   float               y_scale_factor    = 1.f;
   hb_raster_extents_t fixed_extents     = {};
   bool                has_extents = false;
+  unsigned            num_threads = 1;
+  hb_raster_format_t  format      = HB_RASTER_FORMAT_A8;
+  float               sdf_spread  = HB_RASTER_SDF_SPREAD_DEFAULT;
+  hb_raster_lcd_layout_t lcd_layout = HB_RASTER_LCD_LAYOUT_RGB;
+  uint8_t             lcd_filter[HB_RASTER_LCD_TAPS] = {0x08, 0x4D, 0x56, 0x4D, 0x08};
+
+  /* Geometry is drawn this many times larger on each axis: three times
+     across the subpixels for LCD.  See hb_raster_draw_update_oversample(). */
+  float               x_oversample = 1.f;
+  float               y_oversample = 1.f;
 
   /* Visibility clip box for curve flattening (device pixels); set
      internally by raster-paint so invisible curves collapse to their
@@ -92,17 +266,66 @@ struct hb_raster_draw_t
   /* Accumulated geometry */
   int64_t edges_left = HB_RASTER_MAX_DRAW_EDGES;
   hb_vector_t<hb_raster_edge_t> edges;
+  hb_vector_t<hb_raster_segment_t> segments;  /* distance fields only */
+  uint8_t segment_flags = 0;  /* for the next segment */
+
+  /* Glyph outlines for hb_raster_draw_glyph_or_fail() — kept across
+     renders */
+  hb_raster_outline_cache_t outline_cache;
 
   /* Scratch — reused across render() calls */
-  hb_vector_t<int32_t> row_area;
-  hb_vector_t<int16_t> row_cover;
-  hb_vector_t<hb_vector_t<unsigned>> edge_buckets;
-  hb_vector_t<unsigned> active_edges;
+  hb_raster_sweep_scratch_t scratch;
+  hb_vector_t<hb_raster_sweep_scratch_t> worker_scratch;
+  hb_vector_t<hb_vector_t<unsigned>> strip_edges;
+  hb_vector_t<unsigned> sdf_order;
+  hb_vector_t<unsigned> sdf_active;
+  hb_vector_t<uint8_t> sdf_info;
+  hb_vector_t<hb_pair_t<int32_t, int32_t>> sdf_crossings;
+  hb_vector_t<uint8_t> sdf_inside;
+  hb_raster_image_t *lcd_coverage = nullptr;
+  hb_vector_t<uint8_t> lcd_row;
+  hb_vector_t<uint8_t> lcd_packed;
 
   /* Recycled image for zero-malloc render */
   hb_raster_image_t *recycled_image = nullptr;
 };
 
+static inline bool
+hb_raster_draw_is_distance_field (const hb_raster_draw_t *draw)
+{
+  return draw->format == HB_RASTER_FORMAT_SDF_A8 ||
+	 draw->format == HB_RASTER_FORMAT_MSDF_BGRA32;
+}
+
+static inline bool
+hb_raster_draw_is_lcd_vertical (const hb_raster_draw_t *draw)
+{
+  return draw->lcd_layout == HB_RASTER_LCD_LAYOUT_VRGB ||
+	 draw->lcd_layout == HB_RASTER_LCD_LAYOUT_VBGR;
+}
+
+/* Pixels to pad output extents with, so the field around the outline,
+   or the LCD filter's spill across subpixels, fits. */
+static inline void
+hb_raster_draw_padding (const hb_raster_draw_t *draw,
+			int &x_pad, int &y_pad)
+{
+  x_pad = y_pad = 0;
+  if (hb_raster_draw_is_distance_field (draw))
+    x_pad = y_pad = (int) ceilf (draw->sdf_spread);
+  else if (draw->format == HB_RASTER_FORMAT_LCD_BGRA32)
+    (hb_raster_draw_is_lcd_vertical (draw) ? y_pad : x_pad) = 1;
+}
+
+static inline void
+hb_raster_draw_update_oversample (hb_raster_draw_t *draw)
+{
+  bool lcd = draw->format == HB_RASTER_FORMAT_LCD_BGRA32;
+  bool vertical = hb_raster_draw_is_lcd_vertical (draw);
+  draw->x_oversample = lcd && !vertical ? 3.f : 1.f;
+  draw->y_oversample = lcd &&  vertical ? 3.f : 1.f;
+}
+
 static HB_ALWAYS_INLINE void
 hb_raster_draw_transform_point (const hb_raster_draw_t *draw,
 				float x, float y,
@@ -173,6 +396,7 @@ hb_raster_draw_destroy (hb_raster_draw_t *draw)
     return;
 
   hb_raster_image_destroy (draw->recycled_image);
+  hb_raster_image_destroy (draw->lcd_coverage);
   hb_object_actually_destroy (draw);
   hb_free (draw);
 }
@@ -284,6 +508,94 @@ hb_raster_draw_get_scale_factor (const hb_raster_draw_t *draw,
   if (y_scale_factor) *y_scale_factor = draw->y_scale_factor;
 }
 
+/**
+ * hb_raster_draw_set_num_threads:
+ * @draw: a rasterizer
+ * @num_threads: maximum number of threads to use, or 0 for one per
+ * online processor
+ *
+ * Sets the number of threads hb_raster_draw_render() may use.  Tall
+ * renders, such as whole paragraphs or large glyphs, are then cut into
+ * horizontal strips of rows that are rasterized concurrently.  The
+ * output is identical to that of a single-threaded render.  The default
+ * is 1.
+ *
+ * If HarfBuzz was built without thread support, renders always use a
+ * single thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_set_num_threads (hb_raster_draw_t *draw,
+				unsigned int      num_threads)
+{
+  draw->num_threads = num_threads;
+}
+
+/**
+ * hb_raster_draw_get_num_threads:
+ * @draw: a rasterizer
+ *
+ * Fetches the number of threads set with
+ * hb_raster_draw_set_num_threads().
+ *
+ * Return value: the number of threads, or 0 for one per online processor
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_raster_draw_get_num_threads (const hb_raster_draw_t *draw)
+{
+  return draw->num_threads;
+}
+
+/**
+ * hb_raster_draw_set_outline_cache_max_bytes:
+ * @draw: a rasterizer
+ * @max_bytes: the memory budget, in bytes
+ *
+ * Sets the amount of memory @draw may keep flattened glyph outlines
+ * in.  hb_raster_draw_glyph() and friends then flatten each glyph's
+ * curves once for a given font, and linear part of the transform,
+ * scale factors and format, and only move the cached edges when the
+ * same glyph is drawn again at another position, such as at a new
+ * subpixel offset.  Least-recently used outlines are dropped to stay
+ * within the budget.  Cached outlines hold a reference to their font.
+ *
+ * With the cache enabled, the translation is applied after rounding
+ * the outline to the rasterizer's 1/256-pixel grid, so renders can
+ * differ very slightly from uncached ones, but do not depend on
+ * whether an outline was found in the cache.
+ *
+ * Zero, the default, disables caching and drops cached outlines.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_set_outline_cache_max_bytes (hb_raster_draw_t *draw,
+					    unsigned int      max_bytes)
+{
+  draw->outline_cache.max_bytes = max_bytes;
+  draw->outline_cache.evict (max_bytes);
+}
+
+/**
+ * hb_raster_draw_get_outline_cache_max_bytes:
+ * @draw: a rasterizer
+ *
+ * Fetches the memory budget set with
+ * hb_raster_draw_set_outline_cache_max_bytes().
+ *
+ * Return value: the memory budget, in bytes
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_raster_draw_get_outline_cache_max_bytes (const hb_raster_draw_t *draw)
+{
+  return draw->outline_cache.max_bytes;
+}
+
 /**
  * hb_raster_draw_get_transform:
  * @draw: a rasterizer
@@ -314,7 +626,8 @@ hb_raster_draw_get_transform (const hb_raster_draw_t *draw,
 
 /* Recompute the resolved flattening clip box: the internal clip box
    when set, otherwise the fixed output extents when known.  Expanded
-   by one pixel so fixed-point rounding at the boundary stays safe.
+   by one pixel so fixed-point rounding at the boundary stays safe, and
+   by the spread for distance fields.
    Called whenever the clip box or extents change.  A curve whose
    control-point bounding box misses the clip box entirely is replaced
    by its chord: coverage inside the box then depends only on the
@@ -324,26 +637,210 @@ hb_raster_draw_get_transform (const hb_raster_draw_t *draw,
 static void
 hb_raster_draw_update_flatten_clip (hb_raster_draw_t *draw)
 {
+  int x_pad, y_pad;
+  hb_raster_draw_padding (draw, x_pad, y_pad);
+  float xpad = 1.f + (float) x_pad;
+  float ypad = 1.f + (float) y_pad;
+  float xs = draw->x_oversample, ys = draw->y_oversample;
   if (draw->has_clip_box)
   {
     draw->flatten_clip_active = true;
-    draw->flatten_clip_x0 = draw->clip_x0 - 1.f;
-    draw->flatten_clip_y0 = draw->clip_y0 - 1.f;
-    draw->flatten_clip_x1 = draw->clip_x1 + 1.f;
-    draw->flatten_clip_y1 = draw->clip_y1 + 1.f;
+    draw->flatten_clip_x0 = (draw->clip_x0 - xpad) * xs;
+    draw->flatten_clip_y0 = (draw->clip_y0 - ypad) * ys;
+    draw->flatten_clip_x1 = (draw->clip_x1 + xpad) * xs;
+    draw->flatten_clip_y1 = (draw->clip_y1 + ypad) * ys;
   }
   else if (draw->has_extents)
   {
     draw->flatten_clip_active = true;
-    draw->flatten_clip_x0 = (float) draw->fixed_extents.x_origin - 1.f;
-    draw->flatten_clip_y0 = (float) draw->fixed_extents.y_origin - 1.f;
-    draw->flatten_clip_x1 = (float) draw->fixed_extents.x_origin + (float) draw->fixed_extents.width + 1.f;
-    draw->flatten_clip_y1 = (float) draw->fixed_extents.y_origin + (float) draw->fixed_extents.height + 1.f;
+    draw->flatten_clip_x0 = ((float) draw->fixed_extents.x_origin - xpad) * xs;
+    draw->flatten_clip_y0 = ((float) draw->fixed_extents.y_origin - ypad) * ys;
+    draw->flatten_clip_x1 = ((float) draw->fixed_extents.x_origin + (float) draw->fixed_extents.width + xpad) * xs;
+    draw->flatten_clip_y1 = ((float) draw->fixed_extents.y_origin + (float) draw->fixed_extents.height + ypad) * ys;
   }
   else
     draw->flatten_clip_active = false;
 }
 
+/**
+ * hb_raster_draw_set_format:
+ * @draw: a rasterizer
+ * @format: the output format
+ *
+ * Sets the format hb_raster_draw_render() produces.  The default is
+ * @HB_RASTER_FORMAT_A8 coverage.  With @HB_RASTER_FORMAT_SDF_A8 or
+ * @HB_RASTER_FORMAT_MSDF_BGRA32, the image holds the distance from each
+ * pixel center to the outline instead, computed exactly from the
+ * flattened outline, see hb_raster_draw_set_sdf_spread().  A distance
+ * field rendered once at a moderate size can be sampled at many sizes.
+ * Automatic extents, and those from hb_raster_draw_set_glyph_extents(),
+ * are then padded by the spread on every side.
+ *
+ * With @HB_RASTER_FORMAT_LCD_BGRA32, coverage is computed per subpixel,
+ * see hb_raster_draw_set_lcd_layout(), and padded by a pixel across
+ * the subpixels for the filter's spill.
+ *
+ * Set the format before drawing and before
+ * hb_raster_draw_set_glyph_extents().
+ *
+ * Return value: `true` if @format is supported, `false` otherwise, in
+ * which case the format is not changed
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_draw_set_format (hb_raster_draw_t   *draw,
+			   hb_raster_format_t  format)
+{
+  if (format != HB_RASTER_FORMAT_A8 &&
+      format != HB_RASTER_FORMAT_SDF_A8 &&
+      format != HB_RASTER_FORMAT_MSDF_BGRA32 &&
+      format != HB_RASTER_FORMAT_LCD_BGRA32)
+    return false;
+
+  draw->format = format;
+  hb_raster_draw_update_oversample (draw);
+  hb_raster_draw_update_flatten_clip (draw);
+  return true;
+}
+
+/**
+ * hb_raster_draw_get_format:
+ * @draw: a rasterizer
+ *
+ * Fetches the format set with hb_raster_draw_set_format().
+ *
+ * Return value: the output format
+ *
+ * Since: REPLACEME
+ **/
+hb_raster_format_t
+hb_raster_draw_get_format (const hb_raster_draw_t *draw)
+{
+  return draw->format;
+}
+
+/**
+ * hb_raster_draw_set_sdf_spread:
+ * @draw: a rasterizer
+ * @spread: distance range, in pixels
+ *
+ * Sets the distance, in output pixels, that distance-field formats
+ * encode on each side of the outline: the outline is at 128, and
+ * @spread pixels inside or outside saturate to 255 or 0.  Larger
+ * spreads allow more downscaling and effects such as outlines and
+ * shadows, at the cost of precision.  Spreads are capped at 64 pixels.
+ * The default is 4.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_set_sdf_spread (hb_raster_draw_t *draw,
+			       float             spread)
+{
+  draw->sdf_spread = spread > 0.f ? hb_min (spread, HB_RASTER_SDF_SPREAD_MAX)
+				  : HB_RASTER_SDF_SPREAD_DEFAULT;
+  hb_raster_draw_update_flatten_clip (draw);
+}
+
+/**
+ * hb_raster_draw_get_sdf_spread:
+ * @draw: a rasterizer
+ *
+ * Fetches the spread set with hb_raster_draw_set_sdf_spread().
+ *
+ * Return value: the distance range, in pixels
+ *
+ * Since: REPLACEME
+ **/
+float
+hb_raster_draw_get_sdf_spread (const hb_raster_draw_t *draw)
+{
+  return draw->sdf_spread;
+}
+
+/**
+ * hb_raster_draw_set_lcd_layout:
+ * @draw: a rasterizer
+ * @layout: the subpixel arrangement
+ *
+ * Sets the subpixel arrangement @HB_RASTER_FORMAT_LCD_BGRA32 renders
+ * for.  Coverage is computed at three times the resolution across the
+ * subpixels, horizontally or vertically, then filtered, see
+ * hb_raster_draw_set_lcd_filter().  The default is
+ * @HB_RASTER_LCD_LAYOUT_RGB.
+ *
+ * Return value: `true` if @layout is supported, `false` otherwise, in
+ * which case the layout is not changed
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_draw_set_lcd_layout (hb_raster_draw_t       *draw,
+			       hb_raster_lcd_layout_t  layout)
+{
+  if ((unsigned) layout > HB_RASTER_LCD_LAYOUT_VBGR)
+    return false;
+
+  draw->lcd_layout = layout;
+  hb_raster_draw_update_oversample (draw);
+  hb_raster_draw_update_flatten_clip (draw);
+  return true;
+}
+
+/**
+ * hb_raster_draw_get_lcd_layout:
+ * @draw: a rasterizer
+ *
+ * Fetches the layout set with hb_raster_draw_set_lcd_layout().
+ *
+ * Return value: the subpixel arrangement
+ *
+ * Since: REPLACEME
+ **/
+hb_raster_lcd_layout_t
+hb_raster_draw_get_lcd_layout (const hb_raster_draw_t *draw)
+{
+  return draw->lcd_layout;
+}
+
+/**
+ * hb_raster_draw_set_lcd_filter:
+ * @draw: a rasterizer
+ * @weights: (nullable) (array fixed-size=5): filter weights, in 1/256ths
+ *
+ * Sets the five-tap filter @HB_RASTER_FORMAT_LCD_BGRA32 applies across
+ * subpixel coverage, centered on each subpixel, to reduce color
+ * fringes.  Weights summing to 256 preserve the overall coverage;
+ * filtered values saturate at 255.  `NULL` restores the default,
+ * FreeType's default filter of 8, 77, 86, 77, 8.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_set_lcd_filter (hb_raster_draw_t *draw,
+			       const uint8_t    *weights)
+{
+  hb_memcpy (draw->lcd_filter, weights ? weights : hb_raster_lcd_filter_default,
+	     sizeof (draw->lcd_filter));
+}
+
+/**
+ * hb_raster_draw_get_lcd_filter:
+ * @draw: a rasterizer
+ * @weights: (out) (array fixed-size=5): where to write the filter weights
+ *
+ * Fetches the filter set with hb_raster_draw_set_lcd_filter().
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_get_lcd_filter (const hb_raster_draw_t *draw,
+			       uint8_t                *weights)
+{
+  hb_memcpy (weights, draw->lcd_filter, sizeof (draw->lcd_filter));
+}
+
 /**
  * hb_raster_draw_set_extents:
  * @draw: a rasterizer
@@ -436,10 +933,12 @@ hb_raster_draw_set_glyph_extents (hb_raster_draw_t         *draw,
     ty_max = hb_max (ty_max, ty);
   }
 
-  int32_t ex0 = hb_clamp_to<int32_t> (floorf (tx_min));
-  int32_t ey0 = hb_clamp_to<int32_t> (floorf (ty_min));
-  int32_t ex1 = hb_clamp_to<int32_t> (ceilf  (tx_max));
-  int32_t ey1 = hb_clamp_to<int32_t> (ceilf  (ty_max));
+  int x_pad, y_pad;
+  hb_raster_draw_padding (draw, x_pad, y_pad);
+  int32_t ex0 = hb_clamp_to<int32_t> (floorf (tx_min) - (float) x_pad);
+  int32_t ey0 = hb_clamp_to<int32_t> (floorf (ty_min) - (float) y_pad);
+  int32_t ex1 = hb_clamp_to<int32_t> (ceilf  (tx_max) + (float) x_pad);
+  int32_t ey1 = hb_clamp_to<int32_t> (ceilf  (ty_max) + (float) y_pad);
 
   if (ex1 <= ex0 || ey1 <= ey0)
   {
@@ -465,8 +964,9 @@ hb_raster_draw_set_glyph_extents (hb_raster_draw_t         *draw,
  * @draw: a rasterizer
  *
  * Discards accumulated geometry and extents so @draw can be reused
- * for another render.  User configuration (transform, scale factors)
- * is preserved.  Call hb_raster_draw_reset() to also reset user
+ * for another render.  User configuration (transform, scale factors,
+ * number of threads, format and its parameters) and cached outlines
+ * are preserved.  Call hb_raster_draw_reset() to also reset user
  * configuration to defaults.
  *
  * Since: 14.2.0
@@ -482,7 +982,8 @@ hb_raster_draw_clear (hb_raster_draw_t *draw)
   draw->external_work = nullptr;
   draw->edges_left = HB_RASTER_MAX_DRAW_EDGES;
   draw->edges.clear ();
-  draw->active_edges.clear ();
+  draw->segments.clear ();
+  draw->scratch.active_edges.clear ();
 }
 
 /**
@@ -501,6 +1002,13 @@ hb_raster_draw_reset (hb_raster_draw_t *draw)
   draw->transform         = {1, 0, 0, 1, 0, 0};
   draw->x_scale_factor    = 1.f;
   draw->y_scale_factor    = 1.f;
+  draw->num_threads       = 1;
+  draw->format            = HB_RASTER_FORMAT_A8;
+  draw->sdf_spread        = HB_RASTER_SDF_SPREAD_DEFAULT;
+  draw->lcd_layout        = HB_RASTER_LCD_LAYOUT_RGB;
+  hb_memcpy (draw->lcd_filter, hb_raster_lcd_filter_default, sizeof (draw->lcd_filter));
+  hb_raster_draw_update_oversample (draw);
+  hb_raster_draw_set_outline_cache_max_bytes (draw, 0);
   hb_raster_draw_clear (draw);
 }
 
@@ -567,6 +1075,8 @@ transform_point (const hb_raster_draw_t *draw,
 		 float &tx, float &ty)
 {
   hb_raster_draw_transform_point (draw, x, y, tx, ty);
+  tx *= draw->x_oversample;
+  ty *= draw->y_oversample;
 }
 
 static void
@@ -577,6 +1087,23 @@ emit_segment (hb_raster_draw_t *draw,
   if (unlikely (draw->edges_left <= 0))
     return;
 
+  if (hb_raster_draw_is_distance_field (draw) && (x0 != x1 || y0 != y1) &&
+      std::isfinite (x0) && std::isfinite (y0) &&
+      std::isfinite (x1) && std::isfinite (y1))
+  {
+    /* Same range as the fixed-point edges. */
+    const float lim = (float) (INT32_MAX >> HB_RASTER_PIXEL_BITS);
+    hb_raster_segment_t seg = {hb_clamp (x0, -lim, lim), hb_clamp (y0, -lim, lim),
+			       hb_clamp (x1, -lim, lim), hb_clamp (y1, -lim, lim),
+			       draw->segment_flags};
+    if (unlikely (!draw->segments.push_or_fail (seg)))
+    {
+      draw->edges_left = 0;
+      return;
+    }
+    draw->segment_flags = 0;
+  }
+
   int32_t X0 = hb_clamp_to<int32_t> (roundf (x0 * HB_RASTER_ONE_PIXEL));
   int32_t Y0 = hb_clamp_to<int32_t> (roundf (y0 * HB_RASTER_ONE_PIXEL));
   int32_t X1 = hb_clamp_to<int32_t> (roundf (x1 * HB_RASTER_ONE_PIXEL));
@@ -1025,7 +1552,10 @@ hb_raster_move_to (hb_draw_funcs_t *dfuncs HB_UNUSED,
 		   float to_x HB_UNUSED, float to_y HB_UNUSED,
 		   void *user_data HB_UNUSED)
 {
-  /* no-op: state tracked by hb_draw_state_t */
+  /* Position tracked by hb_draw_state_t; distance fields need the
+     contours. */
+  hb_raster_draw_t *draw = (hb_raster_draw_t *) draw_data;
+  draw->segment_flags = hb_raster_segment_t::CONTOUR_START | hb_raster_segment_t::PRIMITIVE_START;
 }
 
 static void
@@ -1041,6 +1571,7 @@ hb_raster_line_to (hb_draw_funcs_t *dfuncs HB_UNUSED,
   float tx0, ty0, tx1, ty1;
   transform_point (draw, st->current_x, st->current_y, tx0, ty0);
   transform_point (draw, to_x,          to_y,           tx1, ty1);
+  draw->segment_flags |= hb_raster_segment_t::PRIMITIVE_START;
   emit_segment (draw, tx0, ty0, tx1, ty1);
 }
 
@@ -1059,6 +1590,7 @@ hb_raster_quadratic_to (hb_draw_funcs_t *dfuncs HB_UNUSED,
   transform_point (draw, st->current_x, st->current_y, tx0, ty0);
   transform_point (draw, control_x,     control_y,      tx1, ty1);
   transform_point (draw, to_x,          to_y,           tx2, ty2);
+  draw->segment_flags |= hb_raster_segment_t::PRIMITIVE_START;
   flatten_quadratic (draw, tx0, ty0, tx1, ty1, tx2, ty2);
 }
 
@@ -1079,6 +1611,7 @@ hb_raster_cubic_to (hb_draw_funcs_t *dfuncs HB_UNUSED,
   transform_point (draw, control1_x,    control1_y,     tx1, ty1);
   transform_point (draw, control2_x,    control2_y,     tx2, ty2);
   transform_point (draw, to_x,          to_y,           tx3, ty3);
+  draw->segment_flags |= hb_raster_segment_t::PRIMITIVE_START;
   flatten_cubic (draw, tx0, ty0, tx1, ty1, tx2, ty2, tx3, ty3);
 }
 
@@ -1141,6 +1674,43 @@ hb_raster_draw_get_funcs (const hb_raster_draw_t *draw HB_UNUSED)
   return static_raster_draw_funcs.get_unconst ();
 }
 
+/* Moves the edges and segments from @edge_start and @segment_start on
+   by (@dx, @dy) pixels.  Edges move by whole fixed-point units, so
+   their slopes hold. */
+static void
+translate_outline (hb_raster_draw_t *draw,
+		   unsigned edge_start, unsigned segment_start,
+		   float dx, float dy)
+{
+  int64_t DX = hb_clamp_to<int32_t> (roundf (dx * HB_RASTER_ONE_PIXEL));
+  int64_t DY = hb_clamp_to<int32_t> (roundf (dy * HB_RASTER_ONE_PIXEL));
+  if (DX || DY)
+  {
+    unsigned j = edge_start;
+    for (unsigned i = edge_start; i < draw->edges.length; i++)
+    {
+      hb_raster_edge_t e = draw->edges.arrayZ[i];
+      e.xL = hb_clamp_to<int32_t> (e.xL + DX);
+      e.yL = hb_clamp_to<int32_t> (e.yL + DY);
+      e.xH = hb_clamp_to<int32_t> (e.xH + DX);
+      e.yH = hb_clamp_to<int32_t> (e.yH + DY);
+      if (unlikely (e.yL == e.yH)) continue; /* clamped flat */
+      draw->edges.arrayZ[j++] = e;
+    }
+    draw->edges.shrink (j);
+  }
+
+  const float lim = (float) (INT32_MAX >> HB_RASTER_PIXEL_BITS);
+  for (unsigned i = segment_start; i < draw->segments.length; i++)
+  {
+    hb_raster_segment_t &g = draw->segments.arrayZ[i];
+    g.x0 = hb_clamp (g.x0 + dx, -lim, lim);
+    g.y0 = hb_clamp (g.y0 + dy, -lim, lim);
+    g.x1 = hb_clamp (g.x1 + dx, -lim, lim);
+    g.y1 = hb_clamp (g.y1 + dy, -lim, lim);
+  }
+}
+
 /**
  * hb_raster_draw_glyph_or_fail:
  * @draw: a rasterizer
@@ -1154,6 +1724,10 @@ hb_raster_draw_get_funcs (const hb_raster_draw_t *draw HB_UNUSED)
  *   hb_raster_draw_get_funcs (draw), draw);
  * ]|
  *
+ * except that the flattened outline is reused from, and kept in, the
+ * outline cache, if one was set up with
+ * hb_raster_draw_set_outline_cache_max_bytes().
+ *
  * Return value: `true` if the glyph was drawn, `false` if the font has
  * no outlines for @glyph.
  *
@@ -1164,8 +1738,79 @@ hb_raster_draw_glyph_or_fail (hb_raster_draw_t *draw,
 			      hb_font_t       *font,
 			      hb_codepoint_t   glyph)
 {
-  return hb_font_draw_glyph_or_fail (font, glyph,
-				     hb_raster_draw_get_funcs (draw), draw);
+  hb_draw_funcs_t *funcs = hb_raster_draw_get_funcs (draw);
+
+  /* The translation, in device pixels, that cached outlines leave out. */
+  float dx = draw->transform.x0 / draw->x_scale_factor * draw->x_oversample;
+  float dy = draw->transform.y0 / draw->y_scale_factor * draw->y_oversample;
+  if (!draw->outline_cache.max_bytes ||
+      unlikely (!std::isfinite (dx) || !std::isfinite (dy)))
+    return hb_font_draw_glyph_or_fail (font, glyph, funcs, draw);
+
+  hb_raster_outline_key_t key;
+  hb_memset (&key, 0, sizeof (key));
+  key.font = font;
+  key.font_serial = font->serial;
+  key.glyph = glyph;
+  key.xx = draw->transform.xx;
+  key.yx = draw->transform.yx;
+  key.xy = draw->transform.xy;
+  key.yy = draw->transform.yy;
+  key.x_scale_factor = draw->x_scale_factor;
+  key.y_scale_factor = draw->y_scale_factor;
+  key.x_oversample = draw->x_oversample;
+  key.y_oversample = draw->y_oversample;
+  key.distance_field = hb_raster_draw_is_distance_field (draw);
+  uint32_t hash = key.hash ();
+
+  unsigned edge_start = draw->edges.length;
+  unsigned segment_start = draw->segments.length;
+  bool drawn;
+
+  hb_raster_outline_entry_t *entry = draw->outline_cache.fetch (key, hash);
+  if (entry)
+  {
+    drawn = entry->drawn;
+    unsigned num_edges = (unsigned) hb_clamp (draw->edges_left, (int64_t) 0, (int64_t) entry->num_edges);
+    if (unlikely (!draw->edges.resize_dirty (edge_start + num_edges) ||
+		  !draw->segments.resize_dirty (segment_start + entry->num_segments)))
+    {
+      draw->edges.shrink (edge_start);
+      draw->edges_left = 0;
+      return drawn;
+    }
+    hb_memcpy (draw->edges.arrayZ + edge_start, entry->edges (),
+	       num_edges * sizeof (hb_raster_edge_t));
+    hb_memcpy (draw->segments.arrayZ + segment_start, entry->segments (),
+	       entry->num_segments * sizeof (hb_raster_segment_t));
+    draw->edges_left -= num_edges;
+    if (num_edges < entry->num_edges)
+      draw->edges_left = 0;
+  }
+  else
+  {
+    /* Flatten at the origin, and the whole outline: the flattening clip
+       depends on where the glyph lands. */
+    hb_transform_t<> transform = draw->transform;
+    bool flatten_clip_active = draw->flatten_clip_active;
+    draw->transform.x0 = draw->transform.y0 = 0.f;
+    draw->flatten_clip_active = false;
+    drawn = hb_font_draw_glyph_or_fail (font, glyph, funcs, draw);
+    draw->transform = transform;
+    draw->flatten_clip_active = flatten_clip_active;
+
+    /* Outlines cut short by the edge or work budgets are not kept. */
+    const int64_t *work = draw->external_work ? draw->external_work : &draw->flatten_work_left;
+    if (draw->edges_left > 0 && *work > 0)
+      draw->outline_cache.insert (key, hash, drawn,
+				  draw->edges.arrayZ + edge_start,
+				  draw->edges.length - edge_start,
+				  draw->segments.arrayZ + segment_start,
+				  draw->segments.length - segment_start);
+  }
+
+  translate_outline (draw, edge_start, segment_start, dx, dy);
+  return drawn;
 }
 
 /**
@@ -1189,6 +1834,50 @@ hb_raster_draw_glyph (hb_raster_draw_t *draw,
 }
 
 
+/**
+ * hb_raster_draw_buffer:
+ * @draw: a rasterizer
+ * @font: font to draw from
+ * @buffer: a shaped buffer
+ *
+ * Draws all glyphs of shaped @buffer into @draw, each at its shaped
+ * position, with the pen starting at the origin.  The rasterizer's
+ * current transform applies to the whole run.  Edges of all glyphs
+ * accumulate into one outline, so a following hb_raster_draw_render()
+ * rasterizes the run in a single scanline sweep instead of one per
+ * glyph.
+ *
+ * If no extents were set, the result is sized to the ink of the whole
+ * run, up to 4096 pixels per side.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_draw_buffer (hb_raster_draw_t *draw,
+		       hb_font_t        *font,
+		       hb_buffer_t      *buffer)
+{
+  if (unlikely (hb_buffer_get_content_type (buffer) != HB_BUFFER_CONTENT_TYPE_GLYPHS))
+    return;
+
+  unsigned count;
+  const hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  const hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  hb_transform_t<> transform = draw->transform;
+  float pen_x = 0.f, pen_y = 0.f;
+  for (unsigned i = 0; i < count; i++)
+  {
+    draw->transform = transform;
+    draw->transform.translate (pen_x + pos[i].x_offset, pen_y + pos[i].y_offset);
+    hb_raster_draw_glyph (draw, font, info[i].codepoint);
+    pen_x += pos[i].x_advance;
+    pen_y += pos[i].y_advance;
+  }
+  draw->transform = transform;
+}
+
+
 /*
  * Analytic coverage rasterizer
  *
@@ -1235,10 +1924,12 @@ cell_add (int32_t *area, int16_t *cover, unsigned width, int col,
 }
 
 /* Walk one edge through the pixel cells of a single pixel row,
-   accumulating area/cover.  py is the integer pixel-row index. */
+   accumulating area/cover.  py is the integer pixel-row index.
+   If blocks is not null, marks the column blocks touched. */
 static HB_ALWAYS_INLINE void
 edge_sweep_row (int32_t                *area,
 		int16_t                *cover,
+		uint64_t               *blocks,
 		unsigned                width,
 		int                     x_org,
 		int32_t                 y_top,
@@ -1274,6 +1965,20 @@ edge_sweep_row (int32_t                *area,
   int32_t fx1 = x1 & HB_RASTER_PIXEL_MASK;
   int32_t wind = edge.wind;
 
+  if (blocks)
+  {
+    /* Pieces left of the surface carry their cover into column 0. */
+    int64_t lo = (int64_t) hb_min (cx0, cx1) - x_org;
+    int64_t hi = (int64_t) hb_max (cx0, cx1) - x_org;
+    if (lo < (int64_t) width)
+    {
+      unsigned b0 = (unsigned) hb_max (lo, (int64_t) 0) >> HB_RASTER_BLOCK_BITS;
+      unsigned b1 = (unsigned) hb_clamp (hi, (int64_t) 0, (int64_t) width - 1) >> HB_RASTER_BLOCK_BITS;
+      for (unsigned b = b0; b <= b1; b++)
+	blocks[b >> 6] |= (uint64_t) 1 << (b & 63);
+    }
+  }
+
   /* Fast path: both endpoints in the same pixel column. */
   if (cx0 == cx1)
   {
@@ -1325,17 +2030,27 @@ edge_sweep_row (int32_t                *area,
   }
 }
 
-/* Convert cover-delta + area to alpha bytes, then clear.
-   Returns final cover accumulator over [x_min, x_max]. */
+/* Alpha of a cell with accumulated cover and no area of its own. */
+static inline uint8_t
+cover_to_alpha (int32_t cover_accum)
+{
+  int32_t alpha = cover_accum * (2 * HB_RASTER_ONE_PIXEL);
+  alpha = alpha < 0 ? -alpha : alpha;
+  if (alpha > HB_RASTER_FULL_COVERAGE) alpha = HB_RASTER_FULL_COVERAGE;
+  return (uint8_t) (((unsigned) alpha * 255 + HB_RASTER_FULL_COVERAGE / 2) >> (2 * HB_RASTER_PIXEL_BITS + 1));
+}
+
+/* Convert cover-delta + area to alpha bytes, then clear.  Starts from
+   cover_accum carried in from the left; returns it at x_max. */
 static int32_t
 sweep_row_to_alpha (uint8_t *__restrict row_buf,
 		    int32_t *__restrict area,
 		    int16_t *__restrict cover,
 		    unsigned x_min,
-		    unsigned x_max)
+		    unsigned x_max,
+		    int32_t cover_accum = 0)
 {
   const int32_t cover_scale = 2 * HB_RASTER_ONE_PIXEL;
-  int32_t cover_accum = 0;
   unsigned x = x_min;
 
 #ifdef HB_RASTER_NEON
@@ -1434,21 +2149,928 @@ sweep_row_to_alpha (uint8_t *__restrict row_buf,
   return cover_accum;
 }
 
+/* dst[i] = src[i] + dst[i] · (255 − src[i]) / 255: coverage, or each
+   channel of LCD coverage, composited over what's there. */
+static void
+coverage_over_span (uint8_t *__restrict dst,
+		    const uint8_t *__restrict src,
+		    unsigned n)
+{
+  unsigned i = 0;
 
-/**
- * hb_raster_draw_render:
- * @draw: a rasterizer
- *
- * Rasterizes the accumulated outline geometry into a new
- * #hb_raster_image_t.  After rendering, the accumulated edges are
- * cleared so the rasterizer can be reused. Output format is always
- * @HB_RASTER_FORMAT_A8.
- *
- * Return value: (transfer full):
- * A rendered #hb_raster_image_t. Returns `NULL` on allocation/configuration
- * failure. If no geometry was accumulated, returns an empty image.
- *
- * Since: 13.0.0
+#ifdef HB_RASTER_NEON
+  uint16x8_t bias_v = vdupq_n_u16 (255);
+  for (; i + 16 <= n; i += 16)
+  {
+    uint8x16_t s = vld1q_u8 (src + i);
+    uint8x16_t d = vld1q_u8 (dst + i);
+    uint8x16_t inv = vmvnq_u8 (s);
+    uint16x8_t lo = vaddq_u16 (vmull_u8 (vget_low_u8 (d), vget_low_u8 (inv)), bias_v);
+    uint16x8_t hi = vaddq_u16 (vmull_u8 (vget_high_u8 (d), vget_high_u8 (inv)), bias_v);
+    vst1q_u8 (dst + i, vaddq_u8 (vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi, 8)), s));
+  }
+#elif defined(HB_RASTER_SSE2)
+  __m128i zero_v = _mm_setzero_si128 ();
+  __m128i ones_v = _mm_set1_epi8 ((char) 0xFF);
+  __m128i bias_v = _mm_set1_epi16 (255);
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i s = _mm_loadu_si128 ((const __m128i *) (const void *) (src + i));
+    __m128i d = _mm_loadu_si128 ((const __m128i *) (const void *) (dst + i));
+    __m128i inv = _mm_xor_si128 (s, ones_v);
+    __m128i lo = _mm_mullo_epi16 (_mm_unpacklo_epi8 (d, zero_v), _mm_unpacklo_epi8 (inv, zero_v));
+    __m128i hi = _mm_mullo_epi16 (_mm_unpackhi_epi8 (d, zero_v), _mm_unpackhi_epi8 (inv, zero_v));
+    lo = _mm_srli_epi16 (_mm_add_epi16 (lo, bias_v), 8);
+    hi = _mm_srli_epi16 (_mm_add_epi16 (hi, bias_v), 8);
+    _mm_storeu_si128 ((__m128i *) (void *) (dst + i),
+		      _mm_add_epi8 (_mm_packus_epi16 (lo, hi), s));
+  }
+#endif
+
+  for (; i < n; i++)
+    dst[i] = src[i] + hb_raster_div255 (dst[i] * (255u - src[i]));
+}
+
+
+/* Add edge @i to the bucket of the first row of [row0, row1) it may
+   cover; edges starting above row0 go to row0's bucket. */
+static HB_ALWAYS_INLINE void
+bucket_edge (hb_raster_sweep_scratch_t &s,
+	     const hb_raster_edge_t *edges,
+	     unsigned i,
+	     const hb_raster_extents_t &ext,
+	     unsigned row0, unsigned row1)
+{
+  int row = (edges[i].yL >> HB_RASTER_PIXEL_BITS) - ext.y_origin;
+  if (row < (int) row0) row = (int) row0;
+  if ((unsigned) row >= row1) return;
+  s.edge_buckets.arrayZ[row - row0].push (i);
+}
+
+/* Scanline loop over rows [row0, row1), whose edges have been bucketed
+   with bucket_edge(): accumulates each row's active edges and converts
+   them to alpha.  With sparse, only touched column blocks are swept;
+   between them the cover doesn't change, so the alpha is constant.
+   Each row's pixels are a sum over its edges' cells, independent of
+   the order edges are visited in, so any partition of the rows gives
+   the same image.  With over, each row's alpha is composited over the
+   image's pixels instead of stored. */
+template <bool sparse>
+static void
+sweep_rows (const hb_raster_edge_t *edges,
+	    hb_raster_sweep_scratch_t &s,
+	    hb_raster_image_t *image,
+	    const hb_raster_extents_t &ext,
+	    unsigned row0, unsigned row1,
+	    bool over)
+{
+  /* Scanline loop with active edge list. */
+  s.active_edges.clear ();
+
+  for (unsigned row = row0; row < row1; row++)
+  {
+    int64_t y_top_64 = ((int64_t) ext.y_origin + (int64_t) row) * HB_RASTER_ONE_PIXEL;
+    int32_t y_top = (int32_t) hb_clamp (y_top_64, (int64_t) INT32_MIN, (int64_t) INT32_MAX);
+
+    /* Add new edges from this row's bucket. */
+    s.active_edges.extend (s.edge_buckets.arrayZ[row - row0]);
+
+    /* Process active edges and compact live ones in one linear pass. */
+    unsigned x_min = ext.width, x_max = 0;
+    unsigned write = 0;
+    unsigned active_len = s.active_edges.length;
+    for (unsigned j = 0; j < active_len; j++)
+    {
+      unsigned edge_idx = s.active_edges.arrayZ[j];
+      const auto &e = edges[edge_idx];
+      if (e.yH <= y_top)
+	continue;
+
+      edge_sweep_row (s.row_area.arrayZ, s.row_cover.arrayZ,
+		      sparse ? s.row_blocks.arrayZ : nullptr,
+		      ext.width, ext.x_origin, y_top, e, x_min, x_max);
+      s.active_edges.arrayZ[write++] = edge_idx;
+    }
+    s.active_edges.resize (write);
+
+    if (x_min > x_max)
+      continue;
+
+    uint8_t *dst = image->pixels () + (size_t) row * ext.stride;
+    uint8_t *row_buf = dst;
+    if (over)
+    {
+      row_buf = s.row_alpha.arrayZ;
+      if (sparse) /* Runs may leave gaps. */
+	hb_memset (row_buf + x_min, 0, x_max + 1 - x_min);
+    }
+    int32_t cover_accum = 0;
+    unsigned x = x_min;
+    if (!sparse)
+    {
+      cover_accum = sweep_row_to_alpha (row_buf,
+					s.row_area.arrayZ, s.row_cover.arrayZ,
+					x_min, x_max);
+      x = x_max + 1;
+    }
+    else
+    {
+      unsigned w0 = (x_min >> HB_RASTER_BLOCK_BITS) >> 6;
+      unsigned w1 = (x_max >> HB_RASTER_BLOCK_BITS) >> 6;
+      for (unsigned w = w0; w <= w1; w++)
+      {
+	uint64_t bits = s.row_blocks.arrayZ[w];
+	s.row_blocks.arrayZ[w] = 0;
+	while (bits)
+	{
+	  /* Next run of set bits. */
+	  unsigned first = hb_ctz (bits);
+	  uint64_t run = bits >> first;
+	  unsigned len = ~run ? hb_ctz (~run) : 64;
+	  bits = first + len < 64 ? bits & (~(uint64_t) 0 << (first + len)) : 0;
+
+	  unsigned start = hb_max (((w * 64 + first) << HB_RASTER_BLOCK_BITS), x_min);
+	  unsigned end = hb_min (((w * 64 + first + len) << HB_RASTER_BLOCK_BITS) - 1, x_max);
+	  if (unlikely (start > end))
+	    continue;
+
+	  if (cover_accum != 0)
+	    hb_memset (row_buf + x, cover_to_alpha (cover_accum), start - x);
+	  cover_accum = sweep_row_to_alpha (row_buf,
+					    s.row_area.arrayZ, s.row_cover.arrayZ,
+					    start, end, cover_accum);
+	  x = end + 1;
+	}
+      }
+    }
+
+    /* If cover doesn't cancel, memset the constant-alpha tail. */
+    if (cover_accum != 0)
+    {
+      hb_memset (row_buf + x, cover_to_alpha (cover_accum), ext.width - x);
+      x = ext.width;
+    }
+
+    if (over)
+      coverage_over_span (dst + x_min, row_buf + x_min, x - x_min);
+  }
+}
+
+/* Sweeps horizontal strips of HB_RASTER_STRIP_ROWS rows concurrently,
+   each worker with its own scratch.  Returns false, with the image
+   cleared, if it didn't; the caller then sweeps serially.  Strips
+   already composited over the image can't be taken back though, so
+   with over, failing after sweeping started sets @failed instead. */
+static bool
+sweep_strips (hb_raster_draw_t *draw,
+	      hb_raster_image_t *image,
+	      const hb_raster_extents_t &ext,
+	      bool sparse,
+	      bool over,
+	      bool &failed)
+{
+  unsigned num_strips = (ext.height + HB_RASTER_STRIP_ROWS - 1) / HB_RASTER_STRIP_ROWS;
+  unsigned num_threads = hb_min (hb_parallel_num_threads (draw->num_threads), num_strips);
+  if (num_threads == 1)
+    return false;
+
+  /* Bin edges into every strip they cover rows of. */
+  unsigned old_strips = draw->strip_edges.length;
+  if (num_strips > old_strips)
+  {
+    if (unlikely (!draw->strip_edges.resize (num_strips)))
+      return false;
+  }
+  for (unsigned k = 0; k < hb_min (num_strips, old_strips); k++)
+    draw->strip_edges.arrayZ[k].clear ();
+
+  for (unsigned i = 0; i < draw->edges.length; i++)
+  {
+    const auto &e = draw->edges.arrayZ[i];
+    int64_t r0 = (int64_t) (e.yL >> HB_RASTER_PIXEL_BITS) - ext.y_origin;
+    int64_t r1 = (((int64_t) e.yH + HB_RASTER_PIXEL_MASK) >> HB_RASTER_PIXEL_BITS) - ext.y_origin;
+    r0 = hb_max (r0, (int64_t) 0);
+    r1 = hb_min (r1, (int64_t) ext.height);
+    if (r0 >= r1) continue;
+    unsigned k1 = (unsigned) (r1 - 1) / HB_RASTER_STRIP_ROWS;
+    for (unsigned k = (unsigned) r0 / HB_RASTER_STRIP_ROWS; k <= k1; k++)
+      draw->strip_edges.arrayZ[k].push (i);
+  }
+  for (unsigned k = 0; k < num_strips; k++)
+    if (unlikely (draw->strip_edges.arrayZ[k].in_error ()))
+      return false;
+
+  if (draw->worker_scratch.length < num_threads - 1 &&
+      unlikely (!draw->worker_scratch.resize (num_threads - 1)))
+    return false;
+  if (unlikely (!draw->scratch.prepare (ext.width, HB_RASTER_STRIP_ROWS, sparse, over)))
+    return false;
+  for (unsigned w = 0; w < num_threads - 1; w++)
+    if (unlikely (!draw->worker_scratch.arrayZ[w].prepare (ext.width, HB_RASTER_STRIP_ROWS, sparse, over)))
+      return false;
+
+  hb_atomic_t<int> strip_failed {0};
+  bool ret = hb_parallel_for (num_threads, num_strips,
+			      [&] (unsigned worker, unsigned k)
+  {
+    hb_raster_sweep_scratch_t &s = worker ? draw->worker_scratch.arrayZ[worker - 1] : draw->scratch;
+    unsigned row0 = k * HB_RASTER_STRIP_ROWS;
+    unsigned row1 = hb_min (row0 + HB_RASTER_STRIP_ROWS, ext.height);
+
+    s.clear_buckets (row1 - row0);
+    for (unsigned i : draw->strip_edges.arrayZ[k])
+      bucket_edge (s, draw->edges.arrayZ, i, ext, row0, row1);
+    for (unsigned r = 0; r < row1 - row0; r++)
+      if (unlikely (s.edge_buckets.arrayZ[r].in_error ()))
+      {
+	strip_failed.set_relaxed (1);
+	return;
+      }
+
+    if (sparse)
+      sweep_rows<true> (draw->edges.arrayZ, s, image, ext, row0, row1, over);
+    else
+      sweep_rows<false> (draw->edges.arrayZ, s, image, ext, row0, row1, over);
+  });
+
+  if (unlikely (!ret || strip_failed.get_relaxed ()))
+  {
+    if (over)
+      failed = true;
+    else
+      image->clear ();
+    return false;
+  }
+  return true;
+}
+
+/* Bucket edges by starting row and sweep them into @image, cleared,
+   of extents @ext; or with @over, over its pixels.  Returns false on
+   allocation failure. */
+static bool
+sweep_coverage (hb_raster_draw_t *draw,
+		hb_raster_image_t *image,
+		const hb_raster_extents_t &ext,
+		bool over = false)
+{
+  if (!draw->edges.length || !ext.width || !ext.height)
+    return true;
+
+  bool sparse = ext.width >= HB_RASTER_SPARSE_MIN_WIDTH;
+
+  if (draw->num_threads != 1 &&
+      ext.height >= HB_RASTER_PARALLEL_MIN_ROWS)
+  {
+    bool failed = false;
+    if (sweep_strips (draw, image, ext, sparse, over, failed))
+      return true;
+    if (unlikely (failed))
+      return false;
+  }
+
+  if (unlikely (!draw->scratch.prepare (ext.width, ext.height, sparse, over)))
+    return false;
+
+  /* Bucket edges by their starting pixel row. */
+  for (unsigned i = 0; i < draw->edges.length; i++)
+    bucket_edge (draw->scratch, draw->edges.arrayZ, i, ext, 0, ext.height);
+
+  if (sparse)
+    sweep_rows<true> (draw->edges.arrayZ, draw->scratch, image, ext, 0, ext.height, over);
+  else
+    sweep_rows<false> (draw->edges.arrayZ, draw->scratch, image, ext, 0, ext.height, over);
+  return true;
+}
+
+/* LCD subpixel coverage.
+ *
+ * Geometry is drawn three times wider, or taller for vertical layouts,
+ * and swept at that resolution into an A8 coverage image reaching two
+ * subpixels past the output on either side.  Each subpixel is then
+ * filtered with the five-tap FIR centered on it, and the three
+ * subpixels of every pixel packed into its R, G and B bytes.
+ */
+
+/* dst[i] = min (Σ w[k] · src[i + k · tap_stride], 65535) >> 8 */
+static void
+lcd_filter_span (uint8_t *__restrict dst,
+		 const uint8_t *__restrict src,
+		 size_t tap_stride,
+		 unsigned n,
+		 const uint8_t *w)
+{
+  unsigned i = 0;
+
+#ifdef HB_RASTER_NEON
+  for (; i + 16 <= n; i += 16)
+  {
+    uint16x8_t lo = vdupq_n_u16 (0), hi = vdupq_n_u16 (0);
+    for (unsigned k = 0; k < HB_RASTER_LCD_TAPS; k++)
+    {
+      uint8x16_t v = vld1q_u8 (src + i + k * tap_stride);
+      uint8x8_t wk = vdup_n_u8 (w[k]);
+      lo = vqaddq_u16 (lo, vmull_u8 (vget_low_u8 (v), wk));
+      hi = vqaddq_u16 (hi, vmull_u8 (vget_high_u8 (v), wk));
+    }
+    vst1q_u8 (dst + i, vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi, 8)));
+  }
+#elif defined(HB_RASTER_SSE2)
+  __m128i zero_v = _mm_setzero_si128 ();
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i lo = zero_v, hi = zero_v;
+    for (unsigned k = 0; k < HB_RASTER_LCD_TAPS; k++)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (const void *) (src + i + k * tap_stride));
+      __m128i wk = _mm_set1_epi16 ((short) w[k]);
+      lo = _mm_adds_epu16 (lo, _mm_mullo_epi16 (_mm_unpacklo_epi8 (v, zero_v), wk));
+      hi = _mm_adds_epu16 (hi, _mm_mullo_epi16 (_mm_unpackhi_epi8 (v, zero_v), wk));
+    }
+    __m128i r = _mm_packus_epi16 (_mm_srli_epi16 (lo, 8), _mm_srli_epi16 (hi, 8));
+    _mm_storeu_si128 ((__m128i *) (void *) (dst + i), r);
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    unsigned sum = 0;
+    for (unsigned k = 0; k < HB_RASTER_LCD_TAPS; k++)
+      sum += w[k] * src[i + k * tap_stride];
+    dst[i] = (uint8_t) (hb_min (sum, 65535u) >> 8);
+  }
+}
+
+/* Packs the filtered subpixels c0[x · step], c1[…], c2[…], left to
+   right or bottom to top, into B, G, R and their mean into A.
+   Subpixel 0 is red if @red_first, blue otherwise. */
+static void
+lcd_pack_row (uint8_t *__restrict dst,
+	      const uint8_t *c0, const uint8_t *c1, const uint8_t *c2,
+	      unsigned step,
+	      bool red_first,
+	      unsigned width)
+{
+  const uint8_t *red  = red_first ? c0 : c2;
+  const uint8_t *blue = red_first ? c2 : c0;
+  unsigned x = 0;
+
+  /* Mean as (sum + 1) · 21846 >> 16, which is (sum + 1) / 3 for these
+     sums, so the vector and scalar paths agree. */
+#ifdef HB_RASTER_NEON
+  for (; x + 16 <= width; x += 16)
+  {
+    uint8x16_t r, g, b;
+    if (step == 3)
+    {
+      uint8x16x3_t v = vld3q_u8 (c0 + 3 * x);
+      r = red_first ? v.val[0] : v.val[2];
+      g = v.val[1];
+      b = red_first ? v.val[2] : v.val[0];
+    }
+    else
+    {
+      r = vld1q_u8 (red + x);
+      g = vld1q_u8 (c1 + x);
+      b = vld1q_u8 (blue + x);
+    }
+    uint16x8_t one = vdupq_n_u16 (1);
+    uint16x8_t slo = vaddq_u16 (vaddw_u8 (vaddl_u8 (vget_low_u8 (r), vget_low_u8 (g)), vget_low_u8 (b)), one);
+    uint16x8_t shi = vaddq_u16 (vaddw_u8 (vaddl_u8 (vget_high_u8 (r), vget_high_u8 (g)), vget_high_u8 (b)), one);
+    int16x8_t alo = vqdmulhq_n_s16 (vreinterpretq_s16_u16 (slo), 10923);
+    int16x8_t ahi = vqdmulhq_n_s16 (vreinterpretq_s16_u16 (shi), 10923);
+    uint8x16x4_t out;
+    out.val[0] = b;
+    out.val[1] = g;
+    out.val[2] = r;
+    out.val[3] = vcombine_u8 (vmovn_u16 (vreinterpretq_u16_s16 (alo)),
+			      vmovn_u16 (vreinterpretq_u16_s16 (ahi)));
+    vst4q_u8 (dst + 4 * x, out);
+  }
+#elif defined(HB_RASTER_SSE2)
+  if (step == 1)
+  {
+    __m128i zero_v = _mm_setzero_si128 ();
+    __m128i one_v  = _mm_set1_epi16 (1);
+    __m128i third  = _mm_set1_epi16 (21846);
+    for (; x + 16 <= width; x += 16)
+    {
+      __m128i r = _mm_loadu_si128 ((const __m128i *) (const void *) (red + x));
+      __m128i g = _mm_loadu_si128 ((const __m128i *) (const void *) (c1 + x));
+      __m128i b = _mm_loadu_si128 ((const __m128i *) (const void *) (blue + x));
+
+      __m128i slo = _mm_add_epi16 (_mm_add_epi16 (_mm_unpacklo_epi8 (r, zero_v),
+						  _mm_unpacklo_epi8 (g, zero_v)),
+				   _mm_add_epi16 (_mm_unpacklo_epi8 (b, zero_v), one_v));
+      __m128i shi = _mm_add_epi16 (_mm_add_epi16 (_mm_unpackhi_epi8 (r, zero_v),
+						  _mm_unpackhi_epi8 (g, zero_v)),
+				   _mm_add_epi16 (_mm_unpackhi_epi8 (b, zero_v), one_v));
+      __m128i a = _mm_packus_epi16 (_mm_mulhi_epu16 (slo, third),
+				    _mm_mulhi_epu16 (shi, third));
+
+      __m128i bg_lo = _mm_unpacklo_epi8 (b, g);
+      __m128i bg_hi = _mm_unpackhi_epi8 (b, g);
+      __m128i ra_lo = _mm_unpacklo_epi8 (r, a);
+      __m128i ra_hi = _mm_unpackhi_epi8 (r, a);
+      _mm_storeu_si128 ((__m128i *) (void *) (dst + 4 * x +  0), _mm_unpacklo_epi16 (bg_lo, ra_lo));
+      _mm_storeu_si128 ((__m128i *) (void *) (dst + 4 * x + 16), _mm_unpackhi_epi16 (bg_lo, ra_lo));
+      _mm_storeu_si128 ((__m128i *) (void *) (dst + 4 * x + 32), _mm_unpacklo_epi16 (bg_hi, ra_hi));
+      _mm_storeu_si128 ((__m128i *) (void *) (dst + 4 * x + 48), _mm_unpackhi_epi16 (bg_hi, ra_hi));
+    }
+  }
+#endif
+
+  for (; x < width; x++)
+  {
+    unsigned r = red[x * step], g = c1[x * step], b = blue[x * step];
+    dst[4 * x + 0] = (uint8_t) b;
+    dst[4 * x + 1] = (uint8_t) g;
+    dst[4 * x + 2] = (uint8_t) r;
+    dst[4 * x + 3] = (uint8_t) ((r + g + b + 1) / 3);
+  }
+}
+
+static bool
+render_lcd (hb_raster_draw_t *draw,
+	    hb_raster_image_t *image,
+	    const hb_raster_extents_t &ext,
+	    bool over = false)
+{
+  if (!ext.width || !ext.height)
+    return true;
+
+  const bool vertical = hb_raster_draw_is_lcd_vertical (draw);
+  const unsigned reach = HB_RASTER_LCD_TAPS / 2;
+
+  /* ── Sweep subpixel coverage ─────────────────────────────────── */
+  int64_t cx0 = ext.x_origin, cy0 = ext.y_origin;
+  uint64_t cw = ext.width, ch = ext.height;
+  if (vertical)
+  {
+    cy0 = cy0 * 3 - reach;
+    ch  = ch * 3 + 2 * reach;
+  }
+  else
+  {
+    cx0 = cx0 * 3 - reach;
+    cw  = cw * 3 + 2 * reach;
+  }
+  if (unlikely (cw > UINT_MAX || ch > UINT_MAX))
+    return false;
+  /* Out here no edge can reach; nothing is drawn. */
+  if (unlikely (cx0 != (int) cx0 || cy0 != (int) cy0))
+    return true;
+
+  if (!draw->lcd_coverage)
+  {
+    draw->lcd_coverage = hb_raster_image_create_or_fail ();
+    if (unlikely (!draw->lcd_coverage))
+      return false;
+  }
+  hb_raster_image_t *coverage = draw->lcd_coverage;
+  hb_raster_extents_t cext = {(int) cx0, (int) cy0, (unsigned) cw, (unsigned) ch, 0};
+  if (unlikely (!coverage->configure (HB_RASTER_FORMAT_A8, cext)))
+    return false;
+  coverage->clear ();
+  if (unlikely (!sweep_coverage (draw, coverage, coverage->extents)))
+    return false;
+
+  /* ── Filter and pack ─────────────────────────────────────────── */
+  unsigned filtered = 3 * ext.width;
+  if (unlikely (!draw->lcd_row.resize_dirty (filtered)))
+    return false;
+  if (over && unlikely (!draw->lcd_packed.resize_dirty (4 * ext.width)))
+    return false;
+  uint8_t *f = draw->lcd_row.arrayZ;
+  const uint8_t *w = draw->lcd_filter;
+  bool red_first = draw->lcd_layout == HB_RASTER_LCD_LAYOUT_RGB ||
+		   draw->lcd_layout == HB_RASTER_LCD_LAYOUT_VBGR;
+  size_t cstride = coverage->extents.stride;
+  const uint8_t *cov = coverage->buffer.arrayZ;
+
+  for (unsigned row = 0; row < ext.height; row++)
+  {
+    uint8_t *dst = image->pixels () + (size_t) row * ext.stride;
+    uint8_t *packed = over ? draw->lcd_packed.arrayZ : dst;
+    if (vertical)
+    {
+      for (unsigned c = 0; c < 3; c++)
+	lcd_filter_span (f + c * ext.width, cov + (3 * (size_t) row + c) * cstride,
+			 cstride, ext.width, w);
+      lcd_pack_row (packed, f, f + ext.width, f + 2 * ext.width, 1, red_first, ext.width);
+    }
+    else
+    {
+      lcd_filter_span (f, cov + (size_t) row * cstride, 1, filtered, w);
+      lcd_pack_row (packed, f, f + 1, f + 2, 3, red_first, ext.width);
+    }
+    if (over)
+      coverage_over_span (dst, packed, 4 * ext.width);
+  }
+
+  return true;
+}
+
+/* Distance fields.
+ *
+ * Each pixel gets the distance from its center to the nearest segment
+ * of the flattened outline, positive inside.  Inside is decided by the
+ * nonzero winding of the edges at the pixel center, the fill rule of
+ * coverage rendering.
+ *
+ * The multi-channel field follows Chlumsky's msdfgen: contours are cut
+ * at corners, the runs between corners colored so that the two sides
+ * of every corner differ in two of the three channels, and each channel
+ * holds the signed pseudo-distance to the nearest segment of its
+ * colors, which continues a line or curve past its ends along the
+ * tangent.  The median of the channels then keeps corners sharp when
+ * the field is magnified.  Where the median disagrees with the winding,
+ * all channels get the true distance instead.
+ */
+
+#define HB_RASTER_SDF_RED     1u
+#define HB_RASTER_SDF_GREEN   2u
+#define HB_RASTER_SDF_BLUE    4u
+#define HB_RASTER_SDF_YELLOW  (HB_RASTER_SDF_RED | HB_RASTER_SDF_GREEN)
+#define HB_RASTER_SDF_MAGENTA (HB_RASTER_SDF_RED | HB_RASTER_SDF_BLUE)
+#define HB_RASTER_SDF_CYAN    (HB_RASTER_SDF_GREEN | HB_RASTER_SDF_BLUE)
+#define HB_RASTER_SDF_WHITE   (HB_RASTER_SDF_RED | HB_RASTER_SDF_GREEN | HB_RASTER_SDF_BLUE)
+/* In sdf_info, next to the colors: the segment starts or ends the line
+   or curve it was flattened from. */
+#define HB_RASTER_SDF_RUN_START 8u
+#define HB_RASTER_SDF_RUN_END   16u
+
+/* Next color in the cycle cyan, magenta, yellow; avoids sharing a
+   single channel with @banned. */
+static inline uint8_t
+sdf_switch_color (uint8_t color, uint8_t banned = 0)
+{
+  uint8_t combined = color & banned;
+  if (combined == HB_RASTER_SDF_RED ||
+      combined == HB_RASTER_SDF_GREEN ||
+      combined == HB_RASTER_SDF_BLUE)
+    return combined ^ HB_RASTER_SDF_WHITE;
+  if (!color || color == HB_RASTER_SDF_WHITE)
+    return HB_RASTER_SDF_CYAN;
+  unsigned shifted = (unsigned) color << 1;
+  return (uint8_t) ((shifted | shifted >> 3) & HB_RASTER_SDF_WHITE);
+}
+
+/* Splits [0, n) into thirds, as -1, 0, 1, the middle one the largest. */
+static inline int
+sdf_trichotomy (unsigned i, unsigned n)
+{
+  return (int) (3 + 2.875 * i / (n - 1) - 1.4375 + .5) - 3;
+}
+
+/* Fills sdf_info with the colors and run ends of every segment. */
+static bool
+sdf_color_segments (hb_raster_draw_t *draw)
+{
+  const hb_raster_segment_t *seg = draw->segments.arrayZ;
+  uint8_t *info = draw->sdf_info.arrayZ;
+  unsigned n = draw->segments.length;
+  hb_vector_t<unsigned> &corners = draw->sdf_active;
+
+  /* Corners turn by more than 3 radians from straight back, as in
+     msdfgen: sin (3). */
+  const float cross_threshold = 0.14112f;
+
+  uint8_t color = HB_RASTER_SDF_CYAN;
+  for (unsigned c0 = 0; c0 < n;)
+  {
+    unsigned c1 = c0 + 1;
+    while (c1 < n && !(seg[c1].flags & hb_raster_segment_t::CONTOUR_START))
+      c1++;
+    unsigned m = c1 - c0;
+
+    corners.clear ();
+    for (unsigned i = c0; i < c1; i++)
+    {
+      unsigned next = i + 1 < c1 ? i + 1 : c0;
+      bool starts = seg[i].flags & hb_raster_segment_t::PRIMITIVE_START;
+      info[i] = (starts ? HB_RASTER_SDF_RUN_START : 0) |
+		(seg[next].flags & hb_raster_segment_t::PRIMITIVE_START ? HB_RASTER_SDF_RUN_END : 0);
+      if (!starts)
+	continue;
+
+      /* Within a curve, joints are smooth. */
+      unsigned prev = i > c0 ? i - 1 : c1 - 1;
+      float ax = seg[prev].x1 - seg[prev].x0, ay = seg[prev].y1 - seg[prev].y0;
+      float bx = seg[i].x1 - seg[i].x0, by = seg[i].y1 - seg[i].y0;
+      float dot = ax * bx + ay * by;
+      float cross = ax * by - ay * bx;
+      if (dot <= 0 || fabsf (cross) > cross_threshold * sqrtf ((ax * ax + ay * ay) * (bx * bx + by * by)))
+	corners.push (i - c0);
+    }
+    if (unlikely (corners.in_error ()))
+      return false;
+
+    if (!corners.length)
+    {
+      /* Smooth contour. */
+      color = sdf_switch_color (color);
+      for (unsigned i = c0; i < c1; i++)
+	info[i] |= color;
+    }
+    else if (corners.length == 1)
+    {
+      /* Teardrop: thirds of the contour from the corner on. */
+      uint8_t colors[3];
+      color = sdf_switch_color (color);
+      colors[0] = color;
+      colors[1] = HB_RASTER_SDF_WHITE;
+      color = sdf_switch_color (color);
+      colors[2] = color;
+      unsigned corner = corners.arrayZ[0];
+      for (unsigned i = 0; i < m; i++)
+	info[c0 + (corner + i) % m] |= m >= 3 ? colors[1 + sdf_trichotomy (i, m)] : HB_RASTER_SDF_WHITE;
+    }
+    else
+    {
+      unsigned spline = 0;
+      unsigned start = corners.arrayZ[0];
+      color = sdf_switch_color (color);
+      uint8_t initial = color;
+      for (unsigned i = 0; i < m; i++)
+      {
+	unsigned index = (start + i) % m;
+	if (spline + 1 < corners.length && corners.arrayZ[spline + 1] == index)
+	{
+	  spline++;
+	  color = sdf_switch_color (color, spline == corners.length - 1 ? initial : 0);
+	}
+	info[c0 + index] |= color;
+      }
+    }
+
+    c0 = c1;
+  }
+  return true;
+}
+
+static inline uint8_t
+sdf_value (float distance, float spread)
+{
+  float v = hb_clamp (128.f + distance * (128.f / spread), 0.f, 255.f);
+  return (uint8_t) (v + .5f);
+}
+
+/* Signed distance from (px,py) to segment @g, positive inside, where
+   @t is the projection parameter of the point on the segment.  Past
+   the ends of a line or curve, the distance to its tangent line if
+   nearer. */
+static inline float
+sdf_pseudo_distance (const hb_raster_segment_t &g, unsigned info,
+		     float px, float py, float t, float orientation)
+{
+  float ax = g.x1 - g.x0, ay = g.y1 - g.y0;
+  float qx = px - g.x0, qy = py - g.y0;
+  float tc = hb_clamp (t, 0.f, 1.f);
+  float dx = qx - ax * tc, dy = qy - ay * tc;
+  float d = sqrtf (dx * dx + dy * dy);
+
+  float side = (ax * qy - ay * qx) * orientation;
+  if (side < 0)
+    d = -d;
+
+  if ((t < 0 && (info & HB_RASTER_SDF_RUN_START)) ||
+      (t > 1 && (info & HB_RASTER_SDF_RUN_END)))
+  {
+    float perpendicular = side / sqrtf (ax * ax + ay * ay);
+    if (fabsf (perpendicular) <= fabsf (d))
+      d = perpendicular;
+  }
+  return d;
+}
+
+static bool
+render_distance_field (hb_raster_draw_t *draw,
+		       hb_raster_image_t *image,
+		       const hb_raster_extents_t &ext)
+{
+  unsigned n = draw->segments.length;
+  if (!n || !ext.width || !ext.height)
+    return true;
+
+  bool msdf = draw->format == HB_RASTER_FORMAT_MSDF_BGRA32;
+  const hb_raster_segment_t *seg = draw->segments.arrayZ;
+
+  /* With a positive total area, outlines run counter-clockwise, with
+     the inside on their left. */
+  double area = 0;
+  for (unsigned i = 0; i < n; i++)
+    area += (double) seg[i].x0 * (double) seg[i].y1 - (double) seg[i].x1 * (double) seg[i].y0;
+  float orientation = area < 0 ? -1.f : 1.f;
+
+  if (unlikely (!draw->sdf_info.resize_dirty (n) ||
+		!draw->sdf_order.resize_dirty (n) ||
+		!draw->sdf_inside.resize_dirty (ext.width)))
+    return false;
+  if (msdf && unlikely (!sdf_color_segments (draw)))
+    return false;
+
+  /* Segments by their lowest point, to enter the rows they reach. */
+  for (unsigned i = 0; i < n; i++)
+    draw->sdf_order.arrayZ[i] = i;
+  draw->sdf_order.qsort ([seg] (const unsigned &a, const unsigned &b)
+  {
+    float ya = hb_min (seg[a].y0, seg[a].y1);
+    float yb = hb_min (seg[b].y0, seg[b].y1);
+    return ya < yb ? -1 : ya > yb ? 1 : 0;
+  });
+
+  /* Edges by their starting row, to walk the winding. */
+  hb_raster_sweep_scratch_t &s = draw->scratch;
+  if (unlikely (!s.clear_buckets (ext.height)))
+    return false;
+  for (unsigned i = 0; i < draw->edges.length; i++)
+    bucket_edge (s, draw->edges.arrayZ, i, ext, 0, ext.height);
+  s.active_edges.clear ();
+
+  /* Segments farther than the spread from a pixel only saturate it. */
+  float reach = draw->sdf_spread;
+  float spread = draw->sdf_spread;
+  int64_t work_left = HB_RASTER_MAX_DISTANCE_WORK;
+  hb_vector_t<unsigned> &active = draw->sdf_active;
+  active.clear ();
+  unsigned next = 0;
+  const uint8_t *info = draw->sdf_info.arrayZ;
+  uint8_t *inside = draw->sdf_inside.arrayZ;
+
+  for (unsigned row = 0; row < ext.height; row++)
+  {
+    int64_t y_fx = ((int64_t) ext.y_origin + row) * HB_RASTER_ONE_PIXEL + HB_RASTER_ONE_PIXEL / 2;
+    int32_t yc = (int32_t) hb_clamp (y_fx, (int64_t) INT32_MIN, (int64_t) INT32_MAX);
+    float py = (float) ext.y_origin + (float) row + .5f;
+
+    /* Winding at pixel centers, from the edges crossing the row's
+       center line. */
+    s.active_edges.extend (s.edge_buckets.arrayZ[row]);
+    draw->sdf_crossings.clear ();
+    unsigned write = 0;
+    for (unsigned j = 0; j < s.active_edges.length; j++)
+    {
+      unsigned edge_idx = s.active_edges.arrayZ[j];
+      const auto &e = draw->edges.arrayZ[edge_idx];
+      if (e.yH <= yc)
+	continue;
+      s.active_edges.arrayZ[write++] = edge_idx;
+      if (e.yL > yc)
+	continue;
+      int64_t x = (int64_t) e.xL + ((((int64_t) yc - e.yL) * e.slope) >> 16);
+      draw->sdf_crossings.push (hb_pair_t<int32_t, int32_t> ((int32_t) hb_clamp (x, (int64_t) INT32_MIN, (int64_t) INT32_MAX),
+							     e.wind));
+    }
+    s.active_edges.resize (write);
+    if (unlikely (draw->sdf_crossings.in_error ()))
+      return false;
+    draw->sdf_crossings.qsort ([] (const hb_pair_t<int32_t, int32_t> &a,
+				   const hb_pair_t<int32_t, int32_t> &b)
+    { return a.first < b.first ? -1 : a.first > b.first ? 1 : 0; });
+
+    int wind = 0;
+    unsigned k = 0;
+    for (unsigned col = 0; col < ext.width; col++)
+    {
+      int64_t x_fx = ((int64_t) ext.x_origin + col) * HB_RASTER_ONE_PIXEL + HB_RASTER_ONE_PIXEL / 2;
+      for (; k < draw->sdf_crossings.length && draw->sdf_crossings.arrayZ[k].first <= x_fx; k++)
+	wind += draw->sdf_crossings.arrayZ[k].second;
+      inside[col] = wind != 0;
+    }
+
+    /* Segments within reach of the row. */
+    for (; next < n; next++)
+    {
+      unsigned i = draw->sdf_order.arrayZ[next];
+      if (hb_min (seg[i].y0, seg[i].y1) - reach > py)
+	break;
+      active.push (i);
+    }
+    if (unlikely (active.in_error ()))
+      return false;
+    write = 0;
+    for (unsigned j = 0; j < active.length; j++)
+    {
+      unsigned i = active.arrayZ[j];
+      if (hb_max (seg[i].y0, seg[i].y1) + reach >= py)
+	active.arrayZ[write++] = i;
+    }
+    active.resize (write);
+
+    work_left -= (int64_t) active.length * ext.width;
+    if (unlikely (work_left < 0))
+      return false;
+
+    uint8_t *row_buf = image->pixels () + (size_t) row * ext.stride;
+    for (unsigned col = 0; col < ext.width; col++)
+    {
+      float px = (float) ext.x_origin + (float) col + .5f;
+
+      struct nearest_t
+      {
+	float d2 = INFINITY;
+	float ortho = 0.f;
+	float t = 0.f;
+	unsigned seg = 0;
+      } channels[3];
+      float best_d2 = INFINITY;
+
+      for (unsigned j = 0; j < active.length; j++)
+      {
+	unsigned i = active.arrayZ[j];
+	const hb_raster_segment_t &g = seg[i];
+	if (px < hb_min (g.x0, g.x1) - reach || px > hb_max (g.x0, g.x1) + reach)
+	  continue;
+
+	float ax = g.x1 - g.x0, ay = g.y1 - g.y0;
+	float qx = px - g.x0, qy = py - g.y0;
+	float len2 = ax * ax + ay * ay;
+	float t = (qx * ax + qy * ay) / len2;
+	float tc = hb_clamp (t, 0.f, 1.f);
+	float dx = qx - ax * tc, dy = qy - ay * tc;
+	float d2 = dx * dx + dy * dy;
+	best_d2 = hb_min (best_d2, d2);
+
+	if (!msdf)
+	  continue;
+
+	/* Ties, at shared endpoints, go to the segment pointing most
+	   squarely at the pixel. */
+	float ortho = 0.f;
+	if ((t <= 0 || t >= 1) && d2 > 0)
+	  ortho = fabsf (ax * dx + ay * dy) / sqrtf (len2 * d2);
+	for (unsigned c = 0; c < 3; c++)
+	{
+	  nearest_t &ch = channels[c];
+	  if ((info[i] & (1u << c)) &&
+	      (d2 < ch.d2 || (d2 == ch.d2 && ortho < ch.ortho)))
+	  {
+	    ch.d2 = d2;
+	    ch.ortho = ortho;
+	    ch.t = t;
+	    ch.seg = i;
+	  }
+	}
+      }
+
+      bool in = inside[col];
+      float d = sqrtf (best_d2);
+      uint8_t true_value = sdf_value (in ? d : -d, spread);
+      if (!msdf)
+      {
+	row_buf[col] = true_value;
+	continue;
+      }
+
+      uint8_t v[3];
+      for (unsigned c = 0; c < 3; c++)
+	v[c] = channels[c].d2 == INFINITY ? (in ? 255 : 0)
+	     : sdf_value (sdf_pseudo_distance (seg[channels[c].seg], info[channels[c].seg],
+					       px, py, channels[c].t, orientation),
+			  spread);
+
+      uint8_t median = hb_max (hb_min (v[0], v[1]), hb_min (hb_max (v[0], v[1]), v[2]));
+      if ((median >= 128) != in)
+	v[0] = v[1] = v[2] = true_value;
+
+      uint8_t *p = row_buf + col * 4;
+      p[0] = v[2];
+      p[1] = v[1];
+      p[2] = v[0];
+      p[3] = true_value;
+    }
+  }
+
+  return true;
+}
+
+static inline int64_t
+div_floor (int64_t a, int64_t b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static inline int64_t
+div_ceil (int64_t a, int64_t b)
+{
+  return a >= 0 ? (a + b - 1) / b : -(-a / b);
+}
+
+/**
+ * hb_raster_draw_render:
+ * @draw: a rasterizer
+ *
+ * Rasterizes the accumulated outline geometry into a new
+ * #hb_raster_image_t.  After rendering, the accumulated edges are
+ * cleared so the rasterizer can be reused. Output format is
+ * @HB_RASTER_FORMAT_A8 unless set otherwise with
+ * hb_raster_draw_set_format().
+ *
+ * Return value: (transfer full):
+ * A rendered #hb_raster_image_t. Returns `NULL` on allocation/configuration
+ * failure. If no geometry was accumulated, returns an empty image.
+ *
+ * Since: 13.0.0
  **/
 hb_raster_image_t *
 hb_raster_draw_render (hb_raster_draw_t *draw)
@@ -1481,13 +3103,17 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
 	ymax = hb_max (ymax, e.yH);
       }
 
-      /* Convert fixed-point → pixels (floor for min, ceil for max).  Edge
-	 coordinates are saturated to int32 range in emit_segment, so the
-	 +MASK ceil step must be widened to avoid signed overflow. */
-      int x0 = xmin >> HB_RASTER_PIXEL_BITS;
-      int y0 = ymin >> HB_RASTER_PIXEL_BITS;
-      int x1 = (int) (((int64_t) xmax + HB_RASTER_PIXEL_MASK) >> HB_RASTER_PIXEL_BITS);
-      int y1 = (int) (((int64_t) ymax + HB_RASTER_PIXEL_MASK) >> HB_RASTER_PIXEL_BITS);
+      /* Convert fixed-point → pixels (floor for min, ceil for max), and
+	 oversampled subpixels back to pixels.  Edge coordinates are
+	 saturated to int32 range in emit_segment, so the +MASK ceil step
+	 must be widened to avoid signed overflow. */
+      int x_pad, y_pad;
+      hb_raster_draw_padding (draw, x_pad, y_pad);
+      int64_t xs = (int64_t) draw->x_oversample, ys = (int64_t) draw->y_oversample;
+      int x0 = (int) div_floor (xmin >> HB_RASTER_PIXEL_BITS, xs) - x_pad;
+      int y0 = (int) div_floor (ymin >> HB_RASTER_PIXEL_BITS, ys) - y_pad;
+      int x1 = (int) (div_ceil (((int64_t) xmax + HB_RASTER_PIXEL_MASK) >> HB_RASTER_PIXEL_BITS, xs) + x_pad);
+      int y1 = (int) (div_ceil (((int64_t) ymax + HB_RASTER_PIXEL_MASK) >> HB_RASTER_PIXEL_BITS, ys) + y_pad);
 
       ext.x_origin = x0;
       ext.y_origin = y0;
@@ -1499,7 +3125,7 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
 
   /* ── 2. Compute stride ─────────────────────────────────────────── */
   if (ext.stride == 0)
-    ext.stride = (ext.width + 3u) & ~3u;
+    ext.stride = (ext.width * hb_raster_image_t::bytes_per_pixel (draw->format) + 3u) & ~3u;
 
   /* ── 3. Allocate or reuse image ─────────────────────────────────── */
   /* Reset one-shot state on every exit path. */
@@ -1517,87 +3143,71 @@ hb_raster_draw_render (hb_raster_draw_t *draw)
     if (unlikely (!image)) return nullptr;
   }
 
-  if (unlikely (!image->configure (HB_RASTER_FORMAT_A8, ext)))
+  if (unlikely (!image->configure (draw->format, ext)))
     return nullptr;
   image->clear ();
 
-  /* ── 4. Bucket edges by starting row and rasterize scanlines ──── */
-  if (draw->edges.length && ext.width && ext.height)
+  if (hb_raster_draw_is_distance_field (draw))
   {
-    if (unlikely (!draw->row_area.resize_dirty (ext.width) ||
-		  !draw->row_cover.resize_dirty (ext.width)))
+    if (unlikely (!render_distance_field (draw, image.get (), image->extents)))
       return nullptr;
-    hb_memset (draw->row_area.arrayZ,  0, ext.width * sizeof (int32_t));
-    hb_memset (draw->row_cover.arrayZ, 0, ext.width * sizeof (int16_t));
-
-    /* Bucket edges by their starting pixel row.
-       Only grow the outer vector; clear inner vectors without freeing. */
-    unsigned old_buckets = draw->edge_buckets.length;
-    if (ext.height > old_buckets)
-    {
-      if (unlikely (!draw->edge_buckets.resize (ext.height)))
-	return nullptr;
-    }
-    for (unsigned i = 0; i < hb_min (ext.height, old_buckets); i++)
-      draw->edge_buckets.arrayZ[i].clear ();
-    /* New buckets (if any) are already empty from resize's zero-init. */
-
-    for (unsigned i = 0; i < draw->edges.length; i++)
-    {
-      int row = (draw->edges.arrayZ[i].yL >> HB_RASTER_PIXEL_BITS) - ext.y_origin;
-      if (row < 0) row = 0;
-      if ((unsigned) row >= ext.height) continue;
-      draw->edge_buckets.arrayZ[row].push (i);
-    }
-
-    /* Scanline loop with active edge list. */
-    draw->active_edges.clear ();
-
-    for (unsigned row = 0; row < ext.height; row++)
-    {
-      int64_t y_top_64 = ((int64_t) ext.y_origin + (int64_t) row) * HB_RASTER_ONE_PIXEL;
-      int32_t y_top = (int32_t) hb_clamp (y_top_64, (int64_t) INT32_MIN, (int64_t) INT32_MAX);
+    return image.release ();
+  }
 
-      /* Add new edges from this row's bucket. */
-      draw->active_edges.extend (draw->edge_buckets.arrayZ[row]);
+  if (draw->format == HB_RASTER_FORMAT_LCD_BGRA32)
+  {
+    if (unlikely (!render_lcd (draw, image.get (), image->extents)))
+      return nullptr;
+    return image.release ();
+  }
 
-      /* Process active edges and compact live ones in one linear pass. */
-      unsigned x_min = ext.width, x_max = 0;
-      unsigned write = 0;
-      unsigned active_len = draw->active_edges.length;
-      for (unsigned j = 0; j < active_len; j++)
-      {
-	unsigned edge_idx = draw->active_edges.arrayZ[j];
-	const auto &e = draw->edges.arrayZ[edge_idx];
-	if (e.yH <= y_top)
-	  continue;
+  /* ── 4. Bucket edges by starting row and rasterize scanlines ──── */
+  if (unlikely (!sweep_coverage (draw, image.get (), ext)))
+    return nullptr;
 
-	edge_sweep_row (draw->row_area.arrayZ, draw->row_cover.arrayZ,
-			ext.width, ext.x_origin, y_top, e, x_min, x_max);
-	draw->active_edges.arrayZ[write++] = edge_idx;
-      }
-      draw->active_edges.resize (write);
+  return image.release ();
+}
 
-      if (x_min <= x_max)
-      {
-	int32_t cover_accum = sweep_row_to_alpha (image->buffer.arrayZ + row * ext.stride,
-						   draw->row_area.arrayZ, draw->row_cover.arrayZ,
-						   x_min, x_max);
+/**
+ * hb_raster_draw_render_into:
+ * @draw: a rasterizer
+ * @image: the image to draw into
+ *
+ * Rasterizes the accumulated outline geometry straight into @image,
+ * compositing it over the pixels already there, instead of into a new
+ * image.  Together with hb_raster_image_configure_for_data(), this
+ * draws glyphs into caller memory, such as a mapped framebuffer or
+ * texture upload buffer, without copying them there afterwards.
+ *
+ * Only the part of the geometry within @image's extents is drawn; set
+ * the same extents with hb_raster_draw_set_extents() before drawing to
+ * skip flattening curves outside them.  Coverage is composited with
+ * SRC_OVER, each subpixel on its own for @HB_RASTER_FORMAT_LCD_BGRA32.
+ * @image must have the format set with hb_raster_draw_set_format();
+ * distance fields are not supported.
+ *
+ * After rendering, the accumulated edges are cleared, as with
+ * hb_raster_draw_render().
+ *
+ * Return value: `true` on success, `false` if the formats don't match,
+ * the format is a distance field, or on allocation failure, in which
+ * case @image may have been partially drawn into
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_draw_render_into (hb_raster_draw_t  *draw,
+			    hb_raster_image_t *image)
+{
+  /* Reset one-shot state on every exit path. */
+  HB_SCOPE_GUARD (hb_raster_draw_clear (draw));
 
-	/* If cover doesn't cancel, memset the constant-alpha tail. */
-	if (cover_accum != 0)
-	{
-	  int32_t alpha = cover_accum * (2 * HB_RASTER_ONE_PIXEL);
-	  alpha = alpha < 0 ? -alpha : alpha;
-	  if (alpha > HB_RASTER_FULL_COVERAGE) alpha = HB_RASTER_FULL_COVERAGE;
-	  uint8_t byte = (uint8_t) (((unsigned) alpha * 255 + HB_RASTER_FULL_COVERAGE / 2) >> (2 * HB_RASTER_PIXEL_BITS + 1));
+  if (unlikely (image->format != draw->format ||
+		hb_raster_draw_is_distance_field (draw)))
+    return false;
 
-	  uint8_t *row_buf = image->buffer.arrayZ + row * ext.stride;
-	  hb_memset (row_buf + x_max + 1, byte, ext.width - 1 - x_max);
-	}
-      }
-    }
-  }
+  if (draw->format == HB_RASTER_FORMAT_LCD_BGRA32)
+    return render_lcd (draw, image, image->extents, true);
 
-  return image.release ();
+  return sweep_coverage (draw, image, image->extents, true);
 }
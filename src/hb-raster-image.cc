@@ -27,6 +27,7 @@
 #include "hb.hh"
 
 #include "hb-raster-image.hh"
+#include "hb-raster-composite.hh"
 
 #include <math.h>
 
@@ -195,314 +196,14 @@ hb_raster_png_write_blob_fini (hb_raster_png_write_blob_t *w)
 #endif
 
 
-/*
- * Image compositing
- */
-
-/* Unpack premultiplied pixel to float RGBA [0,1]. */
-static inline void
-unpack_to_float (uint32_t px, float &r, float &g, float &b, float &a)
-{
-  b = (px & 0xFF) / 255.f;
-  g = ((px >> 8) & 0xFF) / 255.f;
-  r = ((px >> 16) & 0xFF) / 255.f;
-  a = (px >> 24) / 255.f;
-}
-
-/* Pack float RGBA [0,1] premultiplied back to uint32_t. */
-static inline uint32_t
-pack_from_float (float r, float g, float b, float a)
-{
-  return hb_raster_pack_pixel ((uint8_t) (hb_clamp (b, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (g, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (r, 0.f, 1.f) * 255.f + 0.5f),
-			       (uint8_t) (hb_clamp (a, 0.f, 1.f) * 255.f + 0.5f));
-}
-
-/* Separable blend mode functions: operate on unpremultiplied [0,1] channels. */
-static inline float
-blend_multiply (float sc, float dc) { return sc * dc; }
-static inline float
-blend_screen (float sc, float dc) { return sc + dc - sc * dc; }
-static inline float
-blend_overlay (float sc, float dc)
-{ return dc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
-static inline float
-blend_darken (float sc, float dc) { return hb_min (sc, dc); }
-static inline float
-blend_lighten (float sc, float dc) { return hb_max (sc, dc); }
-static inline float
-blend_color_dodge (float sc, float dc)
-{
-  if (dc <= 0.f) return 0.f;
-  if (sc >= 1.f) return 1.f;
-  return hb_min (1.f, dc / (1.f - sc));
-}
-static inline float
-blend_color_burn (float sc, float dc)
-{
-  if (dc >= 1.f) return 1.f;
-  if (sc <= 0.f) return 0.f;
-  return 1.f - hb_min (1.f, (1.f - dc) / sc);
-}
-static inline float
-blend_hard_light (float sc, float dc)
-{ return sc <= 0.5f ? 2.f * sc * dc : 1.f - 2.f * (1.f - sc) * (1.f - dc); }
-static inline float
-blend_soft_light (float sc, float dc)
-{
-  if (sc <= 0.5f)
-    return dc - (1.f - 2.f * sc) * dc * (1.f - dc);
-  float d = (dc <= 0.25f) ? ((16.f * dc - 12.f) * dc + 4.f) * dc
-			   : sqrtf (dc);
-  return dc + (2.f * sc - 1.f) * (d - dc);
-}
-static inline float
-blend_difference (float sc, float dc) { return fabsf (sc - dc); }
-static inline float
-blend_exclusion (float sc, float dc) { return sc + dc - 2.f * sc * dc; }
-
-/* Apply a separable blend mode per-pixel.
- * Both src and dst are premultiplied BGRA32. */
-static inline uint32_t
-apply_separable_blend (uint32_t src, uint32_t dst,
-		       float (*blend_fn)(float, float))
-{
-  float sr, sg, sb, sa;
-  float dr, dg, db, da;
-  unpack_to_float (src, sr, sg, sb, sa);
-  unpack_to_float (dst, dr, dg, db, da);
-
-  float usr = sa > 0.f ? sr / sa : 0.f;
-  float usg = sa > 0.f ? sg / sa : 0.f;
-  float usb = sa > 0.f ? sb / sa : 0.f;
-  float udr = da > 0.f ? dr / da : 0.f;
-  float udg = da > 0.f ? dg / da : 0.f;
-  float udb = da > 0.f ? db / da : 0.f;
-
-  float br = blend_fn (usr, udr);
-  float bg = blend_fn (usg, udg);
-  float bb = blend_fn (usb, udb);
-
-  float ra = sa + da - sa * da;
-  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
-  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
-  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
-
-  return pack_from_float (rr, rg, rb, ra);
-}
-
-/* HSL helpers */
-static inline float
-hsl_luminosity (float r, float g, float b)
-{ return 0.299f * r + 0.587f * g + 0.114f * b; }
-
-static inline float
-hsl_saturation (float r, float g, float b)
-{ return hb_max (hb_max (r, g), b) - hb_min (hb_min (r, g), b); }
-
-static inline void
-hsl_clip_color (float &r, float &g, float &b)
-{
-  float l = hsl_luminosity (r, g, b);
-  float mn = hb_min (hb_min (r, g), b);
-  float mx = hb_max (hb_max (r, g), b);
-  if (mn < 0.f)
-  {
-    float d = l - mn;
-    if (d > 0.f) { r = l + (r - l) * l / d; g = l + (g - l) * l / d; b = l + (b - l) * l / d; }
-  }
-  if (mx > 1.f)
-  {
-    float d = mx - l;
-    if (d > 0.f) { r = l + (r - l) * (1.f - l) / d; g = l + (g - l) * (1.f - l) / d; b = l + (b - l) * (1.f - l) / d; }
-  }
-}
-
-static inline void
-hsl_set_luminosity (float &r, float &g, float &b, float l)
-{
-  float d = l - hsl_luminosity (r, g, b);
-  r += d; g += d; b += d;
-  hsl_clip_color (r, g, b);
-}
-
-static inline void
-hsl_set_saturation_inner (float &mn, float &mid, float &mx, float s)
-{
-  if (mx > mn)
-  {
-    mid = (mid - mn) * s / (mx - mn);
-    mx = s;
-  }
-  else
-    mid = mx = 0.f;
-  mn = 0.f;
-}
-
-static inline void
-hsl_set_saturation (float &r, float &g, float &b, float s)
-{
-  if (r <= g)
-  {
-    if (g <= b)      hsl_set_saturation_inner (r, g, b, s);
-    else if (r <= b) hsl_set_saturation_inner (r, b, g, s);
-    else             hsl_set_saturation_inner (b, r, g, s);
-  }
-  else
-  {
-    if (r <= b)      hsl_set_saturation_inner (g, r, b, s);
-    else if (g <= b) hsl_set_saturation_inner (g, b, r, s);
-    else             hsl_set_saturation_inner (b, g, r, s);
-  }
-}
-
-static inline uint32_t
-apply_hsl_blend (uint32_t src, uint32_t dst,
-		 hb_paint_composite_mode_t mode)
-{
-  float sr, sg, sb, sa;
-  float dr, dg, db, da;
-  unpack_to_float (src, sr, sg, sb, sa);
-  unpack_to_float (dst, dr, dg, db, da);
-
-  float usr = sa > 0.f ? sr / sa : 0.f;
-  float usg = sa > 0.f ? sg / sa : 0.f;
-  float usb = sa > 0.f ? sb / sa : 0.f;
-  float udr = da > 0.f ? dr / da : 0.f;
-  float udg = da > 0.f ? dg / da : 0.f;
-  float udb = da > 0.f ? db / da : 0.f;
-
-  float br = udr, bg = udg, bb = udb;
-
-  if (mode == HB_PAINT_COMPOSITE_MODE_HSL_HUE)
-  {
-    br = usr; bg = usg; bb = usb;
-    hsl_set_saturation (br, bg, bb, hsl_saturation (udr, udg, udb));
-    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
-  }
-  else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_SATURATION)
-  {
-    br = udr; bg = udg; bb = udb;
-    hsl_set_saturation (br, bg, bb, hsl_saturation (usr, usg, usb));
-    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
-  }
-  else if (mode == HB_PAINT_COMPOSITE_MODE_HSL_COLOR)
-  {
-    br = usr; bg = usg; bb = usb;
-    hsl_set_luminosity (br, bg, bb, hsl_luminosity (udr, udg, udb));
-  }
-  else /* HSL_LUMINOSITY */
-  {
-    br = udr; bg = udg; bb = udb;
-    hsl_set_luminosity (br, bg, bb, hsl_luminosity (usr, usg, usb));
-  }
-
-  float ra = sa + da - sa * da;
-  float rr = sa * da * br + sa * (1.f - da) * usr + (1.f - sa) * da * udr;
-  float rg = sa * da * bg + sa * (1.f - da) * usg + (1.f - sa) * da * udg;
-  float rb = sa * da * bb + sa * (1.f - da) * usb + (1.f - sa) * da * udb;
-
-  return pack_from_float (rr, rg, rb, ra);
-}
-
-/* Composite per-pixel with full blend mode support. */
-static inline uint32_t
-composite_pixel (uint32_t src, uint32_t dst,
-		 hb_paint_composite_mode_t mode)
-{
-  uint8_t sa = (uint8_t) (src >> 24);
-  uint8_t da = (uint8_t) (dst >> 24);
-
-  switch (mode)
-  {
-  case HB_PAINT_COMPOSITE_MODE_CLEAR:
-    return 0;
-  case HB_PAINT_COMPOSITE_MODE_SRC:
-    return src;
-  case HB_PAINT_COMPOSITE_MODE_DEST:
-    return dst;
-  case HB_PAINT_COMPOSITE_MODE_SRC_OVER:
-    return hb_raster_src_over (src, dst);
-  case HB_PAINT_COMPOSITE_MODE_DEST_OVER:
-    return hb_raster_src_over (dst, src);
-  case HB_PAINT_COMPOSITE_MODE_SRC_IN:
-    return hb_raster_alpha_mul (src, da);
-  case HB_PAINT_COMPOSITE_MODE_DEST_IN:
-    return hb_raster_alpha_mul (dst, sa);
-  case HB_PAINT_COMPOSITE_MODE_SRC_OUT:
-    return hb_raster_alpha_mul (src, 255 - da);
-  case HB_PAINT_COMPOSITE_MODE_DEST_OUT:
-    return hb_raster_alpha_mul (dst, 255 - sa);
-  case HB_PAINT_COMPOSITE_MODE_SRC_ATOP:
-  {
-    /* Fa=Da, Fb=1-Sa */
-    uint32_t a = hb_raster_alpha_mul (src, da);
-    uint32_t b = hb_raster_alpha_mul (dst, 255 - sa);
-    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
-    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
-    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
-    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
-    return hb_raster_pack_pixel (rb, rg, rr, ra);
-  }
-  case HB_PAINT_COMPOSITE_MODE_DEST_ATOP:
-  {
-    uint32_t a = hb_raster_alpha_mul (dst, sa);
-    uint32_t b = hb_raster_alpha_mul (src, 255 - da);
-    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
-    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
-    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
-    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
-    return hb_raster_pack_pixel (rb, rg, rr, ra);
-  }
-  case HB_PAINT_COMPOSITE_MODE_XOR:
-  {
-    uint32_t a = hb_raster_alpha_mul (src, 255 - da);
-    uint32_t b = hb_raster_alpha_mul (dst, 255 - sa);
-    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (a & 0xFF) + (b & 0xFF));
-    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((a >> 8) & 0xFF) + ((b >> 8) & 0xFF));
-    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((a >> 16) & 0xFF) + ((b >> 16) & 0xFF));
-    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (a >> 24) + (b >> 24));
-    return hb_raster_pack_pixel (rb, rg, rr, ra);
-  }
-  case HB_PAINT_COMPOSITE_MODE_PLUS:
-  {
-    uint8_t rb = (uint8_t) hb_min (255u, (unsigned) (src & 0xFF) + (dst & 0xFF));
-    uint8_t rg = (uint8_t) hb_min (255u, (unsigned) ((src >> 8) & 0xFF) + ((dst >> 8) & 0xFF));
-    uint8_t rr = (uint8_t) hb_min (255u, (unsigned) ((src >> 16) & 0xFF) + ((dst >> 16) & 0xFF));
-    uint8_t ra = (uint8_t) hb_min (255u, (unsigned) (src >> 24) + (dst >> 24));
-    return hb_raster_pack_pixel (rb, rg, rr, ra);
-  }
-
-  case HB_PAINT_COMPOSITE_MODE_MULTIPLY:  return apply_separable_blend (src, dst, blend_multiply);
-  case HB_PAINT_COMPOSITE_MODE_SCREEN:    return apply_separable_blend (src, dst, blend_screen);
-  case HB_PAINT_COMPOSITE_MODE_OVERLAY:   return apply_separable_blend (src, dst, blend_overlay);
-  case HB_PAINT_COMPOSITE_MODE_DARKEN:    return apply_separable_blend (src, dst, blend_darken);
-  case HB_PAINT_COMPOSITE_MODE_LIGHTEN:   return apply_separable_blend (src, dst, blend_lighten);
-  case HB_PAINT_COMPOSITE_MODE_COLOR_DODGE: return apply_separable_blend (src, dst, blend_color_dodge);
-  case HB_PAINT_COMPOSITE_MODE_COLOR_BURN:  return apply_separable_blend (src, dst, blend_color_burn);
-  case HB_PAINT_COMPOSITE_MODE_HARD_LIGHT:  return apply_separable_blend (src, dst, blend_hard_light);
-  case HB_PAINT_COMPOSITE_MODE_SOFT_LIGHT:  return apply_separable_blend (src, dst, blend_soft_light);
-  case HB_PAINT_COMPOSITE_MODE_DIFFERENCE:  return apply_separable_blend (src, dst, blend_difference);
-  case HB_PAINT_COMPOSITE_MODE_EXCLUSION:   return apply_separable_blend (src, dst, blend_exclusion);
-
-  case HB_PAINT_COMPOSITE_MODE_HSL_HUE:
-  case HB_PAINT_COMPOSITE_MODE_HSL_SATURATION:
-  case HB_PAINT_COMPOSITE_MODE_HSL_COLOR:
-  case HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY:
-    return apply_hsl_blend (src, dst, mode);
-
-  default:
-    return hb_raster_src_over (src, dst);
-  }
-}
-
 /* hb_raster_image_t */
 
 unsigned
 hb_raster_image_t::bytes_per_pixel (hb_raster_format_t format)
 {
-  return format == HB_RASTER_FORMAT_BGRA32 ? 4u : 1u;
+  return format == HB_RASTER_FORMAT_BGRA32 ||
+	 format == HB_RASTER_FORMAT_MSDF_BGRA32 ||
+	 format == HB_RASTER_FORMAT_LCD_BGRA32 ? 4u : 1u;
 }
 
 bool
@@ -510,7 +211,10 @@ hb_raster_image_t::configure (hb_raster_format_t format,
 			      hb_raster_extents_t extents)
 {
   if (format != HB_RASTER_FORMAT_A8 &&
-      format != HB_RASTER_FORMAT_BGRA32)
+      format != HB_RASTER_FORMAT_BGRA32 &&
+      format != HB_RASTER_FORMAT_SDF_A8 &&
+      format != HB_RASTER_FORMAT_MSDF_BGRA32 &&
+      format != HB_RASTER_FORMAT_LCD_BGRA32)
     format = HB_RASTER_FORMAT_A8;
 
   unsigned bpp = bytes_per_pixel (format);
@@ -530,6 +234,40 @@ hb_raster_image_t::configure (hb_raster_format_t format,
   if (unlikely (!buffer.resize_dirty (buf_size)))
     return false;
 
+  this->data = nullptr;
+  this->format = format;
+  this->extents = extents;
+  return true;
+}
+
+bool
+hb_raster_image_t::configure_for_data (hb_raster_format_t format,
+				       hb_raster_extents_t extents,
+				       uint8_t *data)
+{
+  if (format != HB_RASTER_FORMAT_A8 &&
+      format != HB_RASTER_FORMAT_BGRA32 &&
+      format != HB_RASTER_FORMAT_SDF_A8 &&
+      format != HB_RASTER_FORMAT_MSDF_BGRA32 &&
+      format != HB_RASTER_FORMAT_LCD_BGRA32)
+    return false;
+
+  unsigned bpp = bytes_per_pixel (format);
+  if (extents.width > UINT_MAX / bpp)
+    return false;
+
+  unsigned min_stride = extents.width * bpp;
+  if (extents.stride == 0)
+    extents.stride = min_stride;
+  if (extents.stride < min_stride)
+    return false;
+
+  if (extents.height && extents.stride > (size_t) -1 / extents.height)
+    return false;
+  if (extents.width && extents.height && !data)
+    return false;
+
+  this->data = data;
   this->format = format;
   this->extents = extents;
   return true;
@@ -694,6 +432,7 @@ hb_raster_image_t::deserialize_from_png (hb_blob_t *blob)
   }
 
   hb_swap (buffer, decoded.buffer);
+  data = nullptr;
   hb_swap (this->extents, decoded.extents);
   hb_swap (format, decoded.format);
   hb_raster_png_read_blob_fini (reader);
@@ -782,7 +521,7 @@ hb_raster_image_t::serialize_to_png_or_fail () const
   for (unsigned y = 0; y < extents.height; y++)
   {
     uint8_t *dst = writer->rgba + (size_t) y * rowbytes;
-    const uint8_t *src = buffer.arrayZ + (size_t) (extents.height - 1 - y) * extents.stride;
+    const uint8_t *src = pixels () + (size_t) (extents.height - 1 - y) * extents.stride;
 
     for (unsigned x = 0; x < extents.width; x++)
     {
@@ -836,6 +575,15 @@ hb_raster_image_t::serialize_to_png_or_fail () const
 void
 hb_raster_image_t::clear ()
 {
+  if (data)
+  {
+    /* The caller's rows may be parts of wider ones; leave the rest. */
+    unsigned row_size = extents.width * bytes_per_pixel (format);
+    for (unsigned y = 0; y < extents.height; y++)
+      hb_memset (data + (size_t) y * extents.stride, 0, row_size);
+    return;
+  }
+
   size_t buf_size = (size_t) extents.stride * extents.height;
   hb_memset (buffer.arrayZ, 0, buf_size);
 }
@@ -843,7 +591,7 @@ hb_raster_image_t::clear ()
 const uint8_t *
 hb_raster_image_t::get_buffer () const
 {
-  return buffer.arrayZ;
+  return pixels ();
 }
 
 void
@@ -852,15 +600,11 @@ hb_raster_image_t::composite_from (const hb_raster_image_t *src,
 {
   unsigned w = extents.width;
   unsigned h = extents.height;
-  unsigned stride = extents.stride;
 
   for (unsigned y = 0; y < h; y++)
-  {
-    hb_packed_t<uint32_t> *dp = (hb_packed_t<uint32_t> *) (buffer.arrayZ + y * stride);
-    const hb_packed_t<uint32_t> *sp = (const hb_packed_t<uint32_t> *) (src->buffer.arrayZ + y * stride);
-    for (unsigned x = 0; x < w; x++)
-      dp[x] = hb_packed_t<uint32_t> (composite_pixel ((uint32_t) sp[x], (uint32_t) dp[x], mode));
-  }
+    hb_raster_composite_span (pixels () + (size_t) y * extents.stride,
+			      src->pixels () + (size_t) y * src->extents.stride,
+			      w, mode);
 }
 
 /* Composite src image onto dst image.
@@ -1000,12 +744,56 @@ hb_raster_image_configure (hb_raster_image_t         *image,
   if (unlikely (!extents))
   {
     image->extents = {};
+    image->data = nullptr;
     image->buffer.resize_exact (0);
     return true;
   }
   return image->configure (format, *extents);
 }
 
+/**
+ * hb_raster_image_configure_for_data:
+ * @image: a raster image
+ * @format: the pixel format
+ * @extents: extents of @data
+ * @data: (array): caller-owned pixel memory
+ *
+ * Configures @image over pixel memory owned by the caller, such as a
+ * mapped framebuffer or texture upload buffer, instead of its own.
+ * Nothing is copied: hb_raster_image_get_buffer() then returns @data,
+ * and hb_raster_draw_render_into() draws straight into it.
+ *
+ * @extents give the pixel rectangle @data covers, in the same pixel
+ * space as the rasterizer's output, and the distance in bytes between
+ * its rows.  Rows are bottom-to-top, as everywhere else in images: the
+ * first row at @data is the one at @extents.y_origin.  A stride of zero
+ * means rows are packed.  @data must hold @extents.height rows of
+ * @extents.stride bytes, the last one only needing its
+ * @extents.width pixels, and outlive its use by @image.  A stride
+ * larger than the row lets @data be a rectangle of a bigger surface;
+ * pixels outside the rectangle are never touched.
+ *
+ * @image does not free @data.  A later hb_raster_image_configure(), or
+ * recycling @image for a render, switches it back to memory of its
+ * own.
+ *
+ * Return value: `true` if configuration succeeds, `false` if @format
+ * is unknown, @extents is `NULL`, the stride is too small for the
+ * width, or @data is `NULL` for a non-empty rectangle
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_raster_image_configure_for_data (hb_raster_image_t         *image,
+				    hb_raster_format_t         format,
+				    const hb_raster_extents_t *extents,
+				    uint8_t                   *data)
+{
+  if (unlikely (!extents))
+    return false;
+  return image->configure_for_data (format, *extents, data);
+}
+
 /**
  * hb_raster_image_clear:
  * @image: a raster image
@@ -40,11 +40,16 @@ struct hb_raster_image_t
   hb_object_header_t  header;
 
   hb_vector_t<uint8_t> buffer;
+  uint8_t             *data        = nullptr; /* caller's pixels, instead of buffer */
   hb_raster_extents_t  extents     = {};
   hb_raster_format_t   format      = HB_RASTER_FORMAT_A8;
 
+  uint8_t *pixels () const { return data ? data : buffer.arrayZ; }
+
   HB_INTERNAL static unsigned bytes_per_pixel (hb_raster_format_t format);
   HB_INTERNAL bool configure (hb_raster_format_t format, hb_raster_extents_t extents);
+  HB_INTERNAL bool configure_for_data (hb_raster_format_t format, hb_raster_extents_t extents,
+				       uint8_t *data);
   HB_INTERNAL bool deserialize_from_png (hb_blob_t *png);
   HB_INTERNAL hb_blob_t *serialize_to_png_or_fail () const;
   HB_INTERNAL void clear ();
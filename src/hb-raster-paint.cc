@@ -27,6 +27,7 @@
 #include "hb.hh"
 
 #include "hb-raster-paint.hh"
+#include "hb-raster-composite.hh"
 #include "hb-machinery.hh"
 #include "hb-paint.hh"
 
@@ -1248,6 +1249,316 @@ lookup_gradient_lut (const uint32_t *lut,
   return lut[idx];
 }
 
+/*
+ * Gradient spans
+ *
+ * Gradients are filled a row at a time, in spans of up to
+ * GRADIENT_SPAN_LENGTH pixels: first the gradient position of each
+ * pixel, then its color, then compositing.  With SIMD, positions and
+ * LUT indices are computed a vector at a time, over whole vectors.
+ */
+
+#define GRADIENT_SPAN_LENGTH 64
+
+#ifdef HB_RASTER_COMPOSITE_SIMD
+#define GRADIENT_SPAN_STEP HB_RASTER_COMPOSITE_WIDTH
+
+/* atan2f (y, x) brought to [0, 2π), as the sweep gradient wants it;
+ * to within 3e-6 radians. */
+static HB_ALWAYS_INLINE hb_raster_vf_t
+gradient_vatan2 (hb_raster_vf_t y, hb_raster_vf_t x)
+{
+  hb_raster_vf_t ax = vabs (x), ay = vabs (y);
+  hb_raster_vf_t mn = vmin (ax, ay), mx = vmax (ax, ay);
+  hb_raster_vf_t a = vsel (mx > vf (0.f), mn / mx, vf (0.f));
+  hb_raster_vf_t s = a * a;
+  hb_raster_vf_t r = vf (-0.01172120f);
+  r = r * s + vf (0.05265332f);
+  r = r * s + vf (-0.11643287f);
+  r = r * s + vf (0.19354346f);
+  r = r * s + vf (-0.33262347f);
+  r = r * s + vf (0.99997726f);
+  r = r * a;
+  r = vsel (ay > ax, vf (HB_PI / 2) - r, r);
+  r = vsel (x < vf (0.f), vf (HB_PI) - r, r);
+  return vsel (y < vf (0.f), vf (HB_2_PI) - r, r);
+}
+#else
+#define GRADIENT_SPAN_STEP 1
+#endif
+
+/* Each gradient fills @t with the gradient positions of @n pixels, the
+ * first at (@gx, @gy) in glyph space and each next one (@dx, @dy)
+ * further; it clears @cover of the pixels it does not paint.  @n is a
+ * multiple of GRADIENT_SPAN_STEP. */
+
+struct hb_raster_linear_gradient_t
+{
+  static constexpr bool may_skip = false;
+
+  float gx0, gy0, dx, dy, inv_denom;
+
+  void positions (float gx, float gy, float step_x, float step_y,
+		  unsigned n, float *t, uint8_t *cover HB_UNUSED) const
+  {
+    /* Projection onto the axis is affine; step it along the span. */
+    float t0 = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
+    float dt = (step_x * dx + step_y * dy) * inv_denom;
+#ifdef HB_RASTER_COMPOSITE_SIMD
+    hb_raster_vf_t k = vf_ramp ();
+    for (unsigned i = 0; i < n; i += GRADIENT_SPAN_STEP)
+    {
+      vf_store (t + i, vf (t0) + k * vf (dt));
+      k = k + vf ((float) GRADIENT_SPAN_STEP);
+    }
+#else
+    for (unsigned i = 0; i < n; i++)
+      t[i] = t0 + (float) i * dt;
+#endif
+  }
+};
+
+struct hb_raster_radial_gradient_t
+{
+  static constexpr bool may_skip = true;
+
+  /* Precomputed quadratic coefficients for radial gradient:
+   * |p - c0 - t*(c1-c0)|^2 = (r0 + t*(r1-r0))^2
+   *
+   * Expanding gives At^2 + Bt + C = 0 where:
+   *   cdx = c1.x - c0.x, cdy = c1.y - c0.y, dr = r1 - r0
+   *   A = cdx^2 + cdy^2 - dr^2
+   *   B = -2*(px-c0.x)*cdx - 2*(py-c0.y)*cdy - 2*r0*dr
+   *   C = (px-c0.x)^2 + (py-c0.y)^2 - r0^2
+   */
+  float cx0, cy0, cr0, cdx, cdy, dr, A;
+
+  void positions (float gx, float gy, float step_x, float step_y,
+		  unsigned n, float *t, uint8_t *cover) const
+  {
+    float dpx0 = gx - cx0, dpy0 = gy - cy0;
+    bool quadratic = fabsf (A) > 1e-10f;
+#ifdef HB_RASTER_COMPOSITE_SIMD
+    hb_raster_vf_t k = vf_ramp ();
+    for (unsigned i = 0; i < n; i += GRADIENT_SPAN_STEP)
+    {
+      hb_raster_vf_t dpx = vf (dpx0) + k * vf (step_x);
+      hb_raster_vf_t dpy = vf (dpy0) + k * vf (step_y);
+      k = k + vf ((float) GRADIENT_SPAN_STEP);
+      hb_raster_vf_t B = vf (-2.f) * (dpx * vf (cdx) + dpy * vf (cdy) + vf (cr0 * dr));
+      hb_raster_vf_t C = dpx * dpx + dpy * dpy - vf (cr0 * cr0);
+
+      hb_raster_vm_t skip;
+      if (quadratic)
+      {
+	hb_raster_vf_t disc = B * B - vf (4.f) * vf (A) * C;
+	skip = disc < vf (0.f);
+	hb_raster_vf_t sq = vsqrt (vmax (disc, vf (0.f)));
+	/* Choose the root that gives a positive radius, preferring the
+	 * larger one (t closer to 1 = outer circle). */
+	hb_raster_vf_t t1 = (vf (0.f) - B + sq) / vf (2.f * A);
+	hb_raster_vf_t t2 = (vf (0.f) - B - sq) / vf (2.f * A);
+	vf_store (t + i, vsel (vf (cr0) + t1 * vf (dr) >= vf (0.f), t1, t2));
+      }
+      else
+      {
+	/* Linear case: Bt + C = 0 */
+	skip = vabs (B) < vf (1e-10f);
+	vf_store (t + i, (vf (0.f) - C) / B);
+      }
+
+      for (unsigned bits = vm_bits (skip); bits; bits &= bits - 1)
+	cover[i + hb_ctz (bits)] = 0;
+    }
+#else
+    for (unsigned i = 0; i < n; i++)
+    {
+      float dpx = dpx0 + (float) i * step_x;
+      float dpy = dpy0 + (float) i * step_y;
+      float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
+      float C = dpx * dpx + dpy * dpy - cr0 * cr0;
+
+      if (quadratic)
+      {
+	float disc = B * B - 4.f * A * C;
+	if (disc < 0.f)
+	{
+	  cover[i] = 0;
+	  continue;
+	}
+	float sq = sqrtf (disc);
+	float t1 = (-B + sq) / (2.f * A);
+	float t2 = (-B - sq) / (2.f * A);
+	t[i] = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
+      }
+      else
+      {
+	if (fabsf (B) < 1e-10f)
+	{
+	  cover[i] = 0;
+	  continue;
+	}
+	t[i] = -C / B;
+      }
+    }
+#endif
+  }
+};
+
+struct hb_raster_sweep_gradient_t
+{
+  static constexpr bool may_skip = false;
+
+  float cx, cy, a0, inv_angle_range;
+
+  void positions (float gx, float gy, float step_x, float step_y,
+		  unsigned n, float *t, uint8_t *cover HB_UNUSED) const
+  {
+    float dx0 = gx - cx, dy0 = gy - cy;
+#ifdef HB_RASTER_COMPOSITE_SIMD
+    hb_raster_vf_t k = vf_ramp ();
+    for (unsigned i = 0; i < n; i += GRADIENT_SPAN_STEP)
+    {
+      hb_raster_vf_t angle = gradient_vatan2 (vf (dy0) + k * vf (step_y),
+					      vf (dx0) + k * vf (step_x));
+      k = k + vf ((float) GRADIENT_SPAN_STEP);
+      vf_store (t + i, (angle - vf (a0)) * vf (inv_angle_range));
+    }
+#else
+    for (unsigned i = 0; i < n; i++)
+    {
+      float angle = atan2f (dy0 + (float) i * step_y, dx0 + (float) i * step_x);
+      if (angle < 0) angle += (float) HB_2_PI;
+      t[i] = (angle - a0) * inv_angle_range;
+    }
+#endif
+  }
+};
+
+/* Colors of @n gradient positions, as lookup_gradient_lut() gives them
+ * from @lut, or evaluate_color_line() from the stops if there is none. */
+static void
+gradient_colors (const uint32_t *lut,
+		 const hb_color_stop_t *stops, unsigned len,
+		 hb_paint_extend_t extend,
+		 const float *t, const uint8_t *cover,
+		 unsigned n, uint32_t *colors)
+{
+  if (!lut)
+  {
+    for (unsigned i = 0; i < n; i++)
+      colors[i] = cover[i] ? evaluate_color_line (stops, len, t[i], extend) : 0;
+    return;
+  }
+
+#ifdef HB_RASTER_COMPOSITE_SIMD
+  uint32_t idx[GRADIENT_SPAN_LENGTH];
+  hb_raster_vf_t zero = vf (0.f), one = vf (1.f);
+  for (unsigned i = 0; i < n; i += GRADIENT_SPAN_STEP)
+  {
+    /* normalize_gradient_t(), exactly. */
+    hb_raster_vf_t u = vf_load (t + i);
+    u = vsel ((u - u) == zero, u, zero);
+    if (extend == HB_PAINT_EXTEND_PAD)
+      u = vmin (vmax (u, zero), one);
+    else if (extend == HB_PAINT_EXTEND_REPEAT)
+    {
+      u = u - vfloor (u);
+      u = vsel (u < zero, u + one, u);
+    }
+    else
+    {
+      u = vabs (u);
+      u = u - vf (2.f) * vfloor (u * vf (.5f));
+      u = vsel (u > one, vf (2.f) - u, u);
+    }
+    u = vmin (vmax (u, zero), one);
+    vf_store_u32 (idx + i, u * vf ((float) (GRADIENT_LUT_SIZE - 1)) + vf (.5f));
+  }
+  for (unsigned i = 0; i < n; i++)
+    colors[i] = lut[idx[i]];
+#else
+  for (unsigned i = 0; i < n; i++)
+    colors[i] = lookup_gradient_lut (lut, t[i], extend);
+#endif
+}
+
+/* Fills the current clip of @surf with @gradient. */
+template <typename gradient_t>
+static void
+hb_raster_paint_gradient (hb_raster_paint_t *c,
+			  hb_raster_image_t *surf,
+			  const hb_color_stop_t *stops, unsigned len,
+			  hb_paint_extend_t extend,
+			  const gradient_t &gradient)
+{
+  const hb_raster_clip_t &clip = c->current_clip ();
+  unsigned clip_w = clip.max_x > clip.min_x ? clip.max_x - clip.min_x : 0;
+  unsigned clip_h = clip.max_y > clip.min_y ? clip.max_y - clip.min_y : 0;
+  if (unlikely (!c->charge_work ((int64_t) clip_w * clip_h)))
+    return;
+  bool use_lut = (uint64_t) clip_w * clip_h >= GRADIENT_LUT_MIN_PIXELS;
+  uint32_t lut[GRADIENT_LUT_SIZE];
+  if (use_lut)
+    build_gradient_lut (stops, len, lut);
+
+  /* Inverse transform: pixel → glyph space */
+  hb_transform_t<> t = c->current_effective_transform ();
+  float det = t.xx * t.yy - t.xy * t.yx;
+  if (fabsf (det) < 1e-10f) return;
+
+  float inv_det = 1.f / det;
+  float inv_xx =  t.yy * inv_det;
+  float inv_xy = -t.xy * inv_det;
+  float inv_yx = -t.yx * inv_det;
+  float inv_yy =  t.xx * inv_det;
+  float inv_x0 = (t.xy * t.y0 - t.yy * t.x0) * inv_det;
+  float inv_y0 = (t.yx * t.x0 - t.xx * t.y0) * inv_det;
+
+  unsigned stride = surf->extents.stride;
+  int ox = surf->extents.x_origin;
+  int oy = surf->extents.y_origin;
+
+  float positions[GRADIENT_SPAN_LENGTH];
+  uint8_t cover[GRADIENT_SPAN_LENGTH];
+  uint32_t colors[GRADIENT_SPAN_LENGTH];
+
+  for (unsigned py = clip.min_y; py < clip.max_y; py++)
+  {
+    uint8_t *row = surf->buffer.arrayZ + py * stride;
+    const uint8_t *clip_row = clip.is_rect ? nullptr : clip.alpha.arrayZ + py * clip.stride;
+    float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
+    float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
+
+    for (unsigned px = clip.min_x; px < clip.max_x; px += GRADIENT_SPAN_LENGTH)
+    {
+      unsigned n = hb_min (clip.max_x - px, (unsigned) GRADIENT_SPAN_LENGTH);
+      if (clip_row)
+      {
+	hb_memcpy (cover, clip_row + px, n);
+	unsigned i = 0;
+	while (i < n && !cover[i]) i++;
+	if (i == n) continue;
+      }
+      else
+	memset (cover, 255, n);
+
+      float k = (float) (px - clip.min_x);
+      unsigned n_step = (n + GRADIENT_SPAN_STEP - 1) / GRADIENT_SPAN_STEP * GRADIENT_SPAN_STEP;
+      gradient.positions (gx + k * inv_xx, gy + k * inv_yx, inv_xx, inv_yx,
+			  n_step, positions, cover);
+      gradient_colors (use_lut ? lut : nullptr, stops, len, extend,
+		       positions, cover, use_lut ? n_step : n, colors);
+
+      if (clip_row || gradient_t::may_skip)
+	hb_raster_composite_span_mask (row + 4 * px, (const uint8_t *) colors, cover, n);
+      else
+	hb_raster_composite_span (row + 4 * px, (const uint8_t *) colors, n,
+				  HB_PAINT_COMPOSITE_MODE_SRC_OVER);
+    }
+  }
+}
+
 /*
  * Gradient paint callbacks
  */
@@ -1275,133 +1586,28 @@ hb_raster_paint_linear_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
   float mn, mx;
   hb_paint_normalize_color_line (stops, len, &mn, &mx);
 
-  hb_paint_extend_t extend = hb_color_line_get_extend (color_line);
-  const hb_raster_clip_t &clip = c->current_clip ();
-  unsigned clip_w = clip.max_x > clip.min_x ? clip.max_x - clip.min_x : 0;
-  unsigned clip_h = clip.max_y > clip.min_y ? clip.max_y - clip.min_y : 0;
-  if (unlikely (!c->charge_work ((int64_t) clip_w * clip_h)))
-    return;
-  bool use_lut = (uint64_t) clip_w * clip_h >= GRADIENT_LUT_MIN_PIXELS;
-  uint32_t lut[GRADIENT_LUT_SIZE];
-  if (use_lut)
-    build_gradient_lut (stops, len, lut);
-
   /* Reduce 3-point anchor to 2-point gradient axis */
   float lx0, ly0, lx1, ly1;
   hb_paint_reduce_linear_anchors (x0, y0, x1, y1, x2, y2,
 				  &lx0, &ly0, &lx1, &ly1);
 
   /* Apply normalization to endpoints */
-  float gx0 = lx0 + mn * (lx1 - lx0);
-  float gy0 = ly0 + mn * (ly1 - ly0);
+  hb_raster_linear_gradient_t gradient;
+  gradient.gx0 = lx0 + mn * (lx1 - lx0);
+  gradient.gy0 = ly0 + mn * (ly1 - ly0);
   float gx1 = lx0 + mx * (lx1 - lx0);
   float gy1 = ly0 + mx * (ly1 - ly0);
 
-  /* Inverse transform: pixel → glyph space */
-  hb_transform_t<> t = c->current_effective_transform ();
-  float det = t.xx * t.yy - t.xy * t.yx;
-  if (fabsf (det) < 1e-10f) return;
-
-  {
-    float inv_det = 1.f / det;
-    float inv_xx =  t.yy * inv_det;
-    float inv_xy = -t.xy * inv_det;
-    float inv_yx = -t.yx * inv_det;
-    float inv_yy =  t.xx * inv_det;
-    float inv_x0 = (t.xy * t.y0 - t.yy * t.x0) * inv_det;
-    float inv_y0 = (t.yx * t.x0 - t.xx * t.y0) * inv_det;
-
-    /* Gradient direction vector and denominator for projection */
-    float dx = gx1 - gx0, dy = gy1 - gy0;
-    float denom = dx * dx + dy * dy;
-    if (denom < 1e-10f) return;
-    float inv_denom = 1.f / denom;
-
-    unsigned stride = surf->extents.stride;
-    int ox = surf->extents.x_origin;
-    int oy = surf->extents.y_origin;
-
-    if (clip.is_rect)
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = lookup_gradient_lut (lut, proj_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = evaluate_color_line (stops, len, proj_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-    else
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = lookup_gradient_lut (lut, proj_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float proj_t = ((gx - gx0) * dx + (gy - gy0) * dy) * inv_denom;
-	    uint32_t src = evaluate_color_line (stops, len, proj_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-  }
+  /* Gradient direction vector and denominator for projection */
+  gradient.dx = gx1 - gradient.gx0;
+  gradient.dy = gy1 - gradient.gy0;
+  float denom = gradient.dx * gradient.dx + gradient.dy * gradient.dy;
+  if (denom < 1e-10f) return;
+  gradient.inv_denom = 1.f / denom;
 
+  hb_raster_paint_gradient (c, surf, stops, len,
+			    hb_color_line_get_extend (color_line),
+			    gradient);
 }
 
 static void
@@ -1426,259 +1632,23 @@ hb_raster_paint_radial_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
   float mn, mx;
   hb_paint_normalize_color_line (stops, len, &mn, &mx);
 
-  hb_paint_extend_t extend = hb_color_line_get_extend (color_line);
-  const hb_raster_clip_t &clip = c->current_clip ();
-  unsigned clip_w = clip.max_x > clip.min_x ? clip.max_x - clip.min_x : 0;
-  unsigned clip_h = clip.max_y > clip.min_y ? clip.max_y - clip.min_y : 0;
-  if (unlikely (!c->charge_work ((int64_t) clip_w * clip_h)))
-    return;
-  bool use_lut = (uint64_t) clip_w * clip_h >= GRADIENT_LUT_MIN_PIXELS;
-  uint32_t lut[GRADIENT_LUT_SIZE];
-  if (use_lut)
-    build_gradient_lut (stops, len, lut);
-
   /* Apply normalization to circle parameters */
-  float cx0 = x0 + mn * (x1 - x0);
-  float cy0 = y0 + mn * (y1 - y0);
-  float cr0 = r0 + mn * (r1 - r0);
+  hb_raster_radial_gradient_t gradient;
+  gradient.cx0 = x0 + mn * (x1 - x0);
+  gradient.cy0 = y0 + mn * (y1 - y0);
+  gradient.cr0 = r0 + mn * (r1 - r0);
   float cx1 = x0 + mx * (x1 - x0);
   float cy1 = y0 + mx * (y1 - y0);
   float cr1 = r0 + mx * (r1 - r0);
 
-  /* Inverse transform */
-  hb_transform_t<> t = c->current_effective_transform ();
-  float det = t.xx * t.yy - t.xy * t.yx;
-  if (fabsf (det) < 1e-10f) return;
-
-  {
-    float inv_det = 1.f / det;
-    float inv_xx =  t.yy * inv_det;
-    float inv_xy = -t.xy * inv_det;
-    float inv_yx = -t.yx * inv_det;
-    float inv_yy =  t.xx * inv_det;
-    float inv_x0 = (t.xy * t.y0 - t.yy * t.x0) * inv_det;
-    float inv_y0 = (t.yx * t.x0 - t.xx * t.y0) * inv_det;
-
-    /* Precompute quadratic coefficients for radial gradient:
-     * |p - c0 - t*(c1-c0)|^2 = (r0 + t*(r1-r0))^2
-     *
-     * Expanding gives At^2 + Bt + C = 0 where:
-     *   cdx = c1.x - c0.x, cdy = c1.y - c0.y, dr = r1 - r0
-     *   A = cdx^2 + cdy^2 - dr^2
-     *   B = -2*(px-c0.x)*cdx - 2*(py-c0.y)*cdy - 2*r0*dr
-     *   C = (px-c0.x)^2 + (py-c0.y)^2 - r0^2
-     */
-    float cdx = cx1 - cx0, cdy = cy1 - cy0;
-    float dr = cr1 - cr0;
-    float A = cdx * cdx + cdy * cdy - dr * dr;
-
-    unsigned stride = surf->extents.stride;
-    int ox = surf->extents.x_origin;
-    int oy = surf->extents.y_origin;
-
-    if (clip.is_rect)
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      /* Pick the larger root (t closer to 1 = outer circle) */
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      /* Choose the root that gives a positive radius */
-	      if (cr0 + t1 * dr >= 0.f)
-		grad_t = t1;
-	      else
-		grad_t = t2;
-	    }
-	    else
-	    {
-	      /* Linear case: Bt + C = 0 */
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
-	    }
-
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      grad_t = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
-	    }
-	    else
-	    {
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
-	    }
-
-	    uint32_t src = evaluate_color_line (stops, len, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-    else
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      grad_t = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
-	    }
-	    else
-	    {
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
-	    }
-
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float dpx = gx - cx0, dpy = gy - cy0;
-	    float B = -2.f * (dpx * cdx + dpy * cdy + cr0 * dr);
-	    float C = dpx * dpx + dpy * dpy - cr0 * cr0;
-
-	    float grad_t;
-	    if (fabsf (A) > 1e-10f)
-	    {
-	      float disc = B * B - 4.f * A * C;
-	      if (disc < 0.f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      float sq = sqrtf (disc);
-	      float t1 = (-B + sq) / (2.f * A);
-	      float t2 = (-B - sq) / (2.f * A);
-	      grad_t = (cr0 + t1 * dr >= 0.f) ? t1 : t2;
-	    }
-	    else
-	    {
-	      if (fabsf (B) < 1e-10f)
-	      {
-		gx += inv_xx;
-		gy += inv_yx;
-		continue;
-	      }
-	      grad_t = -C / B;
-	    }
-
-	    uint32_t src = evaluate_color_line (stops, len, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-  }
+  gradient.cdx = cx1 - gradient.cx0;
+  gradient.cdy = cy1 - gradient.cy0;
+  gradient.dr = cr1 - gradient.cr0;
+  gradient.A = gradient.cdx * gradient.cdx + gradient.cdy * gradient.cdy - gradient.dr * gradient.dr;
 
+  hb_raster_paint_gradient (c, surf, stops, len,
+			    hb_color_line_get_extend (color_line),
+			    gradient);
 }
 
 static void
@@ -1704,131 +1674,21 @@ hb_raster_paint_sweep_gradient (hb_paint_funcs_t *pfuncs HB_UNUSED,
   float mn, mx;
   hb_paint_normalize_color_line (stops, len, &mn, &mx);
 
-  hb_paint_extend_t extend = hb_color_line_get_extend (color_line);
-  const hb_raster_clip_t &clip = c->current_clip ();
-  unsigned clip_w = clip.max_x > clip.min_x ? clip.max_x - clip.min_x : 0;
-  unsigned clip_h = clip.max_y > clip.min_y ? clip.max_y - clip.min_y : 0;
-  if (unlikely (!c->charge_work ((int64_t) clip_w * clip_h)))
-    return;
-  bool use_lut = (uint64_t) clip_w * clip_h >= GRADIENT_LUT_MIN_PIXELS;
-  uint32_t lut[GRADIENT_LUT_SIZE];
-  if (use_lut)
-    build_gradient_lut (stops, len, lut);
-
   /* Apply normalization to angle range */
   float a0 = start_angle + mn * (end_angle - start_angle);
   float a1 = start_angle + mx * (end_angle - start_angle);
   float angle_range = a1 - a0;
+  if (fabsf (angle_range) < 1e-10f) return;
 
-  /* Inverse transform */
-  hb_transform_t<> t = c->current_effective_transform ();
-  float det = t.xx * t.yy - t.xy * t.yx;
-  if (fabsf (det) < 1e-10f || fabsf (angle_range) < 1e-10f) return;
-
-  {
-    float inv_det = 1.f / det;
-    float inv_xx =  t.yy * inv_det;
-    float inv_xy = -t.xy * inv_det;
-    float inv_yx = -t.yx * inv_det;
-    float inv_yy =  t.xx * inv_det;
-    float inv_x0 = (t.xy * t.y0 - t.yy * t.x0) * inv_det;
-    float inv_y0 = (t.yx * t.x0 - t.xx * t.y0) * inv_det;
-
-    float inv_angle_range = 1.f / angle_range;
-
-    unsigned stride = surf->extents.stride;
-    int ox = surf->extents.x_origin;
-    int oy = surf->extents.y_origin;
-
-    if (clip.is_rect)
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = evaluate_color_line (stops, len, grad_t, extend);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-    else
-    {
-      for (unsigned py = clip.min_y; py < clip.max_y; py++)
-      {
-	hb_packed_t<uint32_t> *row = (hb_packed_t<uint32_t> *) (surf->buffer.arrayZ + py * stride);
-	const uint8_t *clip_row = clip.alpha.arrayZ + py * clip.stride;
-	float gx = inv_xx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_xy * ((float) ((int) py + oy) + 0.5f) + inv_x0;
-	float gy = inv_yx * ((float) ((int) clip.min_x + ox) + 0.5f) + inv_yy * ((float) ((int) py + oy) + 0.5f) + inv_y0;
-	if (use_lut)
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = lookup_gradient_lut (lut, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-	else
-	{
-	  for (unsigned px = clip.min_x; px < clip.max_x; px++)
-	  {
-	    uint8_t clip_alpha = clip_row[px];
-	    if (clip_alpha == 0)
-	    {
-	      gx += inv_xx;
-	      gy += inv_yx;
-	      continue;
-	    }
-	    float angle = atan2f (gy - cy, gx - cx);
-	    if (angle < 0) angle += (float) HB_2_PI;
-	    float grad_t = (angle - a0) * inv_angle_range;
-	    uint32_t src = evaluate_color_line (stops, len, grad_t, extend);
-	    src = hb_raster_alpha_mul (src, clip_alpha);
-	    row[px] = hb_packed_t<uint32_t> (hb_raster_src_over (src, (uint32_t) row[px]));
-	    gx += inv_xx;
-	    gy += inv_yx;
-	  }
-	}
-      }
-    }
-  }
+  hb_raster_sweep_gradient_t gradient;
+  gradient.cx = cx;
+  gradient.cy = cy;
+  gradient.a0 = a0;
+  gradient.inv_angle_range = 1.f / angle_range;
 
+  hb_raster_paint_gradient (c, surf, stops, len,
+			    hb_color_line_get_extend (color_line),
+			    gradient);
 }
 
 static hb_bool_t
@@ -2480,6 +2340,77 @@ hb_raster_paint_glyph (hb_raster_paint_t *paint,
   hb_raster_paint_glyph_impl (paint, font, glyph, false);
 }
 
+/**
+ * hb_raster_paint_buffer:
+ * @paint: a paint context
+ * @font: font to paint from
+ * @buffer: a shaped buffer
+ *
+ * Paints all glyphs of shaped @buffer into @paint, each at its shaped
+ * position, with the pen starting at the origin, as
+ * hb_raster_paint_glyph() would.  The base transform applies to the
+ * whole run, and all glyphs land on one surface, so a single
+ * hb_raster_paint_render() returns the whole run.
+ *
+ * If no extents were set, they are set to cover the whole run, up to
+ * 4096 pixels per side.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_raster_paint_buffer (hb_raster_paint_t *paint,
+			hb_font_t        *font,
+			hb_buffer_t      *buffer)
+{
+  if (unlikely (hb_buffer_get_content_type (buffer) != HB_BUFFER_CONTENT_TYPE_GLYPHS))
+    return;
+
+  unsigned count;
+  const hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  const hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  if (!paint->has_extents)
+  {
+    hb_extents_t<> run;
+    float pen_x = 0.f, pen_y = 0.f;
+    for (unsigned i = 0; i < count; i++)
+    {
+      hb_glyph_extents_t ge;
+      if (hb_font_get_glyph_extents (font, info[i].codepoint, &ge))
+      {
+	float x = pen_x + pos[i].x_offset + ge.x_bearing;
+	float y = pen_y + pos[i].y_offset + ge.y_bearing;
+	run.add_point (x, y);
+	run.add_point (x + ge.width, y + ge.height);
+      }
+      pen_x += pos[i].x_advance;
+      pen_y += pos[i].y_advance;
+    }
+    if (run.is_empty ())
+      return;
+    hb_glyph_extents_t ge = {
+      hb_clamp_to<hb_position_t> (floorf (run.xmin)),
+      hb_clamp_to<hb_position_t> (ceilf (run.ymax)),
+      hb_clamp_to<hb_position_t> (ceilf (run.xmax) - floorf (run.xmin)),
+      hb_clamp_to<hb_position_t> (floorf (run.ymin) - ceilf (run.ymax)),
+    };
+    if (!hb_raster_paint_set_glyph_extents (paint, &ge))
+      return;
+  }
+
+  hb_transform_t<> transform = paint->base_transform;
+  float pen_x = 0.f, pen_y = 0.f;
+  for (unsigned i = 0; i < count; i++)
+  {
+    paint->base_transform = transform;
+    paint->base_transform.translate (pen_x + pos[i].x_offset, pen_y + pos[i].y_offset);
+    hb_raster_paint_glyph_impl (paint, font, info[i].codepoint, false);
+    pen_x += pos[i].x_advance;
+    pen_y += pos[i].y_advance;
+  }
+  paint->base_transform = transform;
+}
+
 /**
  * hb_raster_paint_render:
  * @paint: a paint context
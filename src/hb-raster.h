@@ -37,16 +37,49 @@ HB_BEGIN_DECLS
  * hb_raster_format_t:
  * @HB_RASTER_FORMAT_A8: 8-bit alpha-only coverage
  * @HB_RASTER_FORMAT_BGRA32: 32-bit BGRA color
+ * @HB_RASTER_FORMAT_SDF_A8: 8-bit signed distance field.  128 is on the
+ * outline; larger values are inside.  Distances of the spread or more
+ * saturate to 255 inside and 0 outside.  Since: REPLACEME
+ * @HB_RASTER_FORMAT_MSDF_BGRA32: 32-bit multi-channel signed distance
+ * field.  The median of the B, G and R channels is a distance that keeps
+ * corners sharp when scaled; A holds the true distance as in
+ * @HB_RASTER_FORMAT_SDF_A8.  Since: REPLACEME
+ * @HB_RASTER_FORMAT_LCD_BGRA32: 32-bit subpixel coverage for LCD
+ * screens.  B, G and R hold the filtered coverage of the blue, green and
+ * red subpixels; A holds their mean.  See hb_raster_draw_set_lcd_layout().
+ * Since: REPLACEME
  *
  * Pixel format for raster images.
  *
  * Since: 13.0.0
  */
 typedef enum {
-  HB_RASTER_FORMAT_A8     = 0,
-  HB_RASTER_FORMAT_BGRA32 = 1,
+  HB_RASTER_FORMAT_A8          = 0,
+  HB_RASTER_FORMAT_BGRA32      = 1,
+  HB_RASTER_FORMAT_SDF_A8      = 2,
+  HB_RASTER_FORMAT_MSDF_BGRA32 = 3,
+  HB_RASTER_FORMAT_LCD_BGRA32  = 4,
 } hb_raster_format_t;
 
+/**
+ * hb_raster_lcd_layout_t:
+ * @HB_RASTER_LCD_LAYOUT_RGB: red, green and blue subpixels, left to right
+ * @HB_RASTER_LCD_LAYOUT_BGR: blue, green and red subpixels, left to right
+ * @HB_RASTER_LCD_LAYOUT_VRGB: red, green and blue subpixels, top to bottom
+ * @HB_RASTER_LCD_LAYOUT_VBGR: blue, green and red subpixels, top to bottom
+ *
+ * Subpixel arrangement of an LCD screen, for
+ * @HB_RASTER_FORMAT_LCD_BGRA32 rendering.
+ *
+ * Since: REPLACEME
+ */
+typedef enum {
+  HB_RASTER_LCD_LAYOUT_RGB  = 0,
+  HB_RASTER_LCD_LAYOUT_BGR  = 1,
+  HB_RASTER_LCD_LAYOUT_VRGB = 2,
+  HB_RASTER_LCD_LAYOUT_VBGR = 3,
+} hb_raster_lcd_layout_t;
+
 /**
  * hb_raster_extents_t:
  * @x_origin: X coordinate of the left edge of the image in glyph space
@@ -104,6 +137,12 @@ hb_raster_image_configure (hb_raster_image_t         *image,
 			   hb_raster_format_t        format,
 			   const hb_raster_extents_t *extents);
 
+HB_EXTERN hb_bool_t
+hb_raster_image_configure_for_data (hb_raster_image_t         *image,
+				    hb_raster_format_t         format,
+				    const hb_raster_extents_t *extents,
+				    uint8_t                   *data);
+
 HB_EXTERN void
 hb_raster_image_clear (hb_raster_image_t *image);
 
@@ -180,6 +219,49 @@ hb_raster_draw_get_scale_factor (const hb_raster_draw_t *draw,
 				 float *x_scale_factor,
 				 float *y_scale_factor);
 
+HB_EXTERN hb_bool_t
+hb_raster_draw_set_format (hb_raster_draw_t   *draw,
+			   hb_raster_format_t  format);
+
+HB_EXTERN hb_raster_format_t
+hb_raster_draw_get_format (const hb_raster_draw_t *draw);
+
+HB_EXTERN void
+hb_raster_draw_set_sdf_spread (hb_raster_draw_t *draw,
+			       float             spread);
+
+HB_EXTERN float
+hb_raster_draw_get_sdf_spread (const hb_raster_draw_t *draw);
+
+HB_EXTERN hb_bool_t
+hb_raster_draw_set_lcd_layout (hb_raster_draw_t       *draw,
+			       hb_raster_lcd_layout_t  layout);
+
+HB_EXTERN hb_raster_lcd_layout_t
+hb_raster_draw_get_lcd_layout (const hb_raster_draw_t *draw);
+
+HB_EXTERN void
+hb_raster_draw_set_lcd_filter (hb_raster_draw_t *draw,
+			       const uint8_t    *weights);
+
+HB_EXTERN void
+hb_raster_draw_get_lcd_filter (const hb_raster_draw_t *draw,
+			       uint8_t                *weights);
+
+HB_EXTERN void
+hb_raster_draw_set_num_threads (hb_raster_draw_t *draw,
+				unsigned int      num_threads);
+
+HB_EXTERN unsigned int
+hb_raster_draw_get_num_threads (const hb_raster_draw_t *draw);
+
+HB_EXTERN void
+hb_raster_draw_set_outline_cache_max_bytes (hb_raster_draw_t *draw,
+					    unsigned int      max_bytes);
+
+HB_EXTERN unsigned int
+hb_raster_draw_get_outline_cache_max_bytes (const hb_raster_draw_t *draw);
+
 HB_EXTERN void
 hb_raster_draw_set_extents (hb_raster_draw_t          *draw,
 			    const hb_raster_extents_t *extents);
@@ -205,9 +287,18 @@ hb_raster_draw_glyph_or_fail (hb_raster_draw_t *draw,
 			      hb_font_t       *font,
 			      hb_codepoint_t   glyph);
 
+HB_EXTERN void
+hb_raster_draw_buffer (hb_raster_draw_t *draw,
+		       hb_font_t        *font,
+		       hb_buffer_t      *buffer);
+
 HB_EXTERN hb_raster_image_t *
 hb_raster_draw_render (hb_raster_draw_t *draw);
 
+HB_EXTERN hb_bool_t
+hb_raster_draw_render_into (hb_raster_draw_t  *draw,
+			    hb_raster_image_t *image);
+
 HB_EXTERN void
 hb_raster_draw_clear (hb_raster_draw_t *draw);
 
@@ -329,6 +420,11 @@ hb_raster_paint_glyph_or_fail (hb_raster_paint_t *paint,
 			       hb_font_t        *font,
 			       hb_codepoint_t    glyph);
 
+HB_EXTERN void
+hb_raster_paint_buffer (hb_raster_paint_t *paint,
+			hb_font_t         *font,
+			hb_buffer_t       *buffer);
+
 HB_EXTERN hb_raster_image_t *
 hb_raster_paint_render (hb_raster_paint_t *paint);
 
@@ -343,6 +439,101 @@ hb_raster_paint_recycle_image (hb_raster_paint_t  *paint,
 			       hb_raster_image_t  *image);
 
 
+/* hb_raster_atlas_t */
+
+/**
+ * hb_raster_atlas_t:
+ *
+ * An opaque glyph atlas object.  It caches rendered glyphs packed into
+ * a few large page images, so each glyph is only rasterized once.
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_raster_atlas_t hb_raster_atlas_t;
+
+/**
+ * hb_raster_atlas_glyph_t:
+ * @page: Index of the page holding the glyph
+ * @x: Left column of the glyph in the page
+ * @y: First row of the glyph in the page
+ * @width: Width in pixels
+ * @height: Height in pixels
+ * @x_origin: X coordinate of the left edge of the glyph image, in pixels
+ * relative to the pen position
+ * @y_origin: Y coordinate of the bottom edge of the glyph image, in pixels
+ * relative to the pen position
+ *
+ * Where a glyph lives in an atlas, and where to put it relative to the
+ * pen position.  Rows follow the order of hb_raster_image_get_buffer(),
+ * so the glyph's bottom row is row @y of the page.
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_raster_atlas_glyph_t {
+  unsigned int page;
+  unsigned int x, y;
+  unsigned int width, height;
+  int x_origin, y_origin;
+} hb_raster_atlas_glyph_t;
+
+HB_EXTERN hb_raster_atlas_t *
+hb_raster_atlas_create_or_fail (hb_raster_format_t format,
+				unsigned int       page_width,
+				unsigned int       page_height);
+
+HB_EXTERN hb_raster_atlas_t *
+hb_raster_atlas_reference (hb_raster_atlas_t *atlas);
+
+HB_EXTERN void
+hb_raster_atlas_destroy (hb_raster_atlas_t *atlas);
+
+HB_EXTERN hb_bool_t
+hb_raster_atlas_set_user_data (hb_raster_atlas_t  *atlas,
+			       hb_user_data_key_t *key,
+			       void               *data,
+			       hb_destroy_func_t   destroy,
+			       hb_bool_t           replace);
+
+HB_EXTERN void *
+hb_raster_atlas_get_user_data (const hb_raster_atlas_t *atlas,
+			       hb_user_data_key_t      *key);
+
+HB_EXTERN void
+hb_raster_atlas_set_max_bytes (hb_raster_atlas_t *atlas,
+			       unsigned int       max_bytes);
+
+HB_EXTERN unsigned int
+hb_raster_atlas_get_max_bytes (const hb_raster_atlas_t *atlas);
+
+HB_EXTERN void
+hb_raster_atlas_set_palette (hb_raster_atlas_t *atlas,
+			     unsigned int       palette);
+
+HB_EXTERN void
+hb_raster_atlas_set_foreground (hb_raster_atlas_t *atlas,
+				hb_color_t         foreground);
+
+HB_EXTERN hb_bool_t
+hb_raster_atlas_get_glyph (hb_raster_atlas_t       *atlas,
+			   hb_font_t               *font,
+			   hb_codepoint_t           glyph,
+			   float                    x_offset,
+			   float                    y_offset,
+			   hb_raster_atlas_glyph_t *atlas_glyph);
+
+HB_EXTERN unsigned int
+hb_raster_atlas_get_page_count (const hb_raster_atlas_t *atlas);
+
+HB_EXTERN const hb_raster_image_t *
+hb_raster_atlas_get_page (const hb_raster_atlas_t *atlas,
+			  unsigned int             page,
+			  unsigned int            *serial,
+			  unsigned int            *generation);
+
+HB_EXTERN void
+hb_raster_atlas_clear (hb_raster_atlas_t *atlas);
+
+
 HB_END_DECLS
 
 
@@ -351,6 +542,7 @@ namespace hb {
 HB_DEFINE_VTABLE (raster_image, nullptr);
 HB_DEFINE_VTABLE (raster_draw,  nullptr);
 HB_DEFINE_VTABLE (raster_paint, nullptr);
+HB_DEFINE_VTABLE (raster_atlas, nullptr);
 } // namespace hb
 #endif
 
@@ -166,6 +166,9 @@ struct hb_set_digest_t
     return true;
   }
 
+  /* For vectorized may_have() tests; see hb-ot-layout-scan.hh. */
+  mask_t get_mask (unsigned i) const { return masks[i]; }
+
   private:
 
   mask_t masks[n] = {};
@@ -0,0 +1,538 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+
+#ifndef HB_NO_SHAPER
+
+#include "hb-shape-cache.hh"
+#include "hb-buffer.hh"
+#include "hb-font.hh"
+
+
+void
+hb_shape_cache_t::clear ()
+{
+  entries.clear ();
+
+  for (const hb_shape_cache_plan_t &plan : plans)
+    hb_shape_plan_destroy (plan.shape_plan);
+  plans.clear ();
+
+  epoch++;
+}
+
+void
+hb_shape_cache_t::bind (hb_font_t *font_)
+{
+  if (font == font_ && font_serial == font_->serial)
+    return;
+
+  clear ();
+  hb_font_destroy (font);
+  font = hb_font_reference (font_);
+  font_serial = font_->serial;
+}
+
+int
+hb_shape_cache_t::get_plan_index (hb_shape_plan_t *shape_plan)
+{
+  for (unsigned int i = 0; i < plans.length; i++)
+    if (plans.arrayZ[i].shape_plan == shape_plan ||
+	plans.arrayZ[i].shape_plan->key.equal (&shape_plan->key))
+      return plans.arrayZ[i].disabled ? -1 : (int) i;
+
+  if (plans.length >= HB_SHAPE_CACHE_MAX_PLANS)
+    clear ();
+
+  plans.push (hb_shape_cache_plan_t {hb_shape_plan_reference (shape_plan), 0, 0, false});
+  if (unlikely (plans.in_error ()))
+  {
+    hb_shape_plan_destroy (shape_plan);
+    return -1;
+  }
+  return plans.length - 1;
+}
+
+/* Fonts that kern or substitute across spaces almost never produce a word
+ * we can store, and then the cache is pure overhead.  Once enough words
+ * have been shaped with a plan, give up on it if fewer than one in eight
+ * could be stored. */
+void
+hb_shape_cache_t::account (unsigned int plan_index,
+			   unsigned int num_words,
+			   unsigned int num_stored)
+{
+  hb_shape_cache_plan_t &plan = plans.arrayZ[plan_index];
+  plan.num_words += num_words;
+  plan.num_stored += num_stored;
+  if (plan.num_words < HB_SHAPE_CACHE_TRIAL_WORDS)
+    return;
+
+  plan.disabled = plan.num_stored < plan.num_words / 8;
+  plan.num_words = plan.num_stored = 0;
+}
+
+bool
+hb_shape_cache_t::insert (hb_bytes_t key, uint32_t hash,
+			  const hb_glyph_info_t *infos,
+			  const hb_glyph_position_t *positions,
+			  unsigned int num_glyphs,
+			  unsigned int base_cluster)
+{
+  if (entries.fetch (key, hash))
+    return true; /* Another thread got here first. */
+
+  size_t size = sizeof (hb_shape_cache_entry_t) +
+		num_glyphs * (sizeof (infos[0]) + sizeof (positions[0])) +
+		key.length;
+  if (size > max_bytes)
+    return false;
+  entries.evict (max_bytes - size);
+
+  hb_shape_cache_entry_t *entry = (hb_shape_cache_entry_t *) hb_malloc (size);
+  if (unlikely (!entry))
+    return false;
+  entry->num_glyphs = num_glyphs;
+  entry->key_length = key.length;
+
+  hb_glyph_info_t *entry_infos = entry->infos ();
+  hb_memcpy (entry_infos, infos, num_glyphs * sizeof (infos[0]));
+  for (unsigned int i = 0; i < num_glyphs; i++)
+    entry_infos[i].cluster -= base_cluster;
+  hb_memcpy (entry->positions (), positions, num_glyphs * sizeof (positions[0]));
+  hb_memcpy ((char *) entry->key ().arrayZ, key.arrayZ, key.length);
+
+  return entries.insert (entry, hash);
+}
+
+
+/**
+ * hb_shape_cache_create:
+ *
+ * Creates a new, empty, shaped-word cache, for use with hb_shape_cached().
+ *
+ * The cache holds shaping results for one font at a time.  It is
+ * thread-safe: the same cache can be used by several threads at once.
+ *
+ * Return value: (transfer full): Newly-created shaped-word cache, or
+ * `NULL` on allocation failure.  Destroy with hb_shape_cache_destroy().
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_cache_t *
+hb_shape_cache_create ()
+{
+  return hb_object_create<hb_shape_cache_t> ();
+}
+
+/**
+ * hb_shape_cache_reference: (skip)
+ * @cache: A shaped-word cache
+ *
+ * Increases the reference count on @cache by one.
+ *
+ * Return value: (transfer full): The referenced cache.
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_cache_t *
+hb_shape_cache_reference (hb_shape_cache_t *cache)
+{
+  return hb_object_reference (cache);
+}
+
+/**
+ * hb_shape_cache_destroy: (skip)
+ * @cache: A shaped-word cache
+ *
+ * Decreases the reference count on @cache by one.  When the
+ * reference count reaches zero, the cache is destroyed, freeing
+ * all memory.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_destroy (hb_shape_cache_t *cache)
+{
+  if (!hb_object_destroy (cache)) return;
+
+  hb_free (cache);
+}
+
+/**
+ * hb_shape_cache_set_max_bytes:
+ * @cache: A shaped-word cache
+ * @max_bytes: The memory budget, in bytes
+ *
+ * Sets the amount of memory the shaping results held by @cache may
+ * take.  Least-recently used results are dropped to stay within it.
+ * Zero disables caching.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_set_max_bytes (hb_shape_cache_t *cache,
+			      unsigned int      max_bytes)
+{
+  if (unlikely (!cache)) return;
+
+  hb_lock_t lock (cache->lock);
+  cache->max_bytes = max_bytes;
+  cache->entries.evict (max_bytes);
+}
+
+/**
+ * hb_shape_cache_get_stats:
+ * @cache: A shaped-word cache
+ * @hits: (out) (optional): Number of words found in the cache
+ * @misses: (out) (optional): Number of words not found in the cache
+ *
+ * Fetches how many words hb_shape_cached() has looked up in @cache
+ * so far, by outcome.  Every word of a buffer is looked up, also when
+ * some are missing and the buffer is shaped in full.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_get_stats (hb_shape_cache_t *cache,
+			  unsigned int     *hits,
+			  unsigned int     *misses)
+{
+  unsigned int h = 0, m = 0;
+  if (likely (cache))
+  {
+    hb_lock_t lock (cache->lock);
+    h = cache->hits;
+    m = cache->misses;
+  }
+  if (hits) *hits = h;
+  if (misses) *misses = m;
+}
+
+
+struct hb_shape_cache_word_t
+{
+  unsigned int start; /* Buffer index of first character. */
+  unsigned int cluster; /* Its cluster. */
+  unsigned int key_start;
+  unsigned int key_length; /* Zero if too long to cache. */
+  uint32_t hash;
+};
+
+/* Returns the glyph index at which the text can be cut before the
+ * character with @cluster, or -1 if it cannot be cut there.  The cut is
+ * in visual order; in backward direction the glyphs for the text after
+ * the cut come before it. */
+static int
+_hb_shape_cache_find_cut (const hb_glyph_info_t *info,
+			  unsigned int len,
+			  bool backward,
+			  unsigned int cluster)
+{
+  /* Clusters are monotone; find the first glyph past the cut. */
+  unsigned int lo = 0, hi = len;
+  while (lo < hi)
+  {
+    unsigned int mid = (lo + hi) / 2;
+    if (backward ? info[mid].cluster >= cluster : info[mid].cluster < cluster)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  /* The glyph that starts the cluster, in logical order. */
+  unsigned int i = backward ? lo - 1 : lo;
+  if (backward ? !lo : lo == len)
+    return -1;
+  if (info[i].cluster != cluster ||
+      (info[i].mask & HB_GLYPH_FLAG_UNSAFE_TO_CONCAT))
+    return -1;
+
+  return lo;
+}
+
+/**
+ * hb_shape_cached:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: an #hb_buffer_t to shape
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ * @cache: (nullable): a shaped-word cache, or `NULL`
+ *
+ * Shapes @buffer like hb_shape_full() does, reusing results of shaping
+ * the same words earlier, stored in @cache.
+ *
+ * The text is looked at as a sequence of words, each followed by zero or
+ * more spaces.  When shaping a buffer, each word whose shaping turned out
+ * to be independent of the text around it (as HarfBuzz reports with the
+ * #HB_GLYPH_FLAG_UNSAFE_TO_CONCAT glyph flag) is stored in @cache.  A later
+ * buffer all of whose words are found in @cache is put together from
+ * them instead of being shaped.  The result is the same as hb_shape_full()
+ * would give.
+ *
+ * This pays off for natural-language text, in which the same words come
+ * up again and again.  With fonts that kern or substitute across spaces,
+ * few words are independent of their neighbors; once that is apparent,
+ * @cache stops trying and such buffers are simply shaped.  Buffers with features applied to part of the
+ * text, with non-monotone cluster levels, or shaped with shapers other
+ * than the `ot` and `fallback` shapers, are always shaped.
+ *
+ * If @cache was last used with another font, or @font has been modified
+ * since, its contents are discarded first.
+ *
+ * Return value: false if all shapers failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_cached (hb_font_t          *font,
+		 hb_buffer_t        *buffer,
+		 const hb_feature_t *features,
+		 unsigned int        num_features,
+		 const char * const *shaper_list,
+		 hb_shape_cache_t   *cache)
+{
+  if (unlikely (!buffer->len))
+    return true;
+
+  if (!cache ||
+      buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+      (buffer->flags & HB_BUFFER_FLAG_VERIFY) ||
+      !HB_BUFFER_CLUSTER_LEVEL_IS_MONOTONE (buffer->cluster_level) ||
+      !HB_DIRECTION_IS_VALID (buffer->props.direction))
+    return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  for (unsigned int i = 0; i < num_features; i++)
+    if (features[i].start != HB_FEATURE_GLOBAL_START ||
+	features[i].end != HB_FEATURE_GLOBAL_END)
+      return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  const hb_glyph_info_t *info = buffer->info;
+  unsigned int count = buffer->len;
+  for (unsigned int i = 1; i < count; i++)
+    if (unlikely (info[i].cluster <= info[i - 1].cluster))
+      return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+  hb_shape_plan_t *shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+							      features, num_features,
+							      font->coords, font->num_coords,
+							      shaper_list);
+
+  /* The ot shaper produces the flag we rely on; the fallback shaper has
+   * nothing that reaches across characters. */
+  const char *shaper = shape_plan->key.shaper_name;
+  int plan_index = -1;
+  unsigned int epoch = 0;
+  if (shaper && (0 == strcmp (shaper, "ot") || 0 == strcmp (shaper, "fallback")))
+  {
+    hb_lock_t lock (cache->lock);
+    cache->bind (font);
+    if (cache->max_bytes)
+      plan_index = cache->get_plan_index (shape_plan);
+    epoch = cache->epoch;
+  }
+
+  hb_vector_t<hb_shape_cache_word_t> words;
+  hb_vector_t<uint32_t> keys;
+  hb_vector_t<hb_glyph_info_t> out_info;
+  hb_vector_t<hb_glyph_position_t> out_pos;
+  bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+  bool found = false;
+
+  if (plan_index >= 0)
+  {
+    /* Cut the text into words, each with the spaces following it. */
+    for (unsigned int i = 0; i < count; i++)
+      if (!i || (info[i - 1].codepoint == ' ' && info[i].codepoint != ' '))
+	words.push (hb_shape_cache_word_t {i, info[i].cluster, 0, 0, 0});
+
+    unsigned int flags = buffer->flags & ~(HB_BUFFER_FLAG_BOT |
+					   HB_BUFFER_FLAG_EOT |
+					   HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT);
+    for (unsigned int w = 0; w < words.length; w++)
+    {
+      hb_shape_cache_word_t &word = words.arrayZ[w];
+      bool first = w == 0;
+      bool last = w == words.length - 1;
+      unsigned int start = word.start;
+      unsigned int end = last ? count : words.arrayZ[w + 1].start;
+      if (end - start > HB_SHAPE_CACHE_MAX_WORD_LENGTH)
+	continue;
+
+      word.key_start = keys.length;
+      keys.push (plan_index);
+      keys.push (flags |
+		 (first ? buffer->flags & HB_BUFFER_FLAG_BOT : 0) |
+		 (last ? buffer->flags & HB_BUFFER_FLAG_EOT : 0));
+      keys.push (buffer->cluster_level);
+      keys.push (buffer->invisible);
+      keys.push (buffer->replacement);
+      keys.push (buffer->not_found);
+      keys.push (buffer->not_found_variation_selector);
+      /* Context only matters at the buffer ends; elsewhere words are
+       * only ever found next to other words. */
+      for (unsigned int side = 0; side < 2; side++)
+      {
+	if (side ? last : first)
+	{
+	  keys.push (buffer->context_len[side]);
+	  for (unsigned int i = 0; i < buffer->context_len[side]; i++)
+	    keys.push (buffer->context[side][i]);
+	}
+	else
+	  keys.push ((uint32_t) -1);
+      }
+      for (unsigned int i = start; i < end; i++)
+      {
+	keys.push (info[i].codepoint);
+	keys.push (info[i].cluster - word.cluster);
+      }
+      if (unlikely (keys.in_error ()))
+	break;
+      word.key_length = keys.length - word.key_start;
+      word.hash = hb_bytes_t ((const char *) (keys.arrayZ + word.key_start),
+			      word.key_length * sizeof (keys[0])).hash ();
+    }
+
+    if (likely (!words.in_error () && !keys.in_error ()))
+    {
+      hb_lock_t lock (cache->lock);
+      found = cache->epoch == epoch;
+      if (!found)
+	cache->misses += words.length; /* Their plan index is stale. */
+      /* Every word is looked up, so that the stats count words even
+       * when the buffer ends up shaped in full. */
+      for (unsigned int j = 0; j < words.length && cache->epoch == epoch; j++)
+      {
+	const hb_shape_cache_word_t &word = words.arrayZ[backward ? words.length - 1 - j : j];
+	hb_shape_cache_entry_t *entry = nullptr;
+	if (word.key_length)
+	  entry = cache->entries.fetch (hb_bytes_t ((const char *) (keys.arrayZ + word.key_start),
+						    word.key_length * sizeof (keys[0])),
+					word.hash);
+	if (!entry)
+	{
+	  cache->misses++;
+	  found = false;
+	  continue;
+	}
+	cache->hits++;
+	if (!found)
+	  continue;
+
+	unsigned int n = entry->num_glyphs;
+	unsigned int l = out_info.length;
+	if (unlikely (!out_info.resize_dirty (l + n) ||
+		      !out_pos.resize_dirty (l + n)))
+	{
+	  found = false;
+	  break;
+	}
+	hb_memcpy (out_info.arrayZ + l, entry->infos (), n * sizeof (out_info[0]));
+	for (unsigned int i = l; i < l + n; i++)
+	  out_info.arrayZ[i].cluster += word.cluster;
+	hb_memcpy (out_pos.arrayZ + l, entry->positions (), n * sizeof (out_pos[0]));
+      }
+    }
+  }
+
+  hb_bool_t ret = true;
+  if (found && likely (buffer->ensure (out_info.length)))
+  {
+    unsigned int n = out_info.length;
+    hb_memcpy (buffer->info, out_info.arrayZ, n * sizeof (out_info[0]));
+    buffer->len = n;
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+    buffer->clear_positions ();
+    hb_memcpy (buffer->pos, out_pos.arrayZ, n * sizeof (out_pos[0]));
+  }
+  else
+  {
+    hb_buffer_flags_t orig_flags = buffer->flags;
+    if (plan_index >= 0)
+      buffer->flags = (hb_buffer_flags_t) (orig_flags | HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT);
+
+    buffer->enter ();
+    ret = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+    buffer->leave ();
+
+    buffer->flags = orig_flags;
+
+    if (ret && buffer->successful && words.length && !words.in_error () && !keys.in_error ())
+    {
+      /* Remember each word the shaping result can be cut around. */
+      info = buffer->info;
+      count = buffer->len;
+      bool monotone = true;
+      for (unsigned int i = 1; i < count; i++)
+	if (backward ? info[i].cluster > info[i - 1].cluster
+		     : info[i].cluster < info[i - 1].cluster)
+	  monotone = false;
+
+      hb_lock_t lock (cache->lock);
+      if (monotone && cache->epoch == epoch)
+      {
+	unsigned int num_stored = 0;
+	int cut = backward ? count : 0;
+	for (unsigned int w = 0; w < words.length; w++)
+	{
+	  const hb_shape_cache_word_t &word = words.arrayZ[w];
+	  int next_cut = w + 1 < words.length
+		       ? _hb_shape_cache_find_cut (info, count, backward, words.arrayZ[w + 1].cluster)
+		       : (backward ? 0 : count);
+	  if (cut >= 0 && next_cut >= 0 && word.key_length)
+	  {
+	    unsigned int glyph_start = backward ? next_cut : cut;
+	    unsigned int glyph_end = backward ? cut : next_cut;
+	    num_stored += cache->insert (hb_bytes_t ((const char *) (keys.arrayZ + word.key_start),
+				       word.key_length * sizeof (keys[0])),
+			   word.hash,
+			   info + glyph_start, buffer->pos + glyph_start,
+			   glyph_end - glyph_start,
+			   word.cluster);
+	  }
+	  cut = next_cut;
+	}
+	cache->account (plan_index, words.length, num_stored);
+      }
+    }
+
+  }
+
+  /* Results were produced with the flag; drop it if not asked for. */
+  if (plan_index >= 0 && !(buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT))
+    for (unsigned int i = 0; i < buffer->len; i++)
+      buffer->info[i].mask &= ~HB_GLYPH_FLAG_UNSAFE_TO_CONCAT;
+
+  hb_shape_plan_destroy (shape_plan);
+
+  return ret;
+}
+
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_SHAPE_CACHE_HH
+#define HB_SHAPE_CACHE_HH
+
+#include "hb.hh"
+
+#include "hb-cache.hh"
+#include "hb-mutex.hh"
+#include "hb-shape-plan.hh"
+
+
+/*
+ * Shaped-word cache.
+ *
+ * Text is cut into words, each word taking the spaces that follow it.
+ * Whenever a buffer is shaped through the cache, the words whose both ends
+ * come out clear of HB_GLYPH_FLAG_UNSAFE_TO_CONCAT are remembered, and a
+ * later buffer made up entirely of remembered words is put together from
+ * them without shaping.  The flag is what tells us no lookup, joining, or
+ * other shaping step reached across the word boundary.
+ *
+ * Words at the start and end of a buffer are keyed with the buffer context
+ * and BOT / EOT flags on that side; other words are only ever reused in the
+ * middle of a buffer.
+ */
+
+struct hb_shape_cache_entry_t : hb_lru_link_t
+{
+  unsigned int num_glyphs;
+  unsigned int key_length; /* In bytes. */
+
+  /* Glyph infos, then positions, then the key, follow. */
+  hb_glyph_info_t *infos () { return (hb_glyph_info_t *) (this + 1); }
+  hb_glyph_position_t *positions () { return (hb_glyph_position_t *) (infos () + num_glyphs); }
+  hb_bytes_t key () { return hb_bytes_t ((const char *) (positions () + num_glyphs), key_length); }
+
+  unsigned int get_size () const
+  {
+    return sizeof (*this) +
+	   num_glyphs * (sizeof (hb_glyph_info_t) + sizeof (hb_glyph_position_t)) +
+	   key_length;
+  }
+
+  bool equal (hb_bytes_t key_) { return key () == key_; }
+  void fini () {}
+};
+
+struct hb_shape_cache_plan_t
+{
+  hb_shape_plan_t *shape_plan;
+  /* Words shaped, and how many of those could be stored, since the
+   * last check; see hb_shape_cache_t::account(). */
+  unsigned int num_words;
+  unsigned int num_stored;
+  /* The font hardly ever shapes words independently with this plan;
+   * don't bother. */
+  bool disabled;
+};
+
+struct hb_shape_cache_t
+{
+  ~hb_shape_cache_t ()
+  {
+    clear ();
+    hb_font_destroy (font);
+  }
+
+  hb_object_header_t header;
+
+  hb_mutex_t lock;
+
+  /* The font the entries are for, and its serial when they were made. */
+  hb_font_t *font = nullptr;
+  unsigned int font_serial = 0;
+  /* Bumped whenever the entries are dropped. */
+  unsigned int epoch = 0;
+
+  /* Plans seen so far; entry keys refer to them by index.  We hold a
+   * reference, so an index always means the same plan. */
+  hb_vector_t<hb_shape_cache_plan_t> plans;
+
+  hb_lru_cache_t<hb_shape_cache_entry_t> entries;
+  size_t max_bytes = HB_SHAPE_CACHE_MAX_BYTES_DEFAULT;
+
+  unsigned int hits = 0;
+  unsigned int misses = 0;
+
+  HB_INTERNAL void clear ();
+  HB_INTERNAL void bind (hb_font_t *font);
+  HB_INTERNAL int get_plan_index (hb_shape_plan_t *shape_plan);
+  HB_INTERNAL void account (unsigned int plan_index,
+			    unsigned int num_words,
+			    unsigned int num_stored);
+  HB_INTERNAL bool insert (hb_bytes_t key, uint32_t hash,
+			   const hb_glyph_info_t *infos,
+			   const hb_glyph_position_t *positions,
+			   unsigned int num_glyphs,
+			   unsigned int base_cluster);
+};
+
+
+#endif /* HB_SHAPE_CACHE_HH */
@@ -165,11 +165,44 @@ hb_shape_plan_key_t::equal (const hb_shape_plan_key_t *other)
 	 this->shaper_func == other->shaper_func;
 }
 
+uint32_t
+hb_shape_plan_key_t::hash () const
+{
+  uint32_t h = hb_hash ((unsigned) props.direction);
+  h = h * 31 + hb_hash ((unsigned) props.script);
+  h = h * 31 + hb_hash ((uintptr_t) props.language);
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    const hb_feature_t &feature = user_features[i];
+    bool global = feature.start == HB_FEATURE_GLOBAL_START &&
+		  feature.end   == HB_FEATURE_GLOBAL_END;
+    h = h * 31 + hb_hash (feature.tag);
+    h = h * 31 + hb_hash (feature.value);
+    h = h * 31 + global;
+  }
+#ifndef HB_NO_OT_SHAPE
+  h = h * 31 + hb_hash (ot.variations_index[0]);
+  h = h * 31 + hb_hash (ot.variations_index[1]);
+#endif
+  h = h * 31 + hb_hash ((uintptr_t) shaper_func);
+  return h;
+}
+
 
 /*
  * hb_shape_plan_t
  */
 
+unsigned int
+hb_shape_plan_t::get_size () const
+{
+  size_t size = sizeof (*this) + key.num_user_features * sizeof (key.user_features[0]);
+#ifndef HB_NO_OT_SHAPE
+  size += ot.get_size ();
+#endif
+  return (unsigned) hb_min (size, (size_t) UINT_MAX);
+}
+
 
 /**
  * hb_shape_plan_create:
@@ -463,6 +496,144 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
  * Caching
  */
 
+hb_shape_plan_cache_t *
+hb_face_t::get_shape_plan_cache ()
+{
+retry:
+  hb_shape_plan_cache_t *cache = shape_plans.get_acquire ();
+  if (likely (cache))
+    return cache;
+
+  cache = hb_shape_plan_cache_t::create ();
+  if (unlikely (!cache))
+    return nullptr;
+
+  if (unlikely (!shape_plans.cmpexch (nullptr, cache)))
+  {
+    hb_shape_plan_cache_t::destroy (cache);
+    goto retry;
+  }
+  return cache;
+}
+
+void
+hb_shape_plan_cache_t::fini ()
+{
+  /* No locking; the face is being destroyed. */
+  for (shard_t &shard : shards)
+    shard.items.clear ();
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::fetch (hb_shape_plan_key_t *key, uint32_t hash)
+{
+  shard_t &shard = shards[hash % NUM_SHARDS];
+  hb_lock_t lock (shard.lock);
+
+  item_t *item = shard.items.fetch (key, hash);
+  if (item)
+  {
+    item->last_use = tick.inc ();
+    hits.inc ();
+    return hb_shape_plan_reference (item->shape_plan);
+  }
+
+  misses.inc ();
+  return nullptr;
+}
+
+/* Takes ownership of @shape_plan.  Returns a new reference to the plan
+ * that ends up in the cache, which might be a different, equal plan if
+ * another thread inserted one first. */
+hb_shape_plan_t *
+hb_shape_plan_cache_t::insert (hb_shape_plan_t *shape_plan, uint32_t hash)
+{
+  shard_t &shard = shards[hash % NUM_SHARDS];
+  hb_shape_plan_t *ret;
+  {
+    hb_lock_t lock (shard.lock);
+
+    item_t *item = shard.items.fetch (&shape_plan->key, hash);
+    if (item)
+    {
+      item->last_use = tick.inc ();
+      ret = hb_shape_plan_reference (item->shape_plan);
+      hb_shape_plan_destroy (shape_plan);
+      return ret;
+    }
+
+    item = (item_t *) hb_malloc (sizeof (item_t));
+    if (unlikely (!item))
+      return shape_plan;
+    item->shape_plan = shape_plan;
+    item->size = shape_plan->get_size ();
+    item->last_use = tick.inc ();
+
+    ret = hb_shape_plan_reference (shape_plan);
+    if (unlikely (!shard.items.insert (item, hash)))
+      return ret; /* The item, and the reference it held, are gone. */
+
+    num_plans.inc ();
+    num_bytes.add (item->size);
+  }
+
+  shrink ();
+  return ret;
+}
+
+/* Evicts the least-recently-used plan.  Shards are locked one at a
+ * time, so the choice of victim is a snapshot and might be slightly
+ * stale by the time it is evicted; that is fine for a cache. */
+bool
+hb_shape_plan_cache_t::evict_one ()
+{
+  unsigned now = tick;
+  unsigned best_age = 0;
+  shard_t *victim = nullptr;
+  for (shard_t &shard : shards)
+  {
+    hb_lock_t lock (shard.lock);
+    const item_t *item = shard.items.oldest ();
+    if (!item)
+      continue;
+    unsigned age = now - item->last_use; /* Wraps around fine. */
+    if (!victim || age > best_age)
+    {
+      best_age = age;
+      victim = &shard;
+    }
+  }
+  if (!victim)
+    return false;
+
+  hb_shape_plan_t *evicted = nullptr;
+  {
+    hb_lock_t lock (victim->lock);
+    item_t *item = victim->items.oldest ();
+    if (!item)
+      return true; /* Someone else got here first; let the caller retry. */
+
+    /* Destroyed below, outside the lock. */
+    evicted = hb_shape_plan_reference (item->shape_plan);
+    num_plans.dec ();
+    num_bytes.sub (item->size);
+    victim->items.remove (item);
+  }
+
+  DEBUG_MSG_FUNC (SHAPE_PLAN, evicted, "evicted from cache");
+  evictions.inc ();
+  hb_shape_plan_destroy (evicted);
+  return true;
+}
+
+void
+hb_shape_plan_cache_t::shrink ()
+{
+  while (over_limits () && evict_one ())
+    ;
+}
+
+
 /**
  * hb_shape_plan_create_cached:
  * @face: #hb_face_t to use
@@ -525,11 +696,10 @@ hb_shape_plan_create_cached2 (hb_face_t                     *face,
 		  num_user_features,
 		  shaper_list);
 
-retry:
-  hb_face_t::plan_node_t *cached_plan_nodes = face->shape_plans;
-
   bool dont_cache = !hb_object_is_valid (face);
 
+  hb_shape_plan_cache_t *cache = nullptr;
+  uint32_t hash = 0;
   if (likely (!dont_cache))
   {
     hb_shape_plan_key_t key;
@@ -543,12 +713,15 @@ retry:
 		   shaper_list))
       return hb_shape_plan_get_empty ();
 
-    for (hb_face_t::plan_node_t *node = cached_plan_nodes; node; node = node->next)
-      if (node->shape_plan->key.equal (&key))
-      {
-	DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "fulfilled from cache");
-	return hb_shape_plan_reference (node->shape_plan);
-      }
+    cache = face->get_shape_plan_cache ();
+    hash = key.hash ();
+
+    hb_shape_plan_t *shape_plan = cache ? cache->fetch (&key, hash) : nullptr;
+    if (shape_plan)
+    {
+      DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "fulfilled from cache");
+      return shape_plan;
+    }
   }
 
   hb_shape_plan_t *shape_plan = hb_shape_plan_create2 (face, props,
@@ -556,25 +729,70 @@ retry:
 						       coords, num_coords,
 						       shaper_list);
 
-  if (unlikely (dont_cache))
+  if (unlikely (!cache || !hb_object_is_valid (shape_plan)))
     return shape_plan;
 
-  hb_face_t::plan_node_t *node = (hb_face_t::plan_node_t *) hb_calloc (1, sizeof (hb_face_t::plan_node_t));
-  if (unlikely (!node))
-    return shape_plan;
+  shape_plan = cache->insert (shape_plan, hash);
+  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
 
-  node->shape_plan = shape_plan;
-  node->next = cached_plan_nodes;
+  return shape_plan;
+}
 
-  if (unlikely (!face->shape_plans.cmpexch (cached_plan_nodes, node)))
-  {
-    hb_shape_plan_destroy (shape_plan);
-    hb_free (node);
-    goto retry;
-  }
-  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
+/**
+ * hb_shape_plan_cache_set_limits:
+ * @face: #hb_face_t to use
+ * @max_plans: The maximum number of shaping plans to keep, or zero for no limit
+ * @max_bytes: The approximate maximum memory, in bytes, used by the kept
+ * shaping plans, or zero for no limit
+ *
+ * Sets the limits of the shaping-plan cache of @face, which is used by
+ * hb_shape_plan_create_cached() and hence hb_shape(). When adding a plan
+ * makes the cache exceed either limit, the least-recently-used plans are
+ * evicted. Plans that are still referenced elsewhere stay valid.
+ *
+ * Lowering the limits evicts plans immediately as needed.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_plan_cache_set_limits (hb_face_t    *face,
+				unsigned int  max_plans,
+				unsigned int  max_bytes)
+{
+  if (unlikely (!hb_object_is_valid (face)))
+    return;
+
+  hb_shape_plan_cache_t *cache = face->get_shape_plan_cache ();
+  if (unlikely (!cache))
+    return;
+
+  cache->max_plans = max_plans;
+  cache->max_bytes = max_bytes;
+  cache->shrink ();
+}
+
+/**
+ * hb_shape_plan_cache_get_stats:
+ * @face: #hb_face_t to use
+ * @hits: (out) (optional): Number of lookups fulfilled from the cache
+ * @misses: (out) (optional): Number of lookups not fulfilled from the cache
+ * @evictions: (out) (optional): Number of plans evicted from the cache
+ *
+ * Fetches usage statistics of the shaping-plan cache of @face.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_plan_cache_get_stats (hb_face_t    *face,
+			       unsigned int *hits,      /* OUT. May be NULL. */
+			       unsigned int *misses,    /* OUT. May be NULL. */
+			       unsigned int *evictions  /* OUT. May be NULL. */)
+{
+  hb_shape_plan_cache_t *cache = face->shape_plans.get_acquire ();
 
-  return hb_shape_plan_reference (shape_plan);
+  if (hits) *hits = cache ? cache->hits.get_relaxed () : 0;
+  if (misses) *misses = cache ? cache->misses.get_relaxed () : 0;
+  if (evictions) *evictions = cache ? cache->evictions.get_relaxed () : 0;
 }
 
 
@@ -28,6 +28,7 @@
 #define HB_SHAPE_PLAN_HH
 
 #include "hb.hh"
+#include "hb-cache.hh"
 #include "hb-shaper.hh"
 #include "hb-ot-shape.hh"
 
@@ -60,6 +61,8 @@ struct hb_shape_plan_key_t
   HB_INTERNAL bool user_features_match (const hb_shape_plan_key_t *other);
 
   HB_INTERNAL bool equal (const hb_shape_plan_key_t *other);
+
+  HB_INTERNAL uint32_t hash () const;
 };
 
 struct hb_shape_plan_t
@@ -71,6 +74,88 @@ struct hb_shape_plan_t
 #ifndef HB_NO_OT_SHAPE
   hb_ot_shape_plan_t ot;
 #endif
+
+  HB_INTERNAL unsigned int get_size () const;
+};
+
+
+/*
+ * hb_shape_plan_cache_t
+ *
+ * Per-face cache of shape plans.  Plans are hashed into a fixed number
+ * of shards, each protected by its own lock, so that lookups from
+ * different threads rarely contend.  The cache is bounded by a number
+ * of plans and an approximate byte budget; when either is exceeded the
+ * least-recently-used plan is evicted.  Evicted plans stay alive for as
+ * long as callers hold references to them.
+ */
+
+struct hb_shape_plan_cache_t
+{
+  static constexpr unsigned NUM_SHARDS = 8;
+
+  static hb_shape_plan_cache_t *create ()
+  {
+    hb_shape_plan_cache_t *cache = (hb_shape_plan_cache_t *) hb_calloc (1, sizeof (hb_shape_plan_cache_t));
+    if (unlikely (!cache)) return cache;
+    new (cache) hb_shape_plan_cache_t ();
+    return cache;
+  }
+
+  static void destroy (hb_shape_plan_cache_t *cache)
+  {
+    if (!cache) return;
+    cache->~hb_shape_plan_cache_t ();
+    hb_free (cache);
+  }
+
+  ~hb_shape_plan_cache_t () { fini (); }
+
+  struct item_t : hb_lru_link_t
+  {
+    hb_shape_plan_t *shape_plan;
+    unsigned size;
+    unsigned last_use;
+
+    size_t get_size () const { return size; }
+    bool equal (const hb_shape_plan_key_t *key) const { return shape_plan->key.equal (key); }
+    void fini () { hb_shape_plan_destroy (shape_plan); }
+  };
+
+  struct shard_t
+  {
+    hb_mutex_t lock;
+    hb_lru_cache_t<item_t> items;
+  };
+
+  HB_INTERNAL void fini ();
+
+  HB_INTERNAL hb_shape_plan_t *fetch (hb_shape_plan_key_t *key, uint32_t hash);
+  HB_INTERNAL hb_shape_plan_t *insert (hb_shape_plan_t *shape_plan, uint32_t hash);
+  HB_INTERNAL void shrink ();
+
+  private:
+  HB_INTERNAL bool evict_one ();
+
+  bool over_limits () const
+  {
+    unsigned max_p = max_plans;
+    unsigned max_b = max_bytes;
+    return (max_p && num_plans > max_p) ||
+	   (max_b && num_bytes > max_b);
+  }
+
+  public:
+  shard_t shards[NUM_SHARDS];
+  hb_atomic_t<unsigned> tick;
+  hb_atomic_t<unsigned> num_plans;
+  hb_atomic_t<unsigned> num_bytes;
+  hb_atomic_t<unsigned> max_plans {HB_SHAPE_PLAN_CACHE_MAX_PLANS_DEFAULT};
+  hb_atomic_t<unsigned> max_bytes {HB_SHAPE_PLAN_CACHE_MAX_BYTES_DEFAULT};
+
+  hb_atomic_t<unsigned> hits;
+  hb_atomic_t<unsigned> misses;
+  hb_atomic_t<unsigned> evictions;
 };
 
 
@@ -33,6 +33,7 @@
 #include "hb-buffer.hh"
 #include "hb-font.hh"
 #include "hb-machinery.hh"
+#include "hb-parallel.hh"
 
 
 #ifndef HB_NO_SHAPER
@@ -194,6 +195,199 @@ hb_shape (hb_font_t           *font,
   hb_shape_full (font, buffer, features, num_features, nullptr);
 }
 
+/* Shapes buffers one at a time, reusing the plans resolved so far;
+ * typically only one or two distinct ones are ever needed. */
+struct hb_shape_batch_t
+{
+  hb_shape_batch_t (const hb_feature_t *features_,
+		    unsigned int        num_features_,
+		    const char * const *shaper_list_) :
+    features (features_), num_features (num_features_), shaper_list (shaper_list_) {}
+
+  ~hb_shape_batch_t ()
+  {
+    for (hb_shape_plan_t *plan : plans)
+      hb_shape_plan_destroy (plan);
+  }
+
+  bool shape (hb_font_t *font, hb_buffer_t *buffer)
+  {
+    if (unlikely (!buffer->len))
+      return true;
+
+    if (unlikely (buffer->flags & HB_BUFFER_FLAG_VERIFY))
+      return hb_shape_full (font, buffer, features, num_features, shaper_list);
+
+    if (!shape_plan ||
+	!hb_segment_properties_equal (&shape_plan->key.props, &buffer->props))
+    {
+      shape_plan = nullptr;
+      for (hb_shape_plan_t *plan : plans)
+	if (hb_segment_properties_equal (&plan->key.props, &buffer->props))
+	{
+	  shape_plan = plan;
+	  break;
+	}
+      if (!shape_plan)
+      {
+	shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+						   features, num_features,
+						   font->coords, font->num_coords,
+						   shaper_list);
+	plans.push (shape_plan);
+	if (unlikely (plans.in_error ()))
+	{
+	  /* Allocation failure; shape this one unbatched. */
+	  hb_shape_plan_destroy (shape_plan);
+	  shape_plan = nullptr;
+	  return hb_shape_full (font, buffer, features, num_features, shaper_list);
+	}
+      }
+    }
+
+    buffer->enter ();
+    bool ret = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+    buffer->leave ();
+    return ret;
+  }
+
+  const hb_feature_t *features;
+  unsigned int num_features;
+  const char * const *shaper_list;
+  hb_vector_t<hb_shape_plan_t *> plans;
+  hb_shape_plan_t *shape_plan = nullptr;
+};
+
+/**
+ * hb_shape_batch:
+ * @font: an #hb_font_t to use for shaping
+ * @buffers: (array length=num_buffers): an array of #hb_buffer_t to shape
+ * @num_buffers: the length of @buffers array
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ *
+ * Shapes each of @buffers with @font, as if by calling hb_shape_full() on
+ * each of them in turn, using the same @features and @shaper_list for all.
+ * The buffers may have differing segment properties.
+ *
+ * This is faster than shaping the buffers one by one when there are many
+ * short buffers, since the shaping plans are resolved only once per
+ * distinct set of segment properties in the batch.
+ *
+ * Return value: false if all shapers failed for any of the buffers, true
+ * otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_batch (hb_font_t          *font,
+		hb_buffer_t * const *buffers,
+		unsigned int        num_buffers,
+		const hb_feature_t *features,
+		unsigned int        num_features,
+		const char * const *shaper_list)
+{
+  hb_bool_t ret = true;
+
+  hb_shape_batch_t batch (features, num_features, shaper_list);
+  for (unsigned int i = 0; i < num_buffers; i++)
+    ret = batch.shape (font, buffers[i]) && ret;
+
+  return ret;
+}
+
+/**
+ * hb_shape_parallel:
+ * @font: an #hb_font_t to use for shaping
+ * @buffers: (array length=num_buffers): an array of #hb_buffer_t to shape
+ * @num_buffers: the length of @buffers array
+ * @features: (array length=num_features) (nullable): an array of user
+ *    specified #hb_feature_t or `NULL`
+ * @num_features: the length of @features array
+ * @shaper_list: (array zero-terminated=1) (nullable): a `NULL`-terminated
+ *    array of shapers to use or `NULL`
+ * @num_threads: maximum number of threads to use, or 0 for one per
+ *    available processor
+ *
+ * Like hb_shape_batch(), but spreads the buffers over up to @num_threads
+ * threads, the calling thread included.  Returns when all buffers are
+ * shaped.
+ *
+ * The font and face are shared between the threads and must not be
+ * modified while this function runs; each buffer is only touched by one
+ * thread.  If @font uses the OpenType font functions, each thread gets
+ * its own glyph advance and origin caches, so threads do not contend on
+ * them.  Font functions set by the user must be thread-safe.
+ *
+ * If HarfBuzz was built without thread support this is the same as
+ * hb_shape_batch().
+ *
+ * Return value: false if all shapers failed for any of the buffers, true
+ * otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_parallel (hb_font_t          *font,
+		   hb_buffer_t * const *buffers,
+		   unsigned int        num_buffers,
+		   const hb_feature_t *features,
+		   unsigned int        num_features,
+		   const char * const *shaper_list,
+		   unsigned int        num_threads)
+{
+  num_threads = hb_min (hb_parallel_num_threads (num_threads), hb_max (num_buffers, 1u));
+  if (num_threads == 1)
+    return hb_shape_batch (font, buffers, num_buffers, features, num_features, shaper_list);
+
+  struct worker_t
+  {
+    hb_font_t *font;
+    hb_shape_batch_t *batch;
+  };
+  hb_vector_t<worker_t> workers;
+  if (unlikely (!workers.resize (num_threads)))
+    return hb_shape_batch (font, buffers, num_buffers, features, num_features, shaper_list);
+
+  hb_atomic_t<int> failed {0};
+  bool ret = hb_parallel_for (num_threads, num_buffers,
+			      [&] (unsigned worker, unsigned i)
+  {
+    worker_t &w = workers.arrayZ[worker];
+    if (unlikely (!w.font))
+    {
+      /* Worker zero runs on the calling thread and can use the font
+       * as is; the others get a font of their own. */
+      w.font = worker ? _hb_font_create_for_thread (font) : hb_font_reference (font);
+      w.batch = (hb_shape_batch_t *) hb_malloc (sizeof (hb_shape_batch_t));
+      if (likely (w.batch))
+	new (w.batch) hb_shape_batch_t (features, num_features, shaper_list);
+    }
+    bool ok = likely (w.batch) ? w.batch->shape (w.font, buffers[i])
+			       : hb_shape_full (w.font, buffers[i], features, num_features, shaper_list);
+    if (unlikely (!ok))
+      failed.set_relaxed (1);
+  });
+
+  for (worker_t &w : workers)
+  {
+    if (w.batch)
+    {
+      w.batch->~hb_shape_batch_t ();
+      hb_free (w.batch);
+    }
+    hb_font_destroy (w.font);
+  }
+
+  if (unlikely (!ret))
+    return hb_shape_batch (font, buffers, num_buffers, features, num_features, shaper_list);
+
+  return !failed.get_relaxed ();
+}
+
 
 #ifdef HB_EXPERIMENTAL_API
 #ifndef HB_NO_VAR
@@ -53,6 +53,59 @@ hb_shape_full (hb_font_t          *font,
 	       unsigned int        num_features,
 	       const char * const *shaper_list);
 
+HB_EXTERN hb_bool_t
+hb_shape_batch (hb_font_t          *font,
+		hb_buffer_t * const *buffers,
+		unsigned int        num_buffers,
+		const hb_feature_t *features,
+		unsigned int        num_features,
+		const char * const *shaper_list);
+
+HB_EXTERN hb_bool_t
+hb_shape_parallel (hb_font_t          *font,
+		   hb_buffer_t * const *buffers,
+		   unsigned int        num_buffers,
+		   const hb_feature_t *features,
+		   unsigned int        num_features,
+		   const char * const *shaper_list,
+		   unsigned int        num_threads);
+
+/**
+ * hb_shape_cache_t:
+ *
+ * Data type for holding shaping results of words, for reuse by
+ * hb_shape_cached().
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_shape_cache_t hb_shape_cache_t;
+
+HB_EXTERN hb_shape_cache_t *
+hb_shape_cache_create (void);
+
+HB_EXTERN hb_shape_cache_t *
+hb_shape_cache_reference (hb_shape_cache_t *cache);
+
+HB_EXTERN void
+hb_shape_cache_destroy (hb_shape_cache_t *cache);
+
+HB_EXTERN void
+hb_shape_cache_set_max_bytes (hb_shape_cache_t *cache,
+			      unsigned int      max_bytes);
+
+HB_EXTERN void
+hb_shape_cache_get_stats (hb_shape_cache_t *cache,
+			  unsigned int     *hits,
+			  unsigned int     *misses);
+
+HB_EXTERN hb_bool_t
+hb_shape_cached (hb_font_t          *font,
+		 hb_buffer_t        *buffer,
+		 const hb_feature_t *features,
+		 unsigned int        num_features,
+		 const char * const *shaper_list,
+		 hb_shape_cache_t   *cache);
+
 #ifdef HB_EXPERIMENTAL_API
 HB_EXTERN hb_bool_t
 hb_shape_justify (hb_font_t          *font,
@@ -0,0 +1,316 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+
+#ifdef HB_EXPERIMENTAL_API
+
+#include "hb-subset-cache.hh"
+#include "hb-subset-input.hh"
+#include "hb-blob.hh"
+
+
+hb_subset_cache_entry_t *
+hb_subset_cache_t::fetch (hb_face_t *source, hb_bytes_t key, uint32_t hash)
+{
+  return entries.fetch (hb_pair_t<hb_face_t *, hb_bytes_t> (source, key), hash);
+}
+
+void
+hb_subset_cache_t::insert (hb_face_t *source,
+			   hb_bytes_t key,
+			   uint32_t hash,
+			   hb_blob_t *result)
+{
+  if (fetch (source, key, hash))
+    return; /* Another thread got here first. */
+
+  size_t size = sizeof (hb_subset_cache_entry_t) + key.length + hb_blob_get_length (result);
+  if (size > max_bytes)
+    return;
+  entries.evict (max_bytes - size);
+
+  hb_subset_cache_entry_t *entry = (hb_subset_cache_entry_t *) hb_malloc (sizeof (hb_subset_cache_entry_t) + key.length);
+  if (unlikely (!entry))
+    return;
+  entry->source = hb_face_reference (source);
+  entry->result = hb_blob_reference (result);
+  entry->key_length = key.length;
+  hb_memcpy ((char *) entry->key ().arrayZ, key.arrayZ, key.length);
+
+  entries.insert (entry, hash);
+}
+
+
+/**
+ * hb_subset_cache_create_or_fail:
+ *
+ * Creates a new, empty, subset result cache, for use with
+ * hb_subset_cached_or_fail().
+ *
+ * The cache can hold results for any number of source faces.  It is
+ * thread-safe: the same cache can be used by several threads at once.
+ *
+ * Return value: (transfer full): Newly-created subset result cache, or
+ * `NULL` on allocation failure.  Destroy with hb_subset_cache_destroy().
+ *
+ * XSince: EXPERIMENTAL
+ **/
+hb_subset_cache_t *
+hb_subset_cache_create_or_fail (void)
+{
+  return hb_object_create<hb_subset_cache_t> ();
+}
+
+/**
+ * hb_subset_cache_reference: (skip)
+ * @cache: A subset result cache
+ *
+ * Increases the reference count on @cache by one.
+ *
+ * Return value: (transfer full): The referenced cache.
+ *
+ * XSince: EXPERIMENTAL
+ **/
+hb_subset_cache_t *
+hb_subset_cache_reference (hb_subset_cache_t *cache)
+{
+  return hb_object_reference (cache);
+}
+
+/**
+ * hb_subset_cache_destroy: (skip)
+ * @cache: A subset result cache
+ *
+ * Decreases the reference count on @cache by one.  When the
+ * reference count reaches zero, the cache is destroyed, freeing
+ * all memory and releasing the source faces it holds.
+ *
+ * XSince: EXPERIMENTAL
+ **/
+void
+hb_subset_cache_destroy (hb_subset_cache_t *cache)
+{
+  if (!hb_object_destroy (cache)) return;
+
+  hb_free (cache);
+}
+
+/**
+ * hb_subset_cache_set_max_bytes:
+ * @cache: A subset result cache
+ * @max_bytes: The memory budget, in bytes
+ *
+ * Sets the amount of memory the subset fonts held by @cache may take.
+ * Least-recently used results are dropped to stay within it.  Zero
+ * disables caching and drops all results.
+ *
+ * The budget does not cover the source faces, which each result holds
+ * a reference to.
+ *
+ * XSince: EXPERIMENTAL
+ **/
+void
+hb_subset_cache_set_max_bytes (hb_subset_cache_t *cache,
+			       unsigned int       max_bytes)
+{
+  if (unlikely (!cache)) return;
+
+  hb_lock_t lock (cache->lock);
+  cache->max_bytes = max_bytes;
+  cache->entries.evict (max_bytes);
+}
+
+/**
+ * hb_subset_cache_get_stats:
+ * @cache: A subset result cache
+ * @hits: (out) (optional): Number of requests answered from the cache
+ * @misses: (out) (optional): Number of requests that had to be subset
+ *
+ * Fetches how many requests hb_subset_cached_or_fail() has looked up
+ * in @cache so far, by outcome.
+ *
+ * XSince: EXPERIMENTAL
+ **/
+void
+hb_subset_cache_get_stats (hb_subset_cache_t *cache,
+			   unsigned int      *hits,
+			   unsigned int      *misses)
+{
+  unsigned int h = 0, m = 0;
+  if (likely (cache))
+  {
+    hb_lock_t lock (cache->lock);
+    h = cache->hits;
+    m = cache->misses;
+  }
+  if (hits) *hits = h;
+  if (misses) *misses = m;
+}
+
+
+/* Writes the key for @input: its normalized string form, then what that
+ * leaves out.  Returns false on allocation failure. */
+static bool
+_hb_subset_cache_key (const hb_subset_input_t *input,
+		      hb_vector_t<char> &key)
+{
+  hb_blob_t *str = hb_subset_input_to_string_or_fail (const_cast<hb_subset_input_t *> (input));
+  if (unlikely (!str))
+    return false;
+  key.extend (str->as_bytes ());
+  hb_blob_destroy (str);
+
+  auto append = [&] (const void *p, unsigned size)
+  { key.extend (hb_bytes_t ((const char *) p, size)); };
+
+  key.push (input->force_long_loca);
+
+  /* The string form prints axis positions to six significant digits;
+   * nearby positions give different fonts, so add them exactly. */
+  hb_vector_t<hb_tag_t> axis_tags;
+  for (hb_tag_t tag : input->axes_location.keys ())
+    axis_tags.push (tag);
+  axis_tags.qsort ([] (const hb_tag_t &a, const hb_tag_t &b) { return a < b ? -1 : a > b ? 1 : 0; });
+  for (hb_tag_t tag : axis_tags)
+  {
+    Triple triple = input->axes_location.get (tag);
+    append (&tag, sizeof (tag));
+    append (&triple.minimum, sizeof (triple.minimum));
+    append (&triple.middle, sizeof (triple.middle));
+    append (&triple.maximum, sizeof (triple.maximum));
+  }
+
+  hb_vector_t<hb_ot_name_record_ids_t> name_records;
+  for (const hb_ot_name_record_ids_t &ids : input->name_table_overrides.keys ())
+    name_records.push (ids);
+  name_records.qsort ([] (const hb_ot_name_record_ids_t &a, const hb_ot_name_record_ids_t &b)
+  {
+    if (a.platform_id != b.platform_id) return a.platform_id < b.platform_id ? -1 : 1;
+    if (a.encoding_id != b.encoding_id) return a.encoding_id < b.encoding_id ? -1 : 1;
+    if (a.language_id != b.language_id) return a.language_id < b.language_id ? -1 : 1;
+    if (a.name_id != b.name_id) return a.name_id < b.name_id ? -1 : 1;
+    return 0;
+  });
+  for (const hb_ot_name_record_ids_t &ids : name_records)
+  {
+    hb_bytes_t name = input->name_table_overrides.get (ids);
+    unsigned length = name.length;
+    append (&ids.platform_id, sizeof (ids.platform_id));
+    append (&ids.encoding_id, sizeof (ids.encoding_id));
+    append (&ids.language_id, sizeof (ids.language_id));
+    append (&ids.name_id, sizeof (ids.name_id));
+    append (&length, sizeof (length));
+    append (name.arrayZ, length);
+  }
+
+  return likely (!key.in_error () && !axis_tags.in_error () && !name_records.in_error ());
+}
+
+/**
+ * hb_subset_cached_or_fail:
+ * @source: font face data to be subset.
+ * @input: input to use for the subsetting.
+ * @cache: (nullable): a subset result cache, or `NULL`
+ *
+ * Subsets a font like hb_subset_or_fail() does, reusing the result of
+ * an earlier call with the same @source and equal @input, stored in
+ * @cache.
+ *
+ * Inputs are compared by their settings, not by identity: two
+ * #hb_subset_input_t objects set up the same way find the same result.
+ * The #hb_subset_depend_t attached to @input, if any, is not part of the
+ * comparison, as it does not change the result.  @source is compared
+ * by identity, and must not be modified while results for it are in
+ * @cache.  Failed subsets are not stored.
+ *
+ * When several threads subset the same font with the same input at
+ * once, each may do the work; only one result is kept.
+ *
+ * The returned face is created from the serialized subset font; use
+ * hb_face_reference_blob() to get at the font data without copying it.
+ * Inputs that ask for subsetter accelerator data to be attached to the
+ * result, as hb_subset_preprocess() does, are subset without the cache,
+ * since that data lives with the face, not the font data.
+ *
+ * Return value: (transfer full): A new #hb_face_t, or `NULL` if the
+ * subset operation fails or the face has no glyphs.  Destroy with
+ * hb_face_destroy().
+ *
+ * XSince: EXPERIMENTAL
+ **/
+hb_face_t *
+hb_subset_cached_or_fail (hb_face_t               *source,
+			  const hb_subset_input_t *input,
+			  hb_subset_cache_t       *cache)
+{
+  if (unlikely (!input || !source)) return nullptr;
+
+  hb_vector_t<char> key;
+  if (!cache ||
+      input->attach_accelerator_data ||
+      unlikely (!_hb_subset_cache_key (input, key)))
+    return hb_subset_or_fail (source, input);
+
+  hb_bytes_t key_bytes = hb_bytes_t (key.arrayZ, key.length);
+  uint32_t hash = key_bytes.hash () * 31 + hb_hash ((uintptr_t) source);
+
+  hb_blob_t *blob = nullptr;
+  {
+    hb_lock_t lock (cache->lock);
+    hb_subset_cache_entry_t *entry = cache->fetch (source, key_bytes, hash);
+    if (entry)
+    {
+      cache->hits++;
+      blob = hb_blob_reference (entry->result);
+    }
+    else
+      cache->misses++;
+  }
+
+  if (!blob)
+  {
+    hb_face_t *result = hb_subset_or_fail (source, input);
+    if (unlikely (!result))
+      return nullptr;
+    blob = hb_face_reference_blob (result);
+    hb_face_destroy (result);
+    if (unlikely (!hb_blob_get_length (blob)))
+    {
+      hb_blob_destroy (blob);
+      return nullptr;
+    }
+    hb_blob_make_immutable (blob);
+
+    hb_lock_t lock (cache->lock);
+    cache->insert (source, key_bytes, hash, blob);
+  }
+
+  hb_face_t *face = hb_face_create_or_fail (blob, 0);
+  hb_blob_destroy (blob);
+  return face;
+}
+
+
+#endif
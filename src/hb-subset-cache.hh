@@ -0,0 +1,88 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_SUBSET_CACHE_HH
+#define HB_SUBSET_CACHE_HH
+
+#include "hb.hh"
+
+#include "hb-subset.h"
+#include "hb-cache.hh"
+#include "hb-mutex.hh"
+
+
+/*
+ * Subset result cache.
+ *
+ * Results are keyed by the source face and the subset input, the latter
+ * written out in the normalized form hb_subset_input_to_string_or_fail()
+ * produces, followed by the few input fields that form leaves out.  Each
+ * entry holds a reference to its source face, so a face pointer in a key
+ * can not come to mean another face while the entry lives.
+ */
+
+struct hb_subset_cache_entry_t : hb_lru_link_t
+{
+  hb_face_t *source;
+  hb_blob_t *result;
+  unsigned int key_length;
+
+  /* The key follows. */
+  hb_bytes_t key () const { return hb_bytes_t ((const char *) (this + 1), key_length); }
+
+  unsigned int get_size () const
+  { return sizeof (*this) + key_length + hb_blob_get_length (result); }
+
+  bool equal (const hb_pair_t<hb_face_t *, hb_bytes_t> &key_) const
+  { return source == key_.first && key () == key_.second; }
+  void fini ()
+  {
+    hb_face_destroy (source);
+    hb_blob_destroy (result);
+  }
+};
+
+struct hb_subset_cache_t
+{
+  hb_object_header_t header;
+
+  hb_mutex_t lock;
+
+  hb_lru_cache_t<hb_subset_cache_entry_t> entries;
+  size_t max_bytes = HB_SUBSET_CACHE_MAX_BYTES_DEFAULT;
+
+  unsigned int hits = 0;
+  unsigned int misses = 0;
+
+  HB_INTERNAL hb_subset_cache_entry_t *fetch (hb_face_t *source,
+					      hb_bytes_t key,
+					      uint32_t hash);
+  HB_INTERNAL void insert (hb_face_t *source,
+			   hb_bytes_t key,
+			   uint32_t hash,
+			   hb_blob_t *result);
+};
+
+
+#endif /* HB_SUBSET_CACHE_HH */
@@ -1181,6 +1181,56 @@ hb_subset_input_old_to_new_glyph_mapping (hb_subset_input_t *input)
   return &input->glyph_map;
 }
 
+#ifndef HB_NO_SUBSET_DEPEND
+/**
+ * hb_subset_input_set_depend:
+ * @input: a #hb_subset_input_t object.
+ * @depend: (nullable): a #hb_subset_depend_t built from the face to be
+ * subset, or `NULL`.
+ *
+ * Attaches a glyph dependency graph, as returned by
+ * hb_subset_depend_from_face_or_fail() for the face being subset, to
+ * @input.  Subsetting then computes the GSUB glyph closure by walking the
+ * graph rather than by applying each lookup's closure, which is much
+ * faster when the same face is subset many times.
+ *
+ * The result is the same as without the graph: where the graph can not
+ * tell whether an edge applies, and when instancing, the regular closure
+ * is used.  The regular closure is also used when walking the graph
+ * would take more stages or operations than the limits the regular
+ * closure applies to itself.  A graph built from a different face is
+ * ignored.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_input_set_depend (hb_subset_input_t  *input,
+			    hb_subset_depend_t *depend)
+{
+  hb_subset_depend_reference (depend);
+  hb_subset_depend_destroy (input->depend);
+  input->depend = depend;
+}
+
+/**
+ * hb_subset_input_get_depend:
+ * @input: a #hb_subset_input_t object.
+ *
+ * Gets the glyph dependency graph attached to @input with
+ * hb_subset_input_set_depend().
+ *
+ * Return value: (transfer none) (nullable): the attached
+ * #hb_subset_depend_t, or `NULL`.
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_depend_t *
+hb_subset_input_get_depend (hb_subset_input_t *input)
+{
+  return input->depend;
+}
+#endif
+
 #ifdef HB_EXPERIMENTAL_API
 /**
  * hb_subset_input_override_name_table:
@@ -92,6 +92,9 @@ struct hb_subset_input_t
 #ifdef HB_EXPERIMENTAL_API
     for (auto _ : name_table_overrides.values ())
       _.fini ();
+#endif
+#ifndef HB_NO_SUBSET_DEPEND
+    hb_subset_depend_destroy (depend);
 #endif
   }
 
@@ -124,6 +127,9 @@ struct hb_subset_input_t
 #ifdef HB_EXPERIMENTAL_API
   hb_hashmap_t<hb_ot_name_record_ids_t, hb_bytes_t> name_table_overrides;
 #endif
+#ifndef HB_NO_SUBSET_DEPEND
+  hb_subset_depend_t *depend = nullptr;
+#endif
 
   inline unsigned num_sets () const
   {
@@ -29,6 +29,7 @@
 #include "hb-ot-layout-gdef-table.hh"
 #include "hb-ot-layout-gpos-table.hh"
 #include "hb-ot-layout-gsub-table.hh"
+#include "hb-depend.hh"
 
 using OT::Layout::GSUB;
 using OT::Layout::GPOS;
@@ -283,10 +284,42 @@ remap_feature_indices (const hb_set_t &feature_indices,
   }
 }
 
+/*
+ * Closes gids_to_retain over GSUB by walking the depend graph attached to
+ * the plan.  The graph holds the lookups of every script's features, with
+ * no instancing, so it only stands in for the lookup closure when all
+ * scripts are kept and no axis is restricted.  Returns false if the
+ * lookup closure is still needed.
+ */
+template <typename T>
+static bool
+_depend_substitute_closure (hb_subset_plan_t *plan,
+			    const T          &table,
+			    hb_set_t         *gids_to_retain)
+{
+#ifndef HB_NO_SUBSET_DEPEND
+  hb_subset_depend_t *depend = plan->depend;
+  if (!depend ||
+      depend->get_glyph_count () != plan->source->get_num_glyphs () ||
+      !plan->user_axes_location.is_empty ())
+    return false;
+
+  unsigned num_scripts = table.get_script_count ();
+  for (unsigned i = 0; i < num_scripts; i++)
+    if (!plan->layout_scripts.has (table.get_script_tag (i)))
+      return false;
+
+  return depend->gsub_closure (&plan->layout_features, gids_to_retain);
+#else
+  return false;
+#endif
+}
+
 template <typename T>
 static void
 _closure_glyphs_lookups_features (hb_subset_plan_t   *plan,
 				 hb_set_t	     *gids_to_retain,
+				 bool		      gids_closed,
 				 hb_map_t	     *lookups,
 				 hb_map_t	     *features,
 				 hb_map_t	     *features_w_duplicates,
@@ -308,7 +341,9 @@ _closure_glyphs_lookups_features (hb_subset_plan_t   *plan,
                               catch_all_record_feature_idxes,
                               catch_all_record_idx_feature_map);
 
-  if (table_tag == HB_OT_TAG_GSUB && !(plan->flags & HB_SUBSET_FLAGS_NO_LAYOUT_CLOSURE))
+  if (table_tag == HB_OT_TAG_GSUB && !gids_closed &&
+      !(plan->flags & HB_SUBSET_FLAGS_NO_LAYOUT_CLOSURE) &&
+      !_depend_substitute_closure (plan, *table, gids_to_retain))
     hb_ot_layout_lookups_substitute_closure (plan->source,
                                              &lookup_indices,
 					     gids_to_retain);
@@ -351,12 +386,14 @@ void layout_nameid_closure (hb_subset_plan_t* plan,
 
 void
 layout_populate_gids_to_retain (hb_subset_plan_t* plan,
-		                hb_set_t* drop_tables) {
+		                hb_set_t* drop_tables,
+		                bool glyphs_closed) {
   if (!drop_tables->has (HB_OT_TAG_GSUB))
     // closure all glyphs/lookups/features needed for GSUB substitutions.
     _closure_glyphs_lookups_features<GSUB> (
         plan,
         &plan->_glyphset_gsub,
+        glyphs_closed,
         &plan->gsub_lookups,
         &plan->gsub_features,
         &plan->gsub_features_w_duplicates,
@@ -370,6 +407,7 @@ layout_populate_gids_to_retain (hb_subset_plan_t* plan,
     _closure_glyphs_lookups_features<GPOS> (
         plan,
         &plan->_glyphset_gsub,
+        true,
         &plan->gpos_lookups,
         &plan->gpos_features,
         &plan->gpos_features_w_duplicates,
@@ -52,6 +52,12 @@ HB_SUBSET_PLAN_MEMBER (hb_set_t, layout_scripts)
 //glyph ids requested to retain
 HB_SUBSET_PLAN_MEMBER (hb_set_t, glyphs_requested)
 
+// unicodes, name_ids and glyph mapping as given in the input; kept so the
+// plan can be extended.
+HB_SUBSET_PLAN_MEMBER (hb_set_t, unicodes_requested)
+HB_SUBSET_PLAN_MEMBER (hb_set_t, name_ids_requested)
+HB_SUBSET_PLAN_MEMBER (hb_map_t, glyph_map_requested)
+
 // Tables which should not be processed, just pass them through.
 HB_SUBSET_PLAN_MEMBER (hb_set_t, no_subset_tables)
 
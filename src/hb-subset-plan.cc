@@ -385,6 +385,57 @@ _populate_unicodes_to_retain (const hb_set_t *unicodes_in,
   ;
 }
 
+/*
+ * Merges the unicode mapping of the plan being extended into @plan, whose
+ * mapping so far only covers the unicodes and glyphs added since.
+ */
+static void
+_merge_unicodes_to_retain (const hb_subset_plan_t *base,
+			   hb_subset_plan_t *plan)
+{
+  const auto &base_arr = base->unicode_to_new_gid_list;
+  const auto &delta_arr = plan->unicode_to_new_gid_list;
+
+  /* Both lists are sorted by unicode; the base one has been remapped to
+   * new gids already, so map those back. */
+  hb_sorted_vector_t<hb_codepoint_pair_t> arr;
+  if (unlikely (!plan->check_success (arr.alloc (base_arr.length + delta_arr.length))))
+    return;
+  unsigned i = 0, j = 0;
+  while (i < base_arr.length || j < delta_arr.length)
+  {
+    if (j == delta_arr.length ||
+	(i < base_arr.length && base_arr.arrayZ[i].first < delta_arr.arrayZ[j].first))
+    {
+      hb_codepoint_t cp = base_arr.arrayZ[i].first;
+      arr.push (hb_pair (cp, base->reverse_glyph_map->get (base_arr.arrayZ[i].second)));
+      i++;
+      continue;
+    }
+    if (i < base_arr.length && base_arr.arrayZ[i].first == delta_arr.arrayZ[j].first)
+      i++;
+    arr.push (delta_arr.arrayZ[j++]);
+  }
+
+  plan->codepoint_to_glyph->alloc (arr.length);
+  for (const auto &_ : arr)
+    plan->codepoint_to_glyph->set (_.first, _.second);
+  hb_swap (plan->unicode_to_new_gid_list, arr);
+
+  /* Variation selectors of both, which are not counted for OS/2. */
+  hb_set_t unicodes;
+  auto &list = plan->unicode_to_new_gid_list;
+  if (list.length)
+    unicodes.add_sorted_array (&list.arrayZ->first, list.length, sizeof (*list.arrayZ));
+  plan->os2_info.min_cmap_codepoint = unicodes.get_min();
+  plan->os2_info.max_cmap_codepoint = unicodes.get_max();
+
+  plan->unicodes.union_ (base->unicodes);
+  plan->unicodes.union_ (unicodes);
+
+  plan->_glyphset_gsub.union_ (base->_glyphset_cmaped);
+}
+
 static unsigned
 _glyf_add_gid_and_children (const OT::glyf_accelerator_t &glyf,
 			    hb_codepoint_t gid,
@@ -437,7 +488,8 @@ _nameid_closure (hb_subset_plan_t* plan,
 
 static void
 _populate_gids_to_retain (hb_subset_plan_t* plan,
-		          hb_set_t* drop_tables)
+		          hb_set_t* drop_tables,
+			  const hb_subset_plan_t *base)
 {
   OT::glyf_accelerator_t glyf (plan->source);
 #ifndef HB_NO_SUBSET_CFF
@@ -455,13 +507,33 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
 
   if (!drop_tables->has (HB_OT_TAG_MATH))
   {
-    _math_closure (plan, &plan->_glyphset_gsub);
+    if (base)
+    {
+      /* MATH closure is per glyph; only run it on the new glyphs. */
+      hb_set_t delta = plan->_glyphset_cmaped;
+      delta.subtract (base->_glyphset_cmaped);
+      _math_closure (plan, &delta);
+      plan->_glyphset_gsub.union_ (delta);
+      plan->_glyphset_gsub.union_ (base->_glyphset_mathed);
+    }
+    else
+      _math_closure (plan, &plan->_glyphset_gsub);
     _remove_invalid_gids (&plan->_glyphset_gsub, plan->source->get_num_glyphs ());
   }
   plan->_glyphset_mathed = plan->_glyphset_gsub;
 
+  /* The GSUB closure of the glyphs being extended is a subset of the new
+   * closure; start from it, and skip the closure altogether if nothing
+   * outside it was added. */
+  bool glyphs_closed = false;
+  if (base)
+  {
+    glyphs_closed = plan->_glyphset_gsub.is_subset (base->_glyphset_gsub);
+    plan->_glyphset_gsub.union_ (base->_glyphset_gsub);
+  }
+
 #ifndef HB_NO_SUBSET_LAYOUT
-  layout_populate_gids_to_retain(plan, drop_tables);
+  layout_populate_gids_to_retain(plan, drop_tables, glyphs_closed);
 #endif
 
   _remove_invalid_gids (&plan->_glyphset_gsub, plan->source->get_num_glyphs ());
@@ -478,6 +550,14 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
   // XXX TODO VARC closure / subset
 
   _nameid_closure (plan, drop_tables);
+  /* Composite and seac closures are per glyph, so when extending only the
+   * new glyphs need walking. */
+  if (base)
+  {
+    cur_glyphset.subtract (base->_glyphset_colred);
+    plan->_glyphset.union_ (base->_glyphset);
+  }
+
   /* Populate a full set of glyphs to retain by adding all referenced
    * composite glyphs. */
   if (glyf.has_data ())
@@ -489,7 +569,7 @@ _populate_gids_to_retain (hb_subset_plan_t* plan,
 #ifndef HB_NO_SUBSET_CFF
   if (!plan->accelerator || plan->accelerator->has_seac)
   {
-    bool has_seac = false;
+    bool has_seac = base && base->has_seac;
     if (cff->is_valid ())
       for (hb_codepoint_t gid : cur_glyphset)
 	if (_add_cff_seac_components (*cff, gid, &plan->_glyphset))
@@ -628,7 +708,8 @@ _create_old_gid_to_new_gid_map (const hb_face_t *face,
 }
 
 hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
-				    const hb_subset_input_t *input)
+				    const hb_subset_input_t *input,
+				    const hb_subset_plan_t *base)
 {
   successful = true;
   flags = input->flags;
@@ -640,6 +721,9 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
   layout_features = *input->sets.layout_features;
   layout_scripts = *input->sets.layout_scripts;
   glyphs_requested = *input->sets.glyphs;
+  unicodes_requested = *input->sets.unicodes;
+  name_ids_requested = *input->sets.name_ids;
+  glyph_map_requested = input->glyph_map;
   drop_tables = *input->sets.drop_tables;
   no_subset_tables = *input->sets.no_subset_tables;
   source = hb_face_reference (face);
@@ -677,6 +761,9 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
 
   attach_accelerator_data = input->attach_accelerator_data;
   force_long_loca = input->force_long_loca;
+#ifndef HB_NO_SUBSET_DEPEND
+  depend = hb_subset_depend_reference (input->depend);
+#endif
 #ifdef HB_EXPERIMENTAL_API
   force_long_loca = force_long_loca || (flags & HB_SUBSET_FLAGS_IFTB_REQUIREMENTS);
 #endif
@@ -692,9 +779,24 @@ hb_subset_plan_t::hb_subset_plan_t (hb_face_t *face,
       return;
 #endif
 
-  _populate_unicodes_to_retain (input->sets.unicodes, input->sets.glyphs, this);
+  /* Inverted sets skip the bidi closure, so can't be mapped piecewise. */
+  if (base && !unicodes_requested.is_inverted ())
+  {
+    hb_set_t unicodes = unicodes_requested;
+    unicodes.subtract (base->unicodes_requested);
+    hb_set_t glyphs = glyphs_requested;
+    glyphs.subtract (base->glyphs_requested);
+
+    _populate_unicodes_to_retain (&unicodes, &glyphs, this);
+    _merge_unicodes_to_retain (base, this);
+  }
+  else
+  {
+    base = nullptr;
+    _populate_unicodes_to_retain (input->sets.unicodes, input->sets.glyphs, this);
+  }
 
-  _populate_gids_to_retain (this, input->sets.drop_tables);
+  _populate_gids_to_retain (this, input->sets.drop_tables, base);
   if (unlikely (in_error ()))
     return;
 
@@ -792,6 +894,9 @@ hb_subset_plan_t::~hb_subset_plan_t()
   cff2_accel.fini ();
 #endif
   hb_face_destroy (source);
+#ifndef HB_NO_SUBSET_DEPEND
+  hb_subset_depend_destroy (depend);
+#endif
 
 #ifdef HB_EXPERIMENTAL_API
   for (auto _ : name_table_overrides.iter_ref ())
@@ -835,6 +940,96 @@ hb_subset_plan_create_or_fail (hb_face_t	 *face,
   return plan;
 }
 
+/**
+ * hb_subset_plan_create_extended_or_fail:
+ * @plan: a subsetting plan.
+ * @unicodes: (nullable): additional unicode code points to retain.
+ * @glyphs: (nullable): additional glyph ids to retain.
+ *
+ * Computes a plan for subsetting the face of @plan with the input @plan
+ * was created from, extended by @unicodes and @glyphs.  The result is the
+ * same as that of hb_subset_plan_create_or_fail() with the extended input,
+ * but is faster to compute: the glyph closures (cmap, MATH, GSUB, COLR,
+ * composite glyphs) are only carried out for what was added, on top of
+ * those already computed for @plan.
+ *
+ * This is meant for subsetting the same font repeatedly for growing
+ * sets of code points, as in progressive font loading.
+ *
+ * @plan itself is not modified.  The new plan uses as many threads
+ * as @plan; see hb_subset_plan_set_num_threads().
+ *
+ * Return value: (transfer full): New subset plan. Destroy with
+ * hb_subset_plan_destroy(). If there is a failure creating the plan
+ * nullptr will be returned.
+ *
+ * Since: REPLACEME
+ **/
+hb_subset_plan_t *
+hb_subset_plan_create_extended_or_fail (const hb_subset_plan_t *plan,
+					const hb_set_t         *unicodes,
+					const hb_set_t         *glyphs)
+{
+  if (unlikely (!plan || plan->in_error ())) return nullptr;
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  if (unlikely (!input))
+    return nullptr;
+
+  *input->sets.unicodes = plan->unicodes_requested;
+  if (unicodes)
+    input->sets.unicodes->union_ (*unicodes);
+  *input->sets.glyphs = plan->glyphs_requested;
+  if (glyphs)
+    input->sets.glyphs->union_ (*glyphs);
+  *input->sets.no_subset_tables = plan->no_subset_tables;
+  *input->sets.drop_tables = plan->drop_tables;
+  *input->sets.name_ids = plan->name_ids_requested;
+  *input->sets.name_languages = plan->name_languages;
+  *input->sets.layout_features = plan->layout_features;
+  *input->sets.layout_scripts = plan->layout_scripts;
+
+  input->flags = plan->flags;
+  input->attach_accelerator_data = plan->attach_accelerator_data;
+  input->force_long_loca = plan->force_long_loca;
+  input->axes_location = plan->user_axes_location;
+  input->glyph_map = plan->glyph_map_requested;
+#ifndef HB_NO_SUBSET_DEPEND
+  hb_subset_input_set_depend (input, plan->depend);
+#endif
+
+#ifdef HB_EXPERIMENTAL_API
+  for (auto _ : plan->name_table_overrides)
+  {
+    hb_bytes_t name_bytes = _.second;
+    unsigned len = name_bytes.length;
+    char *name_str = (char *) hb_malloc (len);
+    if (unlikely (!name_str))
+      break;
+
+    hb_memcpy (name_str, name_bytes.arrayZ, len);
+    input->name_table_overrides.set (_.first, hb_bytes_t (name_str, len));
+  }
+#endif
+
+  hb_subset_plan_t *extended = nullptr;
+  if (likely (!input->in_error () && !input->glyph_map.in_error ()))
+    extended = hb_object_create<hb_subset_plan_t> (plan->source, input, plan);
+  hb_subset_input_destroy (input);
+
+  if (unlikely (!extended))
+    return nullptr;
+
+  if (unlikely (extended->in_error ()))
+  {
+    hb_subset_plan_destroy (extended);
+    return nullptr;
+  }
+
+  extended->num_threads = plan->num_threads;
+  return extended;
+}
+
 /**
  * hb_subset_plan_destroy:
  * @plan: a #hb_subset_plan_t
@@ -964,3 +1159,45 @@ hb_subset_plan_get_user_data (const hb_subset_plan_t *plan,
 {
   return hb_object_get_user_data (plan, key);
 }
+
+/**
+ * hb_subset_plan_set_num_threads:
+ * @plan: a #hb_subset_plan_t object.
+ * @num_threads: maximum number of threads to use, or 0 for one per
+ * online processor
+ *
+ * Sets the number of threads hb_subset_plan_execute_or_fail() may use.
+ * Tables that don't depend on each other, such as glyf, GSUB and GPOS,
+ * are then subset concurrently.  The generated subset is identical to
+ * that of a single-threaded execution.  The default is 1.
+ *
+ * If HarfBuzz was built without thread support, tables are always
+ * subset on a single thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_plan_set_num_threads (hb_subset_plan_t *plan,
+				unsigned int      num_threads)
+{
+  if (hb_object_is_immutable (plan))
+    return;
+  plan->num_threads = num_threads;
+}
+
+/**
+ * hb_subset_plan_get_num_threads:
+ * @plan: a #hb_subset_plan_t object.
+ *
+ * Fetches the number of threads set with
+ * hb_subset_plan_set_num_threads().
+ *
+ * Return value: the number of threads, or 0 for one per online processor
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_subset_plan_get_num_threads (const hb_subset_plan_t *plan)
+{
+  return plan->num_threads;
+}
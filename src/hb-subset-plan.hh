@@ -128,7 +128,8 @@ namespace OT {
 struct hb_subset_plan_t
 {
   HB_INTERNAL hb_subset_plan_t (hb_face_t *,
-				const hb_subset_input_t *input);
+				const hb_subset_input_t *input,
+				const hb_subset_plan_t *base = nullptr);
 
   HB_INTERNAL ~hb_subset_plan_t();
 
@@ -156,6 +157,11 @@ struct hb_subset_plan_t
 
   hb_face_t *dest;
 
+#ifndef HB_NO_SUBSET_DEPEND
+  // Glyph dependency graph of source, to drive the GSUB closure from
+  hb_subset_depend_t *depend = nullptr;
+#endif
+
   unsigned int _num_output_glyphs;
 
   bool all_axes_pinned;
@@ -184,6 +190,12 @@ struct hb_subset_plan_t
   const hb_subset_accelerator_t* accelerator;
   hb_subset_accelerator_t* inprogress_accelerator;
 
+  // Threads hb_subset_plan_execute_or_fail() may subset tables on.
+  unsigned num_threads = 1;
+  // Guard state tables being subset concurrently share.
+  hb_mutex_t sanitized_table_cache_lock;
+  hb_mutex_t dest_lock;
+
  public:
 
   template<typename T>
@@ -191,16 +203,28 @@ struct hb_subset_plan_t
   {
     hb_blob_ptr_t<T> operator () (hb_subset_plan_t *plan)
     {
-      hb_lock_t lock (plan->accelerator ? &plan->accelerator->sanitized_table_cache_lock : nullptr);
-
+      hb_mutex_t *lock = plan->accelerator ? &plan->accelerator->sanitized_table_cache_lock : &plan->sanitized_table_cache_lock;
       auto *cache = plan->accelerator ? &plan->accelerator->sanitized_table_cache : &plan->sanitized_table_cache;
+      {
+	hb_lock_t l (lock);
+	if (cache
+	    && !cache->in_error ()
+	    && cache->has (+T::tableTag)) {
+	  return hb_blob_reference (cache->get (+T::tableTag).get ());
+	}
+      }
+
+      // Sanitize outside the lock, so that tables subset on different
+      // threads don't wait on each other.  If two threads race to load
+      // the same table, the one cached first wins.
+      hb::unique_ptr<hb_blob_t> table_blob {hb_sanitize_context_t ().reference_table<T> (plan->source)};
+
+      hb_lock_t l (lock);
       if (cache
 	  && !cache->in_error ()
 	  && cache->has (+T::tableTag)) {
 	return hb_blob_reference (cache->get (+T::tableTag).get ());
       }
-
-      hb::unique_ptr<hb_blob_t> table_blob {hb_sanitize_context_t ().reference_table<T> (plan->source)};
       hb_blob_t* ret = hb_blob_reference (table_blob.get ());
 
       if (likely (cache))
@@ -307,6 +331,7 @@ struct hb_subset_plan_t
 		hb_blob_get_length (source_blob));
       hb_blob_destroy (source_blob);
     }
+    hb_lock_t l (dest_lock);
     return hb_face_builder_add_table (dest, tag, contents);
   }
 };
@@ -376,7 +401,8 @@ layout_nameid_closure (hb_subset_plan_t* plan,
 
 HB_INTERNAL void
 layout_populate_gids_to_retain (hb_subset_plan_t* plan,
-                                hb_set_t* drop_tables);
+                                hb_set_t* drop_tables,
+                                bool glyphs_closed = false);
 
 HB_INTERNAL void
 collect_layout_variation_indices (hb_subset_plan_t* plan);
@@ -32,6 +32,7 @@
 #include "hb-subset.hh"
 #include "hb-subset-table.hh"
 #include "hb-subset-accelerator.hh"
+#include "hb-parallel.hh"
 
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-var-cvar-table.hh"
@@ -311,6 +312,124 @@ _subset_table (hb_subset_plan_t *plan,
   return true;
 }
 
+static bool
+_subset_tables (hb_subset_plan_t *plan,
+		hb_set_t &pending_subset_tags)
+{
+  hb_set_t subsetted_tags;
+
+  hb_vector_t<char> buf;
+  buf.alloc (8192 - 16);
+
+  while (!pending_subset_tags.is_empty ())
+  {
+    if (subsetted_tags.in_error ()
+	|| pending_subset_tags.in_error ())
+      return false;
+
+    bool made_changes = false;
+    for (hb_tag_t tag : pending_subset_tags)
+    {
+      if (!_dependencies_satisfied (plan, tag,
+				    subsetted_tags,
+				    pending_subset_tags))
+      {
+	// delayed subsetting for some tables since they might have dependency on other tables
+	// in some cases: e.g: during instantiating glyf tables, hmetrics/vmetrics are updated
+	// and saved in subset plan, hmtx/vmtx subsetting need to use these updated metrics values
+	continue;
+      }
+
+      pending_subset_tags.del (tag);
+      subsetted_tags.add (tag);
+      made_changes = true;
+
+      if (unlikely (!_subset_table (plan, buf, tag)))
+	return false;
+    }
+
+    if (!made_changes)
+    {
+      DEBUG_MSG (SUBSET, nullptr, "Table dependencies unable to be satisfied. Subset failed.");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Subsets tables on several threads.  The tables are first sorted into
+ * waves by their dependencies: a wave holds every table whose
+ * dependencies were subset in earlier waves.  The tables of a wave are
+ * then subset concurrently, each worker into a buffer of its own.
+ *
+ * Tables only share plan state along those dependencies, and the face
+ * builder sorts tables by tag, so the result is the same as when
+ * subsetting serially.
+ */
+static bool
+_subset_tables_parallel (hb_subset_plan_t *plan,
+			 hb_set_t &pending_subset_tags)
+{
+  hb_set_t subsetted_tags;
+  hb_vector_t<hb_tag_t> tags;
+  hb_vector_t<unsigned> wave_ends;
+  while (!pending_subset_tags.is_empty ())
+  {
+    if (subsetted_tags.in_error ()
+	|| pending_subset_tags.in_error ())
+      return false;
+
+    unsigned wave_start = tags.length;
+    for (hb_tag_t tag : pending_subset_tags)
+      if (_dependencies_satisfied (plan, tag,
+				   subsetted_tags,
+				   pending_subset_tags))
+	tags.push (tag);
+    if (unlikely (tags.in_error ()))
+      return false;
+
+    if (tags.length == wave_start)
+    {
+      DEBUG_MSG (SUBSET, nullptr, "Table dependencies unable to be satisfied. Subset failed.");
+      return false;
+    }
+
+    for (unsigned i = wave_start; i < tags.length; i++)
+    {
+      pending_subset_tags.del (tags.arrayZ[i]);
+      subsetted_tags.add (tags.arrayZ[i]);
+    }
+    wave_ends.push (tags.length);
+  }
+  if (unlikely (wave_ends.in_error ()))
+    return false;
+
+  hb_vector_t<hb_vector_t<char>> bufs;
+  if (unlikely (!bufs.resize (hb_parallel_num_threads (plan->num_threads))))
+    return false;
+
+  unsigned wave_start = 0;
+  for (unsigned wave_end : wave_ends)
+  {
+    hb_atomic_t<int> failed {0};
+    bool ret = hb_parallel_for (plan->num_threads, wave_end - wave_start,
+				[&] (unsigned worker, unsigned i)
+    {
+      if (unlikely (failed.get_relaxed ()))
+	return;
+      if (unlikely (!_subset_table (plan, bufs.arrayZ[worker], tags.arrayZ[wave_start + i])))
+	failed.set_relaxed (1);
+    });
+    if (unlikely (!ret || failed.get_relaxed ()))
+      return false;
+    wave_start = wave_end;
+  }
+
+  return true;
+}
+
 static void _attach_accelerator_data (hb_subset_plan_t* plan,
                                       hb_face_t* face /* IN/OUT */)
 {
@@ -377,6 +496,9 @@ hb_subset_or_fail (hb_face_t *source, const hb_subset_input_t *input)
  *
  * Executes the provided subsetting @plan.
  *
+ * Tables are subset on as many threads as set with
+ * hb_subset_plan_set_num_threads(); the result does not depend on it.
+ *
  * Return value:
  * on success returns a reference to generated font subset. If the subsetting operation fails
  * returns nullptr.
@@ -393,7 +515,7 @@ hb_subset_plan_execute_or_fail (hb_subset_plan_t *plan)
   hb_tag_t table_tags[32];
   unsigned offset = 0, num_tables = ARRAY_LENGTH (table_tags);
 
-  hb_set_t subsetted_tags, pending_subset_tags;
+  hb_set_t pending_subset_tags;
   while (((void) _get_table_tags (plan, offset, &num_tables, table_tags), num_tables))
   {
     for (unsigned i = 0; i < num_tables; ++i)
@@ -406,56 +528,13 @@ hb_subset_plan_execute_or_fail (hb_subset_plan_t *plan)
     offset += num_tables;
   }
 
-  bool success = true;
-
-  {
-    // Grouping to deallocate buf before calling hb_face_reference (plan->dest).
-
-    hb_vector_t<char> buf;
-    buf.alloc (8192 - 16);
-
-    while (!pending_subset_tags.is_empty ())
-    {
-      if (subsetted_tags.in_error ()
-	  || pending_subset_tags.in_error ()) {
-	success = false;
-	goto end;
-      }
-
-      bool made_changes = false;
-      for (hb_tag_t tag : pending_subset_tags)
-      {
-	if (!_dependencies_satisfied (plan, tag,
-				      subsetted_tags,
-				      pending_subset_tags))
-	{
-	  // delayed subsetting for some tables since they might have dependency on other tables
-	  // in some cases: e.g: during instantiating glyf tables, hmetrics/vmetrics are updated
-	  // and saved in subset plan, hmtx/vmtx subsetting need to use these updated metrics values
-	  continue;
-	}
-
-	pending_subset_tags.del (tag);
-	subsetted_tags.add (tag);
-	made_changes = true;
-
-	success = _subset_table (plan, buf, tag);
-	if (unlikely (!success)) goto end;
-      }
-
-      if (!made_changes)
-      {
-	DEBUG_MSG (SUBSET, nullptr, "Table dependencies unable to be satisfied. Subset failed.");
-	success = false;
-	goto end;
-      }
-    }
-  }
+  bool success = hb_parallel_num_threads (plan->num_threads) > 1
+	       ? _subset_tables_parallel (plan, pending_subset_tags)
+	       : _subset_tables (plan, pending_subset_tags);
 
   if (success && plan->attach_accelerator_data) {
     _attach_accelerator_data (plan, plan->dest);
   }
 
-end:
   return success ? hb_face_reference (plan->dest) : nullptr;
 }
\ No newline at end of file
@@ -237,6 +237,15 @@ hb_subset_axis_range_to_string (hb_subset_input_t *input,
 				char *buf,
 				unsigned size);
 
+#ifndef HB_NO_SUBSET_DEPEND
+HB_EXTERN void
+hb_subset_input_set_depend (hb_subset_input_t  *input,
+			    hb_subset_depend_t *depend);
+
+HB_EXTERN hb_subset_depend_t *
+hb_subset_input_get_depend (hb_subset_input_t *input);
+#endif
+
 #ifdef HB_EXPERIMENTAL_API
 HB_EXTERN hb_blob_t *
 hb_subset_input_to_string_or_fail (hb_subset_input_t *input);
@@ -251,6 +260,40 @@ hb_subset_input_override_name_table (hb_subset_input_t  *input,
 				     int                 str_len);
 
 
+/**
+ * hb_subset_cache_t:
+ *
+ * Data type for holding subsetting results, for reuse by
+ * hb_subset_cached_or_fail().
+ *
+ * XSince: EXPERIMENTAL
+ **/
+typedef struct hb_subset_cache_t hb_subset_cache_t;
+
+HB_EXTERN hb_subset_cache_t *
+hb_subset_cache_create_or_fail (void);
+
+HB_EXTERN hb_subset_cache_t *
+hb_subset_cache_reference (hb_subset_cache_t *cache);
+
+HB_EXTERN void
+hb_subset_cache_destroy (hb_subset_cache_t *cache);
+
+HB_EXTERN void
+hb_subset_cache_set_max_bytes (hb_subset_cache_t *cache,
+			       unsigned int       max_bytes);
+
+HB_EXTERN void
+hb_subset_cache_get_stats (hb_subset_cache_t *cache,
+			   unsigned int      *hits,
+			   unsigned int      *misses);
+
+HB_EXTERN hb_face_t *
+hb_subset_cached_or_fail (hb_face_t               *source,
+			  const hb_subset_input_t *input,
+			  hb_subset_cache_t       *cache);
+
+
 /*
 * Raw outline data access
 */
@@ -281,6 +324,11 @@ HB_EXTERN hb_subset_plan_t *
 hb_subset_plan_create_or_fail (hb_face_t                 *face,
                                const hb_subset_input_t   *input);
 
+HB_EXTERN hb_subset_plan_t *
+hb_subset_plan_create_extended_or_fail (const hb_subset_plan_t *plan,
+                                        const hb_set_t         *unicodes,
+                                        const hb_set_t         *glyphs);
+
 HB_EXTERN void
 hb_subset_plan_destroy (hb_subset_plan_t *plan);
 
@@ -308,6 +356,13 @@ HB_EXTERN void *
 hb_subset_plan_get_user_data (const hb_subset_plan_t *plan,
                               hb_user_data_key_t     *key);
 
+HB_EXTERN void
+hb_subset_plan_set_num_threads (hb_subset_plan_t *plan,
+                                unsigned int      num_threads);
+
+HB_EXTERN unsigned int
+hb_subset_plan_get_num_threads (const hb_subset_plan_t *plan);
+
 
 HB_END_DECLS
 
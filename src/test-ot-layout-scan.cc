@@ -0,0 +1,102 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-ot-layout-scan.hh"
+#include "hb-vector.hh"
+
+static uint32_t rand_state = 1;
+static uint32_t
+next_rand ()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* Scanning agrees with glyph-by-glyph checks, whatever the digest,
+   * lookup mask, and ignored glyph classes. */
+  for (unsigned round = 0; round < 2000; round++)
+  {
+    hb_set_digest_t digest;
+    unsigned num_covered = next_rand () % 8;
+    for (unsigned i = 0; i < num_covered; i++)
+    {
+      hb_codepoint_t g = next_rand () % 70000;
+      if (next_rand () % 4)
+	digest.add (g);
+      else
+	digest.add_range (g, g + next_rand () % 300);
+    }
+
+    hb_mask_t lookup_mask = 1u << (next_rand () % 32);
+    unsigned ignore_props = next_rand () % 16 & 0x0Eu;
+    hb_ot_layout_scan_t scan (digest, lookup_mask, ignore_props);
+
+    hb_vector_t<hb_glyph_info_t> info;
+    unsigned len = next_rand () % 100;
+    hb_always_assert (info.resize (len));
+    for (auto &i : info)
+    {
+      i.codepoint = next_rand () % (next_rand () % 2 ? 1000 : 70000);
+      i.mask = next_rand () % 3 ? next_rand () : lookup_mask;
+      i.cluster = next_rand ();
+      i.var1.u32 = next_rand ();
+      i.var1.u16[0] = 1u << (next_rand () % 4);
+      i.var2.u32 = next_rand ();
+    }
+
+    for (unsigned start = 0; start <= len; start++)
+    {
+      unsigned j = scan.forward (info.arrayZ, start, len);
+      hb_always_assert (j == scan.forward_scalar (info.arrayZ, start, len));
+      hb_always_assert (j == len || scan.may_apply (info.arrayZ[j]));
+    }
+  }
+
+  /* Every digest bit, in both halves of the masks. */
+  for (hb_codepoint_t g = 0; g < 4096; g++)
+  {
+    hb_set_digest_t digest;
+    digest.add (g);
+    hb_ot_layout_scan_t scan (digest, 1, 0);
+
+    hb_glyph_info_t info[16] = {};
+    for (unsigned i = 0; i < ARRAY_LENGTH (info); i++)
+    {
+      info[i].codepoint = g + 1 + i;
+      info[i].mask = 1;
+    }
+    info[9].codepoint = g;
+    hb_always_assert (scan.forward (info, 0, ARRAY_LENGTH (info)) ==
+		      scan.forward_scalar (info, 0, ARRAY_LENGTH (info)));
+    hb_always_assert (scan.forward (info, 0, ARRAY_LENGTH (info)) <= 9);
+  }
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-face.hh"
+#include "hb-ot-layout-gsub-table.hh"
+#include "hb-vector.hh"
+
+#define NUM_SUBTABLES 12
+#define NUM_GLYPHS 100
+#define SHARED_GLYPH 40
+
+static void
+put16 (char *p, unsigned v)
+{
+  p[0] = (char) (v >> 8);
+  p[1] = (char) v;
+}
+
+/* A GSUB whose 'ccmp' has one ligature lookup with NUM_SUBTABLES
+ * subtables.  Subtable i covers glyphs 3i+1, 3i+2 and SHARED_GLYPH, and
+ * ligates
+ *   3i+1, 3i+2      to 80+i,
+ *   3i+2, SHARED    to 60+i,
+ *   SHARED, 41+i    to 80+i.
+ * So most glyphs have one subtable that covers them, and SHARED_GLYPH is
+ * covered by all of them but each only applies before its own glyph. */
+static hb_blob_t *
+create_gsub ()
+{
+  const unsigned lookup_list = 10 + 20 + 14;
+  const unsigned lookup = lookup_list + 4;
+  const unsigned subtable_size = 52;
+  unsigned length = lookup + 6 + 2 * NUM_SUBTABLES + subtable_size * NUM_SUBTABLES;
+  char *gsub = (char *) hb_calloc (length, 1);
+  hb_always_assert (gsub);
+
+  put16 (gsub + 0, 1);
+  put16 (gsub + 4, 10);
+  put16 (gsub + 6, 30);
+  put16 (gsub + 8, lookup_list);
+
+  /* ScriptList: DFLT, whose default LangSys has feature 0 only. */
+  char *p = gsub + 10;
+  put16 (p, 1);
+  hb_memcpy (p + 2, "DFLT", 4);
+  put16 (p + 6, 8);
+  put16 (p + 8, 4);
+  put16 (p + 14, 0xFFFF);
+  put16 (p + 16, 1);
+
+  /* FeatureList: 'ccmp', with lookup 0. */
+  p = gsub + 30;
+  put16 (p, 1);
+  hb_memcpy (p + 2, "ccmp", 4);
+  put16 (p + 6, 8);
+  put16 (p + 10, 1);
+
+  /* LookupList, with one LigatureSubst lookup. */
+  p = gsub + lookup_list;
+  put16 (p, 1);
+  put16 (p + 2, 4);
+  p = gsub + lookup;
+  put16 (p, 4);
+  put16 (p + 4, NUM_SUBTABLES);
+  for (unsigned i = 0; i < NUM_SUBTABLES; i++)
+  {
+    unsigned offset = 6 + 2 * NUM_SUBTABLES + subtable_size * i;
+    put16 (p + 6 + 2 * i, offset);
+
+    char *subtable = p + offset;
+    unsigned first = 3 * i + 1;
+    const unsigned ligatures[3][3] = {
+      {first,        first + 1,    80 + i},
+      {first + 1,    SHARED_GLYPH, 60 + i},
+      {SHARED_GLYPH, 41 + i,       80 + i},
+    };
+    put16 (subtable + 0, 1);
+    put16 (subtable + 2, 42);
+    put16 (subtable + 4, 3);
+    for (unsigned j = 0; j < 3; j++)
+    {
+      char *set = subtable + 12 + 10 * j;
+      put16 (subtable + 6 + 2 * j, 12 + 10 * j);
+      put16 (set + 0, 1);
+      put16 (set + 2, 4);
+      put16 (set + 4, ligatures[j][2]);
+      put16 (set + 6, 2);
+      put16 (set + 8, ligatures[j][1]);
+    }
+    char *coverage = subtable + 42;
+    put16 (coverage + 0, 1);
+    put16 (coverage + 2, 3);
+    put16 (coverage + 4, first);
+    put16 (coverage + 6, first + 1);
+    put16 (coverage + 8, SHARED_GLYPH);
+  }
+
+  return hb_blob_create (gsub, length, HB_MEMORY_MODE_WRITABLE, gsub, hb_free);
+}
+
+static hb_face_t *
+create_face ()
+{
+  static const char maxp[6] = {0x00, 0x00, 0x50, 0x00, 0x00, NUM_GLYPHS};
+  hb_face_t *builder = hb_face_builder_create ();
+  hb_blob_t *blob = create_gsub ();
+  hb_face_builder_add_table (builder, HB_TAG ('G','S','U','B'), blob);
+  hb_blob_destroy (blob);
+  blob = hb_blob_create (maxp, sizeof (maxp), HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+  hb_face_builder_add_table (builder, HB_TAG ('m','a','x','p'), blob);
+  hb_blob_destroy (blob);
+
+  blob = hb_face_reference_blob (builder);
+  hb_face_destroy (builder);
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  return face;
+}
+
+static hb_bool_t
+get_nominal_glyph (hb_font_t *font HB_UNUSED, void *font_data HB_UNUSED,
+		   hb_codepoint_t unicode, hb_codepoint_t *glyph,
+		   void *user_data HB_UNUSED)
+{
+  *glyph = unicode;
+  return unicode < NUM_GLYPHS;
+}
+
+static hb_font_t *
+create_font (hb_face_t *face)
+{
+  hb_font_funcs_t *funcs = hb_font_funcs_create ();
+  hb_font_funcs_set_nominal_glyph_func (funcs, get_nominal_glyph, nullptr, nullptr);
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_funcs (font, funcs, nullptr, nullptr);
+  hb_font_funcs_destroy (funcs);
+  return font;
+}
+
+static void
+shape (hb_font_t *font, const hb_vector_t<hb_codepoint_t> &text,
+       hb_vector_t<hb_codepoint_t> *glyphs)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_codepoints (buffer, text.arrayZ, text.length, 0, -1);
+  hb_buffer_set_direction (buffer, HB_DIRECTION_LTR);
+  hb_buffer_set_script (buffer, HB_SCRIPT_LATIN);
+  hb_shape (font, buffer, nullptr, 0);
+
+  unsigned count;
+  hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  glyphs->resize (0);
+  for (unsigned i = 0; i < count; i++)
+  {
+    glyphs->push (info[i].codepoint);
+    glyphs->push (info[i].cluster);
+  }
+  hb_buffer_destroy (buffer);
+}
+
+static uint32_t rand_state = 1;
+static uint32_t
+next_rand ()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* The same lookup applied with and without a subtable index gives the
+   * same glyphs. */
+  hb_face_t *indexed_face = create_face ();
+  hb_face_t *plain_face = create_face ();
+  hb_always_assert (hb_ot_layout_has_substitution (indexed_face));
+  hb_always_assert (hb_ot_layout_has_substitution (plain_face));
+  plain_face->table.GSUB.get_relaxed ()->subtable_index_budget = 0;
+
+  hb_font_t *indexed = create_font (indexed_face);
+  hb_font_t *plain = create_font (plain_face);
+
+  hb_vector_t<hb_codepoint_t> text, expected, actual;
+  unsigned ligatures = 0;
+  for (unsigned round = 0; round < 5000; round++)
+  {
+    text.resize (0);
+    unsigned len = 1 + next_rand () % 16;
+    for (unsigned i = 0; i < len; i++)
+      text.push (next_rand () % 4 ? next_rand () % (SHARED_GLYPH + NUM_SUBTABLES + 2)
+				  : SHARED_GLYPH);
+
+    shape (plain, text, &expected);
+    shape (indexed, text, &actual);
+    hb_always_assert (actual.as_array () == expected.as_array ());
+    ligatures += text.length - actual.length / 2;
+  }
+  hb_always_assert (ligatures);
+
+  /* Only the first font's lookup has an index. */
+  auto *indexed_lookup = indexed_face->table.GSUB.get_relaxed ()->accels[0].get_acquire ();
+  auto *plain_lookup = plain_face->table.GSUB.get_relaxed ()->accels[0].get_acquire ();
+  hb_always_assert (indexed_lookup && indexed_lookup->get_subtable_index ());
+  hb_always_assert (plain_lookup && !plain_lookup->get_subtable_index ());
+
+  hb_font_destroy (plain);
+  hb_font_destroy (indexed);
+  hb_face_destroy (plain_face);
+  hb_face_destroy (indexed_face);
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-raster-composite.hh"
+
+static uint32_t rand_state = 1;
+static uint32_t
+next_rand ()
+{
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 17;
+  rand_state ^= rand_state << 5;
+  return rand_state;
+}
+
+/* A pixel that exercises the special cases: clear, opaque, gray,
+ * channels at the extremes, and premultiplied or not. */
+static uint32_t
+random_pixel ()
+{
+  static const uint8_t edges[] = {0, 1, 2, 127, 128, 129, 254, 255};
+  uint8_t c[4];
+  for (unsigned i = 0; i < 4; i++)
+    c[i] = next_rand () % 4 ? (uint8_t) next_rand () : edges[next_rand () % ARRAY_LENGTH (edges)];
+  switch (next_rand () % 4)
+  {
+  case 0: /* Premultiplied. */
+    for (unsigned i = 0; i < 3; i++)
+      c[i] = hb_min (c[i], c[3]);
+    break;
+  case 1: /* Gray, ties between channels. */
+    c[1] = c[2] = c[0] = hb_min (c[0], c[3]);
+    break;
+  case 2: /* Two channels tie. */
+    c[next_rand () % 3] = c[next_rand () % 3];
+    break;
+  default: /* Anything. */
+    break;
+  }
+  return hb_raster_pack_pixel (c[0], c[1], c[2], c[3]);
+}
+
+static void
+test_mode (hb_paint_composite_mode_t mode)
+{
+  uint32_t src[70], dst[70], expected[70];
+
+  for (unsigned round = 0; round < 2000; round++)
+  {
+    for (unsigned i = 0; i < ARRAY_LENGTH (src); i++)
+    {
+      src[i] = random_pixel ();
+      dst[i] = next_rand () % 8 ? random_pixel () : src[i];
+      expected[i] = dst[i];
+    }
+
+    /* Any length, from unaligned starts. */
+    unsigned start = next_rand () % 7;
+    unsigned len = next_rand () % (ARRAY_LENGTH (src) - start);
+
+    hb_raster_composite_span_scalar ((uint8_t *) (expected + start),
+				     (const uint8_t *) (src + start), len, mode);
+    hb_raster_composite_span ((uint8_t *) (dst + start),
+			      (const uint8_t *) (src + start), len, mode);
+
+    hb_always_assert (0 == memcmp (dst, expected, sizeof (dst)));
+  }
+
+  /* Every alpha against every alpha, gray and colored. */
+  for (unsigned sa = 0; sa < 256; sa++)
+  {
+    uint32_t s[256], d[256], e[256];
+    for (unsigned da = 0; da < 256; da++)
+    {
+      s[da] = hb_raster_pack_pixel ((uint8_t) (sa / 3), (uint8_t) (sa / 2), (uint8_t) sa, (uint8_t) sa);
+      d[da] = e[da] = hb_raster_pack_pixel ((uint8_t) da, (uint8_t) (da / 2), (uint8_t) (da / 4), (uint8_t) da);
+    }
+    hb_raster_composite_span_scalar ((uint8_t *) e, (const uint8_t *) s, 256, mode);
+    hb_raster_composite_span ((uint8_t *) d, (const uint8_t *) s, 256, mode);
+    hb_always_assert (0 == memcmp (d, e, sizeof (d)));
+  }
+}
+
+static void
+test_mask ()
+{
+  uint32_t src[70], dst[70], expected[70];
+  uint8_t mask[70];
+
+  for (unsigned round = 0; round < 20000; round++)
+  {
+    for (unsigned i = 0; i < ARRAY_LENGTH (src); i++)
+    {
+      src[i] = random_pixel ();
+      dst[i] = expected[i] = random_pixel ();
+      mask[i] = next_rand () % 2 ? (uint8_t) next_rand () : (uint8_t) (next_rand () % 2 * 255);
+    }
+
+    unsigned start = next_rand () % 7;
+    unsigned len = next_rand () % (ARRAY_LENGTH (src) - start);
+
+    hb_raster_composite_span_mask_scalar ((uint8_t *) (expected + start),
+					  (const uint8_t *) (src + start),
+					  mask + start, len);
+    hb_raster_composite_span_mask ((uint8_t *) (dst + start),
+				   (const uint8_t *) (src + start),
+				   mask + start, len);
+
+    hb_always_assert (0 == memcmp (dst, expected, sizeof (dst)));
+  }
+}
+
+#ifdef HB_RASTER_COMPOSITE_SIMD
+static void
+test_floor ()
+{
+  static const float edges[] = {0.f, -0.f, 0.5f, -0.5f, 1.f, -1.f, 1.5f, -1.5f,
+				0.99999994f, -0.99999994f, 1e-30f, -1e-30f,
+				8388607.5f, -8388607.5f, 8388608.f, -8388608.f,
+				16777216.f, -16777216.f, 3e9f, -3e9f, 1e38f, -1e38f};
+  float in[HB_RASTER_COMPOSITE_WIDTH], out[HB_RASTER_COMPOSITE_WIDTH];
+
+  for (unsigned round = 0; round < 20000; round++)
+  {
+    for (unsigned i = 0; i < ARRAY_LENGTH (in); i++)
+    {
+      uint32_t r = next_rand ();
+      switch (r % 3)
+      {
+      case 0: in[i] = edges[(r >> 2) % ARRAY_LENGTH (edges)]; break;
+      case 1: in[i] = (float) (int) (next_rand () % 2001 - 1000) / 8.f; break;
+      default:
+      {
+	/* Any finite float. */
+	uint32_t bits = next_rand ();
+	if ((bits & 0x7F800000u) == 0x7F800000u) bits &= ~0x40000000u;
+	memcpy (&in[i], &bits, 4);
+      }
+      }
+    }
+    vf_store (out, vfloor (vf_load (in)));
+    for (unsigned i = 0; i < ARRAY_LENGTH (in); i++)
+      hb_always_assert (out[i] == floorf (in[i]));
+  }
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+  /* Vectorized compositing agrees with the scalar code bit for bit, in
+   * every mode, including unknown ones. */
+  for (unsigned mode = HB_PAINT_COMPOSITE_MODE_CLEAR;
+       mode <= HB_PAINT_COMPOSITE_MODE_HSL_LUMINOSITY + 1;
+       mode++)
+    test_mode ((hb_paint_composite_mode_t) mode);
+
+  /* Compositing through a mask, as gradients do. */
+  test_mask ();
+
+#ifdef HB_RASTER_COMPOSITE_SIMD
+  test_floor ();
+#endif
+
+  return 0;
+}
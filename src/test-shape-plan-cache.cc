@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#include "hb.hh"
+#include "hb-face.hh"
+#include "hb-shape-plan.hh"
+
+/* Built from the amalgamated sources with HB_CUSTOM_MALLOC, so that the
+ * allocator below is the one the library uses. */
+
+/* How many more allocations succeed; negative for no limit. */
+static int allocs_left = -1;
+
+static bool
+may_allocate ()
+{
+  if (allocs_left < 0)
+    return true;
+  if (!allocs_left)
+    return false;
+  allocs_left--;
+  return true;
+}
+
+extern "C" void *hb_malloc_impl (size_t size) { return may_allocate () ? malloc (size) : nullptr; }
+extern "C" void *hb_calloc_impl (size_t nmemb, size_t size) { return may_allocate () ? calloc (nmemb, size) : nullptr; }
+extern "C" void *hb_realloc_impl (void *ptr, size_t size) { return may_allocate () ? realloc (ptr, size) : nullptr; }
+extern "C" void hb_free_impl (void *ptr) { free (ptr); }
+
+static hb_face_t *
+create_face ()
+{
+  static const char maxp_data[6] = {0x00, 0x00, 0x50, 0x00, 0x00, 0x04};
+  hb_blob_t *maxp = hb_blob_create (maxp_data, sizeof (maxp_data),
+				    HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+  hb_face_t *builder = hb_face_builder_create ();
+  hb_face_builder_add_table (builder, HB_TAG ('m','a','x','p'), maxp);
+  hb_blob_destroy (maxp);
+
+  hb_blob_t *blob = hb_face_reference_blob (builder);
+  hb_face_destroy (builder);
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  return face;
+}
+
+static hb_shape_plan_t *
+create_plan (hb_face_t *face)
+{
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+  return hb_shape_plan_create_cached (face, &props, nullptr, 0, nullptr);
+}
+
+/* A plan that fails to go into the cache, at any of the allocations
+ * that takes, does not keep the next one out. */
+static void
+test_insert_failure ()
+{
+  for (int limit = 0; ; limit++)
+  {
+    assert (limit < 100000);
+    hb_face_t *face = create_face ();
+
+    allocs_left = limit;
+    hb_shape_plan_t *first = create_plan (face);
+    allocs_left = -1;
+
+    hb_shape_plan_t *second = create_plan (face);
+    hb_shape_plan_t *third = create_plan (face);
+    assert (hb_object_is_valid (second));
+    assert (second == third);
+    bool done = first == second;
+
+    hb_shape_plan_destroy (third);
+    hb_shape_plan_destroy (second);
+    hb_shape_plan_destroy (first);
+    hb_face_destroy (face);
+
+    if (done)
+      break;
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  test_insert_failure ();
+
+  return 0;
+}
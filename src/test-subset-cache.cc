@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2026  Google, Inc.
+ *
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-machinery.hh"
+#include "hb-subset-accelerator.hh"
+#include "hb-subset-input.hh"
+
+/* Accelerator data can only be asked for internally, through
+ * hb_subset_input_t::attach_accelerator_data, so this is not in
+ * test/api. */
+
+#ifdef HB_EXPERIMENTAL_API
+
+static hb_face_t *
+create_face ()
+{
+  static const char maxp_data[6] = {0x00, 0x00, 0x50, 0x00, 0x00, 0x04};
+  hb_blob_t *maxp = hb_blob_create (maxp_data, sizeof (maxp_data),
+				    HB_MEMORY_MODE_READONLY, nullptr, nullptr);
+  hb_face_t *builder = hb_face_builder_create ();
+  hb_face_builder_add_table (builder, HB_TAG ('m','a','x','p'), maxp);
+  hb_blob_destroy (maxp);
+
+  hb_blob_t *blob = hb_face_reference_blob (builder);
+  hb_face_destroy (builder);
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  return face;
+}
+
+static bool
+has_accelerator (hb_face_t *face)
+{
+  return hb_face_get_user_data (face, hb_subset_accelerator_t::user_data_key ());
+}
+
+static void
+test_accelerator ()
+{
+  hb_face_t *face = create_face ();
+  hb_subset_cache_t *cache = hb_subset_cache_create_or_fail ();
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_add (hb_subset_input_glyph_set (input), 1);
+
+  /* Plain results come from the cache, without accelerator data. */
+  for (unsigned i = 0; i < 2; i++)
+  {
+    hb_face_t *subset = hb_subset_cached_or_fail (face, input, cache);
+    assert (subset);
+    assert (!has_accelerator (subset));
+    hb_face_destroy (subset);
+  }
+  unsigned hits, misses;
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  assert (hits == 1 && misses == 1);
+
+  /* Results asking for accelerator data always have it, the first time
+   * and when asked again; those requests bypass the cache. */
+  input->attach_accelerator_data = true;
+  for (unsigned i = 0; i < 2; i++)
+  {
+    hb_face_t *subset = hb_subset_cached_or_fail (face, input, cache);
+    assert (subset);
+    assert (has_accelerator (subset));
+    hb_face_destroy (subset);
+  }
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  assert (hits == 1 && misses == 1);
+
+  hb_subset_input_destroy (input);
+  hb_subset_cache_destroy (cache);
+  hb_face_destroy (face);
+}
+
+#endif
+
+int
+main (int argc, char **argv)
+{
+#ifdef HB_EXPERIMENTAL_API
+  test_accelerator ();
+#endif
+
+  return 0;
+}
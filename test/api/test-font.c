@@ -193,6 +193,137 @@ test_face_referenceblob (void)
   hb_face_destroy (face);
 }
 
+static void
+shape_to_string (hb_face_t *face, const char *text, char *out, unsigned size)
+{
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_buffer_serialize_glyphs (buffer, 0, hb_buffer_get_length (buffer),
+			      out, size, NULL, font,
+			      HB_BUFFER_SERIALIZE_FORMAT_TEXT,
+			      HB_BUFFER_SERIALIZE_FLAG_DEFAULT);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+}
+
+static hb_blob_t *
+reference_table_of_face (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data)
+{
+  /* No blob for the whole font, so no table directory either. */
+  if (tag == HB_TAG_NONE)
+    return NULL;
+  return hb_face_reference_table ((hb_face_t *) user_data, tag);
+}
+
+static void
+test_face_snapshot (void)
+{
+  static const struct {
+    const char *font;
+    const char *text;
+  } tests[] = {
+    {"fonts/NotoNastaliqUrdu-Regular.ttf", "\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85 \xd8\xaf\xd9\x86\xdb\x8c\xd8\xa7 \xd9\x86\xd8\xb3\xd8\xaa\xd8\xb9\xd9\x84\xdb\x8c\xd9\x82"},
+    {"fonts/Mplus1p-Regular.ttf", "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7\xab\xa0 abc"},
+    {"fonts/NotoSans-Bold.ttf", "Snapshot fi ffl 1/2"},
+  };
+  static char expected[4096], actual[4096];
+
+  for (unsigned i = 0; i < G_N_ELEMENTS (tests); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (tests[i].font);
+    shape_to_string (face, tests[i].text, expected, sizeof (expected));
+    hb_blob_t *snapshot = hb_face_create_snapshot (face);
+    g_assert_cmpuint (hb_blob_get_length (snapshot), >, 64);
+    hb_face_destroy (face);
+
+    /* A fresh face for the same font uses it and shapes the same. */
+    face = hb_test_open_font_file (tests[i].font);
+    g_assert_true (hb_face_set_snapshot (face, snapshot));
+    shape_to_string (face, tests[i].text, actual, sizeof (actual));
+    g_assert_cmpstr (actual, ==, expected);
+    hb_face_destroy (face);
+
+    /* Also by a face without a table directory, from the same tables. */
+    hb_face_t *source = hb_test_open_font_file (tests[i].font);
+    face = hb_face_create_for_tables (reference_table_of_face, source, NULL);
+    hb_face_set_index (face, hb_face_get_index (source));
+    g_assert_true (hb_face_set_snapshot (face, snapshot));
+    shape_to_string (face, tests[i].text, actual, sizeof (actual));
+    g_assert_cmpstr (actual, ==, expected);
+    hb_face_destroy (face);
+    hb_face_destroy (source);
+
+    /* But not once the face has built its accelerators. */
+    face = hb_test_open_font_file (tests[i].font);
+    shape_to_string (face, tests[i].text, actual, sizeof (actual));
+    g_assert_false (hb_face_set_snapshot (face, snapshot));
+    hb_face_destroy (face);
+
+    /* It is refused for other faces. */
+    face = hb_test_open_font_file (tests[(i + 1) % G_N_ELEMENTS (tests)].font);
+    g_assert_false (hb_face_set_snapshot (face, snapshot));
+    hb_face_destroy (face);
+
+    /* Or for the same font with other cmap data, even though the table
+     * keeps its length and checksum: one word goes up as another goes
+     * down. */
+    {
+      face = hb_test_open_font_file (tests[i].font);
+      hb_blob_t *font_blob = hb_face_reference_blob (face);
+      hb_blob_t *cmap_blob = hb_face_reference_table (face, HB_TAG ('c','m','a','p'));
+      unsigned font_length, cmap_length;
+      const char *font_data = hb_blob_get_data (font_blob, &font_length);
+      const char *cmap_data = hb_blob_get_data (cmap_blob, &cmap_length);
+      g_assert_cmpuint (cmap_length, >=, 16);
+      unsigned offset = (unsigned) (cmap_data - font_data) + cmap_length / 4 * 4 - 8;
+      char *font_copy = (char *) malloc (font_length);
+      memcpy (font_copy, font_data, font_length);
+      uint8_t *p = (uint8_t *) font_copy + offset;
+      for (int j = 3; j >= 0 && !++p[j]; j--) ;
+      for (int j = 7; j >= 4 && !p[j]--; j--) ;
+      hb_blob_destroy (cmap_blob);
+      hb_blob_destroy (font_blob);
+      hb_face_destroy (face);
+
+      hb_blob_t *tampered = hb_blob_create (font_copy, font_length, HB_MEMORY_MODE_READONLY, font_copy, free);
+      face = hb_face_create (tampered, 0);
+      hb_blob_destroy (tampered);
+      g_assert_false (hb_face_set_snapshot (face, snapshot));
+      hb_face_destroy (face);
+    }
+
+    /* And when truncated or from another version. */
+    unsigned length;
+    const char *data = hb_blob_get_data (snapshot, &length);
+    char *copy = (char *) malloc (length);
+    hb_blob_t *bad = hb_blob_create_sub_blob (snapshot, 0, 32);
+    face = hb_test_open_font_file (tests[i].font);
+    g_assert_false (hb_face_set_snapshot (face, bad));
+    hb_blob_destroy (bad);
+    memcpy (copy, data, length);
+    copy[8]++;
+    bad = hb_blob_create (copy, length, HB_MEMORY_MODE_READONLY, NULL, NULL);
+    g_assert_false (hb_face_set_snapshot (face, bad));
+    hb_blob_destroy (bad);
+
+    /* Damage past the header must not hurt, though glyphs may change. */
+    memcpy (copy, data, length);
+    for (unsigned j = 64; j < length; j += 7)
+      copy[j] ^= 0x5A;
+    bad = hb_blob_create (copy, length, HB_MEMORY_MODE_READONLY, NULL, NULL);
+    g_assert_true (hb_face_set_snapshot (face, bad));
+    hb_blob_destroy (bad);
+    shape_to_string (face, tests[i].text, actual, sizeof (actual));
+    hb_face_destroy (face);
+
+    free (copy);
+    hb_blob_destroy (snapshot);
+  }
+}
+
 static void
 _test_font_nil_funcs (hb_font_t *font)
 {
@@ -672,6 +803,53 @@ test_font_properties (void)
   hb_font_destroy (subfont);
 }
 
+static void
+test_font_nominal_glyphs_bulk (void)
+{
+  /* Mapping many distinct codepoints in bulk switches the cmap to
+   * its flat page tables; results must not change. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/Mplus1p-Regular.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_map_t *mapping = hb_map_create ();
+  hb_set_t *unicodes = hb_set_create ();
+  hb_face_collect_nominal_glyph_mapping (face, mapping, unicodes);
+  g_assert_cmpuint (hb_set_get_population (unicodes), >, 1000);
+
+  static hb_codepoint_t chars[0x30000], glyphs[0x30000];
+  for (unsigned i = 0; i < G_N_ELEMENTS (chars); i++)
+    chars[i] = i;
+
+  for (unsigned pass = 0; pass < 2; pass++)
+  {
+    unsigned start = 0;
+    while (start < G_N_ELEMENTS (chars))
+    {
+      unsigned done = hb_font_get_nominal_glyphs (font, G_N_ELEMENTS (chars) - start,
+						  chars + start, sizeof (chars[0]),
+						  glyphs + start, sizeof (glyphs[0]));
+      for (unsigned i = start; i < start + done; i++)
+	g_assert_cmpuint (glyphs[i], ==, hb_map_get (mapping, chars[i]));
+      start += done;
+      if (start < G_N_ELEMENTS (chars))
+	g_assert_false (hb_map_has (mapping, chars[start++]));
+    }
+  }
+
+  for (hb_codepoint_t u = 0; u < G_N_ELEMENTS (chars); u++)
+  {
+    hb_codepoint_t glyph;
+    if (hb_font_get_nominal_glyph (font, u, &glyph))
+      g_assert_cmpuint (glyph, ==, hb_map_get (mapping, u));
+    else
+      g_assert_false (hb_map_has (mapping, u));
+  }
+
+  hb_set_destroy (unicodes);
+  hb_map_destroy (mapping);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -681,6 +859,7 @@ main (int argc, char **argv)
   hb_test_add (test_face_create);
   hb_test_add (test_face_createfortables);
   hb_test_add (test_face_referenceblob);
+  hb_test_add (test_face_snapshot);
 
   hb_test_add (test_fontfuncs_empty);
   hb_test_add (test_fontfuncs_nil);
@@ -689,6 +868,7 @@ main (int argc, char **argv)
 
   hb_test_add (test_font_empty);
   hb_test_add (test_font_properties);
+  hb_test_add (test_font_nominal_glyphs_bulk);
 
   return hb_test_run();
 }
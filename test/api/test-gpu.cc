@@ -825,6 +825,203 @@ test_shapes (void)
 }
 
 
+static hb_codepoint_t
+nominal_glyph (hb_font_t *font, hb_codepoint_t unicode)
+{
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, unicode, &gid));
+  return gid;
+}
+
+/* Checks that @atlas_glyph holds exactly what a fresh encode of
+ * @glyph produces. */
+static void
+check_atlas_glyph (hb_gpu_atlas_t             *atlas,
+		   hb_font_t                  *font,
+		   hb_codepoint_t              glyph,
+		   const hb_gpu_atlas_glyph_t *atlas_glyph)
+{
+  hb_gpu_draw_t *draw = hb_gpu_draw_create_or_fail ();
+  hb_gpu_draw_glyph (draw, font, glyph);
+  hb_glyph_extents_t ext;
+  hb_blob_t *blob = hb_gpu_draw_encode (draw, &ext);
+  g_assert_nonnull (blob);
+
+  unsigned length;
+  const char *expected = hb_blob_get_data (blob, &length);
+  g_assert_cmpuint (atlas_glyph->length * 8, ==, length);
+  g_assert_cmpint (atlas_glyph->extents.x_bearing, ==, ext.x_bearing);
+  g_assert_cmpint (atlas_glyph->extents.width, ==, ext.width);
+
+  unsigned data_length;
+  const char *data = hb_gpu_atlas_get_data (atlas, &data_length);
+  g_assert_cmpuint ((atlas_glyph->offset + atlas_glyph->length) * 8, <=, data_length);
+  g_assert_true (0 == memcmp (data + atlas_glyph->offset * 8, expected, length));
+
+  hb_blob_destroy (blob);
+  hb_gpu_draw_destroy (draw);
+}
+
+static void
+test_atlas_glyph (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail ();
+  g_assert_nonnull (atlas);
+  g_assert_null (hb_gpu_atlas_get_data (atlas, nullptr));
+  g_assert_false (hb_gpu_atlas_get_dirty_range (atlas, nullptr, nullptr));
+
+  hb_codepoint_t a = nominal_glyph (font, 'a');
+  hb_codepoint_t b = nominal_glyph (font, 'b');
+
+  hb_gpu_atlas_glyph_t ga, gb;
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &ga));
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, b, &gb));
+  g_assert_cmpuint (ga.length, >, 0);
+  g_assert_cmpuint (gb.offset, ==, ga.offset + ga.length);
+  check_atlas_glyph (atlas, font, a, &ga);
+  check_atlas_glyph (atlas, font, b, &gb);
+
+  /* Everything written so far is dirty. */
+  unsigned offset, length;
+  g_assert_true (hb_gpu_atlas_get_dirty_range (atlas, &offset, &length));
+  g_assert_cmpuint (offset, ==, 0);
+  g_assert_cmpuint (length, ==, ga.length + gb.length);
+  hb_gpu_atlas_clear_dirty_range (atlas);
+
+  /* A cache hit writes nothing. */
+  unsigned serial = hb_gpu_atlas_get_serial (atlas);
+  hb_gpu_atlas_glyph_t again;
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &again));
+  g_assert_cmpuint (again.offset, ==, ga.offset);
+  g_assert_cmpuint (again.length, ==, ga.length);
+  g_assert_false (hb_gpu_atlas_get_dirty_range (atlas, nullptr, nullptr));
+
+  /* A different scale is a different glyph; only it is dirty. */
+  hb_font_set_scale (font, 1000, 1000);
+  hb_gpu_atlas_glyph_t scaled;
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &scaled));
+  g_assert_cmpuint (scaled.offset, ==, gb.offset + gb.length);
+  check_atlas_glyph (atlas, font, a, &scaled);
+  g_assert_true (hb_gpu_atlas_get_dirty_range (atlas, &offset, &length));
+  g_assert_cmpuint (offset, ==, scaled.offset);
+  g_assert_cmpuint (length, ==, scaled.length);
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), ==, serial);
+
+  hb_gpu_atlas_clear (atlas);
+  g_assert_null (hb_gpu_atlas_get_data (atlas, nullptr));
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), !=, serial);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_evict (void)
+{
+  hb_face_t *face = hb_test_open_font_file (FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_codepoint_t a = nominal_glyph (font, 'a');
+  hb_codepoint_t b = nominal_glyph (font, 'b');
+  hb_codepoint_t c = nominal_glyph (font, 'c');
+
+  /* Find out how big each glyph is. */
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail ();
+  hb_gpu_atlas_glyph_t ga, gb, gc;
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &ga));
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, b, &gb));
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, c, &gc));
+  unsigned max_length = MAX (MAX (ga.length, gb.length), gc.length);
+
+  /* Room for 'a' and any other one, not all three. */
+  unsigned budget = (ga.length + max_length) * 8;
+  hb_gpu_atlas_clear (atlas);
+  hb_gpu_atlas_set_max_bytes (atlas, budget);
+  g_assert_cmpuint (hb_gpu_atlas_get_max_bytes (atlas), ==, budget);
+
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &ga));
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, b, &gb));
+  unsigned serial = hb_gpu_atlas_get_serial (atlas);
+
+  /* Touch 'a', so 'b' is the least recently used. */
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &ga));
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, c, &gc));
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), !=, serial);
+
+  unsigned data_length;
+  hb_gpu_atlas_get_data (atlas, &data_length);
+  g_assert_cmpuint (data_length, <=, budget);
+  check_atlas_glyph (atlas, font, a, &ga);
+  check_atlas_glyph (atlas, font, c, &gc);
+
+  /* 'a' survived where it was; 'b' comes back, encoded again. */
+  hb_gpu_atlas_glyph_t again;
+  serial = hb_gpu_atlas_get_serial (atlas);
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, a, &again));
+  g_assert_cmpuint (again.offset, ==, ga.offset);
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), ==, serial);
+  g_assert_true (hb_gpu_atlas_get_glyph (atlas, font, b, &gb));
+  check_atlas_glyph (atlas, font, b, &gb);
+  hb_gpu_atlas_get_data (atlas, &data_length);
+  g_assert_cmpuint (data_length, <=, budget);
+
+  /* A glyph bigger than the whole budget fails without evicting. */
+  hb_gpu_atlas_set_max_bytes (atlas, 8);
+  hb_font_set_scale (font, 1000, 1000);
+  serial = hb_gpu_atlas_get_serial (atlas);
+  g_assert_false (hb_gpu_atlas_get_glyph (atlas, font, a, &again));
+  g_assert_cmpuint (hb_gpu_atlas_get_serial (atlas), ==, serial);
+
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_atlas_color_glyph (void)
+{
+  hb_face_t *face = hb_test_open_font_file (COLR_FONT_FILE);
+  hb_font_t *font = hb_font_create (face);
+
+  hb_gpu_atlas_t *atlas = hb_gpu_atlas_create_or_fail ();
+  hb_gpu_paint_t *paint = hb_gpu_paint_create_or_fail ();
+
+  unsigned num = hb_face_get_glyph_count (face);
+  unsigned checked = 0;
+  for (unsigned i = 0; i < num && checked < 8; i++)
+  {
+    if (!hb_ot_color_glyph_has_paint (face, i))
+      continue;
+
+    hb_gpu_paint_glyph (paint, font, i);
+    hb_blob_t *blob = hb_gpu_paint_encode (paint, nullptr);
+    hb_gpu_atlas_glyph_t g;
+    hb_bool_t ok = hb_gpu_atlas_get_color_glyph (atlas, font, i, &g);
+    g_assert_true (ok == (blob != nullptr));
+    if (blob)
+    {
+      unsigned length;
+      const char *expected = hb_blob_get_data (blob, &length);
+      g_assert_cmpuint (g.length * 8, ==, length);
+      const char *data = hb_gpu_atlas_get_data (atlas, nullptr);
+      g_assert_true (!length || 0 == memcmp (data + g.offset * 8, expected, length));
+      checked++;
+    }
+    hb_blob_destroy (blob);
+  }
+  g_assert_cmpuint (checked, >, 0);
+
+  hb_gpu_paint_destroy (paint);
+  hb_gpu_atlas_destroy (atlas);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+
 int
 main (int argc, char **argv)
 {
@@ -855,5 +1052,9 @@ main (int argc, char **argv)
   hb_test_add (test_paint_clip_path_depth_overflow);
   hb_test_add (test_paint_gradient_overflow_transform);
 
+  hb_test_add (test_atlas_glyph);
+  hb_test_add (test_atlas_evict);
+  hb_test_add (test_atlas_color_glyph);
+
   return hb_test_run ();
 }
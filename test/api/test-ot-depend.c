@@ -587,6 +587,300 @@ test_depend_gsub_formats (void)
   hb_face_destroy (face_source);
 }
 
+/* Subsets face with and without depend attached to the input, and checks
+ * both plans retain the same glyphs. */
+static void
+check_subset_closure (hb_face_t          *face,
+                      hb_subset_depend_t *depend,
+                      const hb_codepoint_t *unicodes,
+                      unsigned            count,
+                      hb_bool_t           all_features)
+{
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  g_assert_nonnull (input);
+  for (unsigned i = 0; i < count; i++)
+    hb_set_add (hb_subset_input_unicode_set (input), unicodes[i]);
+  if (all_features)
+    hb_set_invert (hb_subset_input_set (input, HB_SUBSET_SETS_LAYOUT_FEATURE_TAG));
+
+  hb_subset_plan_t *expected = hb_subset_plan_create_or_fail (face, input);
+  g_assert_nonnull (expected);
+
+  hb_subset_input_set_depend (input, depend);
+  g_assert_true (hb_subset_input_get_depend (input) == depend);
+  hb_subset_plan_t *actual = hb_subset_plan_create_or_fail (face, input);
+  g_assert_nonnull (actual);
+
+  g_assert_true (hb_map_is_equal (hb_subset_plan_old_to_new_glyph_mapping (expected),
+                                  hb_subset_plan_old_to_new_glyph_mapping (actual)));
+
+  hb_subset_plan_destroy (actual);
+  hb_subset_plan_destroy (expected);
+  hb_subset_input_destroy (input);
+}
+
+/* Test driving the subset GSUB closure from the depend graph */
+static void
+test_depend_subset_closure (void)
+{
+  static const hb_codepoint_t latin[] = {'f', 'i', 'l', 'A', 0x0301u, 0x00C1u};
+  static const hb_codepoint_t arabic[] = {0x0644u, 0x0627u, 0x0628u, 0x0646u, 0x06CCu, 0x06F1u};
+  static const char *fonts[] = {
+    "fonts/NotoSans-Bold.ttf",
+    "fonts/SourceSansPro-Regular.otf",
+    "fonts/NotoNastaliqUrdu-Regular.ttf",
+  };
+
+  for (unsigned i = 0; i < G_N_ELEMENTS (fonts); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[i]);
+    hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+    g_assert_nonnull (depend);
+
+    g_test_message ("Testing depend driven closure: %s", fonts[i]);
+    check_subset_closure (face, depend, latin, G_N_ELEMENTS (latin), FALSE);
+    check_subset_closure (face, depend, latin, G_N_ELEMENTS (latin), TRUE);
+    check_subset_closure (face, depend, arabic, G_N_ELEMENTS (arabic), FALSE);
+    check_subset_closure (face, depend, arabic, G_N_ELEMENTS (arabic), TRUE);
+
+    hb_subset_depend_destroy (depend);
+    hb_face_destroy (face);
+  }
+
+  /* A graph built from another face is ignored. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_face_t *other = hb_test_open_font_file ("fonts/SourceSansPro-Regular.otf");
+  hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (other);
+  g_assert_nonnull (depend);
+  check_subset_closure (face, depend, latin, G_N_ELEMENTS (latin), FALSE);
+  hb_subset_depend_destroy (depend);
+  hb_face_destroy (other);
+  hb_face_destroy (face);
+}
+
+#define CHAIN_LENGTH 20
+
+static void
+put16 (char *p, unsigned v)
+{
+  p[0] = (char) (v >> 8);
+  p[1] = (char) v;
+}
+
+/* Builds a face whose 'ccmp' lookups substitute glyph i with i + 1, for
+ * i from 1 to CHAIN_LENGTH.  The lookups come in reverse order, so each
+ * stage of the lookup closure only takes one step down the chain. */
+static hb_face_t *
+create_chain_face (void)
+{
+  static char gsub[10 + 20 + 12 + 2 * CHAIN_LENGTH + 2 + 22 * CHAIN_LENGTH];
+  static char maxp[6] = {0x00, 0x00, 0x50, 0x00};
+  unsigned feature_list = 30;
+  unsigned lookup_list = feature_list + 12 + 2 * CHAIN_LENGTH;
+
+  memset (gsub, 0, sizeof (gsub));
+  put16 (gsub + 0, 1);
+  put16 (gsub + 4, 10);
+  put16 (gsub + 6, feature_list);
+  put16 (gsub + 8, lookup_list);
+
+  /* ScriptList: DFLT, whose default LangSys has feature 0 only. */
+  char *p = gsub + 10;
+  put16 (p, 1);
+  memcpy (p + 2, "DFLT", 4);
+  put16 (p + 6, 8);
+  put16 (p + 8, 4);
+  put16 (p + 14, 0xFFFF);
+  put16 (p + 16, 1);
+
+  /* FeatureList: 'ccmp', with every lookup. */
+  p = gsub + feature_list;
+  put16 (p, 1);
+  memcpy (p + 2, "ccmp", 4);
+  put16 (p + 6, 8);
+  put16 (p + 10, CHAIN_LENGTH);
+  for (unsigned i = 0; i < CHAIN_LENGTH; i++)
+    put16 (p + 12 + 2 * i, i);
+
+  /* LookupList: lookup i is a SingleSubstFormat1 of glyph CHAIN_LENGTH - i,
+   * with delta 1. */
+  p = gsub + lookup_list;
+  put16 (p, CHAIN_LENGTH);
+  for (unsigned i = 0; i < CHAIN_LENGTH; i++)
+  {
+    unsigned offset = 2 + 2 * CHAIN_LENGTH + 20 * i;
+    char *lookup = p + offset;
+    put16 (p + 2 + 2 * i, offset);
+    put16 (lookup + 0, 1);
+    put16 (lookup + 4, 1);
+    put16 (lookup + 6, 8);
+    put16 (lookup + 8, 1);
+    put16 (lookup + 10, 6);
+    put16 (lookup + 12, 1);
+    put16 (lookup + 14, 1);
+    put16 (lookup + 16, 1);
+    put16 (lookup + 18, CHAIN_LENGTH - i);
+  }
+
+  put16 (maxp + 4, CHAIN_LENGTH + 2);
+
+  hb_face_t *builder = hb_face_builder_create ();
+  hb_blob_t *blob = hb_blob_create (gsub, sizeof (gsub), HB_MEMORY_MODE_READONLY, NULL, NULL);
+  hb_face_builder_add_table (builder, HB_TAG ('G','S','U','B'), blob);
+  hb_blob_destroy (blob);
+  blob = hb_blob_create (maxp, sizeof (maxp), HB_MEMORY_MODE_READONLY, NULL, NULL);
+  hb_face_builder_add_table (builder, HB_TAG ('m','a','x','p'), blob);
+  hb_blob_destroy (blob);
+
+  blob = hb_face_reference_blob (builder);
+  hb_face_destroy (builder);
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  return face;
+}
+
+/* Test that a closure past the lookup closure's stage limit ends where
+ * the lookup closure does, with or without the graph. */
+static void
+test_depend_subset_closure_limits (void)
+{
+  hb_face_t *face = create_chain_face ();
+  hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+  g_assert_nonnull (depend);
+  g_assert_true (find_dependency (depend, 1, 2, HB_OT_TAG_GSUB, NULL, NULL));
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  g_assert_nonnull (input);
+  hb_set_add (hb_subset_input_glyph_set (input), 1);
+
+  hb_subset_plan_t *expected = hb_subset_plan_create_or_fail (face, input);
+  g_assert_nonnull (expected);
+  hb_map_t *mapping = hb_subset_plan_old_to_new_glyph_mapping (expected);
+  g_assert_true (hb_map_has (mapping, 3));
+  g_assert_false (hb_map_has (mapping, CHAIN_LENGTH + 1));
+
+  hb_subset_input_set_depend (input, depend);
+  hb_subset_plan_t *actual = hb_subset_plan_create_or_fail (face, input);
+  g_assert_nonnull (actual);
+  g_assert_true (hb_map_is_equal (mapping,
+                                  hb_subset_plan_old_to_new_glyph_mapping (actual)));
+
+  /* Short of the limit, both finish the chain. */
+  hb_set_clear (hb_subset_input_glyph_set (input));
+  hb_set_add (hb_subset_input_glyph_set (input), CHAIN_LENGTH - 4);
+  hb_subset_plan_destroy (actual);
+  actual = hb_subset_plan_create_or_fail (face, input);
+  g_assert_nonnull (actual);
+  g_assert_true (hb_map_has (hb_subset_plan_old_to_new_glyph_mapping (actual),
+                             CHAIN_LENGTH + 1));
+
+  hb_subset_plan_destroy (actual);
+  hb_subset_plan_destroy (expected);
+  hb_subset_input_destroy (input);
+  hb_subset_depend_destroy (depend);
+  hb_face_destroy (face);
+}
+
+/* Checks a and b hold the same edges and sets. */
+static void
+check_same_graph (hb_subset_depend_t *a,
+                  hb_subset_depend_t *b,
+                  unsigned num_glyphs)
+{
+  hb_set_t *a_set = hb_set_create ();
+  hb_set_t *b_set = hb_set_create ();
+  unsigned max_set = 0;
+
+  for (hb_codepoint_t gid = 0; gid < num_glyphs + 1; gid++)
+  {
+    unsigned total = hb_subset_depend_lookup_glyph (a, gid, 0, NULL, NULL);
+    g_assert_cmpuint (total, ==, hb_subset_depend_lookup_glyph (b, gid, 0, NULL, NULL));
+    for (unsigned i = 0; i < total; i++)
+    {
+      hb_subset_depend_entry_t a_entry, b_entry;
+      unsigned count = 1;
+      hb_subset_depend_lookup_glyph (a, gid, i, &count, &a_entry);
+      count = 1;
+      hb_subset_depend_lookup_glyph (b, gid, i, &count, &b_entry);
+      g_assert_cmpmem (&a_entry, sizeof (a_entry), &b_entry, sizeof (b_entry));
+
+      if (a_entry.ligature_set_index != HB_CODEPOINT_INVALID)
+        max_set = MAX (max_set, a_entry.ligature_set_index + 1);
+      if (a_entry.context_set_index != HB_CODEPOINT_INVALID)
+        max_set = MAX (max_set, a_entry.context_set_index + 1);
+    }
+  }
+
+  for (unsigned i = 0; i < max_set + 1; i++)
+  {
+    hb_bool_t has = hb_subset_depend_lookup_set (a, i, a_set);
+    g_assert_true (has == hb_subset_depend_lookup_set (b, i, b_set));
+    if (has)
+      g_assert_true (hb_set_is_equal (a_set, b_set));
+  }
+
+  hb_set_destroy (b_set);
+  hb_set_destroy (a_set);
+}
+
+/* Test serializing a graph and reading it back */
+static void
+test_depend_serialize (void)
+{
+  static const hb_codepoint_t latin[] = {'f', 'i', 'l', 'A', 0x0301u, 0x00C1u};
+  static const hb_codepoint_t arabic[] = {0x0644u, 0x0627u, 0x0628u, 0x0646u, 0x06CCu, 0x06F1u};
+  static const char *fonts[] = {
+    "fonts/NotoSans-Bold.ttf",
+    "fonts/cff1_seac.C0.otf",
+    "fonts/COLRv0.extents.ttf",
+    "fonts/NotoNastaliqUrdu-Regular.ttf",
+  };
+
+  for (unsigned i = 0; i < G_N_ELEMENTS (fonts); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[i]);
+    hb_subset_depend_t *depend = hb_subset_depend_from_face_or_fail (face);
+    g_assert_nonnull (depend);
+
+    g_test_message ("Testing serialized graph: %s", fonts[i]);
+    hb_blob_t *blob = hb_subset_depend_serialize_or_fail (depend);
+    g_assert_nonnull (blob);
+    hb_subset_depend_t *loaded = hb_subset_depend_from_blob_or_fail (blob);
+    g_assert_nonnull (loaded);
+
+    check_same_graph (depend, loaded, hb_face_get_glyph_count (face));
+    check_subset_closure (face, loaded, latin, G_N_ELEMENTS (latin), FALSE);
+    check_subset_closure (face, loaded, arabic, G_N_ELEMENTS (arabic), FALSE);
+
+    /* Serializing a loaded graph gives the same bytes back. */
+    hb_blob_t *again = hb_subset_depend_serialize_or_fail (loaded);
+    hb_test_assert_blobs_equal (blob, again);
+
+    /* Truncated graphs are refused. */
+    unsigned length = hb_blob_get_length (blob);
+    hb_blob_t *truncated = hb_blob_create_sub_blob (blob, 0, length - 1);
+    g_assert_null (hb_subset_depend_from_blob_or_fail (truncated));
+    hb_blob_destroy (truncated);
+    truncated = hb_blob_create_sub_blob (blob, 0, 40);
+    g_assert_null (hb_subset_depend_from_blob_or_fail (truncated));
+    hb_blob_destroy (truncated);
+
+    hb_blob_destroy (again);
+    hb_subset_depend_destroy (loaded);
+    hb_blob_destroy (blob);
+    hb_subset_depend_destroy (depend);
+    hb_face_destroy (face);
+  }
+
+  /* Anything other than a serialized graph is refused. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_blob_t *blob = hb_face_reference_blob (face);
+  g_assert_null (hb_subset_depend_from_blob_or_fail (blob));
+  hb_blob_destroy (blob);
+  hb_face_destroy (face);
+  g_assert_null (hb_subset_depend_from_blob_or_fail (hb_blob_get_empty ()));
+}
+
 int
 main (int argc, char **argv)
 {
@@ -597,6 +891,9 @@ main (int argc, char **argv)
   hb_test_add (test_depend_colr);
   hb_test_add (test_depend_math);
   hb_test_add (test_depend_gsub_formats);
+  hb_test_add (test_depend_subset_closure);
+  hb_test_add (test_depend_subset_closure_limits);
+  hb_test_add (test_depend_serialize);
 
   return hb_test_run ();
 }
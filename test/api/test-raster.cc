@@ -286,6 +286,1032 @@ test_set_glyph_extents_overflow (void)
   hb_raster_paint_destroy (paint);
 }
 
+/* ── Test 8: glyph atlas ─────────────────────────────────────────── */
+
+static void
+test_atlas (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 32, 32);
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'A', &gid));
+
+  hb_raster_atlas_t *atlas = hb_raster_atlas_create_or_fail (HB_RASTER_FORMAT_A8, 64, 64);
+  g_assert_nonnull (atlas);
+  g_assert_cmpuint (hb_raster_atlas_get_page_count (atlas), ==, 0);
+
+  /* Same glyph, same spot. */
+  hb_raster_atlas_glyph_t g1, g2;
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 0.f, 0.f, &g1));
+  g_assert_cmpuint (g1.width, >, 0);
+  unsigned serial1, serial2, generation1, generation2;
+  const hb_raster_image_t *page = hb_raster_atlas_get_page (atlas, g1.page, &serial1, &generation1);
+  g_assert_nonnull (page);
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 5.f, -3.f, &g2));
+  g_assert_true (memcmp (&g1, &g2, sizeof (g1)) == 0);
+  hb_raster_atlas_get_page (atlas, g1.page, &serial2, &generation2);
+  g_assert_cmpuint (serial1, ==, serial2);
+  g_assert_cmpuint (generation1, ==, generation2);
+
+  /* Pixels match rendering directly. */
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  hb_glyph_extents_t gext;
+  hb_font_get_glyph_extents (font, gid, &gext);
+  hb_raster_draw_set_glyph_extents (rdr, &gext);
+  hb_raster_draw_glyph (rdr, font, gid);
+  hb_raster_image_t *img = hb_raster_draw_render (rdr);
+  hb_raster_extents_t ext, page_ext;
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpuint (ext.width, ==, g1.width);
+  g_assert_cmpuint (ext.height, ==, g1.height);
+  g_assert_cmpint (ext.x_origin, ==, g1.x_origin);
+  g_assert_cmpint (ext.y_origin, ==, g1.y_origin);
+  hb_raster_image_get_extents (page, &page_ext);
+  const uint8_t *pixels = hb_raster_image_get_buffer (page);
+  for (unsigned y = 0; y < g1.height; y++)
+    for (unsigned x = 0; x < g1.width; x++)
+      g_assert_cmpuint (pixels[(g1.y + y) * page_ext.stride + g1.x + x], ==,
+			hb_raster_image_get_buffer (img)[y * ext.stride + x]);
+  hb_raster_image_destroy (img);
+  hb_raster_draw_destroy (rdr);
+
+  /* Another subpixel position is another entry.  Adding it changes
+   * the pixels of its page, but not where the first glyph is. */
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 0.5f, 0.f, &g2));
+  g_assert_false (g1.page == g2.page && g1.x == g2.x && g1.y == g2.y);
+  g_assert_cmpuint (g2.page, ==, g1.page);
+  hb_raster_atlas_get_page (atlas, g1.page, &serial2, &generation2);
+  g_assert_cmpuint (serial1, !=, serial2);
+  g_assert_cmpuint (generation1, ==, generation2);
+
+  /* Filling the budget reuses pages. */
+  hb_raster_atlas_set_max_bytes (atlas, 64 * 64);
+  g_assert_cmpuint (hb_raster_atlas_get_max_bytes (atlas), ==, 64 * 64);
+  hb_raster_atlas_get_page (atlas, 0, &serial1, &generation1);
+  for (hb_codepoint_t u = 'B'; u <= 'Z'; u++)
+  {
+    hb_codepoint_t g;
+    g_assert_true (hb_font_get_nominal_glyph (font, u, &g));
+    g_assert_true (hb_raster_atlas_get_glyph (atlas, font, g, 0.f, 0.f, &g2));
+    g_assert_cmpuint (g2.x + g2.width, <=, 64);
+    g_assert_cmpuint (g2.y + g2.height, <=, 64);
+  }
+  g_assert_cmpuint (hb_raster_atlas_get_page_count (atlas), ==, 1);
+  hb_raster_atlas_get_page (atlas, 0, &serial2, &generation2);
+  g_assert_cmpuint (serial1, !=, serial2);
+  g_assert_cmpuint (generation1, !=, generation2);
+
+  /* Too big for a page. */
+  hb_font_set_scale (font, 200, 200);
+  g_assert_false (hb_raster_atlas_get_glyph (atlas, font, gid, 0.f, 0.f, &g2));
+
+  /* Glyphs without ink. */
+  hb_font_set_scale (font, 32, 32);
+  hb_codepoint_t space;
+  g_assert_true (hb_font_get_nominal_glyph (font, ' ', &space));
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, space, 0.f, 0.f, &g2));
+  g_assert_cmpuint (g2.width, ==, 0);
+
+  /* A page made again after a clear is a new generation. */
+  hb_raster_atlas_get_page (atlas, 0, nullptr, &generation1);
+  hb_raster_atlas_clear (atlas);
+  g_assert_cmpuint (hb_raster_atlas_get_page_count (atlas), ==, 0);
+  g_assert_null (hb_raster_atlas_get_page (atlas, 0, nullptr, nullptr));
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 0.f, 0.f, &g2));
+  hb_raster_atlas_get_page (atlas, 0, nullptr, &generation2);
+  g_assert_cmpuint (generation1, !=, generation2);
+  hb_raster_atlas_destroy (atlas);
+
+  /* Color atlas. */
+  atlas = hb_raster_atlas_create_or_fail (HB_RASTER_FORMAT_BGRA32, 128, 128);
+  g_assert_nonnull (atlas);
+  hb_raster_atlas_set_foreground (atlas, HB_COLOR (255, 0, 0, 255));
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 0.f, 0.f, &g1));
+  g_assert_cmpuint (g1.width, >, 0);
+  page = hb_raster_atlas_get_page (atlas, g1.page, nullptr, nullptr);
+  hb_raster_image_get_extents (page, &page_ext);
+  g_assert_cmpuint (hb_raster_image_get_format (page), ==, HB_RASTER_FORMAT_BGRA32);
+  bool inked = false;
+  pixels = hb_raster_image_get_buffer (page);
+  for (unsigned y = 0; y < g1.height; y++)
+    for (unsigned x = 0; x < g1.width; x++)
+      inked |= pixels[(g1.y + y) * page_ext.stride + (g1.x + x) * 4 + 3] != 0;
+  g_assert_true (inked);
+  hb_raster_atlas_set_foreground (atlas, HB_COLOR (0, 0, 255, 255));
+  g_assert_true (hb_raster_atlas_get_glyph (atlas, font, gid, 0.f, 0.f, &g2));
+  g_assert_false (g1.x == g2.x && g1.y == g2.y);
+  hb_raster_atlas_destroy (atlas);
+
+  g_assert_null (hb_raster_atlas_create_or_fail (HB_RASTER_FORMAT_A8, 0, 64));
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 9: whole-run rendering ─────────────────────────────────── */
+
+static void
+test_buffer (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 24, 24);
+
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "Hello, world", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, nullptr, 0);
+  unsigned count;
+  hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, &count);
+  hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  /* Same pixels as drawing glyph by glyph. */
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f, 3.f, 5.f);
+  hb_raster_draw_buffer (rdr, font, buffer);
+  float xx, yx, xy, yy, dx, dy;
+  hb_raster_draw_get_transform (rdr, &xx, &yx, &xy, &yy, &dx, &dy);
+  g_assert_cmpfloat (dx, ==, 3.f);
+  g_assert_cmpfloat (dy, ==, 5.f);
+  hb_raster_image_t *run = hb_raster_draw_render (rdr);
+  g_assert_nonnull (run);
+
+  float pen = 3.f;
+  for (unsigned i = 0; i < count; i++)
+  {
+    hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f,
+				  pen + pos[i].x_offset, 5.f + pos[i].y_offset);
+    hb_raster_draw_glyph (rdr, font, info[i].codepoint);
+    pen += pos[i].x_advance;
+  }
+  hb_raster_image_t *glyphs = hb_raster_draw_render (rdr);
+
+  hb_raster_extents_t run_ext, glyphs_ext;
+  hb_raster_image_get_extents (run, &run_ext);
+  hb_raster_image_get_extents (glyphs, &glyphs_ext);
+  g_assert_cmpint (run_ext.x_origin, ==, glyphs_ext.x_origin);
+  g_assert_cmpint (run_ext.y_origin, ==, glyphs_ext.y_origin);
+  g_assert_cmpuint (run_ext.width, ==, glyphs_ext.width);
+  g_assert_cmpuint (run_ext.height, ==, glyphs_ext.height);
+  g_assert_cmpuint (run_ext.width, >, (unsigned) (pen - 3.f) - 10);
+  g_assert_true (memcmp (hb_raster_image_get_buffer (run),
+			 hb_raster_image_get_buffer (glyphs),
+			 run_ext.stride * run_ext.height) == 0);
+
+  /* Painting the run covers the same ink. */
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  hb_raster_paint_set_transform (paint, 1.f, 0.f, 0.f, 1.f, 3.f, 5.f);
+  hb_raster_paint_buffer (paint, font, buffer);
+  hb_raster_image_t *painted = hb_raster_paint_render (paint);
+  g_assert_nonnull (painted);
+  hb_raster_extents_t painted_ext;
+  hb_raster_image_get_extents (painted, &painted_ext);
+  /* Glyph extents are rounded to font units, so allow a pixel of slack. */
+  g_assert_cmpint (abs (painted_ext.x_origin - run_ext.x_origin), <=, 1);
+  g_assert_cmpint (abs (painted_ext.y_origin - run_ext.y_origin), <=, 1);
+  g_assert_cmpint (abs ((int) painted_ext.width - (int) run_ext.width), <=, 2);
+  g_assert_cmpint (abs ((int) painted_ext.height - (int) run_ext.height), <=, 2);
+  const uint8_t *bgra = hb_raster_image_get_buffer (painted);
+  unsigned matched = 0;
+  for (unsigned py = 0; py < painted_ext.height; py++)
+    for (unsigned px = 0; px < painted_ext.width; px++)
+    {
+      int a = bgra[py * painted_ext.stride + px * 4 + 3];
+      int b = pixel_at (run, px + painted_ext.x_origin, py + painted_ext.y_origin);
+      g_assert_cmpint (abs (a - b), <=, 1);
+      matched += b != 0;
+    }
+  g_assert_cmpuint (matched, >, run_ext.width * run_ext.height / 8);
+  hb_raster_paint_recycle_image (paint, painted);
+
+  /* Wide runs are swept only where there are edges; spaced-out glyphs
+   * must come out the same as rendered alone. */
+  hb_font_set_scale (font, 64, 64);
+  hb_raster_draw_reset (rdr);
+  pen = 0.f;
+  for (unsigned i = 0; i < count; i++)
+  {
+    hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f, pen + .3f, .6f);
+    hb_raster_draw_glyph (rdr, font, info[i].codepoint);
+    pen += 80.f;
+  }
+  hb_raster_draw_recycle_image (rdr, run);
+  run = hb_raster_draw_render (rdr);
+  hb_raster_image_get_extents (run, &run_ext);
+  g_assert_cmpuint (run_ext.width, >=, 512);
+  pen = 0.f;
+  for (unsigned i = 0; i < count; i++)
+  {
+    hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f, pen + .3f, .6f);
+    hb_raster_draw_glyph (rdr, font, info[i].codepoint);
+    hb_raster_image_t *glyph = hb_raster_draw_render (rdr);
+    hb_raster_extents_t ext;
+    hb_raster_image_get_extents (glyph, &ext);
+    for (int y = run_ext.y_origin; y < run_ext.y_origin + (int) run_ext.height; y++)
+      for (int x = (int) pen - 8; x < (int) pen + 72; x++)
+	g_assert_cmpuint (pixel_at (run, x, y), ==, pixel_at (glyph, x, y));
+    hb_raster_image_destroy (glyph);
+    pen += 80.f;
+  }
+
+  /* Unshaped buffers draw nothing. */
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "Hello", -1, 0, -1);
+  hb_raster_draw_buffer (rdr, font, buffer);
+  hb_raster_draw_recycle_image (rdr, run);
+  run = hb_raster_draw_render (rdr);
+  hb_raster_image_get_extents (run, &run_ext);
+  g_assert_cmpuint (run_ext.width, ==, 0);
+
+  hb_raster_image_destroy (run);
+  hb_raster_image_destroy (glyphs);
+  hb_raster_paint_destroy (paint);
+  hb_raster_draw_destroy (rdr);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 10: strip-parallel rendering ───────────────────────────── */
+
+static void
+test_num_threads (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 1200, 1200);
+
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  g_assert_cmpuint (hb_raster_draw_get_num_threads (rdr), ==, 1);
+
+  /* Tall enough to be swept in strips: same pixels on any number of
+   * threads. */
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'g', &gid));
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.3f, 1.f, 0.f, 0.f);
+  hb_raster_draw_glyph (rdr, font, gid);
+  hb_raster_image_t *serial = hb_raster_draw_render (rdr);
+  g_assert_nonnull (serial);
+
+  hb_raster_extents_t serial_ext;
+  hb_raster_image_get_extents (serial, &serial_ext);
+  g_assert_cmpuint (serial_ext.height, >=, 512);
+
+  const unsigned thread_counts[] = {0, 2, 7};
+  for (unsigned num_threads : thread_counts)
+  {
+    hb_raster_draw_set_num_threads (rdr, num_threads);
+    hb_raster_draw_glyph (rdr, font, gid);
+    hb_raster_image_t *img = hb_raster_draw_render (rdr);
+    g_assert_nonnull (img);
+    g_assert_cmpuint (hb_raster_draw_get_num_threads (rdr), ==, num_threads);
+
+    hb_raster_extents_t ext;
+    hb_raster_image_get_extents (img, &ext);
+    g_assert_cmpmem (&ext, sizeof (ext), &serial_ext, sizeof (serial_ext));
+    g_assert_cmpmem (hb_raster_image_get_buffer (img), ext.stride * ext.height,
+		     hb_raster_image_get_buffer (serial), ext.stride * ext.height);
+    hb_raster_image_destroy (img);
+  }
+
+  /* Kept across clear, reset by reset. */
+  hb_raster_draw_clear (rdr);
+  g_assert_cmpuint (hb_raster_draw_get_num_threads (rdr), ==, 7);
+  hb_raster_draw_reset (rdr);
+  g_assert_cmpuint (hb_raster_draw_get_num_threads (rdr), ==, 1);
+
+  hb_raster_image_destroy (serial);
+  hb_raster_draw_destroy (rdr);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 11: distance fields ────────────────────────────────────── */
+
+static void
+test_sdf (void)
+{
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  g_assert_cmpint (hb_raster_draw_get_format (rdr), ==, HB_RASTER_FORMAT_A8);
+  g_assert_false (hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_BGRA32));
+  g_assert_cmpint (hb_raster_draw_get_format (rdr), ==, HB_RASTER_FORMAT_A8);
+
+  g_assert_cmpfloat (hb_raster_draw_get_sdf_spread (rdr), ==, 4.f);
+  hb_raster_draw_set_sdf_spread (rdr, 1000.f);
+  g_assert_cmpfloat (hb_raster_draw_get_sdf_spread (rdr), ==, 64.f);
+  hb_raster_draw_set_sdf_spread (rdr, -1.f);
+  g_assert_cmpfloat (hb_raster_draw_get_sdf_spread (rdr), ==, 4.f);
+
+  /* Single channel: 128 on the outline, 32 per pixel with a spread
+   * of 4, extents padded by the spread. */
+  g_assert_true (hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_SDF_A8));
+  draw_rect (rdr, 10.f, 10.f, 30.f, 30.f);
+  hb_raster_image_t *img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  g_assert_cmpint (hb_raster_image_get_format (img), ==, HB_RASTER_FORMAT_SDF_A8);
+
+  hb_raster_extents_t ext;
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpint (ext.x_origin, ==, 6);
+  g_assert_cmpint (ext.y_origin, ==, 6);
+  g_assert_cmpuint (ext.width, ==, 28);
+  g_assert_cmpuint (ext.height, ==, 28);
+
+  g_assert_cmpint (pixel_at (img, 20, 20), ==, 255);
+  g_assert_cmpint (pixel_at (img, 10, 20), ==, 144);
+  g_assert_cmpint (pixel_at (img, 9, 20), ==, 112);
+  g_assert_cmpint (pixel_at (img, 12, 20), ==, 208);
+  g_assert_cmpint (pixel_at (img, 6, 20), ==, 16);
+  g_assert_cmpint (pixel_at (img, 6, 6), ==, 0);
+  /* Rounded outside the corner: 0.5√2 pixels away. */
+  g_assert_cmpint (pixel_at (img, 9, 9), ==, 105);
+  hb_raster_image_destroy (img);
+
+  /* Multi-channel: the median keeps the corner sharp, the alpha
+   * channel has the true distance. */
+  g_assert_true (hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_MSDF_BGRA32));
+  draw_rect (rdr, 10.f, 10.f, 30.f, 30.f);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  g_assert_cmpint (hb_raster_image_get_format (img), ==, HB_RASTER_FORMAT_MSDF_BGRA32);
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpuint (ext.width, ==, 28);
+  g_assert_cmpuint (ext.stride, >=, 28 * 4);
+
+  const uint8_t *buf = hb_raster_image_get_buffer (img);
+  const uint8_t *corner = buf + (9 - ext.y_origin) * ext.stride + (9 - ext.x_origin) * 4;
+  uint8_t b = corner[0], g = corner[1], r = corner[2];
+  uint8_t lo = r < g ? r : g, hi = r < g ? g : r;
+  uint8_t median = b < lo ? lo : b > hi ? hi : b;
+  g_assert_cmpint (median, ==, 112);
+  g_assert_cmpint (corner[3], ==, 105);
+
+  const uint8_t *center = buf + (20 - ext.y_origin) * ext.stride + (20 - ext.x_origin) * 4;
+  for (unsigned c = 0; c < 4; c++)
+    g_assert_cmpint (center[c], ==, 255);
+  hb_raster_image_destroy (img);
+
+  /* Glyph extents are padded too. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 32, 32);
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'A', &gid));
+  hb_glyph_extents_t gext;
+  g_assert_true (hb_font_get_glyph_extents (font, gid, &gext));
+
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_A8);
+  hb_raster_draw_set_glyph_extents (rdr, &gext);
+  hb_raster_extents_t a8_ext;
+  hb_raster_draw_get_extents (rdr, &a8_ext);
+
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_SDF_A8);
+  hb_raster_draw_set_glyph_extents (rdr, &gext);
+  hb_raster_draw_get_extents (rdr, &ext);
+  g_assert_cmpint (ext.x_origin, ==, a8_ext.x_origin - 4);
+  g_assert_cmpint (ext.y_origin, ==, a8_ext.y_origin - 4);
+  g_assert_cmpuint (ext.width, ==, a8_ext.width + 8);
+  g_assert_cmpuint (ext.height, ==, a8_ext.height + 8);
+
+  hb_raster_draw_glyph (rdr, font, gid);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  hb_raster_image_destroy (img);
+
+  hb_raster_draw_reset (rdr);
+  g_assert_cmpint (hb_raster_draw_get_format (rdr), ==, HB_RASTER_FORMAT_A8);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+  hb_raster_draw_destroy (rdr);
+}
+
+/* ── Test 12: LCD subpixel coverage ─────────────────────────────── */
+
+static const uint8_t *
+lcd_pixel_at (hb_raster_image_t *img, int x, int y)
+{
+  hb_raster_extents_t ext;
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpint (x - ext.x_origin, >=, 0);
+  g_assert_cmpint (y - ext.y_origin, >=, 0);
+  g_assert_cmpint (x - ext.x_origin, <, (int) ext.width);
+  g_assert_cmpint (y - ext.y_origin, <, (int) ext.height);
+  return hb_raster_image_get_buffer (img) +
+	 (y - ext.y_origin) * ext.stride + (x - ext.x_origin) * 4;
+}
+
+static void
+assert_bgra (const uint8_t *px, int b, int g, int r, int a)
+{
+  g_assert_cmpint (px[0], ==, b);
+  g_assert_cmpint (px[1], ==, g);
+  g_assert_cmpint (px[2], ==, r);
+  g_assert_cmpint (px[3], ==, a);
+}
+
+static void
+test_lcd (void)
+{
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  g_assert_cmpint (hb_raster_draw_get_lcd_layout (rdr), ==, HB_RASTER_LCD_LAYOUT_RGB);
+  g_assert_false (hb_raster_draw_set_lcd_layout (rdr, (hb_raster_lcd_layout_t) 4));
+
+  uint8_t weights[5];
+  hb_raster_draw_get_lcd_filter (rdr, weights);
+  g_assert_cmpint (weights[0], ==, 8);
+  g_assert_cmpint (weights[1], ==, 77);
+  g_assert_cmpint (weights[2], ==, 86);
+
+  /* A rectangle on pixel boundaries: the filter spills 84 and 7 of the
+   * edge subpixel's coverage into the two subpixels before it. */
+  g_assert_true (hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_LCD_BGRA32));
+  draw_rect (rdr, 10.f, 10.f, 30.f, 30.f);
+  hb_raster_image_t *img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  g_assert_cmpint (hb_raster_image_get_format (img), ==, HB_RASTER_FORMAT_LCD_BGRA32);
+
+  hb_raster_extents_t ext;
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpint (ext.x_origin, ==, 9);
+  g_assert_cmpint (ext.y_origin, ==, 10);
+  g_assert_cmpuint (ext.width, ==, 22);
+  g_assert_cmpuint (ext.height, ==, 20);
+  g_assert_cmpuint (ext.stride, >=, 22 * 4);
+
+  assert_bgra (lcd_pixel_at (img,  9, 20),  84,   7,   0,  30);
+  assert_bgra (lcd_pixel_at (img, 10, 20), 255, 247, 170, 224);
+  assert_bgra (lcd_pixel_at (img, 20, 20), 255, 255, 255, 255);
+  assert_bgra (lcd_pixel_at (img, 29, 20), 170, 247, 255, 224);
+  assert_bgra (lcd_pixel_at (img, 30, 20),   0,   7,  84,  30);
+  hb_raster_image_destroy (img);
+
+  /* BGR swaps the ends. */
+  g_assert_true (hb_raster_draw_set_lcd_layout (rdr, HB_RASTER_LCD_LAYOUT_BGR));
+  draw_rect (rdr, 10.f, 10.f, 30.f, 30.f);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  assert_bgra (lcd_pixel_at (img,  9, 20),   0,   7,  84,  30);
+  assert_bgra (lcd_pixel_at (img, 10, 20), 170, 247, 255, 224);
+  hb_raster_image_destroy (img);
+
+  /* Vertical RGB: red on top, padded by a row instead. */
+  g_assert_true (hb_raster_draw_set_lcd_layout (rdr, HB_RASTER_LCD_LAYOUT_VRGB));
+  draw_rect (rdr, 10.f, 10.f, 30.f, 30.f);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  hb_raster_image_get_extents (img, &ext);
+  g_assert_cmpint (ext.x_origin, ==, 10);
+  g_assert_cmpint (ext.y_origin, ==, 9);
+  g_assert_cmpuint (ext.width, ==, 20);
+  g_assert_cmpuint (ext.height, ==, 22);
+  assert_bgra (lcd_pixel_at (img, 20,  9),   0,   7,  84,  30);
+  assert_bgra (lcd_pixel_at (img, 20, 10), 170, 247, 255, 224);
+  assert_bgra (lcd_pixel_at (img, 20, 29), 255, 247, 170, 224);
+  assert_bgra (lcd_pixel_at (img, 20, 30),  84,   7,   0,  30);
+  hb_raster_image_destroy (img);
+
+  /* A single-tap filter leaves the subpixels unfiltered. */
+  const uint8_t box[5] = {0, 0, 255, 0, 0};
+  hb_raster_draw_set_lcd_filter (rdr, box);
+  hb_raster_draw_set_lcd_layout (rdr, HB_RASTER_LCD_LAYOUT_RGB);
+  draw_rect (rdr, 10.f, 10.f, 30.5f, 30.f);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  assert_bgra (lcd_pixel_at (img,  9, 20),   0,   0,   0,   0);
+  assert_bgra (lcd_pixel_at (img, 30, 20),   0, 127, 254, 127);
+  hb_raster_image_destroy (img);
+
+  hb_raster_draw_set_lcd_filter (rdr, nullptr);
+  hb_raster_draw_get_lcd_filter (rdr, weights);
+  g_assert_cmpint (weights[4], ==, 8);
+
+  /* Glyph extents are padded across the subpixels, and a glyph's mean
+   * coverage stays close to grayscale rendering. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 48, 48);
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'W', &gid));
+  hb_glyph_extents_t gext;
+  g_assert_true (hb_font_get_glyph_extents (font, gid, &gext));
+
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_A8);
+  hb_raster_draw_set_glyph_extents (rdr, &gext);
+  hb_raster_extents_t a8_ext;
+  hb_raster_draw_get_extents (rdr, &a8_ext);
+  hb_raster_draw_glyph (rdr, font, gid);
+  hb_raster_image_t *a8 = hb_raster_draw_render (rdr);
+  g_assert_nonnull (a8);
+
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_LCD_BGRA32);
+  hb_raster_draw_set_glyph_extents (rdr, &gext);
+  hb_raster_draw_get_extents (rdr, &ext);
+  g_assert_cmpint (ext.x_origin, ==, a8_ext.x_origin - 1);
+  g_assert_cmpint (ext.y_origin, ==, a8_ext.y_origin);
+  g_assert_cmpuint (ext.width, ==, a8_ext.width + 2);
+  g_assert_cmpuint (ext.height, ==, a8_ext.height);
+  hb_raster_draw_glyph (rdr, font, gid);
+  img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+
+  double a8_sum = 0, lcd_sum = 0;
+  for (int y = ext.y_origin; y < ext.y_origin + (int) ext.height; y++)
+    for (int x = ext.x_origin; x < ext.x_origin + (int) ext.width; x++)
+    {
+      a8_sum += pixel_at (a8, x, y);
+      lcd_sum += lcd_pixel_at (img, x, y)[3];
+    }
+  g_assert_cmpfloat (a8_sum, >, 0.);
+  g_assert_cmpfloat (lcd_sum, >, a8_sum * 0.98);
+  g_assert_cmpfloat (lcd_sum, <, a8_sum * 1.02);
+  hb_raster_image_destroy (a8);
+  hb_raster_image_destroy (img);
+
+  hb_raster_draw_reset (rdr);
+  g_assert_cmpint (hb_raster_draw_get_format (rdr), ==, HB_RASTER_FORMAT_A8);
+  g_assert_cmpint (hb_raster_draw_get_lcd_layout (rdr), ==, HB_RASTER_LCD_LAYOUT_RGB);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+  hb_raster_draw_destroy (rdr);
+}
+
+/* ── Test 13: outline cache ──────────────────────────────────────── */
+
+/* Largest difference between two A8 images, over both extents. */
+static unsigned
+max_pixel_diff (hb_raster_image_t *a, hb_raster_image_t *b)
+{
+  hb_raster_extents_t ea, eb;
+  hb_raster_image_get_extents (a, &ea);
+  hb_raster_image_get_extents (b, &eb);
+  int x0 = MIN (ea.x_origin, eb.x_origin);
+  int y0 = MIN (ea.y_origin, eb.y_origin);
+  int x1 = MAX (ea.x_origin + (int) ea.width,  eb.x_origin + (int) eb.width);
+  int y1 = MAX (ea.y_origin + (int) ea.height, eb.y_origin + (int) eb.height);
+
+  unsigned diff = 0;
+  for (int y = y0; y < y1; y++)
+    for (int x = x0; x < x1; x++)
+      diff = MAX (diff, (unsigned) abs ((int) pixel_at (a, x, y) - (int) pixel_at (b, x, y)));
+  return diff;
+}
+
+static hb_raster_image_t *
+render_glyph_at (hb_raster_draw_t *rdr, hb_font_t *font, hb_codepoint_t gid,
+		 float dx, float dy)
+{
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.2f, 1.f, dx, dy);
+  hb_raster_draw_glyph (rdr, font, gid);
+  hb_raster_image_t *img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  return img;
+}
+
+static hb_raster_image_t *
+render_buffer_at (hb_raster_draw_t *rdr, hb_font_t *font, hb_buffer_t *buffer,
+		  float dx, float dy)
+{
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.f, 1.f, dx, dy);
+  hb_raster_draw_buffer (rdr, font, buffer);
+  hb_raster_image_t *img = hb_raster_draw_render (rdr);
+  g_assert_nonnull (img);
+  return img;
+}
+
+static void
+test_outline_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 64, 64);
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'g', &gid));
+
+  hb_raster_draw_t *uncached = hb_raster_draw_create_or_fail ();
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+  g_assert_cmpuint (hb_raster_draw_get_outline_cache_max_bytes (rdr), ==, 0);
+  hb_raster_draw_set_outline_cache_max_bytes (rdr, 1 << 20);
+  g_assert_cmpuint (hb_raster_draw_get_outline_cache_max_bytes (rdr), ==, 1 << 20);
+
+  /* Found in the cache or not, the same pixels; and all but the same
+   * as without a cache. */
+  hb_raster_image_t *reference = render_glyph_at (uncached, font, gid, 10.3f, 5.7f);
+  hb_raster_image_t *miss = render_glyph_at (rdr, font, gid, 10.3f, 5.7f);
+  hb_raster_image_t *hit = render_glyph_at (rdr, font, gid, 10.3f, 5.7f);
+  g_assert_cmpuint (max_pixel_diff (miss, hit), ==, 0);
+  g_assert_cmpuint (max_pixel_diff (miss, reference), <=, 2);
+  hb_raster_image_destroy (reference);
+  hb_raster_image_destroy (miss);
+  hb_raster_image_destroy (hit);
+
+  /* At other subpixel positions the cached edges only move. */
+  hb_raster_draw_t *fresh = hb_raster_draw_create_or_fail ();
+  hb_raster_draw_set_outline_cache_max_bytes (fresh, 1 << 20);
+  const float offsets[] = {0.25f, 0.5f, -3.75f};
+  for (float offset : offsets)
+  {
+    reference = render_glyph_at (uncached, font, gid, 10.3f + offset, 5.7f - offset);
+    miss = render_glyph_at (fresh, font, gid, 10.3f + offset, 5.7f - offset);
+    hit = render_glyph_at (rdr, font, gid, 10.3f + offset, 5.7f - offset);
+    g_assert_cmpuint (max_pixel_diff (miss, hit), ==, 0);
+    g_assert_cmpuint (max_pixel_diff (hit, reference), <=, 2);
+    hb_raster_image_destroy (reference);
+    hb_raster_image_destroy (miss);
+    hb_raster_image_destroy (hit);
+    hb_raster_draw_set_outline_cache_max_bytes (fresh, 0);
+    hb_raster_draw_set_outline_cache_max_bytes (fresh, 1 << 20);
+  }
+  hb_raster_draw_destroy (fresh);
+
+  /* A whole run, whose repeated glyphs land at different subpixel
+   * positions, is drawn the same from the cache, and within two levels
+   * of drawing it without. */
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "Hello, hello, world", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, nullptr, 0);
+  reference = render_buffer_at (uncached, font, buffer, 2.6f, 40.2f);
+  miss = render_buffer_at (rdr, font, buffer, 2.6f, 40.2f);
+  hit = render_buffer_at (rdr, font, buffer, 2.6f, 40.2f);
+  g_assert_cmpuint (max_pixel_diff (miss, hit), ==, 0);
+  g_assert_cmpuint (max_pixel_diff (hit, reference), <=, 2);
+  hb_raster_image_destroy (reference);
+  hb_raster_image_destroy (miss);
+  hb_raster_image_destroy (hit);
+  hb_buffer_destroy (buffer);
+
+  /* A changed font is not served stale outlines. */
+  hb_font_set_scale (font, 96, 96);
+  reference = render_glyph_at (uncached, font, gid, 10.3f, 5.7f);
+  hit = render_glyph_at (rdr, font, gid, 10.3f, 5.7f);
+  g_assert_cmpuint (max_pixel_diff (hit, reference), <=, 2);
+  hb_raster_image_destroy (reference);
+  hb_raster_image_destroy (hit);
+
+  /* Too small a budget keeps nothing, but still draws. */
+  hb_raster_draw_set_outline_cache_max_bytes (rdr, 16);
+  reference = render_glyph_at (uncached, font, gid, 1.5f, 2.5f);
+  hit = render_glyph_at (rdr, font, gid, 1.5f, 2.5f);
+  g_assert_cmpuint (max_pixel_diff (hit, reference), <=, 2);
+  hb_raster_image_destroy (reference);
+  hb_raster_image_destroy (hit);
+
+  /* Kept across clear, reset by reset. */
+  hb_raster_draw_clear (rdr);
+  g_assert_cmpuint (hb_raster_draw_get_outline_cache_max_bytes (rdr), ==, 16);
+  hb_raster_draw_reset (rdr);
+  g_assert_cmpuint (hb_raster_draw_get_outline_cache_max_bytes (rdr), ==, 0);
+
+  hb_raster_draw_destroy (rdr);
+  hb_raster_draw_destroy (uncached);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 14: rendering into caller memory ──────────────────────── */
+
+/* Renders @gid into @fb, a @fb_width × @fb_height surface of @bpp bytes
+ * per pixel with a wider stride, at @rect, and checks that against
+ * hb_raster_draw_render() composited over @background by hand, and
+ * that nothing outside @rect changed. */
+static void
+check_render_into (hb_raster_draw_t *rdr, hb_font_t *font, hb_codepoint_t gid,
+		   hb_raster_format_t format, unsigned bpp, uint8_t background,
+		   hb_raster_extents_t rect)
+{
+  const unsigned fb_width = 320, fb_height = 600, fb_stride = fb_width * bpp + 12;
+  const unsigned x0 = 5, y0 = 7; /* rect's place in fb */
+  g_assert_cmpuint (x0 + rect.width, <=, fb_width);
+  g_assert_cmpuint (y0 + rect.height, <=, fb_height);
+  uint8_t *fb = (uint8_t *) malloc (fb_stride * fb_height);
+  memset (fb, background, fb_stride * fb_height);
+
+  hb_raster_draw_set_format (rdr, format);
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.3f, 1.f, 0.f, 0.f);
+  hb_raster_draw_set_extents (rdr, &rect);
+  hb_raster_draw_glyph (rdr, font, gid);
+  hb_raster_image_t *reference = hb_raster_draw_render (rdr);
+  g_assert_nonnull (reference);
+
+  hb_raster_image_t *img = hb_raster_image_create_or_fail ();
+  rect.stride = fb_stride;
+  uint8_t *data = fb + y0 * fb_stride + x0 * bpp;
+  g_assert_true (hb_raster_image_configure_for_data (img, format, &rect, data));
+  g_assert_true (hb_raster_image_get_buffer (img) == data);
+
+  hb_raster_draw_set_transform (rdr, 1.f, 0.f, 0.3f, 1.f, 0.f, 0.f);
+  hb_raster_draw_set_extents (rdr, &rect);
+  hb_raster_draw_glyph (rdr, font, gid);
+  g_assert_true (hb_raster_draw_render_into (rdr, img));
+
+  hb_raster_extents_t ref_ext;
+  hb_raster_image_get_extents (reference, &ref_ext);
+  const uint8_t *ref = hb_raster_image_get_buffer (reference);
+  for (unsigned y = 0; y < fb_height; y++)
+    for (unsigned x = 0; x < fb_stride; x++)
+    {
+      uint8_t expected = background;
+      if (y >= y0 && y < y0 + rect.height &&
+	  x >= x0 * bpp && x < (x0 + rect.width) * bpp)
+      {
+	unsigned s = ref[(y - y0) * ref_ext.stride + x - x0 * bpp];
+	expected = (uint8_t) (s + ((background * (255 - s) + 255) >> 8));
+      }
+      if (fb[y * fb_stride + x] != expected)
+	g_error ("byte (%u, %u): %u, expected %u", x, y, fb[y * fb_stride + x], expected);
+    }
+
+  hb_raster_image_destroy (img);
+  hb_raster_image_destroy (reference);
+  free (fb);
+}
+
+static void
+test_render_into (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_set_scale (font, 1200, 1200);
+  hb_codepoint_t gid;
+  g_assert_true (hb_font_get_nominal_glyph (font, 'g', &gid));
+
+  hb_raster_draw_t *rdr = hb_raster_draw_create_or_fail ();
+
+  /* Over existing content, and over nothing, where it is exactly what
+   * hb_raster_draw_render() gives; in a rectangle cutting through the
+   * glyph. */
+  hb_raster_extents_t rect = {40, -250, 300, 590, 0};
+  check_render_into (rdr, font, gid, HB_RASTER_FORMAT_A8, 1, 0x40, rect);
+  check_render_into (rdr, font, gid, HB_RASTER_FORMAT_A8, 1, 0, rect);
+  check_render_into (rdr, font, gid, HB_RASTER_FORMAT_LCD_BGRA32, 4, 0x40, rect);
+
+  /* Tall enough to be swept in strips. */
+  hb_raster_draw_set_num_threads (rdr, 4);
+  check_render_into (rdr, font, gid, HB_RASTER_FORMAT_A8, 1, 0x40, rect);
+  hb_raster_draw_set_num_threads (rdr, 1);
+
+  /* Formats must match, and not be distance fields. */
+  uint8_t pixels[16 * 16] = {};
+  hb_raster_extents_t small = {0, 0, 16, 16, 0};
+  hb_raster_image_t *img = hb_raster_image_create_or_fail ();
+  g_assert_true (hb_raster_image_configure_for_data (img, HB_RASTER_FORMAT_A8, &small, pixels));
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_LCD_BGRA32);
+  draw_rect (rdr, 0, 0, 8, 8);
+  g_assert_false (hb_raster_draw_render_into (rdr, img));
+  g_assert_true (hb_raster_image_configure_for_data (img, HB_RASTER_FORMAT_SDF_A8, &small, pixels));
+  hb_raster_draw_set_format (rdr, HB_RASTER_FORMAT_SDF_A8);
+  draw_rect (rdr, 0, 0, 8, 8);
+  g_assert_false (hb_raster_draw_render_into (rdr, img));
+
+  /* Bad configurations are refused; configure() takes the image back
+   * to memory of its own. */
+  small.stride = 15;
+  g_assert_false (hb_raster_image_configure_for_data (img, HB_RASTER_FORMAT_A8, &small, pixels));
+  small.stride = 0;
+  g_assert_false (hb_raster_image_configure_for_data (img, HB_RASTER_FORMAT_A8, &small, NULL));
+  g_assert_false (hb_raster_image_configure_for_data (img, HB_RASTER_FORMAT_A8, NULL, pixels));
+  g_assert_true (hb_raster_image_configure (img, HB_RASTER_FORMAT_A8, &small));
+  g_assert_true (hb_raster_image_get_buffer (img) != pixels);
+
+  hb_raster_image_destroy (img);
+  hb_raster_draw_destroy (rdr);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+/* ── Test 15: gradients against a per-pixel reference ───────────── */
+
+/* Gradients are filled a span at a time, with SIMD where available, and
+ * looked up in a 256-entry color table on large areas.  Each pixel must
+ * be within GRADIENT_TOLERANCE levels, per premultiplied channel, of the
+ * color the gradient has at the pixel center, worked out here in double
+ * precision.  The table rounds positions by up to half an entry, 1/510;
+ * over the steepest stop segment below, 255 levels over half the line,
+ * that is one level, plus rounding both ways. */
+
+#define GRADIENT_TOLERANCE 2
+
+enum gradient_kind_t { LINEAR, RADIAL, SWEEP };
+
+static const hb_color_stop_t gradient_stops[] = {
+  {0.f,  false, HB_COLOR (0x20, 0x20, 0xF0, 0xFF)},
+  {.5f,  false, HB_COLOR (0x20, 0xC0, 0x20, 0x80)},
+  {1.f,  false, HB_COLOR (0xF0, 0x10, 0x40, 0xFF)},
+};
+
+static unsigned
+get_gradient_stops (hb_color_line_t *color_line HB_UNUSED,
+		    void *color_line_data HB_UNUSED,
+		    unsigned start,
+		    unsigned *count,
+		    hb_color_stop_t *stops,
+		    void *user_data HB_UNUSED)
+{
+  unsigned total = G_N_ELEMENTS (gradient_stops);
+  if (count)
+  {
+    unsigned n = start < total ? MIN (*count, total - start) : 0;
+    for (unsigned i = 0; i < n; i++)
+      stops[i] = gradient_stops[start + i];
+    *count = n;
+  }
+  return total;
+}
+
+static hb_paint_extend_t
+get_gradient_extend (hb_color_line_t *color_line HB_UNUSED,
+		     void *color_line_data,
+		     void *user_data HB_UNUSED)
+{
+  return *(hb_paint_extend_t *) color_line_data;
+}
+
+/* The gradient position at (x, y), or false where it paints nothing. */
+static bool
+reference_gradient_t (gradient_kind_t kind, double x, double y, double *t)
+{
+  switch (kind)
+  {
+  case LINEAR:
+  {
+    /* From (10, 5) to (60, 30). */
+    double dx = 50, dy = 25;
+    *t = ((x - 10) * dx + (y - 5) * dy) / (dx * dx + dy * dy);
+    return true;
+  }
+  case RADIAL:
+  {
+    /* From the circle at (30, 35) of radius 4 to the one at (45, 40)
+     * of radius 25, which contains it: the largest t whose circle
+     * passes through the point. */
+    double cdx = 15, cdy = 5, dr = 21, r0 = 4;
+    double px = x - 30, py = y - 35;
+    double A = cdx * cdx + cdy * cdy - dr * dr;
+    double B = -2 * (px * cdx + py * cdy + r0 * dr);
+    double C = px * px + py * py - r0 * r0;
+    double disc = B * B - 4 * A * C;
+    if (disc < 0) return false;
+    double t1 = (-B + sqrt (disc)) / (2 * A);
+    double t2 = (-B - sqrt (disc)) / (2 * A);
+    *t = MAX (t1, t2);
+    if (r0 + *t * dr < 0) *t = MIN (t1, t2);
+    return r0 + *t * dr >= 0;
+  }
+  case SWEEP:
+  default:
+  {
+    /* Around (45, 40), from .5 to 2 radians. */
+    double a = atan2 (y - 40, x - 45);
+    if (a < 0) a += 2 * G_PI;
+    *t = (a - .5) / (2 - .5);
+    return true;
+  }
+  }
+}
+
+/* Premultiplied BGRA of the color line at t. */
+static void
+reference_gradient_color (double t, hb_paint_extend_t extend, double bgra[4])
+{
+  if (extend == HB_PAINT_EXTEND_PAD)
+    t = CLAMP (t, 0., 1.);
+  else if (extend == HB_PAINT_EXTEND_REPEAT)
+    t -= floor (t);
+  else
+  {
+    t = fmod (fabs (t), 2.);
+    if (t > 1) t = 2 - t;
+  }
+
+  unsigned i = t < gradient_stops[1].offset ? 0 : 1;
+  const hb_color_stop_t *s0 = &gradient_stops[i], *s1 = &gradient_stops[i + 1];
+  double k = (t - s0->offset) / (s1->offset - s0->offset);
+  k = CLAMP (k, 0., 1.);
+
+  for (unsigned c = 0; c < 4; c++)
+  {
+    /* Bytes of hb_color_t are B, G, R, A from the top down. */
+    unsigned shift = 24 - 8 * c;
+    double a0 = (s0->color & 0xFF) / 255., a1 = (s1->color & 0xFF) / 255.;
+    double c0 = ((s0->color >> shift) & 0xFF) * (c < 3 ? a0 : 1.);
+    double c1 = ((s1->color >> shift) & 0xFF) * (c < 3 ? a1 : 1.);
+    bgra[c] = c0 + k * (c1 - c0);
+  }
+}
+
+static bool
+reference_gradient_pixel (gradient_kind_t kind, hb_paint_extend_t extend,
+			  double x, double y, double bgra[4])
+{
+  double t;
+  if (!reference_gradient_t (kind, x, y, &t))
+  {
+    bgra[0] = bgra[1] = bgra[2] = bgra[3] = 0;
+    return false;
+  }
+  reference_gradient_color (t, extend, bgra);
+  return true;
+}
+
+static void
+check_gradient (gradient_kind_t kind, hb_paint_extend_t extend,
+		unsigned width, unsigned height)
+{
+  hb_raster_paint_t *paint = hb_raster_paint_create_or_fail ();
+  g_assert_nonnull (paint);
+  hb_raster_extents_t ext = {-7, -4, width, height, 0};
+  hb_raster_paint_set_extents (paint, &ext);
+  hb_paint_funcs_t *funcs = hb_raster_paint_get_funcs (paint);
+
+  hb_color_line_t color_line = {0};
+  color_line.data = &extend;
+  color_line.get_color_stops = get_gradient_stops;
+  color_line.get_extend = get_gradient_extend;
+
+  switch (kind)
+  {
+  case LINEAR:
+    hb_paint_linear_gradient (funcs, paint, &color_line, 10, 5, 60, 30, -15, 55);
+    break;
+  case RADIAL:
+    hb_paint_radial_gradient (funcs, paint, &color_line, 30, 35, 4, 45, 40, 25);
+    break;
+  case SWEEP:
+    hb_paint_sweep_gradient (funcs, paint, &color_line, 45, 40, .5f, 2.f);
+    break;
+  }
+
+  hb_raster_image_t *img = hb_raster_paint_render (paint);
+  g_assert_nonnull (img);
+  hb_raster_extents_t img_ext;
+  hb_raster_image_get_extents (img, &img_ext);
+  g_assert_cmpint (img_ext.x_origin, ==, ext.x_origin);
+  g_assert_cmpint (img_ext.y_origin, ==, ext.y_origin);
+  g_assert_cmpuint (img_ext.width, ==, width);
+  g_assert_cmpuint (img_ext.height, ==, height);
+  const uint8_t *buffer = hb_raster_image_get_buffer (img);
+
+  /* Pixels whose color jumps within a hundredth of a pixel of their
+   * center, at a repeat seam or where the sweep wraps around, may fall
+   * on either side; they are skipped. */
+  unsigned checked = 0, skipped = 0;
+  for (unsigned row = 0; row < height; row++)
+    for (unsigned col = 0; col < width; col++)
+    {
+      double x = (double) col + ext.x_origin + .5, y = (double) row + ext.y_origin + .5;
+      double expected[4], near[4];
+      reference_gradient_pixel (kind, extend, x, y, expected);
+
+      bool edge = false;
+      static const double offsets[4][2] = {{-.01, 0}, {.01, 0}, {0, -.01}, {0, .01}};
+      for (unsigned o = 0; o < 4 && !edge; o++)
+      {
+	reference_gradient_pixel (kind, extend, x + offsets[o][0], y + offsets[o][1], near);
+	for (unsigned c = 0; c < 4; c++)
+	  if (fabs (near[c] - expected[c]) > 16)
+	    edge = true;
+      }
+      if (edge)
+      {
+	skipped++;
+	continue;
+      }
+
+      const uint8_t *pixel = buffer + row * img_ext.stride + col * 4;
+      for (unsigned c = 0; c < 4; c++)
+	if (fabs (pixel[c] - expected[c]) > GRADIENT_TOLERANCE)
+	  g_error ("gradient %d, extend %d, %ux%u: pixel (%u, %u) channel %u is %u, expected %.2f",
+		   kind, extend, width, height, col, row, c, pixel[c], expected[c]);
+      checked++;
+    }
+  g_assert_cmpuint (skipped, <, checked / 50);
+
+  hb_raster_paint_recycle_image (paint, img);
+  hb_raster_paint_destroy (paint);
+}
+
+static void
+test_gradients (void)
+{
+  static const hb_paint_extend_t extends[] = {
+    HB_PAINT_EXTEND_PAD,
+    HB_PAINT_EXTEND_REPEAT,
+    HB_PAINT_EXTEND_REFLECT,
+  };
+
+  for (unsigned kind = LINEAR; kind <= SWEEP; kind++)
+    for (unsigned i = 0; i < G_N_ELEMENTS (extends); i++)
+    {
+      /* Large enough for the color table, and odd-sized so that rows end
+       * partway through a vector; then small enough to go without it. */
+      check_gradient ((gradient_kind_t) kind, extends[i], 101, 83);
+      check_gradient ((gradient_kind_t) kind, extends[i], 37, 21);
+    }
+}
+
 /* ── main ────────────────────────────────────────────────────────── */
 
 int
@@ -300,6 +1326,14 @@ main (int argc, char **argv)
   hb_test_add (test_set_glyph_extents_with_transform);
   hb_test_add (test_image_nonfinite_transform);
   hb_test_add (test_set_glyph_extents_overflow);
+  hb_test_add (test_atlas);
+  hb_test_add (test_buffer);
+  hb_test_add (test_num_threads);
+  hb_test_add (test_sdf);
+  hb_test_add (test_lcd);
+  hb_test_add (test_outline_cache);
+  hb_test_add (test_render_into);
+  hb_test_add (test_gradients);
 
   return hb_test_run ();
 }
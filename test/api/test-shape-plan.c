@@ -318,6 +318,68 @@ test_ot_shape_plan_get_feature_tags_userfeatures_disablenondeafult (void)
   hb_face_destroy (face);
 }
 
+static void
+shape_with_kern_value (hb_font_t *font, unsigned int value)
+{
+  hb_feature_t feature = {HB_TAG ('k','e','r','n'), value, HB_FEATURE_GLOBAL_START, HB_FEATURE_GLOBAL_END};
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "Hello", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, &feature, 1);
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 5);
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_shape_plan_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  unsigned int hits, misses, evictions;
+
+  hb_shape_plan_cache_get_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  g_assert_cmpuint (evictions, ==, 0);
+
+  hb_shape_plan_cache_set_limits (face, 4, 0);
+
+  /* Cycling through more plans than fit evicts on every miss. */
+  for (unsigned int round = 0; round < 2; round++)
+    for (unsigned int i = 0; i < 8; i++)
+      shape_with_kern_value (font, i);
+  hb_shape_plan_cache_get_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 16);
+  g_assert_cmpuint (evictions, ==, 12);
+
+  /* The four most recently used plans are still cached. */
+  for (unsigned int i = 4; i < 8; i++)
+    shape_with_kern_value (font, i);
+  hb_shape_plan_cache_get_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (hits, ==, 4);
+  g_assert_cmpuint (misses, ==, 16);
+  g_assert_cmpuint (evictions, ==, 12);
+
+  /* Lowering the byte budget evicts immediately. */
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  props.script = HB_SCRIPT_LATIN;
+  props.direction = HB_DIRECTION_LTR;
+  hb_shape_plan_t *plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  hb_shape_plan_cache_set_limits (face, 0, 1);
+  hb_shape_plan_cache_get_stats (face, &hits, &misses, &evictions);
+  g_assert_cmpuint (evictions, ==, 17);
+
+  /* Evicted plans stay usable while referenced. */
+  g_assert_true (hb_shape_plan_get_shaper (plan) != NULL);
+  hb_shape_plan_destroy (plan);
+
+  hb_shape_plan_cache_get_stats (face, NULL, NULL, NULL);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -331,5 +393,7 @@ main (int argc, char **argv)
   hb_test_add (test_ot_shape_plan_get_feature_tags_userfeatures_disablepartial);
   hb_test_add (test_ot_shape_plan_get_feature_tags_userfeatures_disablenondeafult);
 
+  hb_test_add (test_shape_plan_cache);
+
   return hb_test_run();
 }
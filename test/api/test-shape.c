@@ -207,6 +207,230 @@ test_shape_overlong_mark_cluster (void)
 }
 
 
+static void
+test_shape_batch (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  const char *texts[] = {"Hello", "", "world", "\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85", "Hello"};
+  hb_buffer_t *batch[G_N_ELEMENTS (texts)];
+  hb_buffer_t *single[G_N_ELEMENTS (texts)];
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS (texts); i++)
+  {
+    batch[i] = hb_buffer_create ();
+    hb_buffer_add_utf8 (batch[i], texts[i], -1, 0, -1);
+    hb_buffer_guess_segment_properties (batch[i]);
+
+    single[i] = hb_buffer_create ();
+    hb_buffer_add_utf8 (single[i], texts[i], -1, 0, -1);
+    hb_buffer_guess_segment_properties (single[i]);
+    hb_shape (font, single[i], NULL, 0);
+  }
+
+  g_assert_true (hb_shape_batch (font, batch, G_N_ELEMENTS (texts), NULL, 0, NULL));
+
+  for (i = 0; i < G_N_ELEMENTS (texts); i++)
+  {
+    g_assert_cmpint (hb_buffer_diff (batch[i], single[i], (hb_codepoint_t) -1, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+    hb_buffer_destroy (batch[i]);
+    hb_buffer_destroy (single[i]);
+  }
+
+  g_assert_true (hb_shape_batch (font, NULL, 0, NULL, 0, NULL));
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_parallel (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  const char *texts[] = {"Hello", "", "world", "\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85", "Hello"};
+  hb_buffer_t *parallel[64];
+  hb_buffer_t *single[G_N_ELEMENTS (parallel)];
+  unsigned int num_threads[] = {0, 1, 2, 3, 100};
+  unsigned int i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (parallel); i++)
+  {
+    single[i] = hb_buffer_create ();
+    hb_buffer_add_utf8 (single[i], texts[i % G_N_ELEMENTS (texts)], -1, 0, -1);
+    hb_buffer_guess_segment_properties (single[i]);
+    hb_shape (font, single[i], NULL, 0);
+  }
+
+  for (j = 0; j < G_N_ELEMENTS (num_threads); j++)
+  {
+    for (i = 0; i < G_N_ELEMENTS (parallel); i++)
+    {
+      parallel[i] = hb_buffer_create ();
+      hb_buffer_add_utf8 (parallel[i], texts[i % G_N_ELEMENTS (texts)], -1, 0, -1);
+      hb_buffer_guess_segment_properties (parallel[i]);
+    }
+
+    g_assert_true (hb_shape_parallel (font, parallel, G_N_ELEMENTS (parallel), NULL, 0, NULL, num_threads[j]));
+
+    for (i = 0; i < G_N_ELEMENTS (parallel); i++)
+    {
+      g_assert_cmpint (hb_buffer_diff (parallel[i], single[i], (hb_codepoint_t) -1, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+      hb_buffer_destroy (parallel[i]);
+    }
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (parallel); i++)
+    hb_buffer_destroy (single[i]);
+
+  g_assert_true (hb_shape_parallel (font, NULL, 0, NULL, 0, NULL, 4));
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_cached (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/NotoSans-Bold.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_shape_cache_t *cache = hb_shape_cache_create ();
+  const char *texts[] = {"Hello", "Hello world", "", "\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85", "world  Hello "};
+  unsigned int hits, misses, prev_hits;
+  unsigned int round, i;
+
+  for (round = 0; round < 3; round++)
+  {
+    /* Stop storing anything in the last round. */
+    if (round == 2)
+    {
+      hb_shape_cache_get_stats (cache, &prev_hits, NULL);
+      hb_shape_cache_set_max_bytes (cache, 0);
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (texts); i++)
+    {
+      hb_buffer_t *cached = hb_buffer_create ();
+      hb_buffer_t *expected = hb_buffer_create ();
+
+      hb_buffer_add_utf8 (cached, texts[i], -1, 0, -1);
+      hb_buffer_guess_segment_properties (cached);
+      hb_buffer_add_utf8 (expected, texts[i], -1, 0, -1);
+      hb_buffer_guess_segment_properties (expected);
+
+      g_assert_true (hb_shape_cached (font, cached, NULL, 0, NULL, cache));
+      hb_shape (font, expected, NULL, 0);
+      g_assert_cmpint (hb_buffer_diff (cached, expected, (hb_codepoint_t) -1, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+
+      hb_buffer_destroy (cached);
+      hb_buffer_destroy (expected);
+    }
+  }
+
+  /* Single words are independent of anything else, so must have been
+   * found the second time around, and not after emptying the cache. */
+  hb_shape_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (prev_hits, >, 0);
+  g_assert_cmpuint (hits, ==, prev_hits);
+  g_assert_cmpuint (misses, >, 0);
+
+  /* Stats count words, whether or not the whole buffer is found. */
+  {
+    const char *words[] = {"Hold Held Herd", "Hold Held Herd", "Hold Hello Herd"};
+    const unsigned int expected_hits[] = {0, 3, 5};
+    const unsigned int expected_misses[] = {3, 3, 4};
+    hb_shape_cache_t *fresh = hb_shape_cache_create ();
+    for (i = 0; i < G_N_ELEMENTS (words); i++)
+    {
+      hb_buffer_t *buffer = hb_buffer_create ();
+      hb_buffer_add_utf8 (buffer, words[i], -1, 0, -1);
+      hb_buffer_guess_segment_properties (buffer);
+      g_assert_true (hb_shape_cached (font, buffer, NULL, 0, NULL, fresh));
+      hb_buffer_destroy (buffer);
+
+      hb_shape_cache_get_stats (fresh, &hits, &misses);
+      g_assert_cmpuint (hits, ==, expected_hits[i]);
+      g_assert_cmpuint (misses, ==, expected_misses[i]);
+    }
+    hb_shape_cache_destroy (fresh);
+  }
+
+  {
+    hb_buffer_t *buffer = hb_buffer_create ();
+    hb_buffer_add_utf8 (buffer, texts[0], -1, 0, -1);
+    hb_buffer_guess_segment_properties (buffer);
+    g_assert_true (hb_shape_cached (font, buffer, NULL, 0, NULL, NULL));
+    g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 5);
+    hb_buffer_destroy (buffer);
+  }
+
+  hb_shape_cache_destroy (cache);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static hb_bool_t
+message_func (hb_buffer_t *buffer HB_UNUSED,
+	      hb_font_t *font HB_UNUSED,
+	      const char *message HB_UNUSED,
+	      void *user_data HB_UNUSED)
+{
+  return true;
+}
+
+/* Runs of single substitution / positioning lookups are applied in one
+ * pass, except when messaging, which wants to see each lookup on its own. */
+static void
+test_shape_fused_lookups (void)
+{
+  const char *fonts[] = {"fonts/NotoSans-Bold.ttf", "fonts/SourceSansPro-Regular.otf"};
+  const char *texts[] = {"Hello 1/2 World!", "\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 2026", "fi ffl Tj 0"};
+  /* Some of these have a glyph go through more than one lookup of a run. */
+  const char *features[] = {"", "smcp,c2sc", "pnum,onum", "pnum,zero,sups", "frac,-kern"};
+  unsigned int f, t, k;
+
+  for (f = 0; f < G_N_ELEMENTS (fonts); f++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[f]);
+    hb_font_t *font = hb_font_create (face);
+
+    for (t = 0; t < G_N_ELEMENTS (texts); t++)
+      for (k = 0; k < G_N_ELEMENTS (features); k++)
+      {
+	hb_feature_t feature_list[4];
+	unsigned int num_features = 0;
+	const char *p = features[k];
+	hb_buffer_t *fused = hb_buffer_create ();
+	hb_buffer_t *unfused = hb_buffer_create ();
+
+	while (*p)
+	{
+	  const char *end = strchr (p, ',');
+	  if (!end) end = p + strlen (p);
+	  g_assert_true (hb_feature_from_string (p, end - p, &feature_list[num_features++]));
+	  p = *end ? end + 1 : end;
+	}
+
+	hb_buffer_add_utf8 (fused, texts[t], -1, 0, -1);
+	hb_buffer_guess_segment_properties (fused);
+	hb_buffer_add_utf8 (unfused, texts[t], -1, 0, -1);
+	hb_buffer_guess_segment_properties (unfused);
+	hb_buffer_set_message_func (unfused, message_func, NULL, NULL);
+
+	hb_shape (font, fused, feature_list, num_features);
+	hb_shape (font, unfused, feature_list, num_features);
+	g_assert_cmpint (hb_buffer_diff (fused, unfused, (hb_codepoint_t) -1, 0), ==, HB_BUFFER_DIFF_FLAG_EQUAL);
+
+	hb_buffer_destroy (fused);
+	hb_buffer_destroy (unfused);
+      }
+
+    hb_font_destroy (font);
+    hb_face_destroy (face);
+  }
+}
+
 static void
 test_shape_list (void)
 {
@@ -228,6 +452,10 @@ main (int argc, char **argv)
   hb_test_add (test_shape);
   hb_test_add (test_shape_clusters);
   hb_test_add (test_shape_overlong_mark_cluster);
+  hb_test_add (test_shape_batch);
+  hb_test_add (test_shape_parallel);
+  hb_test_add (test_shape_cached);
+  hb_test_add (test_shape_fused_lookups);
   /* TODO test fallback shaper */
   /* TODO test shaper_full */
   hb_test_add (test_shape_list);
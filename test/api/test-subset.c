@@ -192,6 +192,178 @@ test_subset_plan (void)
   hb_face_destroy (face_ac);
 }
 
+static hb_blob_t *
+_subset_on_threads (hb_face_t         *face,
+		    hb_subset_input_t *input,
+		    unsigned           num_threads)
+{
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  g_assert_true (plan);
+  g_assert_cmpuint (hb_subset_plan_get_num_threads (plan), ==, 1);
+  hb_subset_plan_set_num_threads (plan, num_threads);
+  g_assert_cmpuint (hb_subset_plan_get_num_threads (plan), ==, num_threads);
+
+  hb_face_t *subset = hb_subset_plan_execute_or_fail (plan);
+  g_assert_true (subset);
+  hb_blob_t *blob = hb_face_reference_blob (subset);
+
+  hb_face_destroy (subset);
+  hb_subset_plan_destroy (plan);
+  return blob;
+}
+
+static void
+_check_subset_on_threads (const char *font_file,
+			  hb_tag_t    pinned_axis,
+			  float       pinned_value)
+{
+  hb_face_t *face = hb_test_open_font_file (font_file);
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_add_range (hb_subset_input_unicode_set (input), 0, 0x10FFFF);
+  if (pinned_axis)
+    g_assert_true (hb_subset_input_pin_axis_location (input, face, pinned_axis, pinned_value));
+
+  hb_blob_t *serial = _subset_on_threads (face, input, 1);
+  hb_blob_t *parallel = _subset_on_threads (face, input, 4);
+
+  unsigned serial_length, parallel_length;
+  const char *serial_data = hb_blob_get_data (serial, &serial_length);
+  const char *parallel_data = hb_blob_get_data (parallel, &parallel_length);
+  g_assert_cmpuint (serial_length, >, 0);
+  g_assert_cmpmem (serial_data, serial_length, parallel_data, parallel_length);
+
+  hb_blob_destroy (serial);
+  hb_blob_destroy (parallel);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_plan_num_threads (void)
+{
+  _check_subset_on_threads ("fonts/Roboto-Regular.abc.ttf", 0, 0.f);
+  _check_subset_on_threads ("fonts/NotoNastaliqUrdu-Regular.ttf", 0, 0.f);
+  _check_subset_on_threads ("fonts/AdobeVFPrototype-Subset.otf", 0, 0.f);
+  _check_subset_on_threads ("fonts/SourceSansVariable-Roman.abc.ttf", 0, 0.f);
+  /* Instancing: hmtx, maxp and OS/2 wait on glyf, GPOS on GDEF. */
+  _check_subset_on_threads ("fonts/Roboto-Variable.abc.ttf", HB_TAG ('w','g','h','t'), 700.f);
+  _check_subset_on_threads ("fonts/Mada-VF.ttf", HB_TAG ('w','g','h','t'), 300.f);
+}
+
+static hb_blob_t *
+_execute_plan (hb_subset_plan_t *plan)
+{
+  hb_face_t *subset = hb_subset_plan_execute_or_fail (plan);
+  g_assert_true (subset);
+  hb_blob_t *blob = hb_face_reference_blob (subset);
+  hb_face_destroy (subset);
+  return blob;
+}
+
+static void
+_check_extended_plan (const char *font_file,
+		      hb_tag_t    pinned_axis,
+		      float       pinned_value)
+{
+  hb_face_t *face = hb_test_open_font_file (font_file);
+
+  /* Interleave the font's unicodes across three steps, adding a couple
+   * of glyphs by id in the last one. */
+  hb_set_t *all = hb_set_create ();
+  hb_face_collect_unicodes (face, all);
+  hb_set_t *steps[3];
+  for (unsigned i = 0; i < 3; i++)
+    steps[i] = hb_set_create ();
+  hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+  for (unsigned i = 0; hb_set_next (all, &cp); i++)
+    hb_set_add (steps[i % 3], cp);
+  hb_set_t *glyphs = hb_set_create ();
+  hb_set_add (glyphs, hb_face_get_glyph_count (face) - 1);
+  hb_set_add (glyphs, hb_face_get_glyph_count (face) / 2);
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_union (hb_subset_input_unicode_set (input), steps[0]);
+  if (pinned_axis)
+    g_assert_true (hb_subset_input_pin_axis_location (input, face, pinned_axis, pinned_value));
+
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  g_assert_true (plan);
+  hb_subset_plan_t *plan1 = hb_subset_plan_create_extended_or_fail (plan, steps[1], NULL);
+  g_assert_true (plan1);
+  hb_subset_plan_t *plan2 = hb_subset_plan_create_extended_or_fail (plan1, steps[2], glyphs);
+  g_assert_true (plan2);
+
+  hb_set_union (hb_subset_input_unicode_set (input), steps[1]);
+  hb_set_union (hb_subset_input_unicode_set (input), steps[2]);
+  hb_set_union (hb_subset_input_glyph_set (input), glyphs);
+  hb_subset_plan_t *fresh = hb_subset_plan_create_or_fail (face, input);
+  g_assert_true (fresh);
+
+  g_assert_true (hb_map_is_equal (hb_subset_plan_old_to_new_glyph_mapping (plan2),
+				  hb_subset_plan_old_to_new_glyph_mapping (fresh)));
+  g_assert_true (hb_map_is_equal (hb_subset_plan_unicode_to_old_glyph_mapping (plan2),
+				  hb_subset_plan_unicode_to_old_glyph_mapping (fresh)));
+
+  hb_blob_t *extended_blob = _execute_plan (plan2);
+  hb_blob_t *fresh_blob = _execute_plan (fresh);
+  unsigned extended_length, fresh_length;
+  const char *extended_data = hb_blob_get_data (extended_blob, &extended_length);
+  const char *fresh_data = hb_blob_get_data (fresh_blob, &fresh_length);
+  g_assert_cmpuint (fresh_length, >, 0);
+  g_assert_cmpmem (extended_data, extended_length, fresh_data, fresh_length);
+
+  hb_blob_destroy (extended_blob);
+  hb_blob_destroy (fresh_blob);
+  hb_subset_plan_destroy (fresh);
+  hb_subset_plan_destroy (plan2);
+  hb_subset_plan_destroy (plan1);
+  hb_subset_plan_destroy (plan);
+  hb_subset_input_destroy (input);
+  hb_set_destroy (glyphs);
+  for (unsigned i = 0; i < 3; i++)
+    hb_set_destroy (steps[i]);
+  hb_set_destroy (all);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_plan_create_extended (void)
+{
+  _check_extended_plan ("fonts/Roboto-Regular.components.ttf", 0, 0.f);
+  _check_extended_plan ("fonts/NotoSans-Bold.ttf", 0, 0.f);
+  _check_extended_plan ("fonts/NotoNastaliqUrdu-Regular.ttf", 0, 0.f);
+  _check_extended_plan ("fonts/SourceSansPro-Regular.otf", 0, 0.f);
+  _check_extended_plan ("fonts/cmunrm.otf", 0, 0.f);
+  _check_extended_plan ("fonts/MathTestFontFull.otf", 0, 0.f);
+  _check_extended_plan ("fonts/test_glyphs-glyf_colr_1_variable.ttf", 0, 0.f);
+  _check_extended_plan ("fonts/Mada-VF.ttf", HB_TAG ('w','g','h','t'), 300.f);
+}
+
+static void
+test_subset_plan_create_extended_args (void)
+{
+  g_assert_null (hb_subset_plan_create_extended_or_fail (NULL, NULL, NULL));
+
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_add (hb_subset_input_unicode_set (input), 'a');
+  hb_subset_plan_t *plan = hb_subset_plan_create_or_fail (face, input);
+  hb_subset_plan_set_num_threads (plan, 3);
+
+  hb_set_t *unicodes = hb_set_create ();
+  hb_set_add (unicodes, 'b');
+  hb_subset_plan_t *extended = hb_subset_plan_create_extended_or_fail (plan, unicodes, NULL);
+  g_assert_nonnull (extended);
+  g_assert_cmpuint (hb_subset_plan_get_num_threads (extended), ==, 3);
+
+  hb_subset_plan_destroy (extended);
+  hb_set_destroy (unicodes);
+  hb_subset_plan_destroy (plan);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (face);
+}
+
 static hb_blob_t*
 _copy_table (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data)
 {
@@ -600,6 +772,127 @@ test_subset_input_to_string (void)
     hb_subset_input_destroy (input);
   }
 }
+
+static hb_subset_input_t *
+create_abc_input (void)
+{
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_t *codepoints = hb_subset_input_unicode_set (input);
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'b');
+  hb_set_add (codepoints, 'c');
+  return input;
+}
+
+static void
+check_same_font (hb_face_t *a, hb_face_t *b)
+{
+  hb_blob_t *blob_a = hb_face_reference_blob (a);
+  hb_blob_t *blob_b = hb_face_reference_blob (b);
+  unsigned len_a, len_b;
+  const char *data_a = hb_blob_get_data (blob_a, &len_a);
+  const char *data_b = hb_blob_get_data (blob_b, &len_b);
+  g_assert_cmpuint (len_a, >, 0);
+  g_assert_cmpmem (data_a, len_a, data_b, len_b);
+  hb_blob_destroy (blob_a);
+  hb_blob_destroy (blob_b);
+}
+
+static void
+test_subset_cached (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_subset_cache_t *cache = hb_subset_cache_create_or_fail ();
+  g_assert_nonnull (cache);
+  unsigned hits, misses;
+
+  hb_subset_input_t *input = create_abc_input ();
+  hb_face_t *expected = hb_subset_or_fail (face, input);
+  hb_face_t *first = hb_subset_cached_or_fail (face, input, cache);
+  g_assert_nonnull (first);
+  check_same_font (expected, first);
+
+  /* An equal input, built separately, in another order. */
+  hb_subset_input_t *input2 = hb_subset_input_create_or_fail ();
+  hb_set_t *codepoints = hb_subset_input_unicode_set (input2);
+  hb_set_add (codepoints, 'c');
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'b');
+  hb_face_t *second = hb_subset_cached_or_fail (face, input2, cache);
+  check_same_font (expected, second);
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+
+  /* Differing flags are a different request. */
+  hb_subset_input_set_flags (input2, HB_SUBSET_FLAGS_RETAIN_GIDS);
+  hb_face_t *retained = hb_subset_cached_or_fail (face, input2, cache);
+  g_assert_nonnull (retained);
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+
+  /* Dropping everything makes the first input miss again. */
+  hb_subset_cache_set_max_bytes (cache, 0);
+  hb_subset_cache_set_max_bytes (cache, 1u << 20);
+  hb_face_t *third = hb_subset_cached_or_fail (face, input, cache);
+  check_same_font (expected, third);
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 3);
+
+  /* A budget that fits one result evicts the least recently used. */
+  hb_blob_t *blob = hb_face_reference_blob (third);
+  hb_subset_cache_set_max_bytes (cache, hb_blob_get_length (blob) + 1024);
+  hb_blob_destroy (blob);
+  hb_face_destroy (hb_subset_cached_or_fail (face, input2, cache));
+  hb_face_destroy (hb_subset_cached_or_fail (face, input, cache));
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 5);
+
+  /* No cache subsets directly. */
+  hb_face_t *uncached = hb_subset_cached_or_fail (face, input, NULL);
+  check_same_font (expected, uncached);
+  g_assert_null (hb_subset_cached_or_fail (NULL, input, cache));
+
+  hb_face_destroy (uncached);
+  hb_face_destroy (third);
+  hb_face_destroy (retained);
+  hb_face_destroy (second);
+  hb_face_destroy (first);
+  hb_face_destroy (expected);
+  hb_subset_input_destroy (input2);
+  hb_subset_input_destroy (input);
+  hb_subset_cache_destroy (cache);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_cached_axis_location (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Mada-VF.ttf");
+  hb_subset_cache_t *cache = hb_subset_cache_create_or_fail ();
+  unsigned hits, misses;
+
+  /* Positions the string form prints the same are still told apart. */
+  hb_subset_input_t *input = create_abc_input ();
+  hb_subset_input_pin_axis_location (input, face, HB_TAG ('w', 'g', 'h', 't'), 600.f);
+  hb_subset_input_t *input2 = create_abc_input ();
+  hb_subset_input_pin_axis_location (input2, face, HB_TAG ('w', 'g', 'h', 't'), 600.0001f);
+
+  hb_face_destroy (hb_subset_cached_or_fail (face, input, cache));
+  hb_face_destroy (hb_subset_cached_or_fail (face, input2, cache));
+  hb_face_destroy (hb_subset_cached_or_fail (face, input, cache));
+  hb_subset_cache_get_stats (cache, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+
+  hb_subset_input_destroy (input2);
+  hb_subset_input_destroy (input);
+  hb_subset_cache_destroy (cache);
+  hb_face_destroy (face);
+}
 #endif
 
 int
@@ -613,10 +906,15 @@ main (int argc, char **argv)
   hb_test_add (test_subset_set_flags);
   hb_test_add (test_subset_sets);
   hb_test_add (test_subset_plan);
+  hb_test_add (test_subset_plan_num_threads);
+  hb_test_add (test_subset_plan_create_extended);
+  hb_test_add (test_subset_plan_create_extended_args);
   hb_test_add (test_subset_create_for_tables_face);
 
   #ifdef HB_EXPERIMENTAL_API
   hb_test_add (test_subset_input_to_string);
+  hb_test_add (test_subset_cached);
+  hb_test_add (test_subset_cached_axis_location);
   hb_test_add (test_subset_cff2_get_charstring_data);
   hb_test_add (test_subset_cff2_get_all_charstrings_data);
   hb_test_add (test_subset_cff2_get_charstring_data_no_cff);
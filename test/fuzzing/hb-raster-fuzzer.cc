@@ -54,6 +54,27 @@ extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
       hb_raster_draw_recycle_image (draw, draw_image);
     }
 
+    /* Same outline again as a distance field or LCD coverage. */
+    const hb_raster_format_t formats[] = {HB_RASTER_FORMAT_SDF_A8,
+					  HB_RASTER_FORMAT_MSDF_BGRA32,
+					  HB_RASTER_FORMAT_LCD_BGRA32};
+    hb_raster_draw_set_format (draw, formats[gid % 3]);
+    hb_raster_draw_set_sdf_spread (draw, (float) (1 + gid % 8));
+    hb_raster_draw_set_lcd_layout (draw, (hb_raster_lcd_layout_t) (gid % 4));
+    hb_raster_draw_set_transform (draw, 1.f, 0.f, 0.f, 1.f, x, y);
+    hb_raster_draw_glyph (draw, input.font, gid);
+    hb_raster_image_t *other_image = hb_raster_draw_render (draw);
+    if (other_image)
+    {
+      hb_raster_extents_t ext;
+      hb_raster_image_get_extents (other_image, &ext);
+      counter += ext.width + ext.height;
+      const uint8_t *buf = hb_raster_image_get_buffer (other_image);
+      if (buf && ext.height && ext.stride)
+	counter += buf[0];
+      hb_raster_draw_recycle_image (draw, other_image);
+    }
+
     hb_raster_image_t *paint_image = hb_raster_paint_render (paint);
     if (paint_image)
     {
@@ -0,0 +1,77 @@
+#include "hb-shape-input.hh"
+
+#include <hb-raster.h>
+
+#include <assert.h>
+#include <string.h>
+
+/* Renders the same geometry with one thread and with several, and
+ * checks that the strip-parallel sweep produces the same image as the
+ * serial one. */
+
+static hb_raster_image_t *
+render_glyphs (hb_raster_draw_t *draw,
+	       hb_font_t *font,
+	       unsigned limit,
+	       const uint8_t *data, size_t size,
+	       unsigned num_threads)
+{
+  hb_raster_draw_reset (draw);
+  hb_raster_draw_set_num_threads (draw, num_threads);
+
+  /* A column of glyphs, tall enough to be cut into several strips,
+   * each under a transform picked from the input. */
+  for (unsigned i = 0; i < limit; i++)
+  {
+    uint8_t b = size ? data[i % size] : 0;
+    float shear = (float) ((int) (b & 0x0F) - 8) / 16.f;
+    float stretch = 1.f + (float) (b >> 4) / 8.f;
+    hb_raster_draw_set_transform (draw, 1.f, 0.f, shear, stretch,
+				  (float) ((b & 3) * 37), (float) i * 300.f);
+    hb_raster_draw_glyph (draw, font, i);
+  }
+
+  return hb_raster_draw_render (draw);
+}
+
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+  /* Allocations are not failed here: a failed edge push would give the
+   * two renders different geometry to start with. */
+
+  _fuzzing_shape_input_t input;
+  if (_fuzzing_prepare_shape_input (data, size, 30, 30, &input) == HB_FUZZING_SHAPE_INPUT_MALFORMED)
+    return 0;
+
+  hb_raster_draw_t *draw = hb_raster_draw_create_or_fail ();
+  if (!draw)
+    return 0;
+
+  /* Big enough glyphs for a render to span several strips, but capped
+   * so malicious fonts don't produce huge surfaces. */
+  hb_font_set_scale (input.font, 1000, 1000);
+
+  unsigned glyph_count = hb_face_get_glyph_count (input.face);
+  unsigned limit = glyph_count > 12 ? 12 : glyph_count;
+
+  hb_raster_image_t *serial = render_glyphs (draw, input.font, limit, data, size, 1);
+  hb_raster_image_t *parallel = render_glyphs (draw, input.font, limit, data, size, 4);
+
+  if (serial && parallel)
+  {
+    hb_raster_extents_t serial_ext, parallel_ext;
+    hb_raster_image_get_extents (serial, &serial_ext);
+    hb_raster_image_get_extents (parallel, &parallel_ext);
+    assert (0 == memcmp (&serial_ext, &parallel_ext, sizeof (serial_ext)));
+
+    const uint8_t *serial_buf = hb_raster_image_get_buffer (serial);
+    const uint8_t *parallel_buf = hb_raster_image_get_buffer (parallel);
+    size_t len = (size_t) serial_ext.stride * serial_ext.height;
+    assert (!len || 0 == memcmp (serial_buf, parallel_buf, len));
+  }
+
+  hb_raster_image_destroy (serial);
+  hb_raster_image_destroy (parallel);
+  hb_raster_draw_destroy (draw);
+  return 0;
+}
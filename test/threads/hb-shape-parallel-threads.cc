@@ -0,0 +1,204 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hb.h"
+
+#define SUBSET_FONT_BASE_PATH "test/subset/data/fonts/"
+
+struct test_input_t
+{
+  const char *font_path;
+  const char *text_path;
+  bool is_variable;
+} default_tests[] =
+{
+
+  {"perf/fonts/NotoNastaliqUrdu-Regular.ttf",
+   "perf/texts/fa-paragraph.txt",
+   false},
+
+  {"perf/fonts/Roboto-Regular.ttf",
+   "perf/texts/en-paragraph.txt",
+   false},
+
+  {SUBSET_FONT_BASE_PATH "SourceSerifVariable-Roman.ttf",
+   "perf/texts/en-paragraph.txt",
+   true},
+};
+
+
+static test_input_t *tests = default_tests;
+static unsigned num_tests = sizeof (default_tests) / sizeof (default_tests[0]);
+
+static unsigned num_repetitions = 1;
+static unsigned num_threads = 8;
+/* Number of hb_shape_parallel() calls running at once on the same font. */
+static unsigned num_callers = 2;
+
+static std::vector<hb_buffer_t *>
+load_lines (const test_input_t &input)
+{
+  const char *lang_str = strrchr (input.text_path, '/');
+  lang_str = lang_str ? lang_str + 1 : input.text_path;
+  hb_language_t language = hb_language_from_string (lang_str, -1);
+
+  hb_blob_t *text_blob = hb_blob_create_from_file_or_fail (input.text_path);
+  assert (text_blob);
+  unsigned text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+
+  std::vector<hb_buffer_t *> buffers;
+  for (unsigned i = 0; i < num_repetitions; i++)
+  {
+    unsigned offset = 0;
+    const char *end;
+    while ((end = (const char *) memchr (text + offset, '\n', text_length - offset)))
+    {
+      hb_buffer_t *buf = hb_buffer_create ();
+      hb_buffer_add_utf8 (buf, text, text_length, offset, end - text - offset);
+      hb_buffer_guess_segment_properties (buf);
+      hb_buffer_set_language (buf, language);
+      buffers.push_back (buf);
+
+      offset = end - text + 1;
+    }
+  }
+
+  hb_blob_destroy (text_blob);
+  return buffers;
+}
+
+static void
+destroy_lines (std::vector<hb_buffer_t *> &buffers)
+{
+  for (hb_buffer_t *buf : buffers)
+    hb_buffer_destroy (buf);
+  buffers.clear ();
+}
+
+static void shape (const test_input_t &input,
+		   hb_font_t *font,
+		   const std::vector<hb_buffer_t *> *expected)
+{
+  std::vector<hb_buffer_t *> buffers = load_lines (input);
+  assert (buffers.size () == expected->size ());
+
+  bool ret = hb_shape_parallel (font, buffers.data (), buffers.size (),
+				nullptr, 0, nullptr, num_threads);
+  assert (ret);
+
+  for (unsigned i = 0; i < buffers.size (); i++)
+    if (hb_buffer_diff (buffers[i], (*expected)[i], (hb_codepoint_t) -1, 0))
+    {
+      fprintf (stderr, "Line %u differs from serial shaping\n", i);
+      abort ();
+    }
+
+  destroy_lines (buffers);
+}
+
+static void test_backend (const char *backend,
+			  bool variable,
+			  const test_input_t &test_input)
+{
+  char name[1024] = "shape-parallel";
+  const char *p;
+  strcat (name, "/");
+  p = strrchr (test_input.font_path, '/');
+  strcat (name, p ? p + 1 : test_input.font_path);
+  strcat (name, "/");
+  p = strrchr (test_input.text_path, '/');
+  strcat (name, p ? p + 1 : test_input.text_path);
+  strcat (name, variable ? "/var" : "");
+  strcat (name, "/");
+  strcat (name, backend);
+
+  printf ("Testing %s\n", name);
+
+  hb_font_t *font;
+  {
+    hb_blob_t *blob = hb_blob_create_from_file_or_fail (test_input.font_path);
+    assert (blob);
+    hb_face_t *face = hb_face_create (blob, 0);
+    hb_blob_destroy (blob);
+    font = hb_font_create (face);
+    hb_face_destroy (face);
+  }
+
+  if (variable)
+  {
+    hb_variation_t wght = {HB_TAG ('w','g','h','t'), 500};
+    hb_font_set_variations (font, &wght, 1);
+  }
+
+  bool ret = hb_font_set_funcs_using (font, backend);
+  if (!ret)
+    abort ();
+
+  std::vector<hb_buffer_t *> expected = load_lines (test_input);
+  for (hb_buffer_t *buf : expected)
+    hb_shape (font, buf, nullptr, 0);
+
+  hb_font_make_immutable (font);
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < num_callers; i++)
+    threads.push_back (std::thread (shape, test_input, font, &expected));
+
+  for (unsigned i = 0; i < num_callers; i++)
+    threads[i].join ();
+
+  destroy_lines (expected);
+  hb_font_destroy (font);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+    num_threads = atoi (argv[1]);
+  if (argc > 2)
+    num_repetitions = atoi (argv[2]);
+  if (argc > 3)
+    num_callers = atoi (argv[3]);
+
+  /* Dummy call to alleviate _guess_segment_properties thread safety-ness
+   * https://github.com/harfbuzz/harfbuzz/issues/1191 */
+  hb_language_get_default ();
+
+  if (argc > 5)
+  {
+    num_tests = (argc - 4) / 2;
+    tests = (test_input_t *) calloc (num_tests, sizeof (test_input_t));
+    for (unsigned i = 0; i < num_tests; i++)
+    {
+      tests[i].is_variable = true;
+      tests[i].font_path = argv[4 + i * 2];
+      tests[i].text_path = argv[5 + i * 2];
+    }
+  }
+
+  printf ("Num threads %u; num repetitions %u; num callers %u\n",
+	  num_threads, num_repetitions, num_callers);
+  for (unsigned i = 0; i < num_tests; i++)
+  {
+    auto& test_input = tests[i];
+    for (int variable = 0; variable < int (test_input.is_variable) + 1; variable++)
+    {
+      bool is_var = (bool) variable;
+
+      for (const char **font_funcs = hb_font_list_funcs (); *font_funcs; font_funcs++)
+	test_backend (*font_funcs, is_var, test_input);
+    }
+  }
+
+  if (tests != default_tests)
+    free (tests);
+}